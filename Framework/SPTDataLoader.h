@@ -5,17 +5,31 @@
 
 #import <SPTDataLoader/SPTDataLoaderAuthoriser.h>
 #import <SPTDataLoader/SPTDataLoaderCancellationToken.h>
+#import <SPTDataLoader/SPTDataLoaderChromeTraceRecorder.h>
+#import <SPTDataLoader/SPTDataLoaderConcurrencyLimit.h>
 #import <SPTDataLoader/SPTDataLoaderConsumptionObserver.h>
 #import <SPTDataLoader/SPTDataLoaderDelegate.h>
 #import <SPTDataLoader/SPTDataLoaderExponentialTimer.h>
 #import <SPTDataLoader/SPTDataLoaderFactory.h>
+#import <SPTDataLoader/SPTDataLoaderHistogram.h>
 #import <SPTDataLoader/SPTDataLoaderImplementation.h>
+#import <SPTDataLoader/SPTDataLoaderInFlightRequest.h>
+#import <SPTDataLoader/SPTDataLoaderMetrics.h>
+#import <SPTDataLoader/SPTDataLoaderMetricsRegistry.h>
+#import <SPTDataLoader/SPTDataLoaderMutationQueue.h>
+#import <SPTDataLoader/SPTDataLoaderPreloadPolicy.h>
 #import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
+#import <SPTDataLoader/SPTDataLoaderRedirect.h>
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 #import <SPTDataLoader/SPTDataLoaderResolver.h>
+#import <SPTDataLoader/SPTDataLoaderResolverAddressSource.h>
 #import <SPTDataLoader/SPTDataLoaderResponse.h>
 #import <SPTDataLoader/SPTDataLoaderServerTrustPolicy.h>
 #import <SPTDataLoader/SPTDataLoaderService.h>
+#import <SPTDataLoader/SPTDataLoaderSessionPartition.h>
+#import <SPTDataLoader/SPTDataLoaderSessionStatistics.h>
+#import <SPTDataLoader/SPTDataLoaderSignpostTracer.h>
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
 
 //! Project version number for SPTDataLoader.
 FOUNDATION_EXPORT double SPTDataLoaderVersionNumber;
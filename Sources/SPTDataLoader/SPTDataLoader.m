@@ -11,9 +11,11 @@
 #import <SPTDataLoader/SPTDataLoaderResponse.h>
 
 #import "SPTDataLoaderCancellationTokenFactoryImplementation.h"
+#import "SPTDataLoaderLock.h"
 #import "SPTDataLoaderRequest+Private.h"
 #import "SPTDataLoaderRequestResponseHandler.h"
 #import "SPTDataLoaderResponse+Private.h"
+#import "SPTDataLoaderTraceContext.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -21,7 +23,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, readonly) NSMutableArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens;
 @property (nonatomic, strong, readonly) NSMutableArray<SPTDataLoaderRequest *> *requests;
+@property (nonatomic, strong, readonly) SPTDataLoaderLock *requestsLock;
 @property (nonatomic, strong, readonly) id<SPTDataLoaderCancellationTokenFactory> cancellationTokenFactory;
+@property (nonatomic, strong, nullable) SPTDataLoaderTraceContext *traceContext;
+@property (nonatomic, strong, readonly) NSMutableArray<dispatch_block_t> *pendingDelegateBlocks;
+@property (nonatomic, strong, readonly) SPTDataLoaderLock *pendingDelegateBlocksLock;
+@property (nonatomic, assign) BOOL pendingDelegateBlocksScheduled;
 
 @end
 
@@ -47,101 +54,172 @@ NS_ASSUME_NONNULL_BEGIN
         _cancellationTokens = [NSMutableArray new];
         _delegateQueue = dispatch_get_main_queue();
         _requests = [NSMutableArray new];
+        _requestsLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoader.requests"];
+        _pendingDelegateBlocks = [NSMutableArray new];
+        _pendingDelegateBlocksLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoader.pendingDelegateBlocks"];
     }
     return self;
 }
 
 - (void)executeDelegateBlock:(dispatch_block_t)block
 {
-    if (self.delegateQueue == dispatch_get_main_queue() && [NSThread isMainThread]) {
+    if (self.coalescesDelegateCalls) {
+        [self enqueueDelegateBlock:block];
+    } else if (self.delegateQueue == dispatch_get_main_queue() && [NSThread isMainThread]) {
         block();
     } else {
         dispatch_async(self.delegateQueue, block);
     }
 }
 
-- (void)removeRequest:(SPTDataLoaderRequest *)request
+- (void)enqueueDelegateBlock:(dispatch_block_t)block
+{
+    // Only the first block since the last drain schedules one, the others join it
+    [self.pendingDelegateBlocksLock lock];
+    [self.pendingDelegateBlocks addObject:block];
+    BOOL scheduleDrain = !self.pendingDelegateBlocksScheduled;
+    self.pendingDelegateBlocksScheduled = YES;
+    [self.pendingDelegateBlocksLock unlock];
+
+    if (!scheduleDrain) {
+        return;
+    }
+
+    dispatch_block_t drainBlock = ^{
+        [self drainDelegateBlocks];
+    };
+    const NSTimeInterval coalescingInterval = self.delegateCoalescingInterval;
+    if (coalescingInterval > 0.0) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(coalescingInterval * NSEC_PER_SEC)), self.delegateQueue, drainBlock);
+    } else {
+        dispatch_async(self.delegateQueue, drainBlock);
+    }
+}
+
+- (void)drainDelegateBlocks
 {
-    @synchronized(self.requests) {
-        [self.requests removeObject:request];
+    // Blocks enqueued while these run are left to the next drain, so they still run after them
+    [self.pendingDelegateBlocksLock lock];
+    NSArray<dispatch_block_t> *blocks = [self.pendingDelegateBlocks copy];
+    [self.pendingDelegateBlocks removeAllObjects];
+    self.pendingDelegateBlocksScheduled = NO;
+    [self.pendingDelegateBlocksLock unlock];
+
+    for (dispatch_block_t block in blocks) {
+        block();
     }
+}
 
-    @synchronized(self.cancellationTokens) {
-        NSMutableIndexSet *indicesToRemove = [NSMutableIndexSet new];
-        for (NSUInteger i = 0; i < self.cancellationTokens.count; i++) {
-            if ([self.cancellationTokens[i].objectToCancel isEqual:request]) {
-                [indicesToRemove addIndex:i];
-            }
+- (void)removeRequest:(SPTDataLoaderRequest *)request
+{
+    // The requests and their cancellation tokens share a lock, as they are always updated together
+    [self.requestsLock lock];
+    [self.requests removeObject:request];
+    NSMutableIndexSet *indicesToRemove = [NSMutableIndexSet new];
+    for (NSUInteger i = 0; i < self.cancellationTokens.count; i++) {
+        if ([self.cancellationTokens[i].objectToCancel isEqual:request]) {
+            [indicesToRemove addIndex:i];
         }
-        [self.cancellationTokens removeObjectsAtIndexes:indicesToRemove];
     }
+    [self.cancellationTokens removeObjectsAtIndexes:indicesToRemove];
+    [self.requestsLock unlock];
 }
 
 #pragma mark SPTDataLoader
 
 - (nullable id<SPTDataLoaderCancellationToken>)performRequest:(SPTDataLoaderRequest *)request
 {
-    SPTDataLoaderRequest *copiedRequest = [request copy];
+    return [self performRequests:@[request]].firstObject;
+}
+
+- (NSArray<id<SPTDataLoaderCancellationToken>> *)performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+{
     id<SPTDataLoaderDelegate> delegate = self.delegate;
 
-    // Cancel the request immediately if it requires chunks and the delegate does not support that
+    // Cancel requests immediately if they require chunks and the delegate does not support that
     BOOL chunksSupported = [delegate respondsToSelector:@selector(dataLoaderShouldSupportChunks:)];
     if (chunksSupported) {
         chunksSupported = [delegate dataLoaderShouldSupportChunks:self];
     }
-    if (!chunksSupported && copiedRequest.chunks) {
-        NSError *error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
-                                             code:SPTDataLoaderRequestErrorChunkedRequestWithoutChunkedDelegate
-                                         userInfo:nil];
-        SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
-        response.error = error;
-        [delegate dataLoader:self didReceiveErrorResponse:response];
-        return nil;
-    }
 
-    id<SPTDataLoaderCancellationToken> cancellationToken = [self.cancellationTokenFactory createCancellationTokenWithDelegate:self
-                                                                                                                 cancelObject:copiedRequest];
-    copiedRequest.cancellationToken = cancellationToken;
-    @synchronized(self.cancellationTokens) {
-        [self.cancellationTokens addObject:cancellationToken];
+    NSMutableArray<SPTDataLoaderRequest *> *copiedRequests = [NSMutableArray arrayWithCapacity:requests.count];
+    NSMutableArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens = [NSMutableArray arrayWithCapacity:requests.count];
+    for (SPTDataLoaderRequest *request in requests) {
+        SPTDataLoaderRequest *copiedRequest = [request copy];
+        if (!chunksSupported && copiedRequest.chunks) {
+            NSError *error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                                 code:SPTDataLoaderRequestErrorChunkedRequestWithoutChunkedDelegate
+                                             userInfo:nil];
+            SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+            response.error = error;
+            [delegate dataLoader:self didReceiveErrorResponse:response];
+            continue;
+        }
+
+        id<SPTDataLoaderCancellationToken> cancellationToken = [self.cancellationTokenFactory createCancellationTokenWithDelegate:self
+                                                                                                                     cancelObject:copiedRequest];
+        copiedRequest.cancellationToken = cancellationToken;
+        [copiedRequests addObject:copiedRequest];
+        [cancellationTokens addObject:cancellationToken];
     }
 
-    @synchronized(self.requests) {
-        [self.requests addObject:copiedRequest];
+    if (copiedRequests.count == 0) {
+        return @[];
     }
 
-    [self.requestResponseHandlerDelegate requestResponseHandler:self performRequest:copiedRequest];
+    // Register the whole group under a single lock acquisition
+    [self.requestsLock lock];
+    [self.cancellationTokens addObjectsFromArray:cancellationTokens];
+    [self.requests addObjectsFromArray:copiedRequests];
+    [self.requestsLock unlock];
 
-    return cancellationToken;
+    for (SPTDataLoaderRequest *copiedRequest in copiedRequests) {
+        [self.traceContext beginPhase:SPTDataLoaderTracePhaseSubmission ofRequest:copiedRequest];
+    }
+    // Hand the group over as one unit so the factory and the service can register it in a single pass as well
+    id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    if ([requestResponseHandlerDelegate respondsToSelector:@selector(requestResponseHandler:performRequests:)]) {
+        [requestResponseHandlerDelegate requestResponseHandler:self performRequests:copiedRequests];
+    } else {
+        for (SPTDataLoaderRequest *copiedRequest in copiedRequests) {
+            [requestResponseHandlerDelegate requestResponseHandler:self performRequest:copiedRequest];
+        }
+    }
+
+    return cancellationTokens;
 }
 
 - (void)cancelAllLoads
 {
     NSArray *cancellationTokens = nil;
-    @synchronized(self.cancellationTokens) {
-        cancellationTokens = [self.cancellationTokens copy];
-        [self.cancellationTokens removeAllObjects];
-    }
+    [self.requestsLock lock];
+    cancellationTokens = [self.cancellationTokens copy];
+    [self.cancellationTokens removeAllObjects];
+    [self.requestsLock unlock];
     [cancellationTokens makeObjectsPerformSelector:@selector(cancel)];
 }
 
 - (BOOL)isRequestExpected:(SPTDataLoaderRequest *)request
 {
-    @synchronized (self.requests) {
-        for (SPTDataLoaderRequest *expectedRequest in self.requests) {
-            if (request.uniqueIdentifier == expectedRequest.uniqueIdentifier) {
-                return YES;
-            }
+    BOOL expected = NO;
+    [self.requestsLock lock];
+    for (SPTDataLoaderRequest *expectedRequest in self.requests) {
+        if (request.uniqueIdentifier == expectedRequest.uniqueIdentifier) {
+            expected = YES;
+            break;
         }
     }
-    return NO;
+    [self.requestsLock unlock];
+    return expected;
 }
 
 - (NSArray<SPTDataLoaderRequest *> *)currentRequests
 {
-    @synchronized (self.requests) {
-        return [self.requests copy];
-    }
+    NSArray<SPTDataLoaderRequest *> *requests = nil;
+    [self.requestsLock lock];
+    requests = [self.requests copy];
+    [self.requestsLock unlock];
+    return requests;
 }
 
 #pragma mark NSObject
@@ -161,8 +239,10 @@ NS_ASSUME_NONNULL_BEGIN
         return;
     }
 
+    [self.traceContext beginPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:response.request];
     [self executeDelegateBlock: ^{
         [self.delegate dataLoader:self didReceiveSuccessfulResponse:response];
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:response.request];
     }];
 
     [self removeRequest:response.request];
@@ -174,8 +254,10 @@ NS_ASSUME_NONNULL_BEGIN
         return;
     }
 
+    [self.traceContext beginPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:response.request];
     [self executeDelegateBlock: ^{
         [self.delegate dataLoader:self didReceiveErrorResponse:response];
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:response.request];
     }];
 
     [self removeRequest:response.request];
@@ -188,17 +270,22 @@ NS_ASSUME_NONNULL_BEGIN
     }
 
     if ([self.delegate respondsToSelector:@selector(dataLoader:didCancelRequest:)]) {
+        [self.traceContext beginPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:request];
         [self executeDelegateBlock: ^{
             [self.delegate dataLoader:self didCancelRequest:request];
+            [self.traceContext endPhase:SPTDataLoaderTracePhaseDelegateDelivery ofRequest:request];
         }];
     }
 
     [self removeRequest:request];
 }
 
-- (void)receivedDataChunk:(NSData *)data forResponse:(SPTDataLoaderResponse *)response
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler
 {
     if (![self isRequestExpected:response.request]) {
+        completionHandler();
         return;
     }
 
@@ -207,9 +294,13 @@ NS_ASSUME_NONNULL_BEGIN
 
     BOOL didReceiveDataChunkSelectorExists = [self.delegate respondsToSelector:@selector(dataLoader:didReceiveDataChunk:forResponse:)];
     if (didReceiveDataChunkSelectorExists) {
+        // The chunk counts as consumed once the delegate has returned from handling it
         [self executeDelegateBlock: ^{
             [self.delegate dataLoader:self didReceiveDataChunk:data forResponse:response];
+            completionHandler();
         }];
+    } else {
+        completionHandler();
     }
 }
 
@@ -5,9 +5,206 @@
 
 #import <SPTDataLoader/SPTDataLoader.h>
 
+#import "SPTDataLoaderResponse+Private.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 static NSString * const BlockRequestIdentifierKey = @"BlockRequestIdentifierKey";
+static NSString * const BlockBatchRequestIdentifierKey = @"BlockBatchRequestIdentifierKey";
+
+typedef void (^SPTDataLoaderBlockBatchItemHandler)(SPTDataLoaderResponse *response);
+
+/**
+ The bookkeeping for a batch of requests performed through the block wrapper
+ */
+@interface SPTDataLoaderBlockWrapperBatch : NSObject <SPTDataLoaderCancellationToken>
+
+@property (nonatomic, strong, readonly) SPTDataLoader *dataLoader;
+@property (nonatomic, copy, readonly) NSArray<SPTDataLoaderRequest *> *requests;
+@property (nonatomic, assign, readonly) NSUInteger maximumConcurrentRequests;
+@property (nonatomic, copy, readonly, nullable) SPTDataLoaderBlockCompletion itemCompletion;
+@property (nonatomic, copy, readonly) SPTDataLoaderBlockBatchCompletion completion;
+
+@property (nonatomic, strong, readonly) NSMutableArray *responses;
+@property (nonatomic, strong, readonly) NSMutableArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens;
+@property (nonatomic, assign) NSUInteger nextRequestIndex;
+@property (nonatomic, assign) NSUInteger inFlightRequestCount;
+@property (nonatomic, assign) NSUInteger completedRequestCount;
+@property (nonatomic, assign, readwrite, getter = isCancelled) BOOL cancelled;
+
+@end
+
+@implementation SPTDataLoaderBlockWrapperBatch
+
+- (instancetype)initWithDataLoader:(SPTDataLoader *)dataLoader
+                          requests:(NSArray<SPTDataLoaderRequest *> *)requests
+         maximumConcurrentRequests:(NSUInteger)maximumConcurrentRequests
+                    itemCompletion:(nullable SPTDataLoaderBlockCompletion)itemCompletion
+                        completion:(SPTDataLoaderBlockBatchCompletion)completion
+{
+    self = [super init];
+    if (self) {
+        _dataLoader = dataLoader;
+        _requests = [requests copy];
+        _maximumConcurrentRequests = maximumConcurrentRequests > 0 ? maximumConcurrentRequests : MAX(requests.count, 1u);
+        _itemCompletion = [itemCompletion copy];
+        _completion = [completion copy];
+
+        _responses = [NSMutableArray arrayWithCapacity:requests.count];
+        for (NSUInteger i = 0; i < requests.count; i++) {
+            [_responses addObject:[NSNull null]];
+        }
+        _cancellationTokens = [NSMutableArray new];
+    }
+    return self;
+}
+
++ (SPTDataLoaderResponse *)cancelledResponseForRequest:(SPTDataLoaderRequest *)request
+{
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+    response.error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+    return response;
+}
+
+- (void)start
+{
+    if (self.requests.count == 0) {
+        SPTDataLoaderBlockBatchCompletion completion = self.completion;
+        dispatch_async(self.dataLoader.delegateQueue, ^{
+            completion(@[]);
+        });
+        return;
+    }
+
+    [self performPendingRequests];
+}
+
+- (SPTDataLoaderRequest *)itemRequestAtIndex:(NSUInteger)index
+{
+    SPTDataLoaderRequest *request = [self.requests[index] copy];
+    NSMutableDictionary *mutableUserInfo = [request.userInfo mutableCopy] ?: [NSMutableDictionary new];
+    mutableUserInfo[BlockBatchRequestIdentifierKey] = [^(SPTDataLoaderResponse *response) {
+        [self completeRequestAtIndex:index withResponse:response];
+    } copy];
+    request.userInfo = mutableUserInfo;
+    return request;
+}
+
+- (void)performPendingRequests
+{
+    NSMutableArray<SPTDataLoaderRequest *> *itemRequests = [NSMutableArray new];
+    @synchronized(self) {
+        while (!self.cancelled
+               && self.nextRequestIndex < self.requests.count
+               && self.inFlightRequestCount < self.maximumConcurrentRequests) {
+            [itemRequests addObject:[self itemRequestAtIndex:self.nextRequestIndex]];
+            self.nextRequestIndex++;
+            self.inFlightRequestCount++;
+        }
+    }
+
+    if (itemRequests.count == 0) {
+        return;
+    }
+
+    NSArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens = [self.dataLoader performRequests:itemRequests];
+
+    BOOL cancelled = NO;
+    @synchronized(self) {
+        cancelled = self.cancelled;
+        if (!cancelled && self.completedRequestCount < self.requests.count) {
+            [self.cancellationTokens addObjectsFromArray:cancellationTokens];
+        }
+    }
+
+    // The batch was cancelled while these requests were being submitted
+    if (cancelled) {
+        [cancellationTokens makeObjectsPerformSelector:@selector(cancel)];
+    }
+}
+
+- (void)completeRequestAtIndex:(NSUInteger)index withResponse:(SPTDataLoaderResponse *)response
+{
+    NSArray<SPTDataLoaderResponse *> *responses = nil;
+    @synchronized(self) {
+        if (self.responses[index] != [NSNull null]) {
+            return;
+        }
+
+        self.responses[index] = response;
+        self.inFlightRequestCount--;
+        self.completedRequestCount++;
+
+        NSMutableIndexSet *indicesToRemove = [NSMutableIndexSet new];
+        for (NSUInteger i = 0; i < self.cancellationTokens.count; i++) {
+            SPTDataLoaderRequest *request = self.cancellationTokens[i].objectToCancel;
+            if (request.uniqueIdentifier == response.request.uniqueIdentifier) {
+                [indicesToRemove addIndex:i];
+            }
+        }
+        [self.cancellationTokens removeObjectsAtIndexes:indicesToRemove];
+
+        if (self.completedRequestCount == self.requests.count) {
+            responses = [self.responses copy];
+            [self.cancellationTokens removeAllObjects];
+        }
+    }
+
+    if (self.itemCompletion != nil) {
+        self.itemCompletion(response, response.error);
+    }
+
+    if (responses != nil) {
+        self.completion(responses);
+    } else {
+        [self performPendingRequests];
+    }
+}
+
+#pragma mark SPTDataLoaderCancellationToken
+
+@synthesize cancelled = _cancelled;
+
+- (nullable id<SPTDataLoaderCancellationTokenDelegate>)delegate
+{
+    return nil;
+}
+
+- (nullable id)objectToCancel
+{
+    return self.requests;
+}
+
+- (void)cancel
+{
+    NSArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens = nil;
+    NSRange pendingRange = NSMakeRange(0, 0);
+    @synchronized(self) {
+        if (self.cancelled) {
+            return;
+        }
+
+        self.cancelled = YES;
+        cancellationTokens = [self.cancellationTokens copy];
+        [self.cancellationTokens removeAllObjects];
+
+        // Requests that were never performed complete through the same path as the cancelled ones in flight
+        pendingRange = NSMakeRange(self.nextRequestIndex, self.requests.count - self.nextRequestIndex);
+        self.nextRequestIndex = self.requests.count;
+        self.inFlightRequestCount += pendingRange.length;
+    }
+
+    [cancellationTokens makeObjectsPerformSelector:@selector(cancel)];
+
+    for (NSUInteger index = pendingRange.location; index < NSMaxRange(pendingRange); index++) {
+        SPTDataLoaderResponse *response = [self.class cancelledResponseForRequest:self.requests[index]];
+        dispatch_async(self.dataLoader.delegateQueue, ^{
+            [self completeRequestAtIndex:index withResponse:response];
+        });
+    }
+}
+
+@end
 
 @interface SPTDataLoaderBlockWrapper () <SPTDataLoaderDelegate>
 
@@ -36,8 +233,28 @@ static NSString * const BlockRequestIdentifierKey = @"BlockRequestIdentifierKey"
     return [self.dataLoader performRequest:request];
 }
 
+- (id<SPTDataLoaderCancellationToken>)performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+                            maximumConcurrentRequests:(NSUInteger)maximumConcurrentRequests
+                                       itemCompletion:(nullable SPTDataLoaderBlockCompletion)itemCompletion
+                                           completion:(SPTDataLoaderBlockBatchCompletion)completion
+{
+    SPTDataLoaderBlockWrapperBatch *batch = [[SPTDataLoaderBlockWrapperBatch alloc] initWithDataLoader:self.dataLoader
+                                                                                              requests:requests
+                                                                             maximumConcurrentRequests:maximumConcurrentRequests
+                                                                                        itemCompletion:itemCompletion
+                                                                                            completion:completion];
+    [batch start];
+    return batch;
+}
+
 - (void)dataLoader:(nonnull SPTDataLoader *)dataLoader didReceiveErrorResponse:(nonnull SPTDataLoaderResponse *)response
 {
+    SPTDataLoaderBlockBatchItemHandler batchItemHandler = response.request.userInfo[BlockBatchRequestIdentifierKey];
+    if (batchItemHandler != nil) {
+        batchItemHandler(response);
+        return;
+    }
+
     SPTDataLoaderBlockCompletion completion = response.request.userInfo[BlockRequestIdentifierKey];
     if (completion != nil) {
         completion(response, response.error);
@@ -46,12 +263,27 @@ static NSString * const BlockRequestIdentifierKey = @"BlockRequestIdentifierKey"
 
 - (void)dataLoader:(nonnull SPTDataLoader *)dataLoader didReceiveSuccessfulResponse:(nonnull SPTDataLoaderResponse *)response
 {
+    SPTDataLoaderBlockBatchItemHandler batchItemHandler = response.request.userInfo[BlockBatchRequestIdentifierKey];
+    if (batchItemHandler != nil) {
+        batchItemHandler(response);
+        return;
+    }
+
     SPTDataLoaderBlockCompletion completion = response.request.userInfo[BlockRequestIdentifierKey];
     if (completion != nil) {
         completion(response, nil);
     }
 }
 
+- (void)dataLoader:(nonnull SPTDataLoader *)dataLoader didCancelRequest:(nonnull SPTDataLoaderRequest *)request
+{
+    // Only batches report cancellations, so that their completion is always called
+    SPTDataLoaderBlockBatchItemHandler batchItemHandler = request.userInfo[BlockBatchRequestIdentifierKey];
+    if (batchItemHandler != nil) {
+        batchItemHandler([SPTDataLoaderBlockWrapperBatch cancelledResponseForRequest:request]);
+    }
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,49 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Compresses request bodies with zlib
+ */
+@interface SPTDataLoaderBodyCompressor : NSObject
+
+/**
+ The value of the Content-Encoding header for a compression
+ @param compression The compression to look up
+ @return The header value, or nil for SPTDataLoaderRequestBodyCompressionNone
+ */
++ (nullable NSString *)contentEncodingForCompression:(SPTDataLoaderRequestBodyCompression)compression;
+
+/**
+ Compresses data in one go
+ @param data The data to compress
+ @param compression The compression to apply
+ @return The compressed data, or nil if the data could not be compressed
+ */
++ (nullable NSData *)compressedData:(NSData *)data compression:(SPTDataLoaderRequestBodyCompression)compression;
+
+/**
+ Creates a stream that yields the compressed contents of another stream
+ @discussion Every call starts a thread that reads and compresses the source stream as the returned stream is consumed,
+ and exits once the source stream ends or the returned stream is closed. Call it once per stream that is uploaded.
+ @param stream The unopened stream to compress
+ @param compression The compression to apply
+ @param readHandler Called on the compressing thread with the number of bytes read from the source stream
+ @param failureHandler Called on the compressing thread when the source stream fails to be read, before the returned
+ stream ends. What has been compressed up to then is not a complete body, so the upload must not succeed
+ */
++ (NSInputStream *)compressedStreamWithStream:(NSInputStream *)stream
+                                  compression:(SPTDataLoaderRequestBodyCompression)compression
+                                  readHandler:(nullable void (^)(NSUInteger length))readHandler
+                               failureHandler:(nullable void (^)(NSError *error))failureHandler;
+
+@end
+
+NS_ASSUME_NONNULL_END
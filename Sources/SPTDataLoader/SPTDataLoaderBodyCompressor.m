@@ -0,0 +1,220 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderBodyCompressor.h"
+
+#import <zlib.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSUInteger const SPTDataLoaderBodyCompressorBufferSize = 64 * 1024;
+
+@interface SPTDataLoaderBodyCompressor ()
+
+@property (nonatomic, assign) z_stream stream;
+@property (nonatomic, assign) BOOL initialised;
+
+@end
+
+@implementation SPTDataLoaderBodyCompressor
+
+#pragma mark SPTDataLoaderBodyCompressor
+
++ (nullable NSString *)contentEncodingForCompression:(SPTDataLoaderRequestBodyCompression)compression
+{
+    switch (compression) {
+        case SPTDataLoaderRequestBodyCompressionNone: return nil;
+        case SPTDataLoaderRequestBodyCompressionGzip: return @"gzip";
+        case SPTDataLoaderRequestBodyCompressionDeflate: return @"deflate";
+    }
+    return nil;
+}
+
++ (nullable NSData *)compressedData:(NSData *)data compression:(SPTDataLoaderRequestBodyCompression)compression
+{
+    SPTDataLoaderBodyCompressor *compressor = [[self alloc] initWithCompression:compression];
+    if (compressor == nil) {
+        return nil;
+    }
+
+    NSMutableData *compressedData = [NSMutableData dataWithCapacity:data.length / 2];
+    if (![compressor compressBytes:data.bytes length:data.length finish:YES intoData:compressedData]) {
+        return nil;
+    }
+    return compressedData;
+}
+
++ (NSInputStream *)compressedStreamWithStream:(NSInputStream *)stream
+                                  compression:(SPTDataLoaderRequestBodyCompression)compression
+                                  readHandler:(nullable void (^)(NSUInteger length))readHandler
+                               failureHandler:(nullable void (^)(NSError *error))failureHandler
+{
+    SPTDataLoaderBodyCompressor *compressor = [[self alloc] initWithCompression:compression];
+    if (compressor == nil) {
+        return stream;
+    }
+
+    NSInputStream *inputStream = nil;
+    NSOutputStream *outputStream = nil;
+    [NSStream getBoundStreamsWithBufferSize:SPTDataLoaderBodyCompressorBufferSize
+                                inputStream:&inputStream
+                               outputStream:&outputStream];
+    if (inputStream == nil || outputStream == nil) {
+        return stream;
+    }
+
+    // The pump blocks on reads and writes until the session consumes the stream, which would tie up a worker of a
+    // shared queue for as long as the upload lasts, so it runs on a thread of its own that ends with the stream
+    NSThread *thread = [[NSThread alloc] initWithBlock:^{
+        [compressor pumpStream:stream
+                    intoStream:(NSOutputStream * _Nonnull)outputStream
+                   readHandler:readHandler
+                failureHandler:failureHandler];
+    }];
+    thread.name = @"com.spotify.dataloader.bodycompressor";
+    thread.qualityOfService = NSQualityOfServiceUtility;
+    [thread start];
+
+    return (NSInputStream * _Nonnull)inputStream;
+}
+
+#pragma mark Private
+
+- (nullable instancetype)initWithCompression:(SPTDataLoaderRequestBodyCompression)compression
+{
+    const int SPTDataLoaderBodyCompressorWindowBits = 15;
+    const int SPTDataLoaderBodyCompressorGzipWindowBitsOffset = 16;
+    const int SPTDataLoaderBodyCompressorMemoryLevel = 8;
+
+    int windowBits = 0;
+    switch (compression) {
+        case SPTDataLoaderRequestBodyCompressionNone:
+            return nil;
+        case SPTDataLoaderRequestBodyCompressionGzip:
+            windowBits = SPTDataLoaderBodyCompressorWindowBits + SPTDataLoaderBodyCompressorGzipWindowBitsOffset;
+            break;
+        case SPTDataLoaderRequestBodyCompressionDeflate:
+            windowBits = SPTDataLoaderBodyCompressorWindowBits;
+            break;
+    }
+
+    self = [super init];
+    if (self) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream,
+                         Z_DEFAULT_COMPRESSION,
+                         Z_DEFLATED,
+                         windowBits,
+                         SPTDataLoaderBodyCompressorMemoryLevel,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            return nil;
+        }
+        _stream = stream;
+        _initialised = YES;
+    }
+    return self;
+}
+
+- (BOOL)compressBytes:(const void *)bytes length:(NSUInteger)length finish:(BOOL)finish intoData:(NSMutableData *)data
+{
+    uint8_t buffer[SPTDataLoaderBodyCompressorBufferSize];
+    z_stream *stream = &_stream;
+    const uint8_t *input = bytes;
+
+    do {
+        // zlib counts in 32 bits, so feed larger inputs in slices
+        uInt sliceLength = (uInt)MIN(length, (NSUInteger)UINT32_MAX);
+        BOOL lastSlice = sliceLength == length;
+        stream->next_in = (Bytef *)input;
+        stream->avail_in = sliceLength;
+
+        int flush = (finish && lastSlice) ? Z_FINISH : Z_NO_FLUSH;
+        do {
+            stream->next_out = buffer;
+            stream->avail_out = sizeof(buffer);
+            if (deflate(stream, flush) == Z_STREAM_ERROR) {
+                return NO;
+            }
+            [data appendBytes:buffer length:sizeof(buffer) - stream->avail_out];
+        } while (stream->avail_out == 0);
+
+        input += sliceLength;
+        length -= sliceLength;
+    } while (length > 0);
+
+    return YES;
+}
+
+- (void)pumpStream:(NSInputStream *)sourceStream
+        intoStream:(NSOutputStream *)outputStream
+       readHandler:(nullable void (^)(NSUInteger length))readHandler
+    failureHandler:(nullable void (^)(NSError *error))failureHandler
+{
+    uint8_t buffer[SPTDataLoaderBodyCompressorBufferSize];
+    NSMutableData *compressedData = [NSMutableData dataWithCapacity:SPTDataLoaderBodyCompressorBufferSize];
+
+    [sourceStream open];
+    [outputStream open];
+
+    BOOL finished = NO;
+    while (!finished) {
+        NSInteger readLength = [sourceStream read:buffer maxLength:sizeof(buffer)];
+        if (readLength < 0) {
+            // Bound streams cannot carry an error, so the consumer is told before the truncated body ends
+            if (failureHandler) {
+                failureHandler(sourceStream.streamError ?: [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil]);
+            }
+            break;
+        }
+        finished = readLength == 0;
+        if (readLength > 0 && readHandler) {
+            readHandler((NSUInteger)readLength);
+        }
+
+        compressedData.length = 0;
+        if (![self compressBytes:buffer length:(NSUInteger)readLength finish:finished intoData:compressedData]) {
+            if (failureHandler) {
+                failureHandler([NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil]);
+            }
+            break;
+        }
+        if (![self writeData:compressedData toStream:outputStream]) {
+            break;
+        }
+    }
+
+    [sourceStream close];
+    [outputStream close];
+}
+
+- (BOOL)writeData:(NSData *)data toStream:(NSOutputStream *)outputStream
+{
+    const uint8_t *bytes = data.bytes;
+    NSUInteger remainingLength = data.length;
+    while (remainingLength > 0) {
+        // Blocks until the consumer has made space, fails once it has closed the stream
+        NSInteger writtenLength = [outputStream write:bytes maxLength:remainingLength];
+        if (writtenLength <= 0) {
+            return NO;
+        }
+        bytes += writtenLength;
+        remainingLength -= (NSUInteger)writtenLength;
+    }
+    return YES;
+}
+
+#pragma mark NSObject
+
+- (void)dealloc
+{
+    if (_initialised) {
+        deflateEnd(&_stream);
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,175 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderChromeTraceRecorder.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderChromeTraceRecorderCategory = @"SPTDataLoader";
+
+@interface SPTDataLoaderChromeTraceRecorder ()
+
+@property (nonatomic, copy, readwrite) NSURL *fileURL;
+@property (nonatomic, strong, nullable) NSFileHandle *fileHandle;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) NSMutableData *buffer;
+@property (nonatomic, assign) BOOL hasWrittenEvent;
+@property (nonatomic, assign) uint64_t startTime;
+@property (nonatomic, strong) NSNumber *processIdentifier;
+
+@end
+
+@implementation SPTDataLoaderChromeTraceRecorder
+
+#pragma mark SPTDataLoaderChromeTraceRecorder
+
++ (nullable instancetype)chromeTraceRecorderWithFileURL:(NSURL *)fileURL error:(NSError * _Nullable * _Nullable)error
+{
+    if (![[NSData data] writeToURL:fileURL options:NSDataWritingAtomic error:error]) {
+        return nil;
+    }
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:fileURL error:error];
+    if (fileHandle == nil) {
+        return nil;
+    }
+    return [[self alloc] initWithFileURL:fileURL fileHandle:fileHandle];
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL fileHandle:(NSFileHandle *)fileHandle
+{
+    self = [super init];
+    if (self) {
+        _fileURL = [fileURL copy];
+        _fileHandle = fileHandle;
+        _queue = dispatch_queue_create("com.spotify.dataloader.trace", DISPATCH_QUEUE_SERIAL);
+        _buffer = [NSMutableData dataWithData:(NSData * _Nonnull)[@"[" dataUsingEncoding:NSUTF8StringEncoding]];
+        _startTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        _processIdentifier = @(getpid());
+    }
+
+    return self;
+}
+
+- (void)flush
+{
+    dispatch_sync(self.queue, ^{
+        [self writeBuffer];
+    });
+}
+
+- (void)close
+{
+    dispatch_sync(self.queue, ^{
+        [self closeFile];
+    });
+}
+
+- (void)recordEventWithPhase:(SPTDataLoaderTracePhase)phase
+                     request:(SPTDataLoaderRequest *)request
+                  serviceKey:(NSString *)serviceKey
+                       began:(BOOL)began
+{
+    const NSUInteger SPTDataLoaderChromeTraceRecorderBufferSize = 64 * 1024;
+
+    // Time and thread are taken on the calling thread, everything else happens on the queue
+    uint64_t time = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    uint64_t threadIdentifier = 0;
+    pthread_threadid_np(NULL, &threadIdentifier);
+    int64_t requestIdentifier = request.uniqueIdentifier;
+    NSString *sourceIdentifier = request.sourceIdentifier;
+
+    dispatch_async(self.queue, ^{
+        if (self.fileHandle == nil) {
+            return;
+        }
+
+        NSMutableDictionary *event = [@{ @"name" : NSStringFromSPTDataLoaderTracePhase(phase),
+                                         @"cat" : SPTDataLoaderChromeTraceRecorderCategory,
+                                         @"ph" : began ? @"b" : @"e",
+                                         @"id" : @(requestIdentifier),
+                                         @"ts" : @((double)(time - self.startTime) / (double)NSEC_PER_USEC),
+                                         @"pid" : self.processIdentifier,
+                                         @"tid" : @(threadIdentifier) } mutableCopy];
+        if (began) {
+            NSMutableDictionary *args = [@{ @"requestIdentifier" : @(requestIdentifier),
+                                            @"serviceKey" : serviceKey } mutableCopy];
+            if (sourceIdentifier != nil) {
+                args[@"sourceIdentifier"] = sourceIdentifier;
+            }
+            event[@"args"] = args;
+        }
+
+        NSData *eventData = [NSJSONSerialization dataWithJSONObject:event options:0 error:nil];
+        if (eventData == nil) {
+            return;
+        }
+        if (self.hasWrittenEvent) {
+            [self.buffer appendBytes:",\n" length:2];
+        }
+        [self.buffer appendData:eventData];
+        self.hasWrittenEvent = YES;
+
+        if (self.buffer.length >= SPTDataLoaderChromeTraceRecorderBufferSize) {
+            [self writeBuffer];
+        }
+    });
+}
+
+- (void)writeBuffer
+{
+    if (self.fileHandle == nil || self.buffer.length == 0) {
+        return;
+    }
+
+    [self.fileHandle writeData:self.buffer];
+    self.buffer.length = 0;
+}
+
+- (void)closeFile
+{
+    if (self.fileHandle == nil) {
+        return;
+    }
+
+    [self.buffer appendData:(NSData * _Nonnull)[@"]\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    [self writeBuffer];
+    [self.fileHandle closeFile];
+    self.fileHandle = nil;
+}
+
+#pragma mark SPTDataLoaderTracer
+
+- (void)beganPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    [self recordEventWithPhase:phase request:request serviceKey:serviceKey began:YES];
+}
+
+- (void)endedPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    [self recordEventWithPhase:phase request:request serviceKey:serviceKey began:NO];
+}
+
+#pragma mark NSObject
+
+- (void)dealloc
+{
+    // Blocks on the queue retain the recorder, so nothing is left to run on it
+    [self closeFile];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p fileURL = %@>", self.class, (void *)self, self.fileURL];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,23 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderConcurrencyLimit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderConcurrencyLimit ()
+
+@property (nonatomic, copy, readwrite) NSString *service;
+@property (nonatomic, assign, readwrite) NSUInteger limit;
+@property (nonatomic, assign, readwrite) NSUInteger inFlightCount;
+@property (nonatomic, assign, readwrite) NSUInteger queuedCount;
+@property (nonatomic, assign, readwrite) NSTimeInterval baselineRoundTripTime;
+@property (nonatomic, assign, readwrite) NSTimeInterval smoothedRoundTripTime;
+@property (nonatomic, assign, readwrite) NSUInteger congestionSignalCount;
+@property (nonatomic, assign, readwrite) NSUInteger decreaseCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
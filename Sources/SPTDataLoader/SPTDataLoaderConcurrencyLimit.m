@@ -0,0 +1,27 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderConcurrencyLimit+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SPTDataLoaderConcurrencyLimit
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p service = \"%@\"; limit = %lu; in-flight = %lu; queued = %lu; baseline-rtt = %.3f; smoothed-rtt = %.3f>",
+            self.class,
+            (void *)self,
+            self.service,
+            (unsigned long)self.limit,
+            (unsigned long)self.inFlightCount,
+            (unsigned long)self.queuedCount,
+            self.baselineRoundTripTime,
+            self.smoothedRoundTripTime];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -7,8 +7,10 @@
 
 #import "SPTDataLoaderRequestResponseHandler.h"
 
+@class SPTDataLoaderTraceContext;
 @protocol SPTDataLoaderRequestResponseHandlerDelegate;
 @protocol SPTDataLoaderAuthoriser;
+@protocol SPTDataLoaderTimeProvider;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -17,13 +19,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface SPTDataLoaderFactory (Private) <SPTDataLoaderRequestResponseHandler>
 
+/**
+ The context the requests of the factory and its data loaders are traced through
+ */
+@property (nonatomic, strong, nullable) SPTDataLoaderTraceContext *traceContext;
+
 /**
  Class constructor
  @param requestResponseHandlerDelegate The private delegate to delegate request handling to
  @param authorisers An NSArray of SPTDataLoaderAuthoriser objects for supporting different forms of authorisation
+ @param timeProvider The clock used to schedule request timeouts
  */
 + (instancetype)dataLoaderFactoryWithRequestResponseHandlerDelegate:(nullable id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
-                                                        authorisers:(nullable NSArray<id<SPTDataLoaderAuthoriser>> *)authorisers;
+                                                        authorisers:(nullable NSArray<id<SPTDataLoaderAuthoriser>> *)authorisers
+                                                       timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider;
 
 @end
 
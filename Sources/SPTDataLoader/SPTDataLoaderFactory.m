@@ -12,15 +12,22 @@
 
 #import "SPTDataLoaderFactory+Private.h"
 #import "SPTDataLoaderImplementation+Private.h"
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderMutationQueue+Private.h"
 #import "SPTDataLoaderResponse+Private.h"
 #import "SPTDataLoaderRequest+Private.h"
+#import "SPTDataLoaderTimeProvider.h"
+#import "SPTDataLoaderTraceContext.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface SPTDataLoaderFactory () <SPTDataLoaderRequestResponseHandlerDelegate, SPTDataLoaderAuthoriserDelegate, SPTDataLoaderRequestResponseHandler>
 
 @property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, id<SPTDataLoaderRequestResponseHandler>> *requestToRequestResponseHandler;
+@property (nonatomic, strong) SPTDataLoaderLock *requestToRequestResponseHandlerLock;
 @property (nonatomic, strong, readwrite) dispatch_queue_t requestTimeoutQueue;
+@property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
+@property (nonatomic, strong, nullable) SPTDataLoaderTraceContext *traceContext;
 
 @end
 
@@ -30,19 +37,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)dataLoaderFactoryWithRequestResponseHandlerDelegate:(nullable id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
                                                         authorisers:(nullable NSArray<id<SPTDataLoaderAuthoriser>> *)authorisers
+                                                       timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
-    return [[self alloc] initWithRequestResponseHandlerDelegate:requestResponseHandlerDelegate authorisers:authorisers];
+    return [[self alloc] initWithRequestResponseHandlerDelegate:requestResponseHandlerDelegate
+                                                    authorisers:authorisers
+                                                   timeProvider:timeProvider];
 }
 
 - (instancetype)initWithRequestResponseHandlerDelegate:(nullable id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
                                            authorisers:(nullable NSArray<id<SPTDataLoaderAuthoriser>> *)authorisers
+                                          timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
     self = [super init];
     if (self) {
         _requestResponseHandlerDelegate = requestResponseHandlerDelegate;
         _authorisers = [authorisers copy];
+        _timeProvider = timeProvider;
 
         _requestToRequestResponseHandler = [NSMapTable weakToWeakObjectsMapTable];
+        _requestToRequestResponseHandlerLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderFactory.requestToRequestResponseHandler"];
         _requestTimeoutQueue = dispatch_get_main_queue();
 
         for (id<SPTDataLoaderAuthoriser> authoriser in _authorisers) {
@@ -53,13 +66,133 @@ NS_ASSUME_NONNULL_BEGIN
     return self;
 }
 
+- (BOOL)enqueueRequest:(SPTDataLoaderRequest *)request
+    requestResponseHandler:(nullable id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+                     error:(nullable NSError *)error
+{
+    SPTDataLoaderMutationQueue *mutationQueue = self.mutationQueue;
+    // Replays are never queued a second time, the mutation queue keeps them itself
+    if (!request.persistsWhenOffline || requestResponseHandler == nil || requestResponseHandler == (id)mutationQueue) {
+        return NO;
+    }
+    // A request that reached the service carries its resolved URL, the journal keeps the URL the caller asked for
+    SPTDataLoaderRequest *journaledRequest = request;
+    NSURL *originalURL = request.originalURL;
+    if (originalURL != nil && ![originalURL isEqual:request.URL]) {
+        journaledRequest = [request copy];
+        journaledRequest.URL = (NSURL * _Nonnull)originalURL;
+    }
+    if (![mutationQueue enqueueRequest:journaledRequest error:nil]) {
+        return NO;
+    }
+
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+    response.error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                         code:SPTDataLoaderRequestErrorQueuedForReplay
+                                     userInfo:error != nil ? @{ NSUnderlyingErrorKey : (NSError * _Nonnull)error } : nil];
+    [requestResponseHandler failedResponse:response];
+    return YES;
+}
+
+- (nullable id<SPTDataLoaderRequestResponseHandler>)requestResponseHandlerForRequest:(SPTDataLoaderRequest *)request
+{
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
+    [self.requestToRequestResponseHandlerLock lock];
+    requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:request];
+    [self.requestToRequestResponseHandlerLock unlock];
+    return requestResponseHandler;
+}
+
+- (nullable id<SPTDataLoaderRequestResponseHandler>)removeRequestResponseHandlerForRequest:(SPTDataLoaderRequest *)request
+{
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
+    [self.requestToRequestResponseHandlerLock lock];
+    requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:request];
+    [self.requestToRequestResponseHandler removeObjectForKey:request];
+    [self.requestToRequestResponseHandlerLock unlock];
+    return requestResponseHandler;
+}
+
+- (NSArray<SPTDataLoaderRequest *> *)prepareRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+                              requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+{
+    NSMutableArray<SPTDataLoaderRequest *> *preparedRequests = [NSMutableArray arrayWithCapacity:requests.count];
+    for (SPTDataLoaderRequest *request in requests) {
+        if (self.offline) {
+            if ([self enqueueRequest:request requestResponseHandler:requestResponseHandler error:nil]) {
+                continue;
+            }
+            request.cachePolicy = NSURLRequestReturnCacheDataDontLoad;
+        }
+        [preparedRequests addObject:request];
+    }
+
+    // Register the whole group under a single lock acquisition
+    [self.requestToRequestResponseHandlerLock lock];
+    for (SPTDataLoaderRequest *request in preparedRequests) {
+        [self.requestToRequestResponseHandler setObject:requestResponseHandler forKey:request];
+    }
+    [self.requestToRequestResponseHandlerLock unlock];
+
+    for (SPTDataLoaderRequest *request in preparedRequests) {
+        if (request.timeout > 0.0) {
+            [self scheduleTimeoutOfRequest:request];
+        }
+    }
+
+    return preparedRequests;
+}
+
+- (void)scheduleTimeoutOfRequest:(SPTDataLoaderRequest *)request
+{
+    // Add an absolute timeout for responses
+    request.deadline = self.timeProvider.currentTime + request.timeout;
+    __weak __typeof(self) weakSelf = self;
+    __weak __typeof(request) weakRequest = request;
+    [self.timeProvider dispatchAfter:request.timeout queue:self.requestTimeoutQueue block:^{
+        __strong __typeof(self) strongSelf = weakSelf;
+        __strong __typeof(request) strongRequest = weakRequest;
+        if (strongRequest == nil) {
+            return;
+        }
+        BOOL inFlight = [strongSelf requestResponseHandlerForRequest:strongRequest] != nil;
+        SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:strongRequest
+                                                                                      response:nil];
+        NSError *error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                             code:SPTDataLoaderRequestErrorCodeTimeout
+                                         userInfo:nil];
+        response.error = error;
+        [strongSelf failedResponse:response];
+        if (inFlight) {
+            // Nobody is waiting for the request any more, so its task and any retries still to come are torn down
+            [strongSelf.requestResponseHandlerDelegate requestResponseHandler:strongSelf cancelRequest:strongRequest];
+        }
+    }];
+}
+
 #pragma mark SPTDataLoaderFactory
 
+- (void)setOffline:(BOOL)offline
+{
+    _offline = offline;
+    self.mutationQueue.suspended = offline;
+}
+
+- (void)setMutationQueue:(nullable SPTDataLoaderMutationQueue *)mutationQueue
+{
+    _mutationQueue.requestResponseHandlerDelegate = nil;
+    _mutationQueue = mutationQueue;
+    mutationQueue.requestResponseHandlerDelegate = self;
+    mutationQueue.suspended = self.offline;
+}
+
 - (SPTDataLoader *)createDataLoader
 {
     id<SPTDataLoaderCancellationTokenFactory> cancellationTokenFactory = [SPTDataLoaderCancellationTokenFactoryImplementation new];
-    return [SPTDataLoader dataLoaderWithRequestResponseHandlerDelegate:self
-                                              cancellationTokenFactory:cancellationTokenFactory];
+    SPTDataLoader *dataLoader = [SPTDataLoader dataLoaderWithRequestResponseHandlerDelegate:self
+                                                                   cancellationTokenFactory:cancellationTokenFactory];
+    dataLoader.traceContext = self.traceContext;
+    return dataLoader;
 }
 
 - (SPTDataLoaderBlockWrapper *)createDataLoaderBlockWrapper
@@ -74,12 +207,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)successfulResponse:(SPTDataLoaderResponse *)response
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:response.request];
-        [self.requestToRequestResponseHandler removeObjectForKey:response.request];
-    }
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self removeRequestResponseHandlerForRequest:response.request];
     [requestResponseHandler successfulResponse:response];
+
+    // A response made it through, so the queued requests stand a chance of reaching the server too
+    SPTDataLoaderMutationQueue *mutationQueue = self.mutationQueue;
+    if (mutationQueue != nil && requestResponseHandler != (id)mutationQueue) {
+        [mutationQueue replay];
+    }
 }
 
 - (void)failedResponse:(SPTDataLoaderResponse *)response
@@ -98,48 +233,41 @@ NS_ASSUME_NONNULL_BEGIN
         }
     }
 
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:response.request];
-        [self.requestToRequestResponseHandler removeObjectForKey:response.request];
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self removeRequestResponseHandlerForRequest:response.request];
+    if ([SPTDataLoaderMutationQueue isUnreachableError:response.error] &&
+        [self enqueueRequest:response.request requestResponseHandler:requestResponseHandler error:response.error]) {
+        return;
     }
     [requestResponseHandler failedResponse:response];
 }
 
 - (void)cancelledRequest:(SPTDataLoaderRequest *)request
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:request];
-        [self.requestToRequestResponseHandler removeObjectForKey:request];
-    }
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self removeRequestResponseHandlerForRequest:request];
     [requestResponseHandler cancelledRequest:request];
 }
 
-- (void)receivedDataChunk:(NSData *)data forResponse:(SPTDataLoaderResponse *)response
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:response.request];
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self requestResponseHandlerForRequest:response.request];
+    if (requestResponseHandler == nil) {
+        completionHandler();
+        return;
     }
-    [requestResponseHandler receivedDataChunk:data forResponse:response];
+    [requestResponseHandler receivedDataChunk:data forResponse:response completionHandler:completionHandler];
 }
 
 - (void)receivedInitialResponse:(SPTDataLoaderResponse *)response
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:response.request];
-    }
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self requestResponseHandlerForRequest:response.request];
     [requestResponseHandler receivedInitialResponse:response];
 }
 
 - (void)requestIsWaitingForConnectivity:(nonnull SPTDataLoaderRequest *)request
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:request];
-    }
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self requestResponseHandlerForRequest:request];
     [requestResponseHandler requestIsWaitingForConnectivity:request];
 }
 
@@ -158,6 +286,7 @@ NS_ASSUME_NONNULL_BEGIN
 {
     for (id<SPTDataLoaderAuthoriser> authoriser in self.authorisers) {
         if ([authoriser requestRequiresAuthorisation:request]) {
+            [self.traceContext beginPhase:SPTDataLoaderTracePhaseAuthorisation ofRequest:request];
             [authoriser authoriseRequest:request];
             return;
         }
@@ -166,10 +295,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)needsNewBodyStream:(void (^)(NSInputStream * _Nonnull))completionHandler forRequest:(SPTDataLoaderRequest *)request
 {
-    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = nil;
-    @synchronized(self.requestToRequestResponseHandler) {
-        requestResponseHandler = [self.requestToRequestResponseHandler objectForKey:request];
-    }
+    id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = [self requestResponseHandlerForRequest:request];
     [requestResponseHandler needsNewBodyStream:completionHandler forRequest:request];
 }
 
@@ -178,34 +304,30 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                 performRequest:(SPTDataLoaderRequest *)request
 {
-    if (self.offline) {
-        request.cachePolicy = NSURLRequestReturnCacheDataDontLoad;
+    if ([self prepareRequests:@[ request ] requestResponseHandler:requestResponseHandler].count == 0) {
+        return;
     }
 
-    @synchronized(self.requestToRequestResponseHandler) {
-        [self.requestToRequestResponseHandler setObject:requestResponseHandler forKey:request];
-    }
+    [self.requestResponseHandlerDelegate requestResponseHandler:self performRequest:request];
+}
 
-    // Add an absolute timeout for responses
-    if (request.timeout > 0.0) {
-        __weak __typeof(self) weakSelf = self;
-        __weak __typeof(request) weakRequest = request;
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(request.timeout * NSEC_PER_SEC)),
-                       self.requestTimeoutQueue,
-                       ^{
-                           __strong __typeof(self) strongSelf = weakSelf;
-                           __strong __typeof(request) strongRequest = weakRequest;
-                           SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:strongRequest
-                                                                                                         response:nil];
-                           NSError *error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
-                                                                code:SPTDataLoaderRequestErrorCodeTimeout
-                                                            userInfo:nil];
-                           response.error = error;
-                           [strongSelf failedResponse:response];
-                       });
+- (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+               performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+{
+    NSArray<SPTDataLoaderRequest *> *preparedRequests = [self prepareRequests:requests
+                                                       requestResponseHandler:requestResponseHandler];
+    if (preparedRequests.count == 0) {
+        return;
     }
 
-    [self.requestResponseHandlerDelegate requestResponseHandler:self performRequest:request];
+    id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    if ([requestResponseHandlerDelegate respondsToSelector:@selector(requestResponseHandler:performRequests:)]) {
+        [requestResponseHandlerDelegate requestResponseHandler:self performRequests:preparedRequests];
+    } else {
+        for (SPTDataLoaderRequest *request in preparedRequests) {
+            [requestResponseHandlerDelegate requestResponseHandler:self performRequest:request];
+        }
+    }
 }
 
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
@@ -219,6 +341,7 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)dataLoaderAuthoriser:(id<SPTDataLoaderAuthoriser>)dataLoaderAuthoriser
            authorisedRequest:(SPTDataLoaderRequest *)request
 {
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseAuthorisation ofRequest:request];
     id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
     if ([requestResponseHandlerDelegate respondsToSelector:@selector(requestResponseHandler:authorisedRequest:)]) {
         [requestResponseHandlerDelegate requestResponseHandler:self authorisedRequest:request];
@@ -229,6 +352,7 @@ NS_ASSUME_NONNULL_BEGIN
    didFailToAuthoriseRequest:(SPTDataLoaderRequest *)request
                    withError:(NSError *)error
 {
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseAuthorisation ofRequest:request];
     id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
     if ([requestResponseHandlerDelegate respondsToSelector:@selector(requestResponseHandler:failedToAuthoriseRequest:error:)]) {
         [requestResponseHandlerDelegate requestResponseHandler:self failedToAuthoriseRequest:request error:error];
@@ -0,0 +1,38 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderHistogram.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The live counterpart of a histogram, which values are recorded into from any thread without locking
+ @discussion Values are scaled to integers before they are counted, a scale of 1000000 keeps intervals in seconds to the
+ microsecond. Values up to 2^41 after scaling are bucketed, larger ones are counted in the last bucket.
+ */
+@interface SPTDataLoaderHistogramRecorder : NSObject
+
+/**
+ Class constructor
+ @param scale The factor recorded values are multiplied by before being rounded to an integer
+ */
++ (instancetype)histogramRecorderWithScale:(double)scale;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Counts a value
+ @param value The value to count, negative values are counted as 0
+ */
+- (void)recordValue:(double)value;
+/**
+ A snapshot of the values counted so far
+ @param reset Whether to start counting from scratch as the snapshot is taken
+ */
+- (SPTDataLoaderHistogram *)snapshotResetting:(BOOL)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
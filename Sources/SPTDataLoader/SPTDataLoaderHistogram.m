@@ -0,0 +1,181 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderHistogram+Private.h"
+
+#include <math.h>
+#include <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Every power of two is split into 16 linear sub-buckets, values below 16 get a bucket each
+enum {
+    SPTDataLoaderHistogramSubBucketBits = 4,
+    SPTDataLoaderHistogramSubBucketCount = 1 << SPTDataLoaderHistogramSubBucketBits,
+    SPTDataLoaderHistogramMaximumExponent = 40,
+    SPTDataLoaderHistogramBucketCount = (SPTDataLoaderHistogramMaximumExponent - SPTDataLoaderHistogramSubBucketBits + 2) * SPTDataLoaderHistogramSubBucketCount
+};
+
+static NSUInteger SPTDataLoaderHistogramBucketIndex(uint64_t value)
+{
+    if (value < SPTDataLoaderHistogramSubBucketCount) {
+        return (NSUInteger)value;
+    }
+
+    NSUInteger exponent = (NSUInteger)(63 - __builtin_clzll(value));
+    if (exponent > SPTDataLoaderHistogramMaximumExponent) {
+        return SPTDataLoaderHistogramBucketCount - 1;
+    }
+    NSUInteger shift = exponent - SPTDataLoaderHistogramSubBucketBits;
+    NSUInteger subBucket = (NSUInteger)(value >> shift) & (SPTDataLoaderHistogramSubBucketCount - 1);
+    return (shift + 1) * SPTDataLoaderHistogramSubBucketCount + subBucket;
+}
+
+static uint64_t SPTDataLoaderHistogramBucketUpperBound(NSUInteger index)
+{
+    if (index < SPTDataLoaderHistogramSubBucketCount) {
+        return index;
+    }
+
+    NSUInteger shift = index / SPTDataLoaderHistogramSubBucketCount - 1;
+    uint64_t subBucket = index % SPTDataLoaderHistogramSubBucketCount;
+    uint64_t lowerBound = (SPTDataLoaderHistogramSubBucketCount + subBucket) << shift;
+    return lowerBound + (1ull << shift) - 1;
+}
+
+#pragma mark - SPTDataLoaderHistogram
+
+@interface SPTDataLoaderHistogram ()
+
+@property (nonatomic, assign, readwrite) uint64_t count;
+@property (nonatomic, assign, readwrite) double minimum;
+@property (nonatomic, assign, readwrite) double maximum;
+@property (nonatomic, assign, readwrite) double sum;
+@property (nonatomic, assign) double scale;
+@property (nonatomic, strong) NSData *bucketCounts;
+
+@end
+
+@implementation SPTDataLoaderHistogram
+
+- (double)mean
+{
+    return self.count > 0 ? self.sum / (double)self.count : 0.0;
+}
+
+- (double)valueAtPercentile:(double)percentile
+{
+    if (self.count == 0) {
+        return 0.0;
+    }
+
+    double clampedPercentile = MIN(MAX(percentile, 0.0), 100.0);
+    uint64_t rank = MAX((uint64_t)ceil(clampedPercentile / 100.0 * (double)self.count), 1ull);
+    const uint64_t *bucketCounts = self.bucketCounts.bytes;
+    uint64_t cumulativeCount = 0;
+    for (NSUInteger index = 0; index < SPTDataLoaderHistogramBucketCount; index++) {
+        cumulativeCount += bucketCounts[index];
+        if (cumulativeCount >= rank) {
+            double value = (double)SPTDataLoaderHistogramBucketUpperBound(index) / self.scale;
+            return MIN(MAX(value, self.minimum), self.maximum);
+        }
+    }
+    return self.maximum;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p count = %llu; min = %g; p50 = %g; p99 = %g; max = %g>",
+            self.class,
+            (void *)self,
+            self.count,
+            self.minimum,
+            [self valueAtPercentile:50.0],
+            [self valueAtPercentile:99.0],
+            self.maximum];
+}
+
+@end
+
+#pragma mark - SPTDataLoaderHistogramRecorder
+
+@interface SPTDataLoaderHistogramRecorder () {
+    _Atomic(uint64_t) _bucketCounts[SPTDataLoaderHistogramBucketCount];
+    _Atomic(uint64_t) _sum;
+    _Atomic(uint64_t) _minimum;
+    _Atomic(uint64_t) _maximum;
+}
+
+@property (nonatomic, assign) double scale;
+
+@end
+
+@implementation SPTDataLoaderHistogramRecorder
+
++ (instancetype)histogramRecorderWithScale:(double)scale
+{
+    return [[self alloc] initWithScale:scale];
+}
+
+- (instancetype)initWithScale:(double)scale
+{
+    self = [super init];
+    if (self) {
+        _scale = scale;
+        atomic_init(&_minimum, UINT64_MAX);
+    }
+
+    return self;
+}
+
+- (void)recordValue:(double)value
+{
+    double scaledValue = round(MAX(value, 0.0) * self.scale);
+    uint64_t integerValue = scaledValue < (double)UINT64_MAX ? (uint64_t)scaledValue : UINT64_MAX;
+
+    atomic_fetch_add_explicit(&_bucketCounts[SPTDataLoaderHistogramBucketIndex(integerValue)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_sum, integerValue, memory_order_relaxed);
+
+    uint64_t minimum = atomic_load_explicit(&_minimum, memory_order_relaxed);
+    while (integerValue < minimum
+           && !atomic_compare_exchange_weak_explicit(&_minimum, &minimum, integerValue, memory_order_relaxed, memory_order_relaxed)) {
+    }
+    uint64_t maximum = atomic_load_explicit(&_maximum, memory_order_relaxed);
+    while (integerValue > maximum
+           && !atomic_compare_exchange_weak_explicit(&_maximum, &maximum, integerValue, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+- (SPTDataLoaderHistogram *)snapshotResetting:(BOOL)reset
+{
+    NSMutableData *bucketCounts = [NSMutableData dataWithLength:SPTDataLoaderHistogramBucketCount * sizeof(uint64_t)];
+    uint64_t *counts = bucketCounts.mutableBytes;
+    uint64_t count = 0;
+    for (NSUInteger index = 0; index < SPTDataLoaderHistogramBucketCount; index++) {
+        if (reset) {
+            counts[index] = atomic_exchange_explicit(&_bucketCounts[index], 0, memory_order_relaxed);
+        } else {
+            counts[index] = atomic_load_explicit(&_bucketCounts[index], memory_order_relaxed);
+        }
+        count += counts[index];
+    }
+
+    uint64_t sum = reset ? atomic_exchange_explicit(&_sum, 0, memory_order_relaxed) : atomic_load_explicit(&_sum, memory_order_relaxed);
+    uint64_t minimum = reset ? atomic_exchange_explicit(&_minimum, UINT64_MAX, memory_order_relaxed) : atomic_load_explicit(&_minimum, memory_order_relaxed);
+    uint64_t maximum = reset ? atomic_exchange_explicit(&_maximum, 0, memory_order_relaxed) : atomic_load_explicit(&_maximum, memory_order_relaxed);
+
+    SPTDataLoaderHistogram *histogram = [SPTDataLoaderHistogram new];
+    histogram.count = count;
+    histogram.scale = self.scale;
+    histogram.bucketCounts = bucketCounts;
+    histogram.sum = (double)sum / self.scale;
+    histogram.minimum = count > 0 && minimum != UINT64_MAX ? (double)minimum / self.scale : 0.0;
+    histogram.maximum = count > 0 ? (double)maximum / self.scale : 0.0;
+    return histogram;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
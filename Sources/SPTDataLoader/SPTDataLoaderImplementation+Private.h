@@ -6,6 +6,7 @@
 #import <SPTDataLoader/SPTDataLoaderImplementation.h>
 #import "SPTDataLoaderRequestResponseHandler.h"
 
+@class SPTDataLoaderTraceContext;
 @protocol SPTDataLoaderCancellationTokenFactory;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -15,6 +16,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface SPTDataLoader (Private) <SPTDataLoaderRequestResponseHandler>
 
+/**
+ The context the requests of the data loader are traced through
+ */
+@property (nonatomic, strong, nullable) SPTDataLoaderTraceContext *traceContext;
+
 /**
  Class constructor
  @param requestResponseHandlerDelegate The private delegate for delegating the request handling
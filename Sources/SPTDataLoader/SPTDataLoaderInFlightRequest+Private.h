@@ -0,0 +1,26 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderInFlightRequest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderInFlightRequest ()
+
+@property (nonatomic, strong, readwrite) SPTDataLoaderRequest *request;
+@property (nonatomic, copy, readwrite, nullable) NSString *sourceIdentifier;
+@property (nonatomic, assign, readwrite) SPTDataLoaderInFlightRequestState state;
+@property (nonatomic, assign, readwrite) NSTimeInterval age;
+@property (nonatomic, assign, readwrite) NSTimeInterval timeInState;
+@property (nonatomic, assign, readwrite) NSUInteger retryCount;
+@property (nonatomic, assign, readwrite) int64_t receivedByteCount;
+/**
+ The time the request entered its current state, which tells repeated snapshots of the same wait apart from new ones
+ */
+@property (nonatomic, assign) CFAbsoluteTime stateEntryTime;
+
+@end
+
+NS_ASSUME_NONNULL_END
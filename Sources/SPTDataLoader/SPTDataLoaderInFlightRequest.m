@@ -0,0 +1,51 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderInFlightRequest+Private.h"
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+NSString *NSStringFromSPTDataLoaderInFlightRequestState(SPTDataLoaderInFlightRequestState state)
+{
+    switch (state) {
+        case SPTDataLoaderInFlightRequestStateQueued:
+            return @"queued";
+        case SPTDataLoaderInFlightRequestStateAuthorising:
+            return @"authorising";
+        case SPTDataLoaderInFlightRequestStateWaitingForPreload:
+            return @"waitingForPreload";
+        case SPTDataLoaderInFlightRequestStateRateLimited:
+            return @"rateLimited";
+        case SPTDataLoaderInFlightRequestStateBackingOff:
+            return @"backingOff";
+        case SPTDataLoaderInFlightRequestStateRunning:
+            return @"running";
+        case SPTDataLoaderInFlightRequestStateStreaming:
+            return @"streaming";
+    }
+    return @"unknown";
+}
+
+@implementation SPTDataLoaderInFlightRequest
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p URL = \"%@\"; source = \"%@\"; state = %@; age = %.3f; time-in-state = %.3f; retries = %lu; received = %lld>",
+            self.class,
+            (void *)self,
+            self.request.URL,
+            self.sourceIdentifier,
+            NSStringFromSPTDataLoaderInFlightRequestState(self.state),
+            self.age,
+            self.timeInState,
+            (unsigned long)self.retryCount,
+            self.receivedByteCount];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,75 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ How often the locks sharing a name were taken, and how long they were waited on
+ @discussion Only collected in DEBUG builds.
+ */
+@interface SPTDataLoaderLockContention : NSObject
+
+/**
+ The name of the locks
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+/**
+ The number of times the locks were taken
+ */
+@property (nonatomic, assign, readonly) uint64_t acquisitionCount;
+/**
+ The number of times the locks were held by another thread when they were asked for
+ */
+@property (nonatomic, assign, readonly) uint64_t contendedAcquisitionCount;
+/**
+ The total time spent waiting for the locks
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval waitTime;
+
+@end
+
+/**
+ A non-recursive lock for short critical sections
+ @discussion Backed by os_unfair_lock, which unlike @synchronized needs no lookup of the object being locked on and
+ donates the priority of the waiting thread to the owner. The lock must be released on the thread that took it.
+ */
+@interface SPTDataLoaderLock : NSObject <NSLocking>
+
+/**
+ The name the contention of the lock is reported under
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+
+/**
+ Class constructor
+ @param name The name the contention of the lock is reported under, locks guarding the same kind of state in different
+ objects should share it
+ */
++ (instancetype)lockWithName:(NSString *)name;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Runs a block while holding the lock
+ @param block The block to run, it must not take the lock again
+ */
+- (void)performBlock:(void (NS_NOESCAPE ^)(void))block;
+
+/**
+ The contention of every named lock taken since the last reset, sorted by name
+ @discussion Empty outside of DEBUG builds.
+ */
++ (NSArray<SPTDataLoaderLockContention *> *)contentionProfile;
+
+/**
+ Resets the counters of every named lock
+ */
++ (void)resetContentionProfile;
+
+@end
+
+NS_ASSUME_NONNULL_END
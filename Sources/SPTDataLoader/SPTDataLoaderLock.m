@@ -0,0 +1,208 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderLock.h"
+
+#include <os/lock.h>
+#include <stdatomic.h>
+#include <time.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderLockContention () {
+@public
+    _Atomic(uint64_t) _acquisitionCount;
+    _Atomic(uint64_t) _contendedAcquisitionCount;
+    _Atomic(uint64_t) _waitNanoseconds;
+}
+
+@property (nonatomic, copy, readwrite) NSString *name;
+
+@end
+
+@implementation SPTDataLoaderLockContention
+
+- (instancetype)initWithName:(NSString *)name
+{
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+    }
+
+    return self;
+}
+
+- (uint64_t)acquisitionCount
+{
+    return atomic_load_explicit(&_acquisitionCount, memory_order_relaxed);
+}
+
+- (uint64_t)contendedAcquisitionCount
+{
+    return atomic_load_explicit(&_contendedAcquisitionCount, memory_order_relaxed);
+}
+
+- (NSTimeInterval)waitTime
+{
+    return (NSTimeInterval)atomic_load_explicit(&_waitNanoseconds, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (void)reset
+{
+    atomic_store_explicit(&_acquisitionCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_contendedAcquisitionCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_waitNanoseconds, 0, memory_order_relaxed);
+}
+
+- (SPTDataLoaderLockContention *)snapshot
+{
+    SPTDataLoaderLockContention *snapshot = [[SPTDataLoaderLockContention alloc] initWithName:self.name];
+    atomic_store_explicit(&snapshot->_acquisitionCount, self.acquisitionCount, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->_contendedAcquisitionCount, self.contendedAcquisitionCount, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->_waitNanoseconds,
+                          atomic_load_explicit(&_waitNanoseconds, memory_order_relaxed),
+                          memory_order_relaxed);
+    return snapshot;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p name = \"%@\"; acquisitions = %llu; contended = %llu; waitTime = %f>",
+            self.class, (void *)self, self.name, self.acquisitionCount, self.contendedAcquisitionCount, self.waitTime];
+}
+
+@end
+
+#if DEBUG
+static os_unfair_lock SPTDataLoaderLockContentionRegistryLock = OS_UNFAIR_LOCK_INIT;
+static NSMutableDictionary<NSString *, SPTDataLoaderLockContention *> *SPTDataLoaderLockContentionRegistry = nil;
+
+static SPTDataLoaderLockContention *SPTDataLoaderLockContentionForName(NSString *name)
+{
+    os_unfair_lock_lock(&SPTDataLoaderLockContentionRegistryLock);
+    if (SPTDataLoaderLockContentionRegistry == nil) {
+        SPTDataLoaderLockContentionRegistry = [NSMutableDictionary new];
+    }
+    SPTDataLoaderLockContention *contention = SPTDataLoaderLockContentionRegistry[name];
+    if (contention == nil) {
+        contention = [[SPTDataLoaderLockContention alloc] initWithName:name];
+        SPTDataLoaderLockContentionRegistry[name] = contention;
+    }
+    os_unfair_lock_unlock(&SPTDataLoaderLockContentionRegistryLock);
+    return contention;
+}
+#endif
+
+@interface SPTDataLoaderLock () {
+    os_unfair_lock _lock;
+#if DEBUG
+    SPTDataLoaderLockContention *_contention;
+#endif
+}
+
+@property (nonatomic, copy, readwrite) NSString *name;
+
+@end
+
+@implementation SPTDataLoaderLock
+
+#pragma mark SPTDataLoaderLock
+
++ (instancetype)lockWithName:(NSString *)name
+{
+    return [[self alloc] initWithName:name];
+}
+
+- (instancetype)initWithName:(NSString *)name
+{
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _lock = OS_UNFAIR_LOCK_INIT;
+#if DEBUG
+        _contention = SPTDataLoaderLockContentionForName(_name);
+#endif
+    }
+
+    return self;
+}
+
+- (void)performBlock:(void (NS_NOESCAPE ^)(void))block
+{
+    [self lock];
+    block();
+    [self unlock];
+}
+
++ (NSArray<SPTDataLoaderLockContention *> *)contentionProfile
+{
+#if DEBUG
+    NSArray<SPTDataLoaderLockContention *> *contentions = nil;
+    os_unfair_lock_lock(&SPTDataLoaderLockContentionRegistryLock);
+    contentions = SPTDataLoaderLockContentionRegistry.allValues ?: @[];
+    os_unfair_lock_unlock(&SPTDataLoaderLockContentionRegistryLock);
+
+    NSMutableArray<SPTDataLoaderLockContention *> *profile = [NSMutableArray arrayWithCapacity:contentions.count];
+    for (SPTDataLoaderLockContention *contention in contentions) {
+        [profile addObject:[contention snapshot]];
+    }
+    [profile sortUsingComparator:^NSComparisonResult(SPTDataLoaderLockContention *lhs, SPTDataLoaderLockContention *rhs) {
+        return [lhs.name compare:rhs.name];
+    }];
+    return profile;
+#else
+    return @[];
+#endif
+}
+
++ (void)resetContentionProfile
+{
+#if DEBUG
+    os_unfair_lock_lock(&SPTDataLoaderLockContentionRegistryLock);
+    for (SPTDataLoaderLockContention *contention in SPTDataLoaderLockContentionRegistry.allValues) {
+        [contention reset];
+    }
+    os_unfair_lock_unlock(&SPTDataLoaderLockContentionRegistryLock);
+#endif
+}
+
+#pragma mark NSLocking
+
+- (void)lock
+{
+#if DEBUG
+    SPTDataLoaderLockContention *contention = _contention;
+    atomic_fetch_add_explicit(&contention->_acquisitionCount, 1, memory_order_relaxed);
+    if (os_unfair_lock_trylock(&_lock)) {
+        return;
+    }
+    uint64_t waitStart = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    os_unfair_lock_lock(&_lock);
+    atomic_fetch_add_explicit(&contention->_contendedAcquisitionCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&contention->_waitNanoseconds,
+                              clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - waitStart,
+                              memory_order_relaxed);
+#else
+    os_unfair_lock_lock(&_lock);
+#endif
+}
+
+- (void)unlock
+{
+    os_unfair_lock_unlock(&_lock);
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p name = \"%@\">", self.class, (void *)self, self.name];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
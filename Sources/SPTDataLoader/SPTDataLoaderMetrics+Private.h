@@ -0,0 +1,24 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderMetrics.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderMetrics ()
+
+@property (nonatomic, assign, readwrite) SPTDataLoaderMetricsDimension dimension;
+@property (nonatomic, copy, readwrite) NSString *key;
+@property (nonatomic, strong, readwrite) SPTDataLoaderHistogram *latency;
+@property (nonatomic, strong, readwrite) SPTDataLoaderHistogram *timeToFirstByte;
+@property (nonatomic, strong, readwrite) SPTDataLoaderHistogram *queueWait;
+@property (nonatomic, strong, readwrite) SPTDataLoaderHistogram *bodySize;
+@property (nonatomic, strong, readwrite) SPTDataLoaderHistogram *retryCount;
+@property (nonatomic, copy, readwrite) NSDictionary<NSString *, NSNumber *> *statusClassCounts;
+@property (nonatomic, copy, readwrite) NSDictionary<NSString *, NSNumber *> *errorDomainCounts;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,27 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderMetrics+Private.h"
+
+#import <SPTDataLoader/SPTDataLoaderHistogram.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SPTDataLoaderMetrics
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p key = \"%@\"; requests = %llu; p50 = %.3f; p99 = %.3f>",
+            self.class,
+            (void *)self,
+            self.key,
+            self.latency.count,
+            [self.latency valueAtPercentile:50.0],
+            [self.latency valueAtPercentile:99.0]];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,57 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderMetricsRegistry.h>
+#import <SPTDataLoader/SPTDataLoaderMetrics.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What was measured of a completed request
+ */
+typedef struct {
+    /// The seconds between the service starting the request and it completing
+    NSTimeInterval latency;
+    /// The seconds between the last attempt being sent and its response arriving, or a negative value without a response
+    NSTimeInterval timeToFirstByte;
+    /// The seconds the request was held back before being sent
+    NSTimeInterval queueWait;
+    /// The number of body bytes received
+    int64_t bodySize;
+    /// The number of times the request was retried
+    NSUInteger retryCount;
+    /// The HTTP status code of the response, or 0 without an HTTP response
+    NSInteger statusCode;
+} SPTDataLoaderMetricsSample;
+
+/**
+ The live metrics of a single service key or sourceIdentifier
+ */
+@interface SPTDataLoaderMetricsRecorder : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Counts a completed request
+ @param sample What was measured of the request
+ @param errorDomain The domain of the error the request failed with, or nil if it succeeded
+ */
+- (void)recordSample:(SPTDataLoaderMetricsSample)sample errorDomain:(nullable NSString *)errorDomain;
+
+@end
+
+@interface SPTDataLoaderMetricsRegistry (Private)
+
+/**
+ The recorders a request is counted in, one for its service key and one for its sourceIdentifier if it has one
+ @param request The request about to be performed, before its URL has been resolved
+ */
+- (NSArray<SPTDataLoaderMetricsRecorder *> *)metricsRecordersForRequest:(SPTDataLoaderRequest *)request;
+
+@end
+
+NS_ASSUME_NONNULL_END
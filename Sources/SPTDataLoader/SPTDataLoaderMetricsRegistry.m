@@ -0,0 +1,282 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderMetricsRegistry+Private.h"
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderHistogram+Private.h"
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderMetrics+Private.h"
+#import "SPTDataLoaderRateLimiter+Private.h"
+
+#include <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+enum {
+    // Status classes 1xx to 5xx, with the first slot counting requests without an HTTP response
+    SPTDataLoaderMetricsRecorderStatusClassCount = 6,
+    // Error domains counted without a lock, see SPTDataLoaderMetricsRecorderKnownErrorDomain
+    SPTDataLoaderMetricsRecorderKnownErrorDomainCount = 5
+};
+
+static NSString *SPTDataLoaderMetricsRecorderKnownErrorDomain(NSUInteger index)
+{
+    switch (index) {
+        case 0:
+            return NSURLErrorDomain;
+        case 1:
+            return SPTDataLoaderResponseErrorDomain;
+        case 2:
+            return SPTDataLoaderRequestErrorDomain;
+        case 3:
+            return NSCocoaErrorDomain;
+        default:
+            return NSPOSIXErrorDomain;
+    }
+}
+
+#pragma mark - SPTDataLoaderMetricsRecorder
+
+@interface SPTDataLoaderMetricsRecorder () {
+    _Atomic(uint64_t) _statusClassCounts[SPTDataLoaderMetricsRecorderStatusClassCount];
+    _Atomic(uint64_t) _knownErrorDomainCounts[SPTDataLoaderMetricsRecorderKnownErrorDomainCount];
+}
+
+@property (nonatomic, assign) SPTDataLoaderMetricsDimension dimension;
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *latency;
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *timeToFirstByte;
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *queueWait;
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *bodySize;
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *retryCount;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *errorDomainCounts;
+@property (nonatomic, strong) SPTDataLoaderLock *errorDomainCountsLock;
+
+@end
+
+@implementation SPTDataLoaderMetricsRecorder
+
+- (instancetype)initWithDimension:(SPTDataLoaderMetricsDimension)dimension key:(NSString *)key
+{
+    const double SPTDataLoaderMetricsRecorderMicroseconds = 1000000.0;
+
+    self = [super init];
+    if (self) {
+        _dimension = dimension;
+        _key = [key copy];
+        _latency = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:SPTDataLoaderMetricsRecorderMicroseconds];
+        _timeToFirstByte = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:SPTDataLoaderMetricsRecorderMicroseconds];
+        _queueWait = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:SPTDataLoaderMetricsRecorderMicroseconds];
+        _bodySize = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:1.0];
+        _retryCount = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:1.0];
+        _errorDomainCounts = [NSMutableDictionary new];
+        _errorDomainCountsLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderMetricsRecorder.errorDomainCounts"];
+    }
+
+    return self;
+}
+
+- (void)recordSample:(SPTDataLoaderMetricsSample)sample errorDomain:(nullable NSString *)errorDomain
+{
+    [self.latency recordValue:sample.latency];
+    if (sample.timeToFirstByte >= 0.0) {
+        [self.timeToFirstByte recordValue:sample.timeToFirstByte];
+    }
+    [self.queueWait recordValue:sample.queueWait];
+    [self.bodySize recordValue:(double)sample.bodySize];
+    [self.retryCount recordValue:(double)sample.retryCount];
+
+    NSInteger statusClass = sample.statusCode / 100;
+    NSUInteger statusClassIndex = (statusClass >= 1 && statusClass < SPTDataLoaderMetricsRecorderStatusClassCount) ? (NSUInteger)statusClass : 0;
+    atomic_fetch_add_explicit(&_statusClassCounts[statusClassIndex], 1, memory_order_relaxed);
+
+    if (errorDomain == nil) {
+        return;
+    }
+    for (NSUInteger index = 0; index < SPTDataLoaderMetricsRecorderKnownErrorDomainCount; index++) {
+        if ([errorDomain isEqualToString:SPTDataLoaderMetricsRecorderKnownErrorDomain(index)]) {
+            atomic_fetch_add_explicit(&_knownErrorDomainCounts[index], 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Errors from domains of custom URL protocols and authorisers are rare enough to pay for a lock
+    [self.errorDomainCountsLock lock];
+    self.errorDomainCounts[(NSString * _Nonnull)errorDomain] = @(self.errorDomainCounts[(NSString * _Nonnull)errorDomain].unsignedLongLongValue + 1);
+    [self.errorDomainCountsLock unlock];
+}
+
+- (nullable SPTDataLoaderMetrics *)metricsResetting:(BOOL)reset
+{
+    SPTDataLoaderHistogram *latency = [self.latency snapshotResetting:reset];
+    SPTDataLoaderHistogram *timeToFirstByte = [self.timeToFirstByte snapshotResetting:reset];
+    SPTDataLoaderHistogram *queueWait = [self.queueWait snapshotResetting:reset];
+    SPTDataLoaderHistogram *bodySize = [self.bodySize snapshotResetting:reset];
+    SPTDataLoaderHistogram *retryCount = [self.retryCount snapshotResetting:reset];
+
+    NSMutableDictionary<NSString *, NSNumber *> *statusClassCounts = [NSMutableDictionary new];
+    for (NSUInteger index = 0; index < SPTDataLoaderMetricsRecorderStatusClassCount; index++) {
+        uint64_t count = 0;
+        if (reset) {
+            count = atomic_exchange_explicit(&_statusClassCounts[index], 0, memory_order_relaxed);
+        } else {
+            count = atomic_load_explicit(&_statusClassCounts[index], memory_order_relaxed);
+        }
+        if (count > 0) {
+            NSString *statusClass = index == 0 ? @"none" : [NSString stringWithFormat:@"%lux", (unsigned long)index];
+            statusClassCounts[statusClass] = @(count);
+        }
+    }
+
+    NSMutableDictionary<NSString *, NSNumber *> *errorDomainCounts = nil;
+    [self.errorDomainCountsLock lock];
+    errorDomainCounts = [self.errorDomainCounts mutableCopy];
+    if (reset) {
+        [self.errorDomainCounts removeAllObjects];
+    }
+    [self.errorDomainCountsLock unlock];
+    for (NSUInteger index = 0; index < SPTDataLoaderMetricsRecorderKnownErrorDomainCount; index++) {
+        uint64_t count = 0;
+        if (reset) {
+            count = atomic_exchange_explicit(&_knownErrorDomainCounts[index], 0, memory_order_relaxed);
+        } else {
+            count = atomic_load_explicit(&_knownErrorDomainCounts[index], memory_order_relaxed);
+        }
+        if (count > 0) {
+            errorDomainCounts[SPTDataLoaderMetricsRecorderKnownErrorDomain(index)] = @(count);
+        }
+    }
+
+    if (latency.count == 0) {
+        return nil;
+    }
+
+    SPTDataLoaderMetrics *metrics = [SPTDataLoaderMetrics new];
+    metrics.dimension = self.dimension;
+    metrics.key = self.key;
+    metrics.latency = latency;
+    metrics.timeToFirstByte = timeToFirstByte;
+    metrics.queueWait = queueWait;
+    metrics.bodySize = bodySize;
+    metrics.retryCount = retryCount;
+    metrics.statusClassCounts = statusClassCounts;
+    metrics.errorDomainCounts = errorDomainCounts;
+    return metrics;
+}
+
+@end
+
+#pragma mark - SPTDataLoaderMetricsRegistry
+
+@interface SPTDataLoaderMetricsRegistry ()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, SPTDataLoaderMetricsRecorder *> *serviceKeyRecorders;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, SPTDataLoaderMetricsRecorder *> *sourceIdentifierRecorders;
+@property (nonatomic, strong) SPTDataLoaderLock *recordersLock;
+
+@end
+
+@implementation SPTDataLoaderMetricsRegistry
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _serviceKeyRecorders = [NSMutableDictionary new];
+        _sourceIdentifierRecorders = [NSMutableDictionary new];
+        _recordersLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderMetricsRegistry.recorders"];
+    }
+
+    return self;
+}
+
+#pragma mark SPTDataLoaderMetricsRegistry
+
+- (NSArray<SPTDataLoaderMetrics *> *)metrics
+{
+    return [self metricsResetting:NO];
+}
+
+- (NSArray<SPTDataLoaderMetrics *> *)metricsAndReset
+{
+    return [self metricsResetting:YES];
+}
+
+- (void)reset
+{
+    [self metricsResetting:YES];
+}
+
+- (NSArray<SPTDataLoaderMetrics *> *)metricsResetting:(BOOL)reset
+{
+    NSMutableArray<SPTDataLoaderMetricsRecorder *> *recorders = [NSMutableArray new];
+    [self.recordersLock lock];
+    [recorders addObjectsFromArray:self.serviceKeyRecorders.allValues];
+    [recorders addObjectsFromArray:self.sourceIdentifierRecorders.allValues];
+    [self.recordersLock unlock];
+
+    // Recorders are never removed, so requests in flight keep counting in the ones they hold
+    NSMutableArray<SPTDataLoaderMetrics *> *metrics = [NSMutableArray arrayWithCapacity:recorders.count];
+    for (SPTDataLoaderMetricsRecorder *recorder in recorders) {
+        SPTDataLoaderMetrics *recorderMetrics = [recorder metricsResetting:reset];
+        if (recorderMetrics != nil) {
+            [metrics addObject:recorderMetrics];
+        }
+    }
+    [metrics sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:NSStringFromSelector(@selector(dimension)) ascending:YES],
+                                     [NSSortDescriptor sortDescriptorWithKey:NSStringFromSelector(@selector(key)) ascending:YES] ]];
+    return metrics;
+}
+
+#pragma mark Private
+
+- (NSArray<SPTDataLoaderMetricsRecorder *> *)metricsRecordersForRequest:(SPTDataLoaderRequest *)request
+{
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:request.URL];
+    NSString *sourceIdentifier = request.sourceIdentifier;
+
+    NSMutableArray<SPTDataLoaderMetricsRecorder *> *recorders = [NSMutableArray arrayWithCapacity:2];
+    [self.recordersLock lock];
+    [recorders addObject:[self lockedRecorderInRecorders:self.serviceKeyRecorders
+                                               dimension:SPTDataLoaderMetricsDimensionServiceKey
+                                                     key:serviceKey]];
+    if (sourceIdentifier != nil) {
+        [recorders addObject:[self lockedRecorderInRecorders:self.sourceIdentifierRecorders
+                                                   dimension:SPTDataLoaderMetricsDimensionSourceIdentifier
+                                                         key:(NSString * _Nonnull)sourceIdentifier]];
+    }
+    [self.recordersLock unlock];
+    return recorders;
+}
+
+- (SPTDataLoaderMetricsRecorder *)lockedRecorderInRecorders:(NSMutableDictionary<NSString *, SPTDataLoaderMetricsRecorder *> *)recorders
+                                                  dimension:(SPTDataLoaderMetricsDimension)dimension
+                                                        key:(NSString *)key
+{
+    SPTDataLoaderMetricsRecorder *recorder = recorders[key];
+    if (recorder == nil) {
+        recorder = [[SPTDataLoaderMetricsRecorder alloc] initWithDimension:dimension key:key];
+        recorders[key] = recorder;
+    }
+    return recorder;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    NSUInteger keyCount = 0;
+    [self.recordersLock lock];
+    keyCount = self.serviceKeyRecorders.count + self.sourceIdentifierRecorders.count;
+    [self.recordersLock unlock];
+    return [NSString stringWithFormat:@"<%@: %p keys = %lu>", self.class, (void *)self, (unsigned long)keyCount];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,70 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A request waiting in the journal
+ */
+@interface SPTDataLoaderMutationJournalEntry : NSObject
+
+@property (nonatomic, copy, readonly) NSString *identifier;
+/**
+ The request as it was journaled, every replay performs a copy of it
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderRequest *request;
+
+@end
+
+/**
+ An append-only log of requests on disk
+ @discussion Every change is appended as a line of JSON and flushed to disk before the call returns, so that a crash
+ loses at most the record being written. A torn record at the end of the log is skipped when it is read back. The log
+ is rewritten with only the pending entries when it is opened and once removals dominate it. This class is not thread
+ safe.
+ */
+@interface SPTDataLoaderMutationJournal : NSObject
+
+/**
+ The pending entries in the order they were appended
+ */
+@property (nonatomic, copy, readonly) NSArray<SPTDataLoaderMutationJournalEntry *> *entries;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Opens the journal at a file URL, reading back the entries it holds
+ @param URL The file URL of the journal, which is created if it does not exist
+ @param error Set to the reason the journal could not be opened
+ */
++ (nullable instancetype)journalWithURL:(NSURL *)URL error:(NSError * _Nullable *)error;
+
+/**
+ Whether a request can be written to the journal
+ @discussion Requests with a body stream cannot be journaled
+ */
++ (BOOL)canJournalRequest:(SPTDataLoaderRequest *)request;
+
+/**
+ Appends a request to the journal
+ @param request The request to journal
+ @param error Set to the reason the request could not be written
+ @return The entry of the request, or nil if it could not be written
+ */
+- (nullable SPTDataLoaderMutationJournalEntry *)appendRequest:(SPTDataLoaderRequest *)request error:(NSError * _Nullable *)error;
+
+/**
+ Removes an entry from the journal
+ @param entry The entry to remove
+ */
+- (void)removeEntry:(SPTDataLoaderMutationJournalEntry *)entry;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,350 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderMutationJournal.h"
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderMutationJournalRecordTypeKey = @"type";
+static NSString * const SPTDataLoaderMutationJournalRecordIdentifierKey = @"id";
+static NSString * const SPTDataLoaderMutationJournalRecordRequestKey = @"request";
+static NSString * const SPTDataLoaderMutationJournalRecordTypeAppend = @"append";
+static NSString * const SPTDataLoaderMutationJournalRecordTypeRemove = @"remove";
+
+static NSString * const SPTDataLoaderMutationJournalURLKey = @"url";
+static NSString * const SPTDataLoaderMutationJournalMethodKey = @"method";
+static NSString * const SPTDataLoaderMutationJournalHeadersKey = @"headers";
+static NSString * const SPTDataLoaderMutationJournalBodyKey = @"body";
+static NSString * const SPTDataLoaderMutationJournalBodyFileURLKey = @"bodyFileURL";
+static NSString * const SPTDataLoaderMutationJournalBodyCompressionKey = @"bodyCompression";
+static NSString * const SPTDataLoaderMutationJournalSourceIdentifierKey = @"sourceIdentifier";
+static NSString * const SPTDataLoaderMutationJournalSessionPartitionNameKey = @"sessionPartitionName";
+static NSString * const SPTDataLoaderMutationJournalMaximumRetryCountKey = @"maximumRetryCount";
+static NSString * const SPTDataLoaderMutationJournalTimeoutKey = @"timeout";
+static NSString * const SPTDataLoaderMutationJournalUserInfoKey = @"userInfo";
+
+@interface SPTDataLoaderMutationJournalEntry ()
+
+@property (nonatomic, copy, readwrite) NSString *identifier;
+@property (nonatomic, strong, readwrite) SPTDataLoaderRequest *request;
+@property (nonatomic, copy) NSDictionary<NSString *, id> *record;
+
+@end
+
+@implementation SPTDataLoaderMutationJournalEntry
+
++ (instancetype)entryWithIdentifier:(NSString *)identifier
+                            request:(SPTDataLoaderRequest *)request
+                             record:(NSDictionary<NSString *, id> *)record
+{
+    SPTDataLoaderMutationJournalEntry *entry = [self new];
+    entry.identifier = identifier;
+    entry.request = request;
+    entry.record = record;
+    return entry;
+}
+
+@end
+
+@interface SPTDataLoaderMutationJournal ()
+
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderMutationJournalEntry *> *mutableEntries;
+@property (nonatomic, assign) NSUInteger removedRecordCount;
+
+@end
+
+@implementation SPTDataLoaderMutationJournal
+
+#pragma mark SPTDataLoaderMutationJournal
+
++ (nullable instancetype)journalWithURL:(NSURL *)URL error:(NSError * _Nullable *)error
+{
+    SPTDataLoaderMutationJournal *journal = [[self alloc] initWithURL:URL];
+    if (![journal load:error]) {
+        return nil;
+    }
+    return journal;
+}
+
+- (instancetype)initWithURL:(NSURL *)URL
+{
+    self = [super init];
+    if (self) {
+        _URL = URL;
+        _fileDescriptor = -1;
+        _mutableEntries = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self closeFile];
+}
+
++ (BOOL)canJournalRequest:(SPTDataLoaderRequest *)request
+{
+    return request.bodyStream == nil && request.URL != nil;
+}
+
+- (NSArray<SPTDataLoaderMutationJournalEntry *> *)entries
+{
+    return [self.mutableEntries copy];
+}
+
+- (nullable SPTDataLoaderMutationJournalEntry *)appendRequest:(SPTDataLoaderRequest *)request
+                                                        error:(NSError * _Nullable *)error
+{
+    if (![self.class canJournalRequest:request]) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+        }
+        return nil;
+    }
+
+    NSString *identifier = [NSUUID UUID].UUIDString;
+    NSDictionary<NSString *, id> *record = @{
+        SPTDataLoaderMutationJournalRecordTypeKey : SPTDataLoaderMutationJournalRecordTypeAppend,
+        SPTDataLoaderMutationJournalRecordIdentifierKey : identifier,
+        SPTDataLoaderMutationJournalRecordRequestKey : [self.class propertyListFromRequest:request],
+    };
+    if (![self writeRecords:@[ record ] error:error]) {
+        return nil;
+    }
+
+    SPTDataLoaderMutationJournalEntry *entry = [SPTDataLoaderMutationJournalEntry entryWithIdentifier:identifier
+                                                                                              request:[request copy]
+                                                                                               record:record];
+    [self.mutableEntries addObject:entry];
+    return entry;
+}
+
+- (void)removeEntry:(SPTDataLoaderMutationJournalEntry *)entry
+{
+    if (![self.mutableEntries containsObject:entry]) {
+        return;
+    }
+    [self.mutableEntries removeObject:entry];
+
+    if (self.mutableEntries.count == 0) {
+        // Nothing is pending, so there is nothing worth keeping in the log
+        if (ftruncate(self.fileDescriptor, 0) == 0) {
+            fsync(self.fileDescriptor);
+            self.removedRecordCount = 0;
+            return;
+        }
+    }
+
+    NSDictionary<NSString *, id> *record = @{
+        SPTDataLoaderMutationJournalRecordTypeKey : SPTDataLoaderMutationJournalRecordTypeRemove,
+        SPTDataLoaderMutationJournalRecordIdentifierKey : entry.identifier,
+    };
+    [self writeRecords:@[ record ] error:nil];
+    self.removedRecordCount++;
+
+    const NSUInteger SPTDataLoaderMutationJournalMinimumRemovedRecordsBeforeCompaction = 256;
+    if (self.removedRecordCount >= SPTDataLoaderMutationJournalMinimumRemovedRecordsBeforeCompaction &&
+        self.removedRecordCount > self.mutableEntries.count) {
+        [self compact:nil];
+    }
+}
+
+#pragma mark Private
+
+- (BOOL)load:(NSError * _Nullable *)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:self.URL options:0 error:nil] ?: [NSData data];
+    NSMutableDictionary<NSString *, SPTDataLoaderMutationJournalEntry *> *entries = [NSMutableDictionary new];
+
+    const uint8_t *bytes = data.bytes;
+    NSUInteger lineStart = 0;
+    for (NSUInteger i = 0; i < data.length; ++i) {
+        if (bytes[i] != '\n') {
+            continue;
+        }
+        // A line without a trailing newline was torn by a crash while it was written, and is not read back
+        NSData *line = [data subdataWithRange:NSMakeRange(lineStart, i - lineStart)];
+        lineStart = i + 1;
+
+        NSDictionary *record = [NSJSONSerialization JSONObjectWithData:line options:0 error:nil];
+        if (![record isKindOfClass:[NSDictionary class]]) {
+            continue;
+        }
+        NSString *identifier = record[SPTDataLoaderMutationJournalRecordIdentifierKey];
+        NSString *type = record[SPTDataLoaderMutationJournalRecordTypeKey];
+        if (![identifier isKindOfClass:[NSString class]] || ![type isKindOfClass:[NSString class]]) {
+            continue;
+        }
+
+        if ([type isEqualToString:SPTDataLoaderMutationJournalRecordTypeRemove]) {
+            SPTDataLoaderMutationJournalEntry *entry = entries[identifier];
+            if (entry != nil) {
+                [self.mutableEntries removeObject:entry];
+                entries[identifier] = nil;
+            }
+        } else if ([type isEqualToString:SPTDataLoaderMutationJournalRecordTypeAppend]) {
+            SPTDataLoaderRequest *request = [self.class requestFromPropertyList:record[SPTDataLoaderMutationJournalRecordRequestKey]];
+            if (request == nil || entries[identifier] != nil) {
+                continue;
+            }
+            SPTDataLoaderMutationJournalEntry *entry = [SPTDataLoaderMutationJournalEntry entryWithIdentifier:identifier
+                                                                                                      request:request
+                                                                                                       record:record];
+            entries[identifier] = entry;
+            [self.mutableEntries addObject:entry];
+        }
+    }
+
+    return [self compact:error];
+}
+
+- (BOOL)compact:(NSError * _Nullable *)error
+{
+    NSMutableData *data = [NSMutableData data];
+    for (SPTDataLoaderMutationJournalEntry *entry in self.mutableEntries) {
+        [data appendData:[self.class dataForRecord:entry.record]];
+    }
+
+    [self closeFile];
+    if (![data writeToURL:self.URL options:NSDataWritingAtomic error:error]) {
+        return NO;
+    }
+    self.removedRecordCount = 0;
+    return [self openFile:error];
+}
+
+- (BOOL)openFile:(NSError * _Nullable *)error
+{
+    int fileDescriptor = open(self.URL.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (fileDescriptor < 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        return NO;
+    }
+    self.fileDescriptor = fileDescriptor;
+    return YES;
+}
+
+- (void)closeFile
+{
+    if (self.fileDescriptor >= 0) {
+        close(self.fileDescriptor);
+        self.fileDescriptor = -1;
+    }
+}
+
+- (BOOL)writeRecords:(NSArray<NSDictionary<NSString *, id> *> *)records error:(NSError * _Nullable *)error
+{
+    if (self.fileDescriptor < 0 && ![self openFile:error]) {
+        return NO;
+    }
+
+    NSMutableData *data = [NSMutableData data];
+    for (NSDictionary<NSString *, id> *record in records) {
+        [data appendData:[self.class dataForRecord:record]];
+    }
+
+    const uint8_t *bytes = data.bytes;
+    NSUInteger remaining = data.length;
+    while (remaining > 0) {
+        ssize_t written = write(self.fileDescriptor, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (error) {
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            }
+            return NO;
+        }
+        bytes += written;
+        remaining -= (NSUInteger)written;
+    }
+
+    if (fsync(self.fileDescriptor) != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        return NO;
+    }
+    return YES;
+}
+
++ (NSData *)dataForRecord:(NSDictionary<NSString *, id> *)record
+{
+    NSMutableData *data = [[NSJSONSerialization dataWithJSONObject:record options:0 error:nil] mutableCopy];
+    [data appendBytes:"\n" length:1];
+    return data;
+}
+
++ (NSDictionary<NSString *, id> *)propertyListFromRequest:(SPTDataLoaderRequest *)request
+{
+    NSMutableDictionary<NSString *, id> *propertyList = [NSMutableDictionary new];
+    propertyList[SPTDataLoaderMutationJournalURLKey] = request.URL.absoluteString;
+    propertyList[SPTDataLoaderMutationJournalMethodKey] = @(request.method);
+    propertyList[SPTDataLoaderMutationJournalHeadersKey] = request.headers;
+    propertyList[SPTDataLoaderMutationJournalBodyKey] = [request.body base64EncodedStringWithOptions:0];
+    propertyList[SPTDataLoaderMutationJournalBodyFileURLKey] = request.bodyFileURL.absoluteString;
+    propertyList[SPTDataLoaderMutationJournalBodyCompressionKey] = @(request.bodyCompression);
+    propertyList[SPTDataLoaderMutationJournalSourceIdentifierKey] = request.sourceIdentifier;
+    propertyList[SPTDataLoaderMutationJournalSessionPartitionNameKey] = request.sessionPartitionName;
+    propertyList[SPTDataLoaderMutationJournalMaximumRetryCountKey] = @(request.maximumRetryCount);
+    propertyList[SPTDataLoaderMutationJournalTimeoutKey] = @(request.timeout);
+    // The user info survives a relaunch only when it can be written as JSON
+    if (request.userInfo != nil && [NSJSONSerialization isValidJSONObject:request.userInfo]) {
+        propertyList[SPTDataLoaderMutationJournalUserInfoKey] = request.userInfo;
+    }
+    return propertyList;
+}
+
++ (nullable SPTDataLoaderRequest *)requestFromPropertyList:(nullable NSDictionary<NSString *, id> *)propertyList
+{
+    if (![propertyList isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    NSString *URLString = propertyList[SPTDataLoaderMutationJournalURLKey];
+    NSURL *URL = [URLString isKindOfClass:[NSString class]] ? [NSURL URLWithString:URLString] : nil;
+    if (URL == nil) {
+        return nil;
+    }
+
+    NSString *sourceIdentifier = propertyList[SPTDataLoaderMutationJournalSourceIdentifierKey];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:sourceIdentifier];
+    request.method = (SPTDataLoaderRequestMethod)[propertyList[SPTDataLoaderMutationJournalMethodKey] integerValue];
+    NSDictionary<NSString *, NSString *> *headers = propertyList[SPTDataLoaderMutationJournalHeadersKey];
+    for (NSString *header in headers) {
+        [request addValue:headers[header] forHeader:header];
+    }
+    NSString *body = propertyList[SPTDataLoaderMutationJournalBodyKey];
+    if (body != nil) {
+        request.body = [[NSData alloc] initWithBase64EncodedString:body options:0];
+    }
+    NSString *bodyFileURL = propertyList[SPTDataLoaderMutationJournalBodyFileURLKey];
+    if (bodyFileURL != nil) {
+        request.bodyFileURL = [NSURL URLWithString:bodyFileURL];
+    }
+    request.bodyCompression = (SPTDataLoaderRequestBodyCompression)[propertyList[SPTDataLoaderMutationJournalBodyCompressionKey] integerValue];
+    request.sessionPartitionName = propertyList[SPTDataLoaderMutationJournalSessionPartitionNameKey];
+    request.maximumRetryCount = [propertyList[SPTDataLoaderMutationJournalMaximumRetryCountKey] unsignedIntegerValue];
+    request.timeout = [propertyList[SPTDataLoaderMutationJournalTimeoutKey] doubleValue];
+    NSDictionary *userInfo = propertyList[SPTDataLoaderMutationJournalUserInfoKey];
+    if (userInfo != nil) {
+        request.userInfo = userInfo;
+    }
+    return request;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
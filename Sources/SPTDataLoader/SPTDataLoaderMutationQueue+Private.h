@@ -0,0 +1,35 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderMutationQueue.h>
+
+#import "SPTDataLoaderRequestResponseHandler.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The private API for the mutation queue for internal use in the SPTDataLoader library
+ */
+@interface SPTDataLoaderMutationQueue (Private) <SPTDataLoaderRequestResponseHandler>
+
+/**
+ The object replays are performed through
+ */
+@property (nonatomic, weak, readwrite, nullable) id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate;
+/**
+ Whether replays are held back, for instance while the factory is offline
+ @discussion Setting this to NO starts replaying the pending requests
+ */
+@property (nonatomic, assign, getter = isSuspended) BOOL suspended;
+
+/**
+ Whether an error means the request never reached the server and can be queued for replay
+ @param error The error a request failed with
+ */
++ (BOOL)isUnreachableError:(nullable NSError *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,286 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderMutationQueue.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderMutationJournal.h"
+#import "SPTDataLoaderMutationQueue+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderMutationQueue () <SPTDataLoaderRequestResponseHandler>
+
+@property (nonatomic, weak, readwrite, nullable) id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate;
+@property (nonatomic, strong) SPTDataLoaderMutationJournal *journal;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, SPTDataLoaderMutationJournalEntry *> *replayingRequests;
+@property (nonatomic, assign, getter = isPaused) BOOL paused;
+@property (nonatomic, assign, getter = isSuspended) BOOL suspended;
+
+@end
+
+@implementation SPTDataLoaderMutationQueue
+
+#pragma mark SPTDataLoaderMutationQueue
+
++ (nullable instancetype)mutationQueueWithJournalURL:(NSURL *)journalURL error:(NSError * _Nullable *)error
+{
+    SPTDataLoaderMutationJournal *journal = [SPTDataLoaderMutationJournal journalWithURL:journalURL error:error];
+    if (journal == nil) {
+        return nil;
+    }
+    return [[self alloc] initWithJournal:journal];
+}
+
+- (instancetype)initWithJournal:(SPTDataLoaderMutationJournal *)journal
+{
+    self = [super init];
+    if (self) {
+        _journal = journal;
+        _replayingRequests = [NSMapTable strongToStrongObjectsMapTable];
+        _delegateQueue = dispatch_get_main_queue();
+        _maximumConcurrentReplays = 1;
+    }
+    return self;
+}
+
+- (NSArray<SPTDataLoaderRequest *> *)pendingRequests
+{
+    @synchronized(self) {
+        return [self.journal.entries valueForKey:NSStringFromSelector(@selector(request))];
+    }
+}
+
+- (BOOL)canEnqueueRequest:(SPTDataLoaderRequest *)request
+{
+    switch (request.method) {
+        case SPTDataLoaderRequestMethodPost:
+        case SPTDataLoaderRequestMethodPut:
+        case SPTDataLoaderRequestMethodPatch:
+        case SPTDataLoaderRequestMethodDelete:
+            return [SPTDataLoaderMutationJournal canJournalRequest:request];
+        case SPTDataLoaderRequestMethodGet:
+        case SPTDataLoaderRequestMethodHead:
+            return NO;
+    }
+    return NO;
+}
+
+- (BOOL)enqueueRequest:(SPTDataLoaderRequest *)request error:(NSError * _Nullable *)error
+{
+    if (![self canEnqueueRequest:request]) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFeatureUnsupportedError userInfo:nil];
+        }
+        return NO;
+    }
+
+    NSMutableArray<SPTDataLoaderRequest *> *supersededRequests = [NSMutableArray new];
+    @synchronized(self) {
+        NSArray<SPTDataLoaderMutationJournalEntry *> *entries = self.journal.entries;
+        // Append before dropping what it supersedes, so that a crash in between never loses the latest write
+        if ([self.journal appendRequest:request error:error] == nil) {
+            return NO;
+        }
+        if (self.collapsesSupersededWrites && [self.class isOverwritingMethod:request.method]) {
+            NSSet<SPTDataLoaderMutationJournalEntry *> *replayingEntries = [self replayingEntries];
+            for (SPTDataLoaderMutationJournalEntry *entry in entries) {
+                if ([replayingEntries containsObject:entry] ||
+                    ![entry.request.URL isEqual:request.URL] ||
+                    !(entry.request.method == SPTDataLoaderRequestMethodPatch || [self.class isOverwritingMethod:entry.request.method])) {
+                    continue;
+                }
+                [self.journal removeEntry:entry];
+                [supersededRequests addObject:entry.request];
+            }
+        }
+    }
+
+    id<SPTDataLoaderMutationQueueDelegate> delegate = self.delegate;
+    if (supersededRequests.count > 0 && [delegate respondsToSelector:@selector(mutationQueue:didDiscardSupersededRequest:)]) {
+        dispatch_async(self.delegateQueue, ^{
+            for (SPTDataLoaderRequest *supersededRequest in supersededRequests) {
+                [delegate mutationQueue:self didDiscardSupersededRequest:supersededRequest];
+            }
+        });
+    }
+    return YES;
+}
+
+- (void)replay
+{
+    @synchronized(self) {
+        self.paused = NO;
+    }
+    [self performPendingRequests];
+}
+
+#pragma mark Private
+
++ (BOOL)isUnreachableError:(nullable NSError *)error
+{
+    if (![error.domain isEqualToString:NSURLErrorDomain]) {
+        return NO;
+    }
+    switch (error.code) {
+        case NSURLErrorNotConnectedToInternet:
+        case NSURLErrorCannotFindHost:
+        case NSURLErrorCannotConnectToHost:
+        case NSURLErrorDNSLookupFailed:
+        case NSURLErrorDataNotAllowed:
+        case NSURLErrorInternationalRoamingOff:
+        case NSURLErrorCallIsActive:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
++ (BOOL)isConnectivityError:(nullable NSError *)error
+{
+    if ([self isUnreachableError:error]) {
+        return YES;
+    }
+    // The request may or may not have reached the server, so it is kept to be replayed rather than dropped
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        return error.code == NSURLErrorTimedOut || error.code == NSURLErrorNetworkConnectionLost;
+    }
+    return [error.domain isEqualToString:SPTDataLoaderRequestErrorDomain] && error.code == SPTDataLoaderRequestErrorCodeTimeout;
+}
+
++ (BOOL)isOverwritingMethod:(SPTDataLoaderRequestMethod)method
+{
+    return method == SPTDataLoaderRequestMethodPut || method == SPTDataLoaderRequestMethodDelete;
+}
+
+- (void)setSuspended:(BOOL)suspended
+{
+    @synchronized(self) {
+        _suspended = suspended;
+    }
+    if (!suspended) {
+        [self replay];
+    }
+}
+
+- (NSSet<SPTDataLoaderMutationJournalEntry *> *)replayingEntries
+{
+    return [NSSet setWithArray:self.replayingRequests.objectEnumerator.allObjects];
+}
+
+- (void)performPendingRequests
+{
+    id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    if (requestResponseHandlerDelegate == nil) {
+        return;
+    }
+
+    NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray new];
+    @synchronized(self) {
+        NSUInteger maximumConcurrentReplays = MAX(self.maximumConcurrentReplays, 1u);
+        NSSet<SPTDataLoaderMutationJournalEntry *> *replayingEntries = [self replayingEntries];
+        for (SPTDataLoaderMutationJournalEntry *entry in self.journal.entries) {
+            if (self.paused || self.suspended || self.replayingRequests.count >= maximumConcurrentReplays) {
+                break;
+            }
+            if ([replayingEntries containsObject:entry]) {
+                continue;
+            }
+            SPTDataLoaderRequest *request = [entry.request copy];
+            [self.replayingRequests setObject:entry forKey:request];
+            [requests addObject:request];
+        }
+    }
+
+    for (SPTDataLoaderRequest *request in requests) {
+        [requestResponseHandlerDelegate requestResponseHandler:self performRequest:request];
+    }
+}
+
+- (void)completeRequest:(SPTDataLoaderRequest *)request response:(nullable SPTDataLoaderResponse *)response
+{
+    BOOL keepsRequest = response == nil || (response.statusCode == 0 && [self.class isConnectivityError:response.error]);
+    @synchronized(self) {
+        SPTDataLoaderMutationJournalEntry *entry = [self.replayingRequests objectForKey:request];
+        if (entry == nil) {
+            return;
+        }
+        [self.replayingRequests removeObjectForKey:request];
+        if (keepsRequest) {
+            // The network is still out of reach, wait for the next replay instead of spinning on the failure
+            self.paused = YES;
+        } else {
+            [self.journal removeEntry:entry];
+        }
+    }
+
+    id<SPTDataLoaderMutationQueueDelegate> delegate = self.delegate;
+    if (!keepsRequest && response != nil) {
+        dispatch_async(self.delegateQueue, ^{
+            [delegate mutationQueue:self didReplayRequest:request response:(SPTDataLoaderResponse * _Nonnull)response];
+        });
+    }
+
+    [self performPendingRequests];
+}
+
+#pragma mark SPTDataLoaderRequestResponseHandler
+
+@synthesize requestResponseHandlerDelegate = _requestResponseHandlerDelegate;
+
+- (void)successfulResponse:(SPTDataLoaderResponse *)response
+{
+    [self completeRequest:response.request response:response];
+}
+
+- (void)failedResponse:(SPTDataLoaderResponse *)response
+{
+    [self completeRequest:response.request response:response];
+}
+
+- (void)cancelledRequest:(SPTDataLoaderRequest *)request
+{
+    [self completeRequest:request response:nil];
+}
+
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler
+{
+    completionHandler();
+}
+
+- (void)receivedInitialResponse:(SPTDataLoaderResponse *)response
+{
+}
+
+- (void)requestIsWaitingForConnectivity:(SPTDataLoaderRequest *)request
+{
+}
+
+- (void)needsNewBodyStream:(void (^)(NSInputStream *))completionHandler forRequest:(SPTDataLoaderRequest *)request
+{
+    // Requests with a body stream are never queued
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    @synchronized(self) {
+        return [NSString stringWithFormat:@"<%@: %p pending = %lu; replaying = %lu; paused = %@>",
+                self.class,
+                (void *)self,
+                (unsigned long)self.journal.entries.count,
+                (unsigned long)self.replayingRequests.count,
+                self.paused ? @"YES" : @"NO"];
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
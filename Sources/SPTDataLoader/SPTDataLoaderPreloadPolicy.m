@@ -0,0 +1,48 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderPreloadPolicy.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SPTDataLoaderPreloadPolicy
+
++ (instancetype)preloadPolicy
+{
+    return [self new];
+}
+
+- (instancetype)init
+{
+    const NSUInteger SPTDataLoaderPreloadPolicyDefaultMaximumConcurrentPreloads = 4;
+    const int64_t SPTDataLoaderPreloadPolicyDefaultMaximumBytes = 4 * 1024 * 1024;
+    const NSTimeInterval SPTDataLoaderPreloadPolicyDefaultTimeToLive = 30.0;
+
+    self = [super init];
+    if (self) {
+        _maximumConcurrentPreloads = SPTDataLoaderPreloadPolicyDefaultMaximumConcurrentPreloads;
+        _maximumBytes = SPTDataLoaderPreloadPolicyDefaultMaximumBytes;
+        _timeToLive = SPTDataLoaderPreloadPolicyDefaultTimeToLive;
+        _allowedHosts = [NSSet set];
+    }
+
+    return self;
+}
+
+#pragma mark NSCopying
+
+- (id)copyWithZone:(nullable NSZone *)zone
+{
+    __typeof(self) copy = [self.class new];
+    copy.maximumConcurrentPreloads = self.maximumConcurrentPreloads;
+    copy.maximumBytes = self.maximumBytes;
+    copy.timeToLive = self.timeToLive;
+    copy.allowedHosts = self.allowedHosts;
+    return copy;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,144 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderPreloader;
+@class SPTDataLoaderPreloadPolicy;
+@class SPTDataLoaderRequest;
+
+@protocol SPTDataLoaderTimeProvider;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What a request finds when it asks for a preload of its URL
+ */
+typedef NS_ENUM(NSInteger, SPTDataLoaderPreloaderClaim) {
+    /// Nothing was preloaded, the request is performed as usual
+    SPTDataLoaderPreloaderClaimNone,
+    /// The response was preloaded into the URL cache and is now the request's to load from it
+    SPTDataLoaderPreloaderClaimLoaded,
+    /// The preload is still in flight, the request is performed once it finishes
+    SPTDataLoaderPreloaderClaimPending
+};
+
+@protocol SPTDataLoaderPreloaderDelegate <NSObject>
+
+/**
+ Creates the task to preload a request with
+ @param preloader The preloader asking for the task
+ @param request The request preloading a resource
+ @return The task, which the preloader resumes, or nil if the request may not be sent now
+ */
+- (nullable NSURLSessionTask *)preloader:(SPTDataLoaderPreloader *)preloader taskForRequest:(SPTDataLoaderRequest *)request;
+
+/**
+ Called when a resource was preloaded, for it to be stored in the URL cache
+ @param preloader The preloader that preloaded the resource
+ @param response The response of the preload
+ @param data The body of the response
+ @param request The request that preloaded the resource
+ @param task The task that preloaded the resource
+ */
+- (void)preloader:(SPTDataLoaderPreloader *)preloader
+didPreloadResponse:(NSHTTPURLResponse *)response
+             data:(NSData *)data
+       forRequest:(SPTDataLoaderRequest *)request
+             task:(NSURLSessionTask *)task;
+
+@end
+
+/**
+ Speculatively fetches the resources responses name in their Link rel=preload headers, within a budget
+ @discussion Preloads are kept by URL. A preload is claimed by the first GET request for its URL, or dropped when its
+ time to live runs out, when the request whose response named it is cancelled or when a tag it inherited from that
+ request is cancelled.
+ */
+@interface SPTDataLoaderPreloader : NSObject
+
+/**
+ The budget preloads are made within, nil turns preloading off
+ */
+@property (nonatomic, copy, nullable) SPTDataLoaderPreloadPolicy *policy;
+/**
+ The clock the time to live of preloaded responses is measured with
+ */
+@property (nonatomic, strong) id<SPTDataLoaderTimeProvider> timeProvider;
+
+/**
+ Class constructor
+ @param timeProvider The clock the time to live of preloaded responses is measured with
+ @param delegate The object creating the tasks of the preloads and storing their responses
+ */
++ (instancetype)preloaderWithTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                                 delegate:(id<SPTDataLoaderPreloaderDelegate>)delegate;
+
+/**
+ The resources a response asks to be preloaded, in the order it names them
+ @discussion Relative references are resolved against the URL of the response.
+ @param response The response, which may be a 103 Early Hints response
+ */
++ (NSArray<NSURL *> *)preloadURLsInResponse:(NSHTTPURLResponse *)response;
+
+/**
+ Starts preloading the resources a response asks to be preloaded, as far as the budget allows
+ @param response The response naming the resources
+ @param request The request the response belongs to, whose cancellation drops the preloads
+ @param tags The tags the preloads are dropped by
+ */
+- (void)preloadResourcesOfResponse:(NSHTTPURLResponse *)response
+                           request:(SPTDataLoaderRequest *)request
+                              tags:(nullable NSSet<NSString *> *)tags;
+
+/**
+ Claims the preload of a URL for a request about to be performed
+ @param URL The URL the request is about to be performed against
+ @param finishedHandler Called once the preload finishes when the claim is pending, whether it succeeded or not
+ */
+- (SPTDataLoaderPreloaderClaim)claimPreloadOfURL:(NSURL *)URL finishedHandler:(dispatch_block_t)finishedHandler;
+
+/**
+ Whether a task is the task of a preload
+ @param task The task to look up
+ */
+- (BOOL)handlesTask:(NSURLSessionTask *)task;
+/**
+ Call when the task of a preload received its response
+ @param response The response of the task
+ @param task The task of the preload
+ */
+- (NSURLSessionResponseDisposition)receiveResponse:(NSURLResponse *)response forTask:(NSURLSessionTask *)task;
+/**
+ Call when the task of a preload received data
+ @param data The data the task received
+ @param task The task of the preload
+ */
+- (void)receiveData:(NSData *)data forTask:(NSURLSessionTask *)task;
+/**
+ Call when the task of a preload completed
+ @param error The error the task failed with, if any
+ @param task The task of the preload
+ */
+- (void)completeTask:(NSURLSessionTask *)task error:(nullable NSError *)error;
+
+/**
+ Drops the preloads named by the response to a request
+ @param request The request that was cancelled
+ */
+- (void)cancelPreloadsOfRequest:(SPTDataLoaderRequest *)request;
+/**
+ Drops the preloads carrying a tag
+ @param tag The tag that was cancelled
+ */
+- (void)cancelPreloadsWithTag:(NSString *)tag;
+/**
+ Drops every preload
+ */
+- (void)cancelAllPreloads;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,474 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderPreloader.h"
+
+#import <SPTDataLoader/SPTDataLoaderPreloadPolicy.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderTimeProvider.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderPreloaderSourceIdentifier = @"preload";
+static NSString * const SPTDataLoaderPreloaderHeaderLink = @"Link";
+
+@interface SPTDataLoaderPreloaderEntry : NSObject
+
+@property (nonatomic, strong) SPTDataLoaderRequest *request;
+@property (nonatomic, weak, nullable) SPTDataLoaderRequest *parentRequest;
+@property (nonatomic, copy) NSSet<NSString *> *tags;
+@property (nonatomic, strong, nullable) NSURLSessionTask *task;
+@property (nonatomic, strong, nullable) NSHTTPURLResponse *response;
+@property (nonatomic, strong, nullable) NSMutableData *data;
+@property (nonatomic, assign) int64_t byteCount;
+@property (nonatomic, assign, getter = isLoaded) BOOL loaded;
+@property (nonatomic, assign) CFAbsoluteTime expiryTime;
+@property (nonatomic, strong) NSMutableArray<dispatch_block_t> *finishedHandlers;
+
+@end
+
+@implementation SPTDataLoaderPreloaderEntry
+
+@end
+
+@interface SPTDataLoaderPreloader ()
+
+@property (nonatomic, weak) id<SPTDataLoaderPreloaderDelegate> delegate;
+@property (nonatomic, strong) NSMutableDictionary<NSURL *, SPTDataLoaderPreloaderEntry *> *entriesByURL;
+@property (nonatomic, strong) NSMapTable<NSURLSessionTask *, SPTDataLoaderPreloaderEntry *> *entriesByTask;
+@property (nonatomic, strong) SPTDataLoaderLock *lock;
+
+@end
+
+@implementation SPTDataLoaderPreloader
+
+@synthesize policy = _policy;
+
++ (instancetype)preloaderWithTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                                 delegate:(id<SPTDataLoaderPreloaderDelegate>)delegate
+{
+    return [[self alloc] initWithTimeProvider:timeProvider delegate:delegate];
+}
+
+- (instancetype)initWithTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                            delegate:(id<SPTDataLoaderPreloaderDelegate>)delegate
+{
+    self = [super init];
+    if (self) {
+        _timeProvider = timeProvider;
+        _delegate = delegate;
+        _entriesByURL = [NSMutableDictionary new];
+        _entriesByTask = [NSMapTable strongToStrongObjectsMapTable];
+        _lock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderPreloader"];
+    }
+
+    return self;
+}
+
+- (nullable SPTDataLoaderPreloadPolicy *)policy
+{
+    [self.lock lock];
+    SPTDataLoaderPreloadPolicy *policy = _policy;
+    [self.lock unlock];
+    return policy;
+}
+
+- (void)setPolicy:(nullable SPTDataLoaderPreloadPolicy *)policy
+{
+    SPTDataLoaderPreloadPolicy *policyCopy = [policy copy];
+    [self.lock lock];
+    _policy = policyCopy;
+    [self.lock unlock];
+
+    if (policyCopy == nil) {
+        [self cancelAllPreloads];
+    }
+}
+
+#pragma mark Parsing
+
++ (NSArray<NSURL *> *)preloadURLsInResponse:(NSHTTPURLResponse *)response
+{
+    NSString *linkHeader = response.allHeaderFields[SPTDataLoaderPreloaderHeaderLink];
+    if (linkHeader.length == 0) {
+        return @[];
+    }
+
+    NSMutableArray<NSURL *> *URLs = [NSMutableArray new];
+    for (NSString *linkValue in [self linkValuesInHeader:(NSString * _Nonnull)linkHeader]) {
+        NSURL *URL = [self preloadURLInLinkValue:linkValue baseURL:response.URL];
+        if (URL != nil && ![URLs containsObject:(NSURL * _Nonnull)URL]) {
+            [URLs addObject:(NSURL * _Nonnull)URL];
+        }
+    }
+    return URLs;
+}
+
++ (NSArray<NSString *> *)linkValuesInHeader:(NSString *)header
+{
+    // Link values are separated by commas, which may also appear within the URI reference or a quoted parameter
+    NSMutableArray<NSString *> *linkValues = [NSMutableArray new];
+    NSUInteger valueStart = 0;
+    BOOL inReference = NO;
+    BOOL inQuotes = NO;
+    for (NSUInteger i = 0; i < header.length; ++i) {
+        unichar character = [header characterAtIndex:i];
+        if (character == '"' && !inReference) {
+            inQuotes = !inQuotes;
+        } else if (character == '<' && !inQuotes) {
+            inReference = YES;
+        } else if (character == '>' && !inQuotes) {
+            inReference = NO;
+        } else if (character == ',' && !inQuotes && !inReference) {
+            [linkValues addObject:[header substringWithRange:NSMakeRange(valueStart, i - valueStart)]];
+            valueStart = i + 1;
+        }
+    }
+    [linkValues addObject:[header substringFromIndex:valueStart]];
+    return linkValues;
+}
+
++ (nullable NSURL *)preloadURLInLinkValue:(NSString *)linkValue baseURL:(nullable NSURL *)baseURL
+{
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    NSString *trimmedValue = [linkValue stringByTrimmingCharactersInSet:whitespace];
+    NSRange referenceEnd = [trimmedValue rangeOfString:@">"];
+    if (![trimmedValue hasPrefix:@"<"] || referenceEnd.location == NSNotFound) {
+        return nil;
+    }
+
+    BOOL preload = NO;
+    NSString *parameters = [trimmedValue substringFromIndex:NSMaxRange(referenceEnd)];
+    for (NSString *parameter in [parameters componentsSeparatedByString:@";"]) {
+        NSRange separator = [parameter rangeOfString:@"="];
+        if (separator.location == NSNotFound) {
+            continue;
+        }
+        NSString *name = [[parameter substringToIndex:separator.location] stringByTrimmingCharactersInSet:whitespace];
+        if ([name caseInsensitiveCompare:@"rel"] != NSOrderedSame) {
+            continue;
+        }
+        NSString *value = [[parameter substringFromIndex:NSMaxRange(separator)] stringByTrimmingCharactersInSet:whitespace];
+        value = [value stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\""]];
+        // A rel may carry several relation types separated by spaces
+        for (NSString *relationType in [value componentsSeparatedByCharactersInSet:whitespace]) {
+            preload = preload || [relationType caseInsensitiveCompare:@"preload"] == NSOrderedSame;
+        }
+    }
+    if (!preload) {
+        return nil;
+    }
+
+    NSString *reference = [trimmedValue substringWithRange:NSMakeRange(1, referenceEnd.location - 1)];
+    NSURL *URL = [NSURL URLWithString:reference relativeToURL:baseURL].absoluteURL;
+    NSString *scheme = URL.scheme.lowercaseString;
+    if (URL.host == nil || !([scheme isEqualToString:@"https"] || [scheme isEqualToString:@"http"])) {
+        return nil;
+    }
+    return URL;
+}
+
+#pragma mark Preloading
+
+- (void)preloadResourcesOfResponse:(NSHTTPURLResponse *)response
+                           request:(SPTDataLoaderRequest *)request
+                              tags:(nullable NSSet<NSString *> *)tags
+{
+    SPTDataLoaderPreloadPolicy *policy = self.policy;
+    if (policy == nil) {
+        return;
+    }
+    NSArray<NSURL *> *URLs = [self.class preloadURLsInResponse:response];
+    if (URLs.count == 0) {
+        return;
+    }
+
+    NSMutableArray<SPTDataLoaderPreloaderEntry *> *entries = [NSMutableArray new];
+    [self.lock lock];
+    [self lockedRemoveExpiredEntries];
+    for (NSURL *URL in URLs) {
+        if ([URL isEqual:response.URL] || self.entriesByURL[URL] != nil) {
+            continue;
+        }
+        BOOL sameHost = [self.class host:URL.host matchesHost:response.URL.host];
+        if (!sameHost && ![self.class host:URL.host matchesHosts:policy.allowedHosts]) {
+            continue;
+        }
+        if ([self lockedInFlightCount] >= policy.maximumConcurrentPreloads || [self lockedByteCount] >= policy.maximumBytes) {
+            break;
+        }
+
+        SPTDataLoaderRequest *preloadRequest = [SPTDataLoaderRequest requestWithURL:URL
+                                                                   sourceIdentifier:SPTDataLoaderPreloaderSourceIdentifier];
+        preloadRequest.priority = NSURLSessionTaskPriorityLow;
+        preloadRequest.tags = tags ?: [NSSet set];
+        if (sameHost) {
+            // Authorisation and other headers only go along to the host they were meant for
+            NSDictionary<NSString *, NSString *> *headers = request.headers;
+            for (NSString *header in headers) {
+                [preloadRequest addValue:headers[header] forHeader:header];
+            }
+        }
+
+        SPTDataLoaderPreloaderEntry *entry = [SPTDataLoaderPreloaderEntry new];
+        entry.request = preloadRequest;
+        entry.parentRequest = request;
+        entry.tags = preloadRequest.tags;
+        entry.finishedHandlers = [NSMutableArray new];
+        self.entriesByURL[URL] = entry;
+        [entries addObject:entry];
+    }
+    [self.lock unlock];
+
+    // Creating the tasks calls into the service, so it happens outside the lock
+    for (SPTDataLoaderPreloaderEntry *entry in entries) {
+        [self startEntry:entry];
+    }
+}
+
+- (void)startEntry:(SPTDataLoaderPreloaderEntry *)entry
+{
+    NSURLSessionTask *task = [self.delegate preloader:self taskForRequest:entry.request];
+    NSURL *URL = (NSURL * _Nonnull)entry.request.URL;
+
+    NSArray<dispatch_block_t> *finishedHandlers = nil;
+    [self.lock lock];
+    BOOL wanted = self.entriesByURL[URL] == entry;
+    if (wanted && task != nil) {
+        entry.task = task;
+        [self.entriesByTask setObject:entry forKey:(NSURLSessionTask * _Nonnull)task];
+    } else if (wanted) {
+        [self.entriesByURL removeObjectForKey:URL];
+        finishedHandlers = [entry.finishedHandlers copy];
+        [entry.finishedHandlers removeAllObjects];
+    }
+    [self.lock unlock];
+
+    if (wanted) {
+        [task resume];
+    } else {
+        // Cancelled while the task was being created, cancelling it lets the session account for it
+        [task cancel];
+    }
+    for (dispatch_block_t finishedHandler in finishedHandlers) {
+        finishedHandler();
+    }
+}
+
+- (SPTDataLoaderPreloaderClaim)claimPreloadOfURL:(NSURL *)URL finishedHandler:(dispatch_block_t)finishedHandler
+{
+    SPTDataLoaderPreloaderClaim claim = SPTDataLoaderPreloaderClaimNone;
+    [self.lock lock];
+    [self lockedRemoveExpiredEntries];
+    SPTDataLoaderPreloaderEntry *entry = self.entriesByURL[URL];
+    if (entry.loaded) {
+        [self.entriesByURL removeObjectForKey:URL];
+        claim = SPTDataLoaderPreloaderClaimLoaded;
+    } else if (entry != nil) {
+        [entry.finishedHandlers addObject:[finishedHandler copy]];
+        claim = SPTDataLoaderPreloaderClaimPending;
+    }
+    [self.lock unlock];
+    return claim;
+}
+
+#pragma mark Tasks
+
+- (BOOL)handlesTask:(NSURLSessionTask *)task
+{
+    [self.lock lock];
+    BOOL handlesTask = [self.entriesByTask objectForKey:task] != nil;
+    [self.lock unlock];
+    return handlesTask;
+}
+
+- (NSURLSessionResponseDisposition)receiveResponse:(NSURLResponse *)response forTask:(NSURLSessionTask *)task
+{
+    NSHTTPURLResponse *httpResponse = [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+    // Only a successful response is worth keeping for the request that is going to ask for it
+    if (httpResponse == nil || httpResponse.statusCode < 200 || httpResponse.statusCode >= 300) {
+        return NSURLSessionResponseCancel;
+    }
+
+    const int64_t maximumBytes = self.policy.maximumBytes;
+    [self.lock lock];
+    SPTDataLoaderPreloaderEntry *entry = [self.entriesByTask objectForKey:task];
+    entry.response = httpResponse;
+    const int64_t expectedLength = MAX(httpResponse.expectedContentLength, 0);
+    BOOL withinBudget = entry != nil && [self lockedByteCount] + expectedLength <= maximumBytes;
+    [self.lock unlock];
+
+    return withinBudget ? NSURLSessionResponseAllow : NSURLSessionResponseCancel;
+}
+
+- (void)receiveData:(NSData *)data forTask:(NSURLSessionTask *)task
+{
+    const int64_t maximumBytes = self.policy.maximumBytes;
+    [self.lock lock];
+    SPTDataLoaderPreloaderEntry *entry = [self.entriesByTask objectForKey:task];
+    entry.byteCount += (int64_t)data.length;
+    BOOL withinBudget = entry != nil && [self lockedByteCount] <= maximumBytes;
+    if (withinBudget) {
+        if (entry.data == nil) {
+            entry.data = [data mutableCopy];
+        } else {
+            [entry.data appendData:data];
+        }
+    } else {
+        entry.data = nil;
+    }
+    [self.lock unlock];
+
+    if (!withinBudget) {
+        [task cancel];
+    }
+}
+
+- (void)completeTask:(NSURLSessionTask *)task error:(nullable NSError *)error
+{
+    const NSTimeInterval timeToLive = self.policy.timeToLive;
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+
+    [self.lock lock];
+    SPTDataLoaderPreloaderEntry *entry = [self.entriesByTask objectForKey:task];
+    if (entry == nil) {
+        [self.lock unlock];
+        return;
+    }
+    [self.entriesByTask removeObjectForKey:task];
+    entry.task = nil;
+
+    NSURL *URL = (NSURL * _Nonnull)entry.request.URL;
+    NSHTTPURLResponse *response = entry.response;
+    NSData *data = entry.data ?: [NSData data];
+    BOOL loaded = error == nil && response != nil && timeToLive > 0.0 && self.entriesByURL[URL] == entry;
+    if (loaded) {
+        // The body now lives in the URL cache, it still counts against the budget until it is claimed or expires
+        entry.loaded = YES;
+        entry.expiryTime = currentTime + timeToLive;
+    } else if (self.entriesByURL[URL] == entry) {
+        [self.entriesByURL removeObjectForKey:URL];
+    }
+    entry.data = nil;
+    NSArray<dispatch_block_t> *finishedHandlers = [entry.finishedHandlers copy];
+    [entry.finishedHandlers removeAllObjects];
+    [self.lock unlock];
+
+    // The response must be in the cache before the requests waiting for it go looking
+    if (loaded) {
+        [self.delegate preloader:self
+              didPreloadResponse:(NSHTTPURLResponse * _Nonnull)response
+                            data:data
+                      forRequest:entry.request
+                            task:task];
+    }
+    for (dispatch_block_t finishedHandler in finishedHandlers) {
+        finishedHandler();
+    }
+}
+
+#pragma mark Cancelling
+
+- (void)cancelPreloadsOfRequest:(SPTDataLoaderRequest *)request
+{
+    [self cancelPreloadsPassingTest:^BOOL(SPTDataLoaderPreloaderEntry *entry) {
+        return entry.parentRequest == request;
+    }];
+}
+
+- (void)cancelPreloadsWithTag:(NSString *)tag
+{
+    [self cancelPreloadsPassingTest:^BOOL(SPTDataLoaderPreloaderEntry *entry) {
+        return [entry.tags containsObject:tag];
+    }];
+}
+
+- (void)cancelAllPreloads
+{
+    [self cancelPreloadsPassingTest:^BOOL(SPTDataLoaderPreloaderEntry *entry) {
+        return entry != nil;
+    }];
+}
+
+- (void)cancelPreloadsPassingTest:(BOOL (^)(SPTDataLoaderPreloaderEntry *entry))test
+{
+    NSMutableArray<NSURLSessionTask *> *tasks = [NSMutableArray new];
+    NSMutableArray<dispatch_block_t> *finishedHandlers = [NSMutableArray new];
+    [self.lock lock];
+    for (NSURL *URL in self.entriesByURL.allKeys) {
+        SPTDataLoaderPreloaderEntry *entry = self.entriesByURL[URL];
+        if (!test(entry)) {
+            continue;
+        }
+        [self.entriesByURL removeObjectForKey:URL];
+        if (entry.task != nil) {
+            // The requests waiting for the preload are let go once its task completes
+            [tasks addObject:(NSURLSessionTask * _Nonnull)entry.task];
+        } else {
+            [finishedHandlers addObjectsFromArray:entry.finishedHandlers];
+            [entry.finishedHandlers removeAllObjects];
+        }
+    }
+    [self.lock unlock];
+
+    for (NSURLSessionTask *task in tasks) {
+        [task cancel];
+    }
+    for (dispatch_block_t finishedHandler in finishedHandlers) {
+        finishedHandler();
+    }
+}
+
+#pragma mark Bookkeeping
+
+- (NSUInteger)lockedInFlightCount
+{
+    NSUInteger inFlightCount = 0;
+    for (SPTDataLoaderPreloaderEntry *entry in self.entriesByURL.objectEnumerator) {
+        inFlightCount += entry.loaded ? 0 : 1;
+    }
+    return inFlightCount;
+}
+
+- (int64_t)lockedByteCount
+{
+    int64_t byteCount = 0;
+    for (SPTDataLoaderPreloaderEntry *entry in self.entriesByURL.objectEnumerator) {
+        byteCount += entry.byteCount;
+    }
+    return byteCount;
+}
+
+- (void)lockedRemoveExpiredEntries
+{
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    for (NSURL *URL in self.entriesByURL.allKeys) {
+        SPTDataLoaderPreloaderEntry *entry = self.entriesByURL[URL];
+        if (entry.loaded && entry.expiryTime <= currentTime) {
+            [self.entriesByURL removeObjectForKey:URL];
+        }
+    }
+}
+
++ (BOOL)host:(nullable NSString *)host matchesHost:(nullable NSString *)otherHost
+{
+    return host != nil && otherHost != nil && [host caseInsensitiveCompare:(NSString * _Nonnull)otherHost] == NSOrderedSame;
+}
+
++ (BOOL)host:(nullable NSString *)host matchesHosts:(NSSet<NSString *> *)hosts
+{
+    for (NSString *otherHost in hosts) {
+        if ([self host:host matchesHost:otherHost]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -5,6 +5,7 @@
 
 #import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
 
+@class SPTDataLoaderResponse;
 @protocol SPTDataLoaderTimeProvider;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -16,6 +17,34 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
 
+/**
+ The key the requests to a URL are grouped under, made up of its scheme, host and first path component
+ @param URL The URL to find the service of
+ */
++ (NSString *)serviceKeyFromURL:(nullable NSURL *)URL;
+
+/**
+ Takes a place for a request among the requests in flight to its service
+ @param request The request about to be sent
+ @param waiter The block to call once a place has been taken for the request, if there is none right now
+ @return Whether the request may be sent right away, if not the waiter is called later
+ */
+- (BOOL)acquireConcurrencyForRequest:(SPTDataLoaderRequest *)request waiter:(dispatch_block_t)waiter;
+/**
+ Gives back the place of a request that has been answered, adapting the limit to the answer
+ @param request The request that has been answered
+ @param roundTripTime The time between the request being sent and it completing
+ @param response The response the request completed with
+ */
+- (void)releaseConcurrencyForRequest:(SPTDataLoaderRequest *)request
+                       roundTripTime:(NSTimeInterval)roundTripTime
+                            response:(SPTDataLoaderResponse *)response;
+/**
+ Gives back the place of a request, or stops it from waiting for one, without adapting the limit
+ @param request The request that has been cancelled
+ */
+- (void)abandonConcurrencyForRequest:(SPTDataLoaderRequest *)request;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -6,11 +6,129 @@
 #import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
 
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
 
+#import "SPTDataLoaderConcurrencyLimit+Private.h"
+#import "SPTDataLoaderLock.h"
 #import "SPTDataLoaderTimeProviderImplementation.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ The adaptive concurrency state of a single service
+ */
+@interface SPTDataLoaderAdaptiveConcurrency : NSObject
+
+@property (nonatomic, copy) NSString *service;
+@property (nonatomic, assign) double limit;
+@property (nonatomic, assign) double maximumLimit;
+@property (nonatomic, assign) BOOL slowStart;
+@property (nonatomic, assign) NSTimeInterval baselineRoundTripTime;
+@property (nonatomic, assign) NSTimeInterval smoothedRoundTripTime;
+@property (nonatomic, assign) CFAbsoluteTime lastDecreaseTime;
+@property (nonatomic, assign) NSUInteger congestionSignalCount;
+@property (nonatomic, assign) NSUInteger decreaseCount;
+@property (nonatomic, strong) NSHashTable<SPTDataLoaderRequest *> *inFlightRequests;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderRequest *> *queuedRequests;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, dispatch_block_t> *waiters;
+
+@end
+
+@implementation SPTDataLoaderAdaptiveConcurrency
+
+- (instancetype)initWithService:(NSString *)service initialLimit:(NSUInteger)initialLimit maximumLimit:(NSUInteger)maximumLimit
+{
+    const NSPointerFunctionsOptions SPTDataLoaderAdaptiveConcurrencyRequestOptions = NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality;
+
+    self = [super init];
+    if (self) {
+        _service = [service copy];
+        _maximumLimit = MAX(maximumLimit, 1u);
+        _limit = MIN(MAX(initialLimit, 1u), _maximumLimit);
+        _slowStart = YES;
+        _lastDecreaseTime = -DBL_MAX;
+        _inFlightRequests = [NSHashTable hashTableWithOptions:SPTDataLoaderAdaptiveConcurrencyRequestOptions];
+        _queuedRequests = [NSMutableArray new];
+        _waiters = [[NSMapTable alloc] initWithKeyOptions:SPTDataLoaderAdaptiveConcurrencyRequestOptions
+                                             valueOptions:NSPointerFunctionsStrongMemory
+                                                 capacity:0];
+    }
+    return self;
+}
+
+- (NSUInteger)currentLimit
+{
+    return MAX((NSUInteger)self.limit, 1u);
+}
+
+- (void)recordRoundTripTime:(NSTimeInterval)roundTripTime
+                  congested:(BOOL)congested
+                  tolerance:(double)tolerance
+                currentTime:(CFAbsoluteTime)currentTime
+{
+    const double SPTDataLoaderAdaptiveConcurrencySmoothingFactor = 0.2;
+    const double SPTDataLoaderAdaptiveConcurrencyBaselineDrift = 0.01;
+    const double SPTDataLoaderAdaptiveConcurrencyDecreaseFactor = 0.5;
+
+    if (congested) {
+        self.congestionSignalCount++;
+    } else {
+        // Only answers the service had time to give count towards its round-trip time, fast rejections would skew it
+        self.smoothedRoundTripTime = self.smoothedRoundTripTime > 0.0
+            ? self.smoothedRoundTripTime + (roundTripTime - self.smoothedRoundTripTime) * SPTDataLoaderAdaptiveConcurrencySmoothingFactor
+            : roundTripTime;
+        self.baselineRoundTripTime = self.baselineRoundTripTime > 0.0 ? MIN(self.baselineRoundTripTime, roundTripTime) : roundTripTime;
+        // Let the baseline follow lasting changes of the route, so a slower path does not pin the limit to its floor
+        self.baselineRoundTripTime += (self.smoothedRoundTripTime - self.baselineRoundTripTime) * SPTDataLoaderAdaptiveConcurrencyBaselineDrift;
+    }
+
+    BOOL latencyGrew = self.smoothedRoundTripTime > self.baselineRoundTripTime * tolerance;
+    if (congested || latencyGrew) {
+        // The requests in flight when congestion set in all report it, the limit is only cut once per round-trip
+        if (currentTime - self.lastDecreaseTime >= MAX(self.smoothedRoundTripTime, roundTripTime)) {
+            self.limit = MAX(self.limit * SPTDataLoaderAdaptiveConcurrencyDecreaseFactor, 1.0);
+            self.lastDecreaseTime = currentTime;
+            self.decreaseCount++;
+            self.slowStart = NO;
+        }
+    } else if (self.inFlightRequests.count >= self.currentLimit) {
+        // Only a limit that is used up says anything about whether the service could take more
+        self.limit = MIN(self.limit + (self.slowStart ? 1.0 : 1.0 / self.limit), self.maximumLimit);
+    }
+}
+
+- (NSArray<dispatch_block_t> *)dequeueWaitersIgnoringLimit:(BOOL)ignoringLimit
+{
+    NSMutableArray<dispatch_block_t> *waiters = [NSMutableArray new];
+    while (self.queuedRequests.count > 0 && (ignoringLimit || self.inFlightRequests.count < self.currentLimit)) {
+        SPTDataLoaderRequest *request = self.queuedRequests.firstObject;
+        [self.queuedRequests removeObjectAtIndex:0];
+        dispatch_block_t waiter = [self.waiters objectForKey:request];
+        [self.waiters removeObjectForKey:request];
+        [self.inFlightRequests addObject:request];
+        if (waiter != nil) {
+            [waiters addObject:waiter];
+        }
+    }
+    return waiters;
+}
+
+- (SPTDataLoaderConcurrencyLimit *)snapshot
+{
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = [SPTDataLoaderConcurrencyLimit new];
+    concurrencyLimit.service = self.service;
+    concurrencyLimit.limit = self.currentLimit;
+    concurrencyLimit.inFlightCount = self.inFlightRequests.count;
+    concurrencyLimit.queuedCount = self.queuedRequests.count;
+    concurrencyLimit.baselineRoundTripTime = self.baselineRoundTripTime;
+    concurrencyLimit.smoothedRoundTripTime = self.smoothedRoundTripTime;
+    concurrencyLimit.congestionSignalCount = self.congestionSignalCount;
+    concurrencyLimit.decreaseCount = self.decreaseCount;
+    return concurrencyLimit;
+}
+
+@end
+
 @interface SPTDataLoaderRateLimiter ()
 
 @property (nonatomic, assign) double requestsPerSecond;
@@ -19,6 +137,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *serviceEndpointRequestsPerSecond;
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *serviceEndpointLastExecution;
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *serviceEndpointRetryAt;
+@property (nonatomic, strong) SPTDataLoaderLock *serviceEndpointLock;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, SPTDataLoaderAdaptiveConcurrency *> *serviceEndpointConcurrency;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, SPTDataLoaderAdaptiveConcurrency *> *requestConcurrency;
+@property (nonatomic, strong) SPTDataLoaderLock *concurrencyLock;
 
 @end
 
@@ -36,6 +158,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithDefaultRequestsPerSecond:(double)requestsPerSecond
                                     timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
+    const NSUInteger SPTDataLoaderRateLimiterDefaultInitialConcurrencyLimit = 4;
+    const NSUInteger SPTDataLoaderRateLimiterDefaultMaximumConcurrencyLimit = 64;
+    const double SPTDataLoaderRateLimiterDefaultConcurrencyLatencyTolerance = 2.0;
+
     self = [super init];
     if (self) {
         _requestsPerSecond = requestsPerSecond;
@@ -43,6 +169,15 @@ NS_ASSUME_NONNULL_BEGIN
         _serviceEndpointRequestsPerSecond = [NSMutableDictionary new];
         _serviceEndpointLastExecution = [NSMutableDictionary new];
         _serviceEndpointRetryAt = [NSMutableDictionary new];
+        _serviceEndpointLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderRateLimiter.serviceEndpoint"];
+        _serviceEndpointConcurrency = [NSMutableDictionary new];
+        _requestConcurrency = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                        valueOptions:NSPointerFunctionsStrongMemory
+                                                            capacity:0];
+        _concurrencyLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderRateLimiter.concurrency"];
+        _initialConcurrencyLimit = SPTDataLoaderRateLimiterDefaultInitialConcurrencyLimit;
+        _maximumConcurrencyLimit = SPTDataLoaderRateLimiterDefaultMaximumConcurrencyLimit;
+        _concurrencyLatencyTolerance = SPTDataLoaderRateLimiterDefaultConcurrencyLatencyTolerance;
     }
 
     return self;
@@ -50,24 +185,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSTimeInterval)earliestTimeUntilRequestCanBeExecuted:(SPTDataLoaderRequest *)request
 {
-    NSString *serviceKey = [self serviceKeyFromURL:request.URL];
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:request.URL];
 
     // First check if we are not accepting requests until a certain time (i.e. Retry-after header)
     CFAbsoluteTime currentTime = self.timeProvider.currentTime;
     CFAbsoluteTime retryAtTime = 0.0;
-    @synchronized(self.serviceEndpointRetryAt) {
-        retryAtTime = [self.serviceEndpointRetryAt[serviceKey] doubleValue];
-    }
+    double requestsPerSecond = 0.0;
+    CFAbsoluteTime lastExecution = 0.0;
+    [self.serviceEndpointLock lock];
+    retryAtTime = [self.serviceEndpointRetryAt[serviceKey] doubleValue];
+    requestsPerSecond = [self lockedRequestsPerSecondForServiceKey:serviceKey];
+    lastExecution = [self.serviceEndpointLastExecution[serviceKey] doubleValue];
+    [self.serviceEndpointLock unlock];
     if (currentTime < retryAtTime) {
         return retryAtTime - currentTime;
     }
 
     // Next check that our rate limit is being respected
-    double requestsPerSecond = [self requestsPerSecondForServiceKey:serviceKey];
-    CFAbsoluteTime lastExecution = 0.0;
-    @synchronized(self.serviceEndpointLastExecution) {
-        lastExecution = [self.serviceEndpointLastExecution[serviceKey] doubleValue];
-    }
     CFAbsoluteTime deltaTime = currentTime - lastExecution;
     if (deltaTime < 0) {
         // If currentTime < lastExecution the system clock must have been moved backwards
@@ -85,29 +219,29 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)executedRequest:(SPTDataLoaderRequest *)request
 {
-    NSString *serviceKey = [self serviceKeyFromURL:request.URL];
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:request.URL];
     if (!serviceKey) {
         return;
     }
 
-    @synchronized(self.serviceEndpointLastExecution) {
-        self.serviceEndpointLastExecution[serviceKey] = @(self.timeProvider.currentTime);
-    }
-    @synchronized(self.serviceEndpointRetryAt) {
-        [self.serviceEndpointRetryAt removeObjectForKey:serviceKey];
-    }
+    NSNumber *currentTime = @(self.timeProvider.currentTime);
+    [self.serviceEndpointLock lock];
+    self.serviceEndpointLastExecution[serviceKey] = currentTime;
+    [self.serviceEndpointRetryAt removeObjectForKey:serviceKey];
+    [self.serviceEndpointLock unlock];
 }
 
 - (double)requestsPerSecondForURL:(NSURL *)URL
 {
-    return [self requestsPerSecondForServiceKey:[self serviceKeyFromURL:URL]];
+    return [self requestsPerSecondForServiceKey:[SPTDataLoaderRateLimiter serviceKeyFromURL:URL]];
 }
 
 - (void)setRequestsPerSecond:(double)requestsPerSecond forURL:(NSURL *)URL
 {
-    @synchronized(self.serviceEndpointRequestsPerSecond) {
-        self.serviceEndpointRequestsPerSecond[[self serviceKeyFromURL:URL]] = @(requestsPerSecond);
-    }
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:URL];
+    [self.serviceEndpointLock lock];
+    self.serviceEndpointRequestsPerSecond[serviceKey] = @(requestsPerSecond);
+    [self.serviceEndpointLock unlock];
 }
 
 - (void)setRetryAfter:(NSTimeInterval)absoluteTime forURL:(NSURL *)URL
@@ -116,20 +250,156 @@ NS_ASSUME_NONNULL_BEGIN
         return;
     }
 
-    @synchronized(self.serviceEndpointRetryAt) {
-        self.serviceEndpointRetryAt[[self serviceKeyFromURL:URL]] = @(absoluteTime);
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:URL];
+    [self.serviceEndpointLock lock];
+    self.serviceEndpointRetryAt[serviceKey] = @(absoluteTime);
+    [self.serviceEndpointLock unlock];
+}
+
+- (void)setAdaptiveConcurrency:(BOOL)adaptiveConcurrency forURL:(NSURL *)URL
+{
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:URL];
+    NSArray<dispatch_block_t> *waiters = nil;
+    [self.concurrencyLock lock];
+    SPTDataLoaderAdaptiveConcurrency *concurrency = self.serviceEndpointConcurrency[serviceKey];
+    if (adaptiveConcurrency) {
+        if (concurrency == nil) {
+            self.serviceEndpointConcurrency[serviceKey] = [[SPTDataLoaderAdaptiveConcurrency alloc] initWithService:serviceKey
+                                                                                                        initialLimit:self.initialConcurrencyLimit
+                                                                                                        maximumLimit:self.maximumConcurrencyLimit];
+        }
+    } else {
+        // The requests waiting for a place are let through, those in flight still give theirs back when they complete
+        [self.serviceEndpointConcurrency removeObjectForKey:serviceKey];
+        waiters = [concurrency dequeueWaitersIgnoringLimit:YES];
+    }
+    [self.concurrencyLock unlock];
+    for (dispatch_block_t waiter in waiters) {
+        waiter();
     }
 }
 
-- (double)requestsPerSecondForServiceKey:(NSString *)serviceKey
+- (BOOL)adaptiveConcurrencyForURL:(NSURL *)URL
+{
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:URL];
+    BOOL adaptiveConcurrency = NO;
+    [self.concurrencyLock lock];
+    adaptiveConcurrency = self.serviceEndpointConcurrency[serviceKey] != nil;
+    [self.concurrencyLock unlock];
+    return adaptiveConcurrency;
+}
+
+- (nullable SPTDataLoaderConcurrencyLimit *)concurrencyLimitForURL:(NSURL *)URL
 {
-    @synchronized(self.serviceEndpointRequestsPerSecond) {
-        NSNumber *value = self.serviceEndpointRequestsPerSecond[serviceKey];
-        return (value != nil) ? value.doubleValue : self.requestsPerSecond;
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:URL];
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = nil;
+    [self.concurrencyLock lock];
+    concurrencyLimit = [self.serviceEndpointConcurrency[serviceKey] snapshot];
+    [self.concurrencyLock unlock];
+    return concurrencyLimit;
+}
+
+- (BOOL)acquireConcurrencyForRequest:(SPTDataLoaderRequest *)request waiter:(dispatch_block_t)waiter
+{
+    NSString *serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:request.URL];
+    dispatch_block_t copiedWaiter = [waiter copy];
+    BOOL acquired = YES;
+    [self.concurrencyLock lock];
+    SPTDataLoaderAdaptiveConcurrency *concurrency = self.serviceEndpointConcurrency[serviceKey];
+    if (concurrency != nil && ![concurrency.inFlightRequests containsObject:request]) {
+        [self.requestConcurrency setObject:concurrency forKey:request];
+        if (concurrency.queuedRequests.count == 0 && concurrency.inFlightRequests.count < concurrency.currentLimit) {
+            [concurrency.inFlightRequests addObject:request];
+        } else {
+            if ([concurrency.waiters objectForKey:request] == nil) {
+                [concurrency.queuedRequests addObject:request];
+            }
+            [concurrency.waiters setObject:copiedWaiter forKey:request];
+            acquired = NO;
+        }
+    }
+    [self.concurrencyLock unlock];
+    return acquired;
+}
+
+- (void)releaseConcurrencyForRequest:(SPTDataLoaderRequest *)request
+                       roundTripTime:(NSTimeInterval)roundTripTime
+                            response:(SPTDataLoaderResponse *)response
+{
+    BOOL congested = [self.class isCongestionResponse:response];
+    BOOL sampled = congested || response.statusCode != 0;
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    NSArray<dispatch_block_t> *waiters = nil;
+    [self.concurrencyLock lock];
+    SPTDataLoaderAdaptiveConcurrency *concurrency = [self.requestConcurrency objectForKey:request];
+    if (concurrency != nil) {
+        if (sampled && [concurrency.inFlightRequests containsObject:request]) {
+            [concurrency recordRoundTripTime:roundTripTime
+                                   congested:congested
+                                   tolerance:self.concurrencyLatencyTolerance
+                                 currentTime:currentTime];
+        }
+        waiters = [self removeRequest:request fromConcurrency:concurrency];
     }
+    [self.concurrencyLock unlock];
+    for (dispatch_block_t waiter in waiters) {
+        waiter();
+    }
+}
+
+- (void)abandonConcurrencyForRequest:(SPTDataLoaderRequest *)request
+{
+    NSArray<dispatch_block_t> *waiters = nil;
+    [self.concurrencyLock lock];
+    SPTDataLoaderAdaptiveConcurrency *concurrency = [self.requestConcurrency objectForKey:request];
+    if (concurrency != nil) {
+        waiters = [self removeRequest:request fromConcurrency:concurrency];
+    }
+    [self.concurrencyLock unlock];
+    for (dispatch_block_t waiter in waiters) {
+        waiter();
+    }
+}
+
+- (NSArray<dispatch_block_t> *)removeRequest:(SPTDataLoaderRequest *)request
+                             fromConcurrency:(SPTDataLoaderAdaptiveConcurrency *)concurrency
+{
+    [self.requestConcurrency removeObjectForKey:request];
+    [concurrency.inFlightRequests removeObject:request];
+    [concurrency.queuedRequests removeObjectIdenticalTo:request];
+    [concurrency.waiters removeObjectForKey:request];
+    return [concurrency dequeueWaitersIgnoringLimit:NO];
+}
+
++ (BOOL)isCongestionResponse:(SPTDataLoaderResponse *)response
+{
+    const NSInteger SPTDataLoaderRateLimiterTooManyRequestsStatusCode = 429;
+
+    if (response.statusCode == SPTDataLoaderRateLimiterTooManyRequestsStatusCode ||
+        response.statusCode == SPTDataLoaderResponseHTTPStatusCodeServiceUnavailable) {
+        return YES;
+    }
+    NSError *error = response.error;
+    return ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorTimedOut) ||
+           ([error.domain isEqualToString:SPTDataLoaderRequestErrorDomain] && error.code == SPTDataLoaderRequestErrorCodeTimeout);
+}
+
+- (double)requestsPerSecondForServiceKey:(NSString *)serviceKey
+{
+    double requestsPerSecond = 0.0;
+    [self.serviceEndpointLock lock];
+    requestsPerSecond = [self lockedRequestsPerSecondForServiceKey:serviceKey];
+    [self.serviceEndpointLock unlock];
+    return requestsPerSecond;
+}
+
+- (double)lockedRequestsPerSecondForServiceKey:(NSString *)serviceKey
+{
+    NSNumber *value = self.serviceEndpointRequestsPerSecond[serviceKey];
+    return (value != nil) ? value.doubleValue : self.requestsPerSecond;
 }
 
-- (NSString *)serviceKeyFromURL:(NSURL *)URL
++ (NSString *)serviceKeyFromURL:(nullable NSURL *)URL
 {
     if (!URL) {
         return @"";
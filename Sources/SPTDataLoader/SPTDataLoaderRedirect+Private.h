@@ -0,0 +1,26 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderRedirect.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderRedirect ()
+
+/**
+ Class constructor
+ @param URL The URL that answered with the redirect
+ @param redirectURL The location the request was redirected to
+ @param statusCode The status code of the redirect
+ @param cached Whether the redirect was remembered from an earlier response
+ */
++ (instancetype)redirectWithURL:(NSURL *)URL
+                    redirectURL:(NSURL *)redirectURL
+                     statusCode:(NSInteger)statusCode
+                         cached:(BOOL)cached;
+
+@end
+
+NS_ASSUME_NONNULL_END
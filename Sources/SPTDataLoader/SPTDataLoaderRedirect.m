@@ -0,0 +1,49 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderRedirect+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SPTDataLoaderRedirect
+
++ (instancetype)redirectWithURL:(NSURL *)URL
+                    redirectURL:(NSURL *)redirectURL
+                     statusCode:(NSInteger)statusCode
+                         cached:(BOOL)cached
+{
+    return [[self alloc] initWithURL:URL redirectURL:redirectURL statusCode:statusCode cached:cached];
+}
+
+- (instancetype)initWithURL:(NSURL *)URL
+                redirectURL:(NSURL *)redirectURL
+                 statusCode:(NSInteger)statusCode
+                     cached:(BOOL)cached
+{
+    self = [super init];
+    if (self) {
+        _URL = URL;
+        _redirectURL = redirectURL;
+        _statusCode = statusCode;
+        _cached = cached;
+    }
+
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p %ld \"%@\" -> \"%@\"; cached = %@>",
+            self.class,
+            (void *)self,
+            (long)self.statusCode,
+            self.URL,
+            self.redirectURL,
+            self.cached ? @"YES" : @"NO"];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
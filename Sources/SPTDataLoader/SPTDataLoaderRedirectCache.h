@@ -0,0 +1,66 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+@class SPTDataLoaderRedirect;
+
+@protocol SPTDataLoaderTimeProvider;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Remembers permanent redirects so that later requests can go to the new location without asking the server first
+ @discussion Redirects are kept per method and URL for as long as their Cache-Control or Expires headers allow, or for
+ a day when they carry neither. A 301 is only kept for GET and HEAD requests, since clients may change the method of
+ other requests when following it, while a 308 is kept for any method. Once the cache is full the least recently used
+ redirect makes room for a new one.
+ */
+@interface SPTDataLoaderRedirectCache : NSObject
+
+/**
+ The clock the freshness of the redirects is measured with
+ */
+@property (nonatomic, strong) id<SPTDataLoaderTimeProvider> timeProvider;
+/**
+ The number of redirects kept at most, 0 keeps none
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ Class constructor
+ @param capacity The number of redirects to keep at most
+ @param timeProvider The clock the freshness of the redirects is measured with
+ */
++ (instancetype)redirectCacheWithCapacity:(NSUInteger)capacity timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider;
+
+/**
+ Remembers a redirect if it is permanent and its headers allow it to be cached
+ @param response The response that redirected the request
+ @param redirectURL The location the response redirected to
+ @param method The method of the redirected request
+ @return Whether the redirect was cached
+ */
+- (BOOL)cacheRedirectResponse:(NSHTTPURLResponse *)response
+                  redirectURL:(NSURL *)redirectURL
+                       method:(SPTDataLoaderRequestMethod)method;
+
+/**
+ The fresh redirect remembered for a URL, if there is one
+ @param URL The URL about to be requested
+ @param method The method it is about to be requested with
+ */
+- (nullable SPTDataLoaderRedirect *)redirectForURL:(NSURL *)URL method:(SPTDataLoaderRequestMethod)method;
+
+/**
+ Forgets every redirect
+ */
+- (void)removeAllRedirects;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,214 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderRedirectCache.h"
+
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderRedirect+Private.h"
+#import "SPTDataLoaderTimeProvider.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderRedirectCacheHeaderCacheControl = @"Cache-Control";
+static NSString * const SPTDataLoaderRedirectCacheHeaderExpires = @"Expires";
+static NSString * const SPTDataLoaderRedirectCacheHeaderDate = @"Date";
+
+@interface SPTDataLoaderRedirectCacheEntry : NSObject
+
+@property (nonatomic, strong) NSURL *redirectURL;
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, assign) CFAbsoluteTime expiryTime;
+
+@end
+
+@implementation SPTDataLoaderRedirectCacheEntry
+
+@end
+
+@interface SPTDataLoaderRedirectCache ()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, SPTDataLoaderRedirectCacheEntry *> *entries;
+// The keys of the entries from the least to the most recently used
+@property (nonatomic, strong) NSMutableOrderedSet<NSString *> *recentKeys;
+@property (nonatomic, strong) SPTDataLoaderLock *lock;
+
+@end
+
+@implementation SPTDataLoaderRedirectCache
+
+@synthesize capacity = _capacity;
+
++ (instancetype)redirectCacheWithCapacity:(NSUInteger)capacity timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+{
+    return [[self alloc] initWithCapacity:capacity timeProvider:timeProvider];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+{
+    self = [super init];
+    if (self) {
+        _capacity = capacity;
+        _timeProvider = timeProvider;
+        _entries = [NSMutableDictionary new];
+        _recentKeys = [NSMutableOrderedSet new];
+        _lock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderRedirectCache"];
+    }
+
+    return self;
+}
+
+- (NSUInteger)capacity
+{
+    [self.lock lock];
+    NSUInteger capacity = _capacity;
+    [self.lock unlock];
+    return capacity;
+}
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    [self.lock lock];
+    _capacity = capacity;
+    [self lockedTrimToCapacity];
+    [self.lock unlock];
+}
+
+- (BOOL)cacheRedirectResponse:(NSHTTPURLResponse *)response
+                  redirectURL:(NSURL *)redirectURL
+                       method:(SPTDataLoaderRequestMethod)method
+{
+    NSURL *URL = response.URL;
+    if (URL == nil || [URL isEqual:redirectURL]) {
+        return NO;
+    }
+
+    BOOL methodPreserved = method == SPTDataLoaderRequestMethodGet || method == SPTDataLoaderRequestMethodHead;
+    BOOL permanent = (response.statusCode == SPTDataLoaderResponseHTTPStatusCodeMovedPermanently && methodPreserved)
+        || response.statusCode == SPTDataLoaderResponseHTTPStatusCodePermanentRedirect;
+    if (!permanent) {
+        return NO;
+    }
+
+    NSTimeInterval lifetime = [self.class lifetimeOfResponse:response];
+    if (lifetime <= 0.0) {
+        return NO;
+    }
+
+    SPTDataLoaderRedirectCacheEntry *entry = [SPTDataLoaderRedirectCacheEntry new];
+    entry.redirectURL = redirectURL;
+    entry.statusCode = response.statusCode;
+    entry.expiryTime = self.timeProvider.currentTime + lifetime;
+
+    NSString *key = [self.class keyForURL:(NSURL * _Nonnull)URL method:method];
+    [self.lock lock];
+    BOOL cached = _capacity > 0;
+    if (cached) {
+        self.entries[key] = entry;
+        [self.recentKeys removeObject:key];
+        [self.recentKeys addObject:key];
+        [self lockedTrimToCapacity];
+    }
+    [self.lock unlock];
+    return cached;
+}
+
+- (nullable SPTDataLoaderRedirect *)redirectForURL:(NSURL *)URL method:(SPTDataLoaderRequestMethod)method
+{
+    NSString *key = [self.class keyForURL:URL method:method];
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+
+    [self.lock lock];
+    SPTDataLoaderRedirectCacheEntry *entry = self.entries[key];
+    if (entry != nil && entry.expiryTime <= currentTime) {
+        [self.entries removeObjectForKey:key];
+        [self.recentKeys removeObject:key];
+        entry = nil;
+    } else if (entry != nil) {
+        [self.recentKeys removeObject:key];
+        [self.recentKeys addObject:key];
+    }
+    [self.lock unlock];
+
+    if (entry == nil) {
+        return nil;
+    }
+
+    return [SPTDataLoaderRedirect redirectWithURL:URL redirectURL:entry.redirectURL statusCode:entry.statusCode cached:YES];
+}
+
+- (void)removeAllRedirects
+{
+    [self.lock lock];
+    [self.entries removeAllObjects];
+    [self.recentKeys removeAllObjects];
+    [self.lock unlock];
+}
+
+- (void)lockedTrimToCapacity
+{
+    while (self.recentKeys.count > _capacity) {
+        NSString *leastRecentKey = self.recentKeys.firstObject;
+        [self.recentKeys removeObjectAtIndex:0];
+        [self.entries removeObjectForKey:(NSString * _Nonnull)leastRecentKey];
+    }
+}
+
++ (NSString *)keyForURL:(NSURL *)URL method:(SPTDataLoaderRequestMethod)method
+{
+    return [NSString stringWithFormat:@"%ld %@", (long)method, URL.absoluteString];
+}
+
++ (NSTimeInterval)lifetimeOfResponse:(NSHTTPURLResponse *)response
+{
+    // Kept as long as a browser would keep a permanent redirect without freshness information, within reason
+    const NSTimeInterval SPTDataLoaderRedirectCacheDefaultLifetime = 24.0 * 60.0 * 60.0;
+
+    NSDictionary *headers = response.allHeaderFields;
+    NSString *cacheControl = headers[SPTDataLoaderRedirectCacheHeaderCacheControl];
+    if (cacheControl != nil) {
+        NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+        for (NSString *component in [cacheControl componentsSeparatedByString:@","]) {
+            NSString *directive = [component stringByTrimmingCharactersInSet:whitespace].lowercaseString;
+            if ([directive isEqualToString:@"no-store"] || [directive isEqualToString:@"no-cache"]) {
+                return 0.0;
+            }
+            if ([directive hasPrefix:@"max-age="]) {
+                return [directive substringFromIndex:@"max-age=".length].doubleValue;
+            }
+        }
+    }
+
+    NSString *expires = headers[SPTDataLoaderRedirectCacheHeaderExpires];
+    if (expires != nil) {
+        NSDate *expiryDate = [[self httpDateFormatter] dateFromString:expires];
+        if (expiryDate == nil) {
+            // An invalid Expires means the response has already expired
+            return 0.0;
+        }
+        NSString *dateHeader = headers[SPTDataLoaderRedirectCacheHeaderDate];
+        NSDate *date = dateHeader != nil ? [[self httpDateFormatter] dateFromString:dateHeader] : nil;
+        return [expiryDate timeIntervalSinceDate:date ?: [NSDate date]];
+    }
+
+    return SPTDataLoaderRedirectCacheDefaultLifetime;
+}
+
++ (NSDateFormatter *)httpDateFormatter
+{
+    static NSDateFormatter *httpDateFormatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        httpDateFormatter = [NSDateFormatter new];
+        httpDateFormatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        [httpDateFormatter setDateFormat:@"EEE, dd MMM yyyy HH:mm:ss zzz"];
+    });
+    return httpDateFormatter;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
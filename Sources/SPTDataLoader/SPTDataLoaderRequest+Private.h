@@ -4,6 +4,7 @@
  */
 
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
 
 @protocol SPTDataLoaderCancellationToken;
 
@@ -27,6 +28,65 @@ NS_ASSUME_NONNULL_BEGIN
  The cancellation token associated with the request
  */
 @property (nonatomic, weak) id<SPTDataLoaderCancellationToken> cancellationToken;
+/**
+ Whether the body or body stream is uploaded compressed
+ */
+@property (nonatomic, assign, readonly) BOOL compressesBody;
+/**
+ Whether the body has to be compressed before the URL request is created
+ */
+@property (nonatomic, assign, readonly) BOOL needsBodyCompression;
+/**
+ The number of bytes the uploaded body had before it was compressed, or 0 if it was uploaded uncompressed
+ */
+@property (atomic, assign, readonly) int64_t uncompressedBodyLength;
+/**
+ The URL the request was made for, set before the service replaces the URL with its resolved address or the target of
+ a cached redirect
+ @warning This is not copied when a copy is performed
+ */
+@property (atomic, strong, nullable) NSURL *originalURL;
+/**
+ The service key the request is traced under, set the first time it is traced
+ @warning This is not copied when a copy is performed
+ */
+@property (atomic, copy, nullable) NSString *traceServiceKey;
+/**
+ The time the service took the request on, or 0 if it has not yet
+ @warning This is not copied when a copy is performed
+ */
+@property (atomic, assign) CFAbsoluteTime serviceEntryTime;
+/**
+ The time by which the request has to complete, or 0 if it has no timeout
+ @discussion This is set from the timeout when a factory starts performing the request, on the clock of the factory
+ @warning This is not copied when a copy is performed
+ */
+@property (atomic, assign) CFAbsoluteTime deadline;
+
+/**
+ Marks a trace phase of the request as begun
+ @param phase The phase that began
+ */
+- (void)openTracePhase:(SPTDataLoaderTracePhase)phase;
+/**
+ Marks a trace phase of the request as ended
+ @param phase The phase that ended
+ @return Whether the phase had begun, ends of phases that never began are not traced
+ */
+- (BOOL)closeTracePhase:(SPTDataLoaderTracePhase)phase;
+/**
+ Compresses the body so that the URL request uploads it compressed
+ @discussion This is expensive for large bodies and should be called off the main thread
+ */
+- (void)compressBody;
+/**
+ Wraps a body stream so that it is compressed as it is read
+ @param bodyStream The unopened body stream
+ @param failureHandler Called when the body stream fails to be read, the compressed stream ends without being finished
+ @return The compressed stream, or the body stream itself if the request does not compress its body
+ */
+- (NSInputStream *)compressedBodyStreamForBodyStream:(NSInputStream *)bodyStream
+                                     failureHandler:(nullable void (^)(NSError *error))failureHandler;
 
 @end
 
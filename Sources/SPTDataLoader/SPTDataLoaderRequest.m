@@ -6,20 +6,36 @@
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 
 #import "SPTDataLoaderRequest+Private.h"
+#import "SPTDataLoaderBodyCompressor.h"
+#import "SPTDataLoaderLock.h"
+
+#include <stdatomic.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
 NSString * const SPTDataLoaderRequestErrorDomain = @"com.spotify.dataloader.request";
 
+static NSString * const SPTDataLoaderRequestContentEncodingHeader = @"Content-Encoding";
+
 static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMethod requestMethod);
 
-@interface SPTDataLoaderRequest ()
+@interface SPTDataLoaderRequest () {
+    _Atomic(uint32_t) _openTracePhases;
+}
 
 @property (nonatomic, assign, readwrite) int64_t uniqueIdentifier;
 
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSString *> *mutableHeaders;
+@property (nonatomic, strong) SPTDataLoaderLock *headersLock;
 @property (nonatomic, assign) BOOL retriedAuthorisation;
 @property (nonatomic, weak) id<SPTDataLoaderCancellationToken> cancellationToken;
+@property (nonatomic, strong, nullable) NSData *compressedBody;
+@property (nonatomic, assign) BOOL bodyCompressionAttempted;
+@property (atomic, assign, readwrite) int64_t uncompressedBodyLength;
+@property (atomic, strong, nullable) NSURL *originalURL;
+@property (atomic, copy, nullable) NSString *traceServiceKey;
+@property (atomic, assign) CFAbsoluteTime serviceEntryTime;
+@property (atomic, assign) CFAbsoluteTime deadline;
 
 @end
 
@@ -29,18 +45,19 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
 
 + (instancetype)requestWithURL:(NSURL *)URL sourceIdentifier:(nullable NSString *)sourceIdentifier
 {
-    static int64_t uniqueIdentifierBarrier = 0;
-    @synchronized(self.class) {
-        return [[self alloc] initWithURL:URL
-                        sourceIdentifier:sourceIdentifier
-                        uniqueIdentifier:uniqueIdentifierBarrier++];
-    }
+    static _Atomic(int64_t) uniqueIdentifierBarrier = 0;
+    return [[self alloc] initWithURL:URL
+                    sourceIdentifier:sourceIdentifier
+                    uniqueIdentifier:atomic_fetch_add_explicit(&uniqueIdentifierBarrier, 1, memory_order_relaxed)];
 }
 
 - (instancetype)initWithURL:(NSURL *)URL
            sourceIdentifier:(nullable NSString *)sourceIdentifier
            uniqueIdentifier:(int64_t)uniqueIdentifier
 {
+    const NSUInteger SPTDataLoaderRequestDefaultMinimumCompressedBodySize = 1024;
+    const NSUInteger SPTDataLoaderRequestDefaultMinimumSegmentSize = 1024 * 1024;
+
     self = [super init];
     if (self) {
         _URL = URL;
@@ -48,17 +65,38 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
         _uniqueIdentifier = uniqueIdentifier;
 
         _mutableHeaders = [NSMutableDictionary new];
+        _headersLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderRequest.headers"];
         _method = SPTDataLoaderRequestMethodGet;
+        _minimumCompressedBodySize = SPTDataLoaderRequestDefaultMinimumCompressedBodySize;
+        _minimumSegmentSize = SPTDataLoaderRequestDefaultMinimumSegmentSize;
+        _tags = [NSSet set];
+        _priority = NSURLSessionTaskPriorityDefault;
     }
 
     return self;
 }
 
+- (void)setBody:(nullable NSData *)body
+{
+    _body = body;
+    self.compressedBody = nil;
+    self.bodyCompressionAttempted = NO;
+}
+
+- (void)setBodyCompression:(SPTDataLoaderRequestBodyCompression)bodyCompression
+{
+    _bodyCompression = bodyCompression;
+    self.compressedBody = nil;
+    self.bodyCompressionAttempted = NO;
+}
+
 - (NSDictionary *)headers
 {
-    @synchronized(self.mutableHeaders) {
-        return [self.mutableHeaders copy];
-    }
+    NSDictionary *headers = nil;
+    [self.headersLock lock];
+    headers = [self.mutableHeaders copy];
+    [self.headersLock unlock];
+    return headers;
 }
 
 - (void)addValue:(NSString *)value forHeader:(NSString *)header
@@ -67,21 +105,20 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
         return;
     }
 
-    @synchronized(self.mutableHeaders) {
-        if (!value && header) {
-            [self.mutableHeaders removeObjectForKey:header];
-            return;
-        }
-
+    [self.headersLock lock];
+    if (!value) {
+        [self.mutableHeaders removeObjectForKey:header];
+    } else {
         self.mutableHeaders[header] = value;
     }
+    [self.headersLock unlock];
 }
 
 - (void)removeHeader:(NSString *)header
 {
-    @synchronized(self.mutableHeaders) {
-        [self.mutableHeaders removeObjectForKey:header];
-    }
+    [self.headersLock lock];
+    [self.mutableHeaders removeObjectForKey:header];
+    [self.headersLock unlock];
 }
 
 #pragma mark Private
@@ -92,20 +129,41 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
     NSString * const SPTDataLoaderRequestAcceptLanguageHeader = @"Accept-Language";
 
     NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:self.URL];
+    NSDictionary *headers = self.headers;
 
-    if (!self.headers[SPTDataLoaderRequestAcceptLanguageHeader]) {
+    if (!headers[SPTDataLoaderRequestAcceptLanguageHeader]) {
         [urlRequest addValue:[self.class languageHeaderValue]
           forHTTPHeaderField:SPTDataLoaderRequestAcceptLanguageHeader];
     }
 
-    if (self.bodyStream != nil) {
+    NSString *contentEncoding = nil;
+    if (self.bodyFileURL != nil) {
+        // The upload task reads the file and sets the Content-Length itself
+        self.uncompressedBodyLength = 0;
+    } else if (self.bodyStream != nil) {
+        // Streamed uploads ask for a fresh body stream for every task and compress that, a download task sends the
+        // stream as it is
+        if (self.compressesBody && self.backgroundPolicy != SPTDataLoaderRequestBackgroundPolicyAlways) {
+            contentEncoding = [SPTDataLoaderBodyCompressor contentEncodingForCompression:self.bodyCompression];
+        }
         urlRequest.HTTPBodyStream = self.bodyStream;
     } else if (self.body) {
-        [urlRequest addValue:@(self.body.length).stringValue forHTTPHeaderField:SPTDataLoaderRequestContentLengthHeader];
-        urlRequest.HTTPBody = self.body;
+        NSData *body = (NSData * _Nonnull)self.body;
+        NSData *compressedBody = self.compressedBody;
+        if (self.compressesBody && compressedBody != nil) {
+            contentEncoding = [SPTDataLoaderBodyCompressor contentEncodingForCompression:self.bodyCompression];
+            self.uncompressedBodyLength = (int64_t)body.length;
+            body = compressedBody;
+        } else {
+            self.uncompressedBodyLength = 0;
+        }
+        [urlRequest addValue:@(body.length).stringValue forHTTPHeaderField:SPTDataLoaderRequestContentLengthHeader];
+        urlRequest.HTTPBody = body;
+    }
+    if (contentEncoding != nil) {
+        [urlRequest addValue:contentEncoding forHTTPHeaderField:SPTDataLoaderRequestContentEncodingHeader];
     }
 
-    NSDictionary *headers = self.headers;
     for (NSString *key in headers) {
         NSString *value = headers[key];
         [urlRequest addValue:value forHTTPHeaderField:key];
@@ -117,6 +175,76 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
     return urlRequest;
 }
 
+- (BOOL)compressesBody
+{
+    if (self.bodyCompression == SPTDataLoaderRequestBodyCompressionNone) {
+        return NO;
+    }
+
+    // A body the caller has encoded already must not be encoded twice
+    for (NSString *header in self.headers) {
+        if ([header caseInsensitiveCompare:SPTDataLoaderRequestContentEncodingHeader] == NSOrderedSame) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)needsBodyCompression
+{
+    return self.bodyFileURL == nil
+        && self.bodyStream == nil
+        && self.body != nil
+        && self.body.length >= self.minimumCompressedBodySize
+        && !self.bodyCompressionAttempted
+        && self.compressesBody;
+}
+
+- (void)openTracePhase:(SPTDataLoaderTracePhase)phase
+{
+    atomic_fetch_or_explicit(&_openTracePhases, 1u << phase, memory_order_relaxed);
+}
+
+- (BOOL)closeTracePhase:(SPTDataLoaderTracePhase)phase
+{
+    uint32_t openTracePhases = atomic_fetch_and_explicit(&_openTracePhases, ~(1u << phase), memory_order_relaxed);
+    return (openTracePhases & (1u << phase)) != 0;
+}
+
+- (void)compressBody
+{
+    NSData *body = self.body;
+    if (body == nil || self.bodyCompressionAttempted) {
+        return;
+    }
+
+    NSData *compressedBody = [SPTDataLoaderBodyCompressor compressedData:(NSData * _Nonnull)body
+                                                             compression:self.bodyCompression];
+    // Incompressible bodies are uploaded as they are rather than growing on the wire
+    if (compressedBody.length < body.length) {
+        self.compressedBody = compressedBody;
+    }
+    self.bodyCompressionAttempted = YES;
+}
+
+- (NSInputStream *)compressedBodyStreamForBodyStream:(NSInputStream *)bodyStream
+                                     failureHandler:(nullable void (^)(NSError *error))failureHandler
+{
+    self.uncompressedBodyLength = 0;
+    if (!self.compressesBody) {
+        return bodyStream;
+    }
+
+    __weak __typeof(self) weakSelf = self;
+    return [SPTDataLoaderBodyCompressor compressedStreamWithStream:bodyStream
+                                                       compression:self.bodyCompression
+                                                       readHandler:^(NSUInteger length) {
+        __strong __typeof(self) strongSelf = weakSelf;
+        strongSelf.uncompressedBodyLength += (int64_t)length;
+    }
+                                                    failureHandler:failureHandler];
+}
+
 + (NSString *)languageHeaderValue
 {
     static NSString * languageHeaderValue = nil;
@@ -161,21 +289,33 @@ static NSString * NSStringFromSPTDataLoaderRequestMethod(SPTDataLoaderRequestMet
                                          sourceIdentifier:self.sourceIdentifier
                                          uniqueIdentifier:self.uniqueIdentifier];
     copy.waitsForConnectivity = self.waitsForConnectivity;
+    copy.sessionPartitionName = self.sessionPartitionName;
     copy.maximumRetryCount = self.maximumRetryCount;
     copy.body = [self.body copy];
-    @synchronized(self.mutableHeaders) {
-        copy.mutableHeaders = [self.mutableHeaders mutableCopy];
-    }
+    copy.bodyCompression = self.bodyCompression;
+    copy.minimumCompressedBodySize = self.minimumCompressedBodySize;
+    [self.headersLock lock];
+    copy.mutableHeaders = [self.mutableHeaders mutableCopy];
+    [self.headersLock unlock];
     copy.chunks = self.chunks;
+    copy.maximumInFlightChunks = self.maximumInFlightChunks;
+    copy.minimumChunkSize = self.minimumChunkSize;
+    copy.segmentCount = self.segmentCount;
+    copy.minimumSegmentSize = self.minimumSegmentSize;
     copy.cachePolicy = self.cachePolicy;
     copy.skipNSURLCache = self.skipNSURLCache;
     copy.method = self.method;
     copy.backgroundPolicy = self.backgroundPolicy;
     copy.userInfo = self.userInfo;
     copy.timeout = self.timeout;
+    copy.maximumResponseBodySize = self.maximumResponseBodySize;
     copy.cancellationToken = self.cancellationToken;
     copy.bodyStream = self.bodyStream;
+    copy.bodyFileURL = self.bodyFileURL;
     copy.shouldStopRedirection = self.shouldStopRedirection;
+    copy.persistsWhenOffline = self.persistsWhenOffline;
+    copy.tags = self.tags;
+    copy.priority = self.priority;
     return copy;
 }
 
@@ -35,6 +35,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @optional
 
+/**
+ Performs a group of requests in a single pass
+ @discussion Delegates that do not implement this are handed the requests one at a time
+ @param requestResponseHandler The object that can perform requests and responses
+ @param requests The objects describing the requests to perform, in order
+ */
+- (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+               performRequests:(NSArray<SPTDataLoaderRequest *> *)requests;
 /**
  Delegate a successfully authorised request
  @param requestResponseHandler The handler that successfully authorised the request
@@ -80,8 +88,11 @@ NS_ASSUME_NONNULL_BEGIN
  Called when a chunk is received
  @param data The data received by the request
  @param response The response the chunk is received for
+ @param completionHandler The block to call once the chunk has been consumed, this must always be called
  */
-- (void)receivedDataChunk:(NSData *)data forResponse:(SPTDataLoaderResponse *)response;
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler;
 /**
  Called when the headers for a response are received
  @param response The response containing the initial information (such as headers)
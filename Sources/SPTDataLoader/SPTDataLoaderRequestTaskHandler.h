@@ -5,12 +5,17 @@
 
 #import <Foundation/Foundation.h>
 
+@class SPTDataLoaderInFlightRequest;
+@class SPTDataLoaderMetricsRecorder;
+@class SPTDataLoaderRedirect;
 @class SPTDataLoaderRequestTaskHandler;
 @class SPTDataLoaderRequest;
 @class SPTDataLoaderRateLimiter;
 @class SPTDataLoaderResponse;
+@class SPTDataLoaderTraceContext;
 
 @protocol SPTDataLoaderRequestResponseHandler;
+@protocol SPTDataLoaderTimeProvider;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -40,7 +45,36 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  Whether the request was cancelled
  */
-@property (nonatomic, assign, readonly, getter = isCancelled) BOOL cancelled;
+@property (atomic, assign, readonly, getter = isCancelled) BOOL cancelled;
+/**
+ The headers the next task must send to resume the body where the failed attempt left off
+ @discussion This is nil unless the server supports byte ranges and sent a strong validator for the body
+ */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, NSString *> *resumeHeaders;
+/**
+ The resume data a failed download task left behind, to create the next download task with
+ */
+@property (nonatomic, strong, readonly, nullable) NSData *resumeData;
+/**
+ The context the phases of the request are traced through
+ */
+@property (nonatomic, strong, nullable) SPTDataLoaderTraceContext *traceContext;
+/**
+ The recorders the request is counted in once it succeeds or fails
+ */
+@property (nonatomic, copy, nullable) NSArray<SPTDataLoaderMetricsRecorder *> *metricsRecorders;
+/**
+ The largest response body in bytes the request accepts, 0 means no limit
+ */
+@property (nonatomic, assign) int64_t maximumResponseBodySize;
+/**
+ The tags the request was indexed under when it was handed to the service
+ */
+@property (nonatomic, copy, nullable) NSSet<NSString *> *tags;
+/**
+ The redirects of the current attempt, led by the cached redirects the service applied before creating the task
+ */
+@property (nonatomic, copy, readonly) NSArray<SPTDataLoaderRedirect *> *redirects;
 
 /**
  Class constructor
@@ -48,14 +82,22 @@ NS_ASSUME_NONNULL_BEGIN
  @param request The request object to perform lookup with
  @param requestResponseHandler The object tie to this operation for potential callbacks
  @param rateLimiter The object controlling the rate limits on a per service basis
+ @param timeProvider The clock used to time the request and schedule its retries
  @param delegate The object listening to the task handler
  */
 + (instancetype)dataLoaderRequestTaskHandlerWithTask:(NSURLSessionTask *)task
                                              request:(SPTDataLoaderRequest *)request
                               requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                                          rateLimiter:(nullable SPTDataLoaderRateLimiter *)rateLimiter
+                                        timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
                                             delegate:(id<SPTDataLoaderRequestTaskHandlerDelegate>)delegate;
 
+/**
+ A snapshot of what the request is waiting for and how far it has come
+ @discussion This may be called from any thread while the request is being performed
+ */
+- (SPTDataLoaderInFlightRequest *)inFlightRequest;
+
 /**
  Call to tell the operation it has received a response
  @param response The object describing the response it received from the server
@@ -66,6 +108,18 @@ NS_ASSUME_NONNULL_BEGIN
  @param data The data from the URL session performing the task
  */
 - (void)receiveData:(NSData *)data;
+/**
+ Call before a downloaded body is read into memory
+ @param length The length of the downloaded body
+ @return YES if the body fits the maximum response body size, otherwise the operation fails as the response being too
+ large once it completes
+ */
+- (BOOL)acceptsDownloadedBodyOfLength:(int64_t)length;
+/**
+ Cancels the request on behalf of its caller
+ @discussion The request completes as cancelled even if the handler itself was about to fail or restart it
+ */
+- (void)cancel;
 /**
  Tell the operation the URL session has completed the request
  @param error An optional error to use if the request was not completed successfully
@@ -81,6 +135,11 @@ NS_ASSUME_NONNULL_BEGIN
  Returns YES to allow redirect, NO to block it.
  */
 - (BOOL)mayRedirect;
+/**
+ Records a redirect the request followed, to be listed on its response
+ @param redirect The redirect that was followed
+ */
+- (void)addRedirect:(SPTDataLoaderRedirect *)redirect;
 /**
  Start the data loader task associated with the request
  */
@@ -9,29 +9,63 @@
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 #import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
 
+#import "SPTDataLoaderInFlightRequest+Private.h"
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderMetricsRegistry+Private.h"
+#import "SPTDataLoaderRateLimiter+Private.h"
+#import "SPTDataLoaderRedirect+Private.h"
+#import "SPTDataLoaderRequest+Private.h"
 #import "SPTDataLoaderRequestResponseHandler.h"
 #import "SPTDataLoaderResponse+Private.h"
+#import "SPTDataLoaderTimeProvider.h"
+#import "SPTDataLoaderTraceContext.h"
 
 #import <SPTDataLoader/SPTDataLoaderExponentialTimer.h>
 
+#include <stdatomic.h>
+
 NS_ASSUME_NONNULL_BEGIN
 
 static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
+// A Content-Length is only a promise, never reserve more than this for a body up front
+static int64_t const SPTDataLoaderRequestTaskHandlerMaximumPreallocatedLength = 4 * 1024 * 1024;
 
-@interface SPTDataLoaderRequestTaskHandler ()
+@interface SPTDataLoaderRequestTaskHandler () {
+    // Written on the queues the request moves through and read by snapshots taken from any thread
+    _Atomic(SPTDataLoaderInFlightRequestState) _state;
+    _Atomic(CFAbsoluteTime) _stateEntryTime;
+}
 
-@property (nonatomic, assign, readwrite, getter = isCancelled) BOOL cancelled;
+@property (atomic, assign, readwrite, getter = isCancelled) BOOL cancelled;
+@property (nonatomic, copy, readwrite, nullable) NSDictionary<NSString *, NSString *> *resumeHeaders;
+@property (nonatomic, strong, readwrite, nullable) NSData *resumeData;
 
 @property (nonatomic, weak) id<SPTDataLoaderRequestResponseHandler> requestResponseHandler;
 @property (nonatomic, strong, nullable) SPTDataLoaderRateLimiter *rateLimiter;
+@property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
 @property (nonatomic, weak, readonly) id<SPTDataLoaderRequestTaskHandlerDelegate> delegate;
 
 @property (nonatomic, strong) SPTDataLoaderResponse *response;
 @property (nonatomic, strong, nullable) NSMutableData *receivedData;
+@property (nonatomic, strong, nullable) NSMutableData *pendingChunkData;
+@property (atomic, assign) int64_t receivedLength;
+@property (atomic, assign) BOOL responseTooLarge;
+@property (atomic, strong, nullable) NSError *bodyStreamError;
+@property (atomic, assign) BOOL restartsWithoutRange;
+@property (nonatomic, copy, nullable) NSString *rangeValidator;
+@property (nonatomic, assign) NSUInteger inFlightChunkCount;
+@property (nonatomic, assign) BOOL suspendedForInFlightChunks;
+@property (nonatomic, strong) SPTDataLoaderLock *inFlightChunksLock;
 @property (nonatomic, assign) CFAbsoluteTime absoluteStartTime;
+@property (nonatomic, assign) CFAbsoluteTime creationTime;
+@property (nonatomic, assign) CFAbsoluteTime waitStartTime;
+@property (nonatomic, assign) NSTimeInterval queueWaitTime;
+@property (nonatomic, assign) NSTimeInterval timeToFirstByte;
+@property (atomic, assign) NSUInteger attemptCount;
 @property (nonatomic, assign) NSUInteger retryCount;
 @property (nonatomic, assign) NSUInteger waitCount;
 @property (nonatomic, assign) NSUInteger redirectCount;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderRedirect *> *mutableRedirects;
 @property (nonatomic, copy) dispatch_block_t executionBlock;
 @property (nonatomic, strong) SPTDataLoaderExponentialTimer *exponentialTimer;
 
@@ -52,12 +86,14 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
                                              request:(SPTDataLoaderRequest *)request
                               requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                                          rateLimiter:(nullable SPTDataLoaderRateLimiter *)rateLimiter
+                                        timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
                                             delegate:(id<SPTDataLoaderRequestTaskHandlerDelegate>)delegate
 {
     return [[self alloc] initWithTask:task
                               request:request
                requestResponseHandler:requestResponseHandler
                           rateLimiter:rateLimiter
+                         timeProvider:timeProvider
                              delegate:delegate];
 }
 
@@ -65,6 +101,7 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
                      request:(SPTDataLoaderRequest *)request
       requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                  rateLimiter:(nullable SPTDataLoaderRateLimiter *)rateLimiter
+                timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
                     delegate:(id<SPTDataLoaderRequestTaskHandlerDelegate>)delegate
 {
     const NSTimeInterval SPTDataLoaderRequestTaskHandlerMaximumTime = 60.0;
@@ -76,8 +113,15 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
         _request = request;
         _requestResponseHandler = requestResponseHandler;
         _rateLimiter = rateLimiter;
+        _timeProvider = timeProvider;
         _delegate = delegate;
+        _creationTime = timeProvider.currentTime;
+        _timeToFirstByte = -1.0;
+        atomic_init(&_state, SPTDataLoaderInFlightRequestStateQueued);
+        atomic_init(&_stateEntryTime, _creationTime);
         _shouldStopRedirection = request.shouldStopRedirection;
+        _mutableRedirects = [NSMutableArray new];
+        _inFlightChunksLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderRequestTaskHandler.inFlightChunks"];
 
         __weak __typeof(self) weakSelf = self;
         _executionBlock = ^{
@@ -93,8 +137,25 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
 
 - (void)receiveData:(NSData *)data
 {
+    if (self.responseTooLarge) {
+        return;
+    }
+
+    self.receivedLength += (int64_t)data.length;
+    if ([self exceedsMaximumResponseBodySize:self.receivedLength]) {
+        // Drop what has arrived so far rather than hold on to it until the cancellation comes back
+        self.responseTooLarge = YES;
+        self.receivedData = nil;
+        self.pendingChunkData = nil;
+        [self.task cancel];
+        return;
+    }
+    if (atomic_load_explicit(&_state, memory_order_relaxed) != SPTDataLoaderInFlightRequestStateStreaming) {
+        [self enterState:SPTDataLoaderInFlightRequestStateStreaming];
+    }
+
     if (self.request.chunks) {
-        [self.requestResponseHandler receivedDataChunk:data forResponse:self.response];
+        [self receiveDataChunk:data];
     } else {
         if (!self.receivedData) {
             self.receivedData = [data mutableCopy];
@@ -104,14 +165,131 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
     }
 }
 
+- (void)cancel
+{
+    self.cancelled = YES;
+    [self.task cancel];
+}
+
+- (BOOL)acceptsDownloadedBodyOfLength:(int64_t)length
+{
+    if ([self exceedsMaximumResponseBodySize:length]) {
+        self.responseTooLarge = YES;
+        return NO;
+    }
+    return YES;
+}
+
+- (void)receiveDataChunk:(NSData *)data
+{
+    const NSUInteger minimumChunkSize = self.request.minimumChunkSize;
+    if (minimumChunkSize > 0) {
+        if (!self.pendingChunkData) {
+            self.pendingChunkData = [data mutableCopy];
+        } else {
+            [self.pendingChunkData appendData:data];
+        }
+
+        if (self.pendingChunkData.length < minimumChunkSize) {
+            return;
+        }
+
+        data = self.pendingChunkData;
+        self.pendingChunkData = nil;
+    }
+
+    [self deliverDataChunk:data];
+}
+
+- (void)flushPendingDataChunk
+{
+    NSData *data = self.pendingChunkData;
+    self.pendingChunkData = nil;
+    if (data.length > 0) {
+        [self deliverDataChunk:data];
+    }
+}
+
+- (void)deliverDataChunk:(NSData *)data
+{
+    const NSUInteger maximumInFlightChunks = self.request.maximumInFlightChunks;
+    [self.inFlightChunksLock lock];
+    self.inFlightChunkCount++;
+    // Stop reading from the network until the consumer catches up
+    if (maximumInFlightChunks > 0 && self.inFlightChunkCount >= maximumInFlightChunks && !self.suspendedForInFlightChunks) {
+        self.suspendedForInFlightChunks = YES;
+        [self.task suspend];
+    }
+    [self.inFlightChunksLock unlock];
+
+    [self.traceContext beginPhase:SPTDataLoaderTracePhaseChunk ofRequest:self.request];
+    __weak __typeof(self) weakSelf = self;
+    [self.requestResponseHandler receivedDataChunk:data forResponse:self.response completionHandler:^{
+        [weakSelf consumedDataChunk];
+    }];
+}
+
+- (void)consumedDataChunk
+{
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseChunk ofRequest:self.request];
+    [self.inFlightChunksLock lock];
+    if (self.inFlightChunkCount > 0) {
+        self.inFlightChunkCount--;
+    }
+    if (self.suspendedForInFlightChunks && self.inFlightChunkCount < self.request.maximumInFlightChunks) {
+        self.suspendedForInFlightChunks = NO;
+        [self.task resume];
+    }
+    [self.inFlightChunksLock unlock];
+}
+
 - (nullable SPTDataLoaderResponse *)completeWithError:(nullable NSError *)error
 {
+    SPTDataLoaderTraceContext *traceContext = self.traceContext;
+    [traceContext endPhase:SPTDataLoaderTracePhaseTask ofRequest:self.request];
+    [traceContext beginPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
+
     id<SPTDataLoaderRequestResponseHandler> requestResponseHandler = self.requestResponseHandler;
     if (!self.response) {
         self.response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:self.request response:nil];
     }
+    self.response.redirects = self.mutableRedirects;
+
+    // A cancellation by the caller wins over the reasons the handler cancels its own task for
+    const BOOL cancelledByCaller = self.cancelled;
+
+    if (self.responseTooLarge && !cancelledByCaller) {
+        // The task was cancelled by the handler itself, which is a failure rather than a cancellation of the request
+        error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                    code:SPTDataLoaderRequestErrorResponseTooLarge
+                                userInfo:@{ NSLocalizedDescriptionKey : @"The response body exceeds the maximum response body size" }];
+    }
+
+    NSError *bodyStreamError = self.bodyStreamError;
+    self.bodyStreamError = nil;
+    if (bodyStreamError && !cancelledByCaller) {
+        // The task was cancelled by the handler itself because its body stream could not be read
+        error = bodyStreamError;
+    }
 
-    if ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled) {
+    const BOOL restartsWithoutRange = self.restartsWithoutRange;
+    self.restartsWithoutRange = NO;
+    if (restartsWithoutRange && !cancelledByCaller) {
+        // The task was cancelled by the handler itself because the ranged response did not continue the body, the
+        // request starts over in full without counting against its retries
+        [self.rateLimiter abandonConcurrencyForRequest:self.request];
+        [self.delegate requestTaskHandlerNeedsNewTask:self];
+        [traceContext endPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
+        [self start];
+        return nil;
+    }
+
+    if (cancelledByCaller || ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled)) {
+        // A request cancelled while it waits to be sent never reaches the end of its wait
+        [traceContext endPhase:SPTDataLoaderTracePhaseRateLimiterWait ofRequest:self.request];
+        [traceContext endPhase:SPTDataLoaderTracePhaseRetryBackoff ofRequest:self.request];
+        [self.rateLimiter abandonConcurrencyForRequest:self.request];
+        [traceContext endPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
         [requestResponseHandler cancelledRequest:self.request];
         self.calledCancelledRequest = YES;
         self.cancelled = YES;
@@ -125,26 +303,41 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
     }
 
     self.response.body = self.receivedData;
-    self.response.requestTime = CFAbsoluteTimeGetCurrent() - self.absoluteStartTime;
+    self.response.requestTime = self.timeProvider.currentTime - self.absoluteStartTime;
+    [self.rateLimiter releaseConcurrencyForRequest:self.request
+                                     roundTripTime:self.response.requestTime
+                                          response:self.response];
 
     if (self.response.retryAfter) {
-        [self.rateLimiter setRetryAfter:self.response.retryAfter.timeIntervalSinceReferenceDate
+        // Retry-After is relative to the wall clock, carry the remaining wait over to the time provider
+        NSTimeInterval retryAfterInterval = self.response.retryAfter.timeIntervalSinceNow;
+        [self.rateLimiter setRetryAfter:self.timeProvider.currentTime + retryAfterInterval
                                  forURL:self.response.request.URL];
     }
 
     if (self.response.error) {
-        if ([self.response shouldRetry]) {
+        if ([self.response shouldRetry] && [self retryStartsBeforeDeadline]) {
             if (self.retryCount++ != self.request.maximumRetryCount) {
+                [self prepareResumptionAfterError:error];
+                // The next attempt starts from the URL the cached redirects led to and follows the rest again
+                [self.mutableRedirects filterUsingPredicate:[NSPredicate predicateWithFormat:@"cached == YES"]];
                 [self.delegate requestTaskHandlerNeedsNewTask:self];
+                [traceContext endPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
                 [self start];
                 return nil;
             }
         }
+        [self flushPendingDataChunk];
+        [self recordMetrics];
+        [traceContext endPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
         [requestResponseHandler failedResponse:self.response];
         self.calledFailedResponse = YES;
         return self.response;
     }
 
+    [self flushPendingDataChunk];
+    [self recordMetrics];
+    [traceContext endPhase:SPTDataLoaderTracePhaseCompletion ofRequest:self.request];
     [requestResponseHandler successfulResponse:self.response];
     self.calledSuccessfulResponse = YES;
     return self.response;
@@ -152,20 +345,58 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
 
 - (NSURLSessionResponseDisposition)receiveResponse:(NSURLResponse *)response
 {
+    if (self.resumeHeaders != nil) {
+        BOOL resumed = [self resumesWithResponse:response];
+        self.resumeHeaders = nil;
+        if (resumed) {
+            // The original response stays in place, the consumer sees a single response carrying the whole body
+            self.response.error = nil;
+            return [self responseDisposition];
+        }
+        // The server sent the whole body again, so the bytes from the earlier attempts are dropped
+        [self discardReceivedData];
+        if ([self isPartialContentResponse:response]) {
+            // A range other than the one asked for cannot be delivered as the whole body, so ask for all of it
+            self.restartsWithoutRange = YES;
+            return NSURLSessionResponseCancel;
+        }
+    }
+
     self.response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:self.request response:response];
+    self.response.redirects = self.mutableRedirects;
+    self.timeToFirstByte = self.timeProvider.currentTime - self.absoluteStartTime;
+    // Reject the body before the consumer starts on it, the response still carries the headers that announced it
+    if ([self exceedsMaximumResponseBodySize:response.expectedContentLength]) {
+        self.responseTooLarge = YES;
+        return NSURLSessionResponseCancel;
+    }
+
     [self.requestResponseHandler receivedInitialResponse:self.response];
 
     if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
         NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
         if (httpResponse.expectedContentLength > 0) {
-            self.receivedData = [NSMutableData dataWithCapacity:(NSUInteger)httpResponse.expectedContentLength];
+            int64_t capacity = MIN(httpResponse.expectedContentLength, SPTDataLoaderRequestTaskHandlerMaximumPreallocatedLength);
+            self.receivedData = [NSMutableData dataWithCapacity:(NSUInteger)capacity];
         }
+        self.rangeValidator = [self.class rangeValidatorForResponse:httpResponse];
     }
 
     if (!self.receivedData) {
         self.receivedData = [NSMutableData data];
     }
 
+    return [self responseDisposition];
+}
+
+- (BOOL)exceedsMaximumResponseBodySize:(int64_t)length
+{
+    const int64_t maximumResponseBodySize = self.maximumResponseBodySize;
+    return maximumResponseBodySize > 0 && length > maximumResponseBodySize;
+}
+
+- (NSURLSessionResponseDisposition)responseDisposition
+{
     if (self.request.backgroundPolicy == SPTDataLoaderRequestBackgroundPolicyOnDemand) {
         return NSURLSessionResponseBecomeDownload;
     } else {
@@ -183,15 +414,36 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
     return YES;
 }
 
+- (NSArray<SPTDataLoaderRedirect *> *)redirects
+{
+    return [self.mutableRedirects copy];
+}
+
+- (void)addRedirect:(SPTDataLoaderRedirect *)redirect
+{
+    [self.mutableRedirects addObject:redirect];
+}
+
 - (void)start
 {
     self.started = YES;
+    self.waitStartTime = self.timeProvider.currentTime;
+    [self enterState:SPTDataLoaderInFlightRequestStateQueued];
     self.executionBlock();
 }
 
 - (void)provideNewBodyStreamWithCompletion:(void (^)(NSInputStream * _Nonnull))completionHandler
 {
-    [self.requestResponseHandler needsNewBodyStream:completionHandler forRequest:self.request];
+    SPTDataLoaderRequest *request = self.request;
+    __weak __typeof(self) weakSelf = self;
+    [self.requestResponseHandler needsNewBodyStream:^(NSInputStream *bodyStream) {
+        completionHandler([request compressedBodyStreamForBodyStream:bodyStream failureHandler:^(NSError *error) {
+            // A truncated body would otherwise be uploaded as if it were complete
+            __strong __typeof(self) strongSelf = weakSelf;
+            strongSelf.bodyStreamError = error;
+            [strongSelf.task cancel];
+        }]);
+    } forRequest:request];
 }
 
 - (void)noteWaitingForConnectivity
@@ -201,14 +453,17 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
 
 - (void)checkRateLimiterAndExecute
 {
+    // Every wait, whether on the rate limiter or a retry, ends by coming back here
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseRateLimiterWait ofRequest:self.request];
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseRetryBackoff ofRequest:self.request];
+
     NSTimeInterval waitTime = [self.rateLimiter earliestTimeUntilRequestCanBeExecuted:self.request];
     if (waitTime == 0.0) {
         [self checkRetryLimiterAndExecute];
     } else {
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW,
-                                     (int64_t)(waitTime * NSEC_PER_SEC)),
-                       self.retryQueue,
-                       self.executionBlock);
+        [self.traceContext beginPhase:SPTDataLoaderTracePhaseRateLimiterWait ofRequest:self.request];
+        [self enterState:SPTDataLoaderInFlightRequestStateRateLimited];
+        [self.timeProvider dispatchAfter:waitTime queue:self.retryQueue block:self.executionBlock];
     }
 }
 
@@ -220,17 +475,214 @@ static NSUInteger const SPTDataLoaderRequestTaskHandlerMaxRedirects = 10;
             self.executionBlock();
         } else {
             NSTimeInterval waitTime = self.exponentialTimer.timeIntervalAndCalculateNext;
-            dispatch_after(dispatch_time(DISPATCH_TIME_NOW,
-                                         (int64_t)(waitTime * NSEC_PER_SEC)),
-                           self.retryQueue,
-                           self.executionBlock);
+            [self.traceContext beginPhase:SPTDataLoaderTracePhaseRetryBackoff ofRequest:self.request];
+            [self enterState:SPTDataLoaderInFlightRequestStateBackingOff];
+            [self.timeProvider dispatchAfter:waitTime queue:self.retryQueue block:self.executionBlock];
+        }
+        return;
+    }
+
+    if (self.resumeHeaders == nil) {
+        [self discardReceivedData];
+    }
+
+    // Services with adaptive concurrency hold the task back until one of their requests in flight completes
+    SPTDataLoaderRateLimiter *rateLimiter = self.rateLimiter;
+    if (rateLimiter != nil) {
+        // The wait begins before asking, the waiter may otherwise end it before it began
+        [self.traceContext beginPhase:SPTDataLoaderTracePhaseRateLimiterWait ofRequest:self.request];
+        [self enterState:SPTDataLoaderInFlightRequestStateRateLimited];
+        __weak __typeof(self) weakSelf = self;
+        BOOL acquired = [rateLimiter acquireConcurrencyForRequest:self.request waiter:^{
+            [weakSelf resumeTask];
+        }];
+        if (!acquired) {
+            return;
         }
+    }
+    [self resumeTask];
+}
+
+- (void)resumeTask
+{
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseRateLimiterWait ofRequest:self.request];
+    [self.traceContext beginPhase:SPTDataLoaderTracePhaseTask ofRequest:self.request];
+    self.absoluteStartTime = self.timeProvider.currentTime;
+    self.queueWaitTime += self.absoluteStartTime - self.waitStartTime;
+    self.timeToFirstByte = -1.0;
+    self.attemptCount++;
+    [self enterState:SPTDataLoaderInFlightRequestStateRunning];
+
+    // A new task starts out running, the suspension of a failed task does not carry over to it. The chunks the
+    // consumer still holds do, they complete later and keep counting against the window of the new task.
+    const NSUInteger maximumInFlightChunks = self.request.maximumInFlightChunks;
+    [self.inFlightChunksLock lock];
+    BOOL windowFull = maximumInFlightChunks > 0 && self.inFlightChunkCount >= maximumInFlightChunks;
+    self.suspendedForInFlightChunks = windowFull;
+    [self.inFlightChunksLock unlock];
+    if (!windowFull) {
+        [self.task resume];
+    }
+}
+
+- (BOOL)retryStartsBeforeDeadline
+{
+    CFAbsoluteTime deadline = self.request.deadline;
+    if (deadline <= 0.0) {
+        return YES;
+    }
+
+    // The first retry is sent straight away, later ones wait out the back-off first
+    NSTimeInterval backoffTime = self.waitCount == 0 ? 0.0 : self.exponentialTimer.timeInterval;
+    NSTimeInterval rateLimiterWaitTime = [self.rateLimiter earliestTimeUntilRequestCanBeExecuted:self.request];
+    return self.timeProvider.currentTime + backoffTime + rateLimiterWaitTime < deadline;
+}
+
+- (void)enterState:(SPTDataLoaderInFlightRequestState)state
+{
+    atomic_store_explicit(&_stateEntryTime, self.timeProvider.currentTime, memory_order_relaxed);
+    atomic_store_explicit(&_state, state, memory_order_release);
+}
+
+- (SPTDataLoaderInFlightRequest *)inFlightRequest
+{
+    SPTDataLoaderInFlightRequestState state = atomic_load_explicit(&_state, memory_order_acquire);
+    CFAbsoluteTime stateEntryTime = atomic_load_explicit(&_stateEntryTime, memory_order_relaxed);
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    CFAbsoluteTime serviceEntryTime = self.request.serviceEntryTime;
+
+    SPTDataLoaderInFlightRequest *inFlightRequest = [SPTDataLoaderInFlightRequest new];
+    inFlightRequest.request = self.request;
+    inFlightRequest.sourceIdentifier = self.request.sourceIdentifier;
+    inFlightRequest.state = state;
+    inFlightRequest.stateEntryTime = stateEntryTime;
+    inFlightRequest.timeInState = MAX(currentTime - stateEntryTime, 0.0);
+    inFlightRequest.age = MAX(currentTime - (serviceEntryTime > 0.0 ? serviceEntryTime : self.creationTime), 0.0);
+    NSUInteger attemptCount = self.attemptCount;
+    inFlightRequest.retryCount = attemptCount > 0 ? attemptCount - 1 : 0;
+    inFlightRequest.receivedByteCount = self.receivedLength;
+    return inFlightRequest;
+}
+
+- (void)recordMetrics
+{
+    NSArray<SPTDataLoaderMetricsRecorder *> *metricsRecorders = self.metricsRecorders;
+    if (metricsRecorders.count == 0) {
         return;
     }
 
+    SPTDataLoaderMetricsSample sample;
+    sample.latency = self.timeProvider.currentTime - self.creationTime;
+    sample.timeToFirstByte = self.timeToFirstByte;
+    sample.queueWait = self.queueWaitTime;
+    sample.bodySize = MAX(self.receivedLength, (int64_t)self.response.body.length);
+    sample.retryCount = self.attemptCount > 0 ? self.attemptCount - 1 : 0;
+    sample.statusCode = self.response.statusCode;
+    NSString *errorDomain = self.response.error.domain;
+    for (SPTDataLoaderMetricsRecorder *metricsRecorder in metricsRecorders) {
+        [metricsRecorder recordSample:sample errorDomain:errorDomain];
+    }
+}
+
+- (void)discardReceivedData
+{
     self.receivedData = nil;
-    self.absoluteStartTime = CFAbsoluteTimeGetCurrent();
-    [self.task resume];
+    self.pendingChunkData = nil;
+    self.receivedLength = 0;
+    self.rangeValidator = nil;
+}
+
+- (void)prepareResumptionAfterError:(nullable NSError *)error
+{
+    NSString * const SPTDataLoaderRequestTaskHandlerRangeHeader = @"Range";
+    NSString * const SPTDataLoaderRequestTaskHandlerIfRangeHeader = @"If-Range";
+
+    self.resumeData = error.userInfo[NSURLSessionDownloadTaskResumeData];
+
+    // Only transfers that broke off mid-body can be resumed, failed status codes are retried in full
+    NSString *rangeValidator = self.rangeValidator;
+    BOOL transferFailed = [error.domain isEqualToString:NSURLErrorDomain];
+    if (!transferFailed || rangeValidator == nil || self.receivedLength == 0 || self.request.method != SPTDataLoaderRequestMethodGet) {
+        self.resumeHeaders = nil;
+        return;
+    }
+
+    NSString *range = [NSString stringWithFormat:@"bytes=%lld-", self.receivedLength];
+    self.resumeHeaders = @{ SPTDataLoaderRequestTaskHandlerRangeHeader : range,
+                            SPTDataLoaderRequestTaskHandlerIfRangeHeader : (NSString * _Nonnull)rangeValidator };
+}
+
+- (BOOL)resumesWithResponse:(NSURLResponse *)response
+{
+    NSString * const SPTDataLoaderRequestTaskHandlerContentRangeHeader = @"Content-Range";
+
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return NO;
+    }
+
+    NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
+    if (httpResponse.statusCode != SPTDataLoaderResponseHTTPStatusCodePartialContent) {
+        return NO;
+    }
+
+    NSString *contentRange = [self.class valueForHeader:SPTDataLoaderRequestTaskHandlerContentRangeHeader inResponse:httpResponse];
+    NSString *expectedContentRangePrefix = [NSString stringWithFormat:@"bytes %lld-", self.receivedLength];
+    return [contentRange hasPrefix:expectedContentRangePrefix];
+}
+
+- (BOOL)isPartialContentResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return NO;
+    }
+    return ((NSHTTPURLResponse *)response).statusCode == SPTDataLoaderResponseHTTPStatusCodePartialContent;
+}
+
++ (nullable NSString *)rangeValidatorForResponse:(NSHTTPURLResponse *)response
+{
+    NSString * const SPTDataLoaderRequestTaskHandlerAcceptRangesHeader = @"Accept-Ranges";
+    NSString * const SPTDataLoaderRequestTaskHandlerETagHeader = @"ETag";
+    NSString * const SPTDataLoaderRequestTaskHandlerLastModifiedHeader = @"Last-Modified";
+    NSString * const SPTDataLoaderRequestTaskHandlerByteRangeUnit = @"bytes";
+    NSString * const SPTDataLoaderRequestTaskHandlerWeakETagPrefix = @"W/";
+    NSString * const SPTDataLoaderRequestTaskHandlerContentEncodingHeader = @"Content-Encoding";
+    NSString * const SPTDataLoaderRequestTaskHandlerIdentityEncoding = @"identity";
+
+    if (response.statusCode != SPTDataLoaderResponseHTTPStatusCodeOK) {
+        return nil;
+    }
+
+    // Ranges count bytes of the encoded body, while the received length counts the bytes the session decoded
+    NSString *contentEncoding = [self valueForHeader:SPTDataLoaderRequestTaskHandlerContentEncodingHeader inResponse:response];
+    if (contentEncoding.length > 0
+        && [contentEncoding caseInsensitiveCompare:SPTDataLoaderRequestTaskHandlerIdentityEncoding] != NSOrderedSame) {
+        return nil;
+    }
+
+    NSString *acceptRanges = [self valueForHeader:SPTDataLoaderRequestTaskHandlerAcceptRangesHeader inResponse:response];
+    if (acceptRanges == nil || [acceptRanges rangeOfString:SPTDataLoaderRequestTaskHandlerByteRangeUnit options:NSCaseInsensitiveSearch].location == NSNotFound) {
+        return nil;
+    }
+
+    // If-Range only accepts strong validators, a weak ETag could resume on top of a different body
+    NSString *eTag = [self valueForHeader:SPTDataLoaderRequestTaskHandlerETagHeader inResponse:response];
+    if (eTag.length > 0 && ![eTag hasPrefix:SPTDataLoaderRequestTaskHandlerWeakETagPrefix]) {
+        return eTag;
+    }
+
+    NSString *lastModified = [self valueForHeader:SPTDataLoaderRequestTaskHandlerLastModifiedHeader inResponse:response];
+    return lastModified.length > 0 ? lastModified : nil;
+}
+
++ (nullable NSString *)valueForHeader:(NSString *)header inResponse:(NSHTTPURLResponse *)response
+{
+    NSDictionary *headers = response.allHeaderFields;
+    for (NSString *key in headers) {
+        if ([key caseInsensitiveCompare:header] == NSOrderedSame) {
+            return headers[key];
+        }
+    }
+    return nil;
 }
 
 - (void)completeIfInFlight
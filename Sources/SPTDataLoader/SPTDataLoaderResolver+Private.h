@@ -0,0 +1,26 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderResolver.h>
+
+@protocol SPTDataLoaderTimeProvider;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderResolver (Private)
+
+- (instancetype)initWithTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider;
+- (instancetype)initWithAddressSource:(nullable id<SPTDataLoaderResolverAddressSource>)addressSource
+                       persistenceURL:(nullable NSURL *)persistenceURL
+                         timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider;
+
+/**
+ Blocks until the addresses have been written to the persistence URL
+ */
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -5,61 +5,155 @@
 
 #import <SPTDataLoader/SPTDataLoaderResolver.h>
 
+#import <SPTDataLoader/SPTDataLoaderResolverAddressSource.h>
+
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderResolver+Private.h"
 #import "SPTDataLoaderResolverAddress.h"
+#import "SPTDataLoaderTimeProviderImplementation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderResolverPersistenceHostsKey = @"hosts";
+static NSString * const SPTDataLoaderResolverPersistenceAddressesKey = @"addresses";
+static NSString * const SPTDataLoaderResolverPersistenceAddressKey = @"address";
+static NSString * const SPTDataLoaderResolverPersistenceLastFailedTimeKey = @"lastFailedTime";
+static NSString * const SPTDataLoaderResolverPersistenceExpiryTimeKey = @"expiryTime";
 
 @interface SPTDataLoaderResolver ()
 
+@property (nonatomic, strong, readwrite, nullable) id<SPTDataLoaderResolverAddressSource> addressSource;
+@property (nonatomic, copy, readwrite, nullable) NSURL *persistenceURL;
+
 @property (nonatomic, strong) NSMutableDictionary<NSString *, NSArray<SPTDataLoaderResolverAddress *> *> *resolverHost;
 @property (nonatomic, strong) NSHashTable<SPTDataLoaderResolverAddress *> *addresses;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *expiryTimes;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *refreshTimes;
+@property (nonatomic, strong) NSMutableSet<NSString *> *refreshingHosts;
+@property (nonatomic, strong) NSMutableSet<NSString *> *lookedUpHosts;
+@property (nonatomic, strong) SPTDataLoaderLock *lock;
+@property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
+@property (nonatomic, strong, readonly) dispatch_queue_t persistenceQueue;
 
 @end
 
 @implementation SPTDataLoaderResolver
 
+@synthesize unreachablePeriod = _unreachablePeriod;
+
 #pragma mark SPTDataLoaderResolver
 
++ (instancetype)resolverWithAddressSource:(nullable id<SPTDataLoaderResolverAddressSource>)addressSource
+                           persistenceURL:(nullable NSURL *)persistenceURL
+{
+    return [[self alloc] initWithAddressSource:addressSource
+                                persistenceURL:persistenceURL
+                                  timeProvider:[SPTDataLoaderTimeProviderImplementation new]];
+}
+
+- (NSTimeInterval)unreachablePeriod
+{
+    [self.lock lock];
+    NSTimeInterval unreachablePeriod = _unreachablePeriod;
+    [self.lock unlock];
+    return unreachablePeriod;
+}
+
+- (void)setUnreachablePeriod:(NSTimeInterval)unreachablePeriod
+{
+    [self.lock lock];
+    _unreachablePeriod = unreachablePeriod;
+    for (SPTDataLoaderResolverAddress *resolverAddress in self.addresses) {
+        resolverAddress.unreachablePeriod = unreachablePeriod;
+    }
+    [self.lock unlock];
+}
+
 - (NSString *)addressForHost:(NSString *)host
 {
-    @synchronized(self.resolverHost) {
-        for (SPTDataLoaderResolverAddress *address in self.resolverHost[host]) {
-            if (address.reachable) {
-                return address.address;
-            }
+    id<SPTDataLoaderResolverAddressSource> addressSource = self.addressSource;
+    const CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+
+    [self.lock lock];
+    NSArray<SPTDataLoaderResolverAddress *> *addresses = self.resolverHost[host];
+    NSNumber *expiryTime = self.expiryTimes[host];
+    BOOL refresh = NO;
+    if (addressSource != nil) {
+        [self.lookedUpHosts addObject:host];
+        NSNumber *refreshTime = self.refreshTimes[host];
+        refresh = ![self.refreshingHosts containsObject:host] && (refreshTime == nil || currentTime >= refreshTime.doubleValue);
+        if (refresh) {
+            [self lockedBeginRefreshOfHost:host];
+        }
+    }
+    [self.lock unlock];
+
+    if (refresh) {
+        [self refreshHost:host addressSource:(id<SPTDataLoaderResolverAddressSource> _Nonnull)addressSource];
+    }
+
+    // Expired addresses are only worth using while a source is refreshing them
+    if (expiryTime != nil && currentTime >= expiryTime.doubleValue && addressSource == nil) {
+        return host;
+    }
+
+    for (SPTDataLoaderResolverAddress *address in addresses) {
+        if (address.reachable) {
+            return address.address;
         }
     }
     return host;
 }
 
 - (void)setAddresses:(NSArray<NSString *> *)addresses forHost:(NSString *)host
+{
+    [self.lock lock];
+    [self lockedSetAddresses:addresses forHost:host];
+    [self.expiryTimes removeObjectForKey:host];
+    [self lockedPersist];
+    [self.lock unlock];
+}
+
+- (void)setAddresses:(NSArray<NSString *> *)addresses forHost:(NSString *)host timeToLive:(NSTimeInterval)timeToLive
+{
+    const CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    [self.lock lock];
+    [self lockedSetAddresses:addresses forHost:host];
+    self.expiryTimes[host] = @(currentTime + timeToLive);
+    [self lockedPersist];
+    [self.lock unlock];
+}
+
+- (void)lockedSetAddresses:(NSArray<NSString *> *)addresses forHost:(NSString *)host
 {
     NSMutableArray *mutableAddress = [NSMutableArray new];
     for (NSString *address in addresses) {
-        SPTDataLoaderResolverAddress *resolverAddress = [self resolverAddressForAddress:address];
+        SPTDataLoaderResolverAddress *resolverAddress = [self lockedResolverAddressForAddress:address];
         if (!resolverAddress) {
-            resolverAddress = [SPTDataLoaderResolverAddress dataLoaderResolverAddressWithAddress:address];
+            resolverAddress = [SPTDataLoaderResolverAddress dataLoaderResolverAddressWithAddress:address
+                                                                                 timeProvider:self.timeProvider];
+            resolverAddress.unreachablePeriod = _unreachablePeriod;
             [self.addresses addObject:resolverAddress];
         }
         [mutableAddress addObject:resolverAddress];
     }
-
-    @synchronized(self.resolverHost) {
-        self.resolverHost[host] = mutableAddress;
-    }
+    self.resolverHost[host] = mutableAddress;
 }
 
 - (void)markAddressAsUnreachable:(NSString *)address
 {
-    SPTDataLoaderResolverAddress *resolverAddress = [self resolverAddressForAddress:address];
+    [self.lock lock];
+    SPTDataLoaderResolverAddress *resolverAddress = [self lockedResolverAddressForAddress:address];
     [resolverAddress failedToReach];
+    if (resolverAddress != nil) {
+        [self lockedPersist];
+    }
+    [self.lock unlock];
 }
 
-- (SPTDataLoaderResolverAddress *)resolverAddressForAddress:(NSString *)address
+- (nullable SPTDataLoaderResolverAddress *)lockedResolverAddressForAddress:(NSString *)address
 {
-    NSArray *resolverAddresses = nil;
-    @synchronized(self.addresses) {
-        resolverAddresses = [self.addresses.allObjects copy];
-    }
-    for (SPTDataLoaderResolverAddress *resolverAddress in resolverAddresses) {
+    for (SPTDataLoaderResolverAddress *resolverAddress in self.addresses) {
         if ([resolverAddress.address isEqualToString:address]) {
             return resolverAddress;
         }
@@ -67,16 +161,193 @@
     return nil;
 }
 
-#pragma mark NSObject
+- (void)lockedBeginRefreshOfHost:(NSString *)host
+{
+    [self.refreshingHosts addObject:host];
+    [self.lookedUpHosts removeObject:host];
+}
 
-- (instancetype)init
+- (void)refreshHost:(NSString *)host addressSource:(id<SPTDataLoaderResolverAddressSource>)addressSource
+{
+    __weak __typeof(self) weakSelf = self;
+    [addressSource resolveAddressesForHost:host completion:^(NSArray<NSString *> * _Nullable addresses, NSTimeInterval timeToLive) {
+        [weakSelf resolvedAddresses:addresses timeToLive:timeToLive forHost:host];
+    }];
+}
+
+- (void)resolvedAddresses:(nullable NSArray<NSString *> *)addresses
+               timeToLive:(NSTimeInterval)timeToLive
+                  forHost:(NSString *)host
+{
+    // Refresh once most of the time to live has passed so the addresses are replaced before they expire
+    const double SPTDataLoaderResolverRefreshFraction = 0.8;
+    // A failed resolution keeps the addresses the resolver already has and is tried again after this long
+    const NSTimeInterval SPTDataLoaderResolverFailedRefreshInterval = 30.0;
+
+    const CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    const BOOL resolved = addresses.count > 0 && timeToLive > 0.0;
+    NSTimeInterval refreshInterval = resolved ? timeToLive * SPTDataLoaderResolverRefreshFraction : SPTDataLoaderResolverFailedRefreshInterval;
+
+    [self.lock lock];
+    [self.refreshingHosts removeObject:host];
+    self.refreshTimes[host] = @(currentTime + refreshInterval);
+    if (resolved) {
+        [self lockedSetAddresses:(NSArray<NSString *> * _Nonnull)addresses forHost:host];
+        self.expiryTimes[host] = @(currentTime + timeToLive);
+        [self lockedPersist];
+    }
+    [self.lock unlock];
+
+    if (!resolved) {
+        return;
+    }
+
+    // Hosts that are no longer looked up are left to expire rather than being refreshed forever
+    __weak __typeof(self) weakSelf = self;
+    [self.timeProvider dispatchAfter:refreshInterval
+                               queue:dispatch_get_global_queue(QOS_CLASS_UTILITY, 0)
+                               block:^{
+        [weakSelf refreshHostIfLookedUp:host];
+    }];
+}
+
+- (void)refreshHostIfLookedUp:(NSString *)host
+{
+    id<SPTDataLoaderResolverAddressSource> addressSource = self.addressSource;
+    if (addressSource == nil) {
+        return;
+    }
+
+    [self.lock lock];
+    BOOL refresh = [self.lookedUpHosts containsObject:host] && ![self.refreshingHosts containsObject:host];
+    if (refresh) {
+        [self lockedBeginRefreshOfHost:host];
+    }
+    [self.lock unlock];
+
+    if (refresh) {
+        [self refreshHost:host addressSource:addressSource];
+    }
+}
+
+- (void)flush
+{
+    if (self.persistenceURL == nil) {
+        return;
+    }
+    dispatch_sync(self.persistenceQueue, ^{});
+}
+
+- (void)lockedPersist
+{
+    NSURL *persistenceURL = self.persistenceURL;
+    if (persistenceURL == nil) {
+        return;
+    }
+
+    NSMutableDictionary<NSString *, NSDictionary *> *hosts = [NSMutableDictionary new];
+    for (NSString *host in self.resolverHost) {
+        NSMutableArray<NSDictionary *> *addresses = [NSMutableArray new];
+        for (SPTDataLoaderResolverAddress *resolverAddress in self.resolverHost[host]) {
+            [addresses addObject:@{ SPTDataLoaderResolverPersistenceAddressKey : resolverAddress.address,
+                                    SPTDataLoaderResolverPersistenceLastFailedTimeKey : @(resolverAddress.lastFailedTime) }];
+        }
+        NSMutableDictionary *record = [NSMutableDictionary dictionaryWithObject:addresses
+                                                                         forKey:SPTDataLoaderResolverPersistenceAddressesKey];
+        record[SPTDataLoaderResolverPersistenceExpiryTimeKey] = self.expiryTimes[host];
+        hosts[host] = record;
+    }
+
+    NSDictionary *state = @{ SPTDataLoaderResolverPersistenceHostsKey : hosts };
+    dispatch_async(self.persistenceQueue, ^{
+        NSData *data = [NSJSONSerialization dataWithJSONObject:state options:0 error:nil];
+        [data writeToURL:persistenceURL options:NSDataWritingAtomic error:nil];
+    });
+}
+
+- (void)load
+{
+    NSData *data = [NSData dataWithContentsOfURL:(NSURL * _Nonnull)self.persistenceURL options:0 error:nil];
+    if (data == nil) {
+        return;
+    }
+    NSDictionary *state = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    if (![state isKindOfClass:[NSDictionary class]]) {
+        return;
+    }
+    NSDictionary *hosts = state[SPTDataLoaderResolverPersistenceHostsKey];
+    if (![hosts isKindOfClass:[NSDictionary class]]) {
+        return;
+    }
+
+    for (NSString *host in hosts) {
+        NSDictionary *record = hosts[host];
+        NSArray<NSDictionary *> *records = [record isKindOfClass:[NSDictionary class]] ? record[SPTDataLoaderResolverPersistenceAddressesKey] : nil;
+        if (![records isKindOfClass:[NSArray class]]) {
+            continue;
+        }
+
+        NSMutableArray<NSString *> *addresses = [NSMutableArray new];
+        NSMutableArray<NSNumber *> *lastFailedTimes = [NSMutableArray new];
+        for (NSDictionary *addressRecord in records) {
+            NSString *address = [addressRecord isKindOfClass:[NSDictionary class]] ? addressRecord[SPTDataLoaderResolverPersistenceAddressKey] : nil;
+            if (![address isKindOfClass:[NSString class]]) {
+                continue;
+            }
+            [addresses addObject:address];
+            [lastFailedTimes addObject:@([addressRecord[SPTDataLoaderResolverPersistenceLastFailedTimeKey] doubleValue])];
+        }
+        [self lockedSetAddresses:addresses forHost:host];
+        [self.resolverHost[host] enumerateObjectsUsingBlock:^(SPTDataLoaderResolverAddress *resolverAddress, NSUInteger idx, BOOL *stop) {
+            resolverAddress.lastFailedTime = lastFailedTimes[idx].doubleValue;
+        }];
+
+        NSNumber *expiryTime = record[SPTDataLoaderResolverPersistenceExpiryTimeKey];
+        if ([expiryTime isKindOfClass:[NSNumber class]]) {
+            self.expiryTimes[host] = expiryTime;
+        }
+    }
+}
+
+- (instancetype)initWithTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
+    return [self initWithAddressSource:nil persistenceURL:nil timeProvider:timeProvider];
+}
+
+- (instancetype)initWithAddressSource:(nullable id<SPTDataLoaderResolverAddressSource>)addressSource
+                       persistenceURL:(nullable NSURL *)persistenceURL
+                         timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+{
+    const NSTimeInterval SPTDataLoaderResolverDefaultUnreachablePeriodOneHour = 60.0 * 60.0;
+
     self = [super init];
     if (self) {
+        _addressSource = addressSource;
+        _persistenceURL = [persistenceURL copy];
         _resolverHost = [NSMutableDictionary new];
         _addresses = [NSHashTable weakObjectsHashTable];
+        _expiryTimes = [NSMutableDictionary new];
+        _refreshTimes = [NSMutableDictionary new];
+        _refreshingHosts = [NSMutableSet new];
+        _lookedUpHosts = [NSMutableSet new];
+        _lock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderResolver"];
+        _timeProvider = timeProvider;
+        _persistenceQueue = dispatch_queue_create("com.spotify.dataloader.resolver", DISPATCH_QUEUE_SERIAL);
+        _unreachablePeriod = SPTDataLoaderResolverDefaultUnreachablePeriodOneHour;
+        if (_persistenceURL != nil) {
+            [self load];
+        }
     }
     return self;
 }
 
+#pragma mark NSObject
+
+- (instancetype)init
+{
+    return [self initWithTimeProvider:[SPTDataLoaderTimeProviderImplementation new]];
+}
+
 @end
+
+NS_ASSUME_NONNULL_END
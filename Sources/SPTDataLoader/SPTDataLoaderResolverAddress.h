@@ -5,6 +5,8 @@
 
 #import <Foundation/Foundation.h>
 
+@protocol SPTDataLoaderTimeProvider;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
@@ -20,12 +22,22 @@ NS_ASSUME_NONNULL_BEGIN
  Whether the IP address should currently be considered reachable
  */
 @property (nonatomic, assign, readonly, getter = isReachable) BOOL reachable;
+/**
+ The number of seconds the address is considered unreachable for after failing, an hour by default
+ */
+@property (nonatomic, assign) NSTimeInterval unreachablePeriod;
+/**
+ When the address last failed to be contacted, 0.0 if it never has
+ */
+@property (nonatomic, assign) CFAbsoluteTime lastFailedTime;
 
 /**
  Class constructor
  @param address The IP address to represent
+ @param timeProvider The clock used to decide when a failed address becomes reachable again
  */
-+ (instancetype)dataLoaderResolverAddressWithAddress:(NSString *)address;
++ (instancetype)dataLoaderResolverAddressWithAddress:(NSString *)address
+                                        timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider;
 
 /**
  Call when this address has failed to be contacted
@@ -5,12 +5,13 @@
 
 #import "SPTDataLoaderResolverAddress.h"
 
+#import "SPTDataLoaderTimeProvider.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface SPTDataLoaderResolverAddress ()
 
-@property (nonatomic, assign, readonly) NSTimeInterval stalePeriod;
-@property (nonatomic, assign) CFAbsoluteTime lastFailedTime;
+@property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
 
 @end
 
@@ -20,28 +21,30 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (BOOL)isReachable
 {
-    CFAbsoluteTime currentTime = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
     NSTimeInterval deltaTime = currentTime - self.lastFailedTime;
     if (deltaTime < 0.0) {
         return YES;
     }
 
-    return deltaTime > self.stalePeriod;
+    return deltaTime > self.unreachablePeriod;
 }
 
 + (instancetype)dataLoaderResolverAddressWithAddress:(NSString *)address
+                                        timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
-    return [[self alloc] initWithAddress:address];
+    return [[self alloc] initWithAddress:address timeProvider:timeProvider];
 }
 
-- (instancetype)initWithAddress:(NSString *)address
+- (instancetype)initWithAddress:(NSString *)address timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
 {
     const NSTimeInterval SPTDataLoaderResolverAddressDefaultStalePeriodOneHour = 60.0 * 60.0;
 
     self = [super init];
     if (self) {
         _address = address;
-        _stalePeriod = SPTDataLoaderResolverAddressDefaultStalePeriodOneHour;
+        _unreachablePeriod = SPTDataLoaderResolverAddressDefaultStalePeriodOneHour;
+        _timeProvider = timeProvider;
     }
 
     return self;
@@ -49,7 +52,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)failedToReach
 {
-    self.lastFailedTime = CFAbsoluteTimeGetCurrent();
+    self.lastFailedTime = self.timeProvider.currentTime;
 }
 
 @end
@@ -5,6 +5,7 @@
 
 #import <SPTDataLoader/SPTDataLoaderResponse.h>
 
+@class SPTDataLoaderRedirect;
 @class SPTDataLoaderRequest;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -26,6 +27,10 @@ NS_ASSUME_NONNULL_BEGIN
  Allows private consumers to alter the request time for the response
  */
 @property (nonatomic, assign, readwrite) NSTimeInterval requestTime;
+/**
+ Allows private consumers to record the redirects the request followed
+ */
+@property (nonatomic, copy, readwrite) NSArray<SPTDataLoaderRedirect *> *redirects;
 
 /**
  Class constructor
@@ -19,6 +19,7 @@ static NSString * const SPTDataLoaderResponseHeaderRetryAfter = @"Retry-After";
 @property (nonatomic, strong, readwrite) NSError *error;
 @property (nonatomic, strong, readwrite) NSData *body;
 @property (nonatomic, assign, readwrite) NSTimeInterval requestTime;
+@property (nonatomic, copy, readwrite) NSArray<SPTDataLoaderRedirect *> *redirects;
 
 @end
 
@@ -36,6 +37,7 @@ static NSString * const SPTDataLoaderResponseHeaderRetryAfter = @"Retry-After";
     self = [super init];
     if (self) {
         _request = request;
+        _redirects = @[];
 
         if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
             NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
@@ -78,6 +80,7 @@ static NSString * const SPTDataLoaderResponseHeaderRetryAfter = @"Retry-After";
             case SPTDataLoaderResponseHTTPStatusCodeUseProxy:
             case SPTDataLoaderResponseHTTPStatusCodeUnused:
             case SPTDataLoaderResponseHTTPStatusCodeTemporaryRedirect:
+            case SPTDataLoaderResponseHTTPStatusCodePermanentRedirect:
             case SPTDataLoaderResponseHTTPStatusCodeBadRequest:
             case SPTDataLoaderResponseHTTPStatusCodeUnauthorised:
             case SPTDataLoaderResponseHTTPStatusCodePaymentRequired:
@@ -0,0 +1,73 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "SPTDataLoaderRequestResponseHandler.h"
+
+@class SPTDataLoaderSegmentedDownload;
+
+@protocol SPTDataLoaderTimeProvider;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@protocol SPTDataLoaderSegmentedDownloadDelegate <NSObject>
+
+/**
+ Called once the download has delivered its response, failed or been cancelled
+ @param segmentedDownload The download that finished
+ */
+- (void)segmentedDownloadDidFinish:(SPTDataLoaderSegmentedDownload *)segmentedDownload;
+
+@end
+
+/**
+ Downloads a resource as byte ranges fetched in parallel and hands it on as a single response
+ @discussion The download acts as the request response handler of its segments, which are performed through the
+ request response handler delegate like any other request and so share its rate limiter and connection limits.
+ */
+@interface SPTDataLoaderSegmentedDownload : NSObject <SPTDataLoaderRequestResponseHandler>
+
+/**
+ The request the segments are downloaded for
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderRequest *request;
+/**
+ The largest resource in bytes the download accepts, 0 means no limit
+ */
+@property (nonatomic, assign) int64_t maximumResponseBodySize;
+
+/**
+ Whether a request asks for a segmented download that can be performed
+ @param request The request to check
+ */
++ (BOOL)canPerformRequest:(SPTDataLoaderRequest *)request;
+
+/**
+ Class constructor
+ @param request The request to download
+ @param requestResponseHandler The object to deliver the response of the request to
+ @param requestResponseHandlerDelegate The object performing the segments
+ @param timeProvider The clock used to time the request
+ @param delegate The object told when the download finishes
+ */
++ (instancetype)segmentedDownloadWithRequest:(SPTDataLoaderRequest *)request
+                      requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+              requestResponseHandlerDelegate:(id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
+                                timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                                    delegate:(id<SPTDataLoaderSegmentedDownloadDelegate>)delegate;
+
+/**
+ Performs the probe that the remaining segments are planned from
+ */
+- (void)start;
+/**
+ Cancels every segment that is still in flight
+ */
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
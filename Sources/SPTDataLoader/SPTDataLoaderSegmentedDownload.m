@@ -0,0 +1,539 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderSegmentedDownload.h"
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderResponse+Private.h"
+#import "SPTDataLoaderTimeProvider.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderSegmentedDownloadRangeHeader = @"Range";
+static NSString * const SPTDataLoaderSegmentedDownloadIfRangeHeader = @"If-Range";
+static NSString * const SPTDataLoaderSegmentedDownloadContentRangeHeader = @"Content-Range";
+static NSString * const SPTDataLoaderSegmentedDownloadContentLengthHeader = @"Content-Length";
+static NSString * const SPTDataLoaderSegmentedDownloadETagHeader = @"ETag";
+static NSString * const SPTDataLoaderSegmentedDownloadLastModifiedHeader = @"Last-Modified";
+static NSUInteger const SPTDataLoaderSegmentedDownloadMaximumPreallocatedLength = 4 * 1024 * 1024;
+
+/**
+ A single byte range of a segmented download
+ */
+@interface SPTDataLoaderSegmentedDownloadSegment : NSObject
+
+@property (nonatomic, strong, nullable) SPTDataLoaderRequest *request;
+@property (nonatomic, assign) NSUInteger offset;
+@property (nonatomic, assign) NSUInteger length;
+@property (nonatomic, assign) NSUInteger receivedLength;
+@property (nonatomic, assign) NSUInteger attemptCount;
+@property (nonatomic, assign) BOOL verified;
+@property (nonatomic, assign) BOOL completed;
+
+@end
+
+@implementation SPTDataLoaderSegmentedDownloadSegment
+
+@end
+
+@interface SPTDataLoaderSegmentedDownload ()
+
+@property (nonatomic, weak, readonly) id<SPTDataLoaderRequestResponseHandler> requestResponseHandler;
+@property (nonatomic, strong, readonly) id<SPTDataLoaderTimeProvider> timeProvider;
+@property (nonatomic, weak, readonly) id<SPTDataLoaderSegmentedDownloadDelegate> delegate;
+
+@property (nonatomic, strong, readonly) NSMutableArray<SPTDataLoaderSegmentedDownloadSegment *> *segments;
+@property (nonatomic, strong, nullable) NSMutableData *buffer;
+@property (nonatomic, strong, nullable) SPTDataLoaderResponse *probeResponse;
+@property (nonatomic, assign) NSUInteger totalLength;
+@property (nonatomic, assign) BOOL passthrough;
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, assign) CFAbsoluteTime absoluteStartTime;
+
+@end
+
+@implementation SPTDataLoaderSegmentedDownload
+
+#pragma mark SPTDataLoaderSegmentedDownload
+
++ (BOOL)canPerformRequest:(SPTDataLoaderRequest *)request
+{
+    return request.segmentCount > 1
+        && request.method == SPTDataLoaderRequestMethodGet
+        && !request.chunks
+        && request.backgroundPolicy != SPTDataLoaderRequestBackgroundPolicyAlways
+        && request.headers[SPTDataLoaderSegmentedDownloadRangeHeader] == nil;
+}
+
++ (instancetype)segmentedDownloadWithRequest:(SPTDataLoaderRequest *)request
+                      requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+              requestResponseHandlerDelegate:(id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
+                                timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                                    delegate:(id<SPTDataLoaderSegmentedDownloadDelegate>)delegate
+{
+    return [[self alloc] initWithRequest:request
+                  requestResponseHandler:requestResponseHandler
+          requestResponseHandlerDelegate:requestResponseHandlerDelegate
+                            timeProvider:timeProvider
+                                delegate:delegate];
+}
+
+- (instancetype)initWithRequest:(SPTDataLoaderRequest *)request
+         requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+ requestResponseHandlerDelegate:(id<SPTDataLoaderRequestResponseHandlerDelegate>)requestResponseHandlerDelegate
+                   timeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+                       delegate:(id<SPTDataLoaderSegmentedDownloadDelegate>)delegate
+{
+    self = [super init];
+    if (self) {
+        _request = request;
+        _requestResponseHandler = requestResponseHandler;
+        _requestResponseHandlerDelegate = requestResponseHandlerDelegate;
+        _timeProvider = timeProvider;
+        _delegate = delegate;
+        _segments = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)start
+{
+    SPTDataLoaderSegmentedDownloadSegment *probe = [SPTDataLoaderSegmentedDownloadSegment new];
+    probe.length = MAX(self.request.minimumSegmentSize, (NSUInteger)1);
+    @synchronized(self) {
+        self.absoluteStartTime = self.timeProvider.currentTime;
+        [self.segments addObject:probe];
+    }
+    [self performSegment:probe];
+}
+
+- (void)cancel
+{
+    [self cancelSegmentsExcept:nil];
+}
+
+#pragma mark Private
+
+- (void)performSegment:(SPTDataLoaderSegmentedDownloadSegment *)segment
+{
+    SPTDataLoaderRequest *request = [self.request copy];
+    request.segmentCount = 0;
+    request.chunks = YES;
+    request.maximumInFlightChunks = 0;
+    request.minimumChunkSize = 0;
+    request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyDefault;
+
+    NSString *range = [NSString stringWithFormat:@"bytes=%lu-%lu",
+                       (unsigned long)segment.offset,
+                       (unsigned long)(segment.offset + segment.length - 1)];
+    [request addValue:range forHeader:SPTDataLoaderSegmentedDownloadRangeHeader];
+
+    @synchronized(self) {
+        // A changed resource must not be stitched together with the bytes of the old one
+        NSString *validator = [self strongValidatorForResponse:self.probeResponse];
+        if (validator != nil) {
+            [request addValue:(NSString * _Nonnull)validator forHeader:SPTDataLoaderSegmentedDownloadIfRangeHeader];
+        }
+        segment.request = request;
+        segment.attemptCount++;
+        segment.receivedLength = 0;
+        segment.verified = NO;
+    }
+
+    [self.requestResponseHandlerDelegate requestResponseHandler:self performRequest:request];
+}
+
+- (nullable SPTDataLoaderSegmentedDownloadSegment *)segmentForRequest:(SPTDataLoaderRequest *)request
+{
+    for (SPTDataLoaderSegmentedDownloadSegment *segment in self.segments) {
+        if (segment.request == request) {
+            return segment;
+        }
+    }
+    return nil;
+}
+
+- (NSArray<SPTDataLoaderSegmentedDownloadSegment *> *)planSegmentsWithProbeResponse:(SPTDataLoaderResponse *)response
+                                                                              probe:(SPTDataLoaderSegmentedDownloadSegment *)probe
+{
+    self.probeResponse = response;
+
+    NSUInteger firstByte = 0;
+    NSUInteger lastByte = 0;
+    NSUInteger totalLength = 0;
+    BOOL ranged = response.statusCode == SPTDataLoaderResponseHTTPStatusCodePartialContent
+        && [self parseContentRangeOfResponse:response firstByte:&firstByte lastByte:&lastByte totalLength:&totalLength]
+        && firstByte == 0
+        && lastByte == MIN(probe.length, totalLength) - 1;
+    if (!ranged) {
+        // The server ignored the range, the probe carries the whole resource
+        self.passthrough = YES;
+        self.buffer = [NSMutableData data];
+        probe.verified = YES;
+        return @[];
+    }
+
+    // The buffer grows as the segments arrive, the total announced by the server reserves no more than the cap
+    self.totalLength = totalLength;
+    self.buffer = [NSMutableData dataWithCapacity:MIN(totalLength, SPTDataLoaderSegmentedDownloadMaximumPreallocatedLength)];
+    probe.length = lastByte + 1;
+    probe.verified = YES;
+
+    NSUInteger remainingLength = totalLength - probe.length;
+    if (remainingLength == 0) {
+        return @[];
+    }
+
+    NSUInteger minimumSegmentSize = MAX(self.request.minimumSegmentSize, (NSUInteger)1);
+    NSUInteger segmentCount = MIN(self.request.segmentCount - 1, (remainingLength + minimumSegmentSize - 1) / minimumSegmentSize);
+    segmentCount = MAX(segmentCount, (NSUInteger)1);
+    NSUInteger segmentLength = (remainingLength + segmentCount - 1) / segmentCount;
+
+    NSMutableArray<SPTDataLoaderSegmentedDownloadSegment *> *segments = [NSMutableArray arrayWithCapacity:segmentCount];
+    for (NSUInteger offset = probe.length; offset < totalLength; offset += segmentLength) {
+        SPTDataLoaderSegmentedDownloadSegment *segment = [SPTDataLoaderSegmentedDownloadSegment new];
+        segment.offset = offset;
+        segment.length = MIN(segmentLength, totalLength - offset);
+        [segments addObject:segment];
+    }
+    [self.segments addObjectsFromArray:segments];
+    return segments;
+}
+
+- (BOOL)exceedsMaximumResponseBodySizeWithProbeResponse:(SPTDataLoaderResponse *)response
+{
+    const int64_t maximumResponseBodySize = self.maximumResponseBodySize;
+    NSUInteger firstByte = 0;
+    NSUInteger lastByte = 0;
+    NSUInteger totalLength = 0;
+    if (maximumResponseBodySize <= 0
+        || response.statusCode != SPTDataLoaderResponseHTTPStatusCodePartialContent
+        || ![self parseContentRangeOfResponse:response firstByte:&firstByte lastByte:&lastByte totalLength:&totalLength]) {
+        return NO;
+    }
+    return (unsigned long long)totalLength > (unsigned long long)maximumResponseBodySize;
+}
+
+- (BOOL)verifyResponse:(SPTDataLoaderResponse *)response forSegment:(SPTDataLoaderSegmentedDownloadSegment *)segment
+{
+    NSUInteger firstByte = 0;
+    NSUInteger lastByte = 0;
+    NSUInteger totalLength = 0;
+    if (response.statusCode != SPTDataLoaderResponseHTTPStatusCodePartialContent
+        || ![self parseContentRangeOfResponse:response firstByte:&firstByte lastByte:&lastByte totalLength:&totalLength]) {
+        return NO;
+    }
+    if (firstByte != segment.offset || lastByte != segment.offset + segment.length - 1 || totalLength != self.totalLength) {
+        return NO;
+    }
+
+    SPTDataLoaderResponse *probeResponse = self.probeResponse;
+    for (NSString *header in @[ SPTDataLoaderSegmentedDownloadETagHeader, SPTDataLoaderSegmentedDownloadLastModifiedHeader ]) {
+        NSString *expectedValue = [self valueForHeader:header inResponse:probeResponse];
+        if (expectedValue != nil && ![[self valueForHeader:header inResponse:response] isEqualToString:(NSString * _Nonnull)expectedValue]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)parseContentRangeOfResponse:(SPTDataLoaderResponse *)response
+                          firstByte:(NSUInteger *)firstByte
+                           lastByte:(NSUInteger *)lastByte
+                        totalLength:(NSUInteger *)totalLength
+{
+    NSString *contentRange = [self valueForHeader:SPTDataLoaderSegmentedDownloadContentRangeHeader inResponse:response];
+    if (contentRange == nil) {
+        return NO;
+    }
+
+    // bytes <first>-<last>/<total>, a total of * means the size is unknown and the resource cannot be split
+    NSScanner *scanner = [NSScanner scannerWithString:(NSString * _Nonnull)contentRange];
+    unsigned long long first = 0;
+    unsigned long long last = 0;
+    unsigned long long total = 0;
+    BOOL parsed = [scanner scanString:@"bytes" intoString:NULL]
+        && [scanner scanUnsignedLongLong:&first]
+        && [scanner scanString:@"-" intoString:NULL]
+        && [scanner scanUnsignedLongLong:&last]
+        && [scanner scanString:@"/" intoString:NULL]
+        && [scanner scanUnsignedLongLong:&total]
+        && scanner.isAtEnd;
+    if (!parsed || first > last || last >= total || total > NSUIntegerMax) {
+        return NO;
+    }
+
+    *firstByte = (NSUInteger)first;
+    *lastByte = (NSUInteger)last;
+    *totalLength = (NSUInteger)total;
+    return YES;
+}
+
+- (nullable NSString *)strongValidatorForResponse:(nullable SPTDataLoaderResponse *)response
+{
+    NSString * const SPTDataLoaderSegmentedDownloadWeakETagPrefix = @"W/";
+
+    if (response == nil || self.passthrough) {
+        return nil;
+    }
+
+    NSString *eTag = [self valueForHeader:SPTDataLoaderSegmentedDownloadETagHeader inResponse:(SPTDataLoaderResponse * _Nonnull)response];
+    if (eTag.length > 0 && ![eTag hasPrefix:SPTDataLoaderSegmentedDownloadWeakETagPrefix]) {
+        return eTag;
+    }
+    NSString *lastModified = [self valueForHeader:SPTDataLoaderSegmentedDownloadLastModifiedHeader inResponse:(SPTDataLoaderResponse * _Nonnull)response];
+    return lastModified.length > 0 ? lastModified : nil;
+}
+
+- (nullable NSString *)valueForHeader:(NSString *)header inResponse:(SPTDataLoaderResponse *)response
+{
+    NSDictionary<NSString *, NSString *> *headers = response.responseHeaders;
+    for (NSString *key in headers) {
+        if ([key caseInsensitiveCompare:header] == NSOrderedSame) {
+            return headers[key];
+        }
+    }
+    return nil;
+}
+
+- (SPTDataLoaderResponse *)responseForRequestWithStatusCode:(NSInteger)statusCode
+                                                    headers:(nullable NSDictionary<NSString *, NSString *> *)headers
+                                                resolvedURL:(nullable NSURL *)resolvedURL
+{
+    NSHTTPURLResponse *URLResponse = nil;
+    if (statusCode != 0) {
+        URLResponse = [[NSHTTPURLResponse alloc] initWithURL:resolvedURL ?: self.request.URL
+                                                  statusCode:statusCode
+                                                 HTTPVersion:nil
+                                                headerFields:headers];
+    }
+
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:self.request response:URLResponse];
+    response.requestTime = self.timeProvider.currentTime - self.absoluteStartTime;
+    return response;
+}
+
+- (void)cancelSegmentsExcept:(nullable SPTDataLoaderSegmentedDownloadSegment *)exceptedSegment
+{
+    NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray new];
+    @synchronized(self) {
+        for (SPTDataLoaderSegmentedDownloadSegment *segment in self.segments) {
+            if (segment != exceptedSegment && !segment.completed && segment.request != nil) {
+                [requests addObject:(SPTDataLoaderRequest * _Nonnull)segment.request];
+            }
+        }
+    }
+
+    id<SPTDataLoaderRequestResponseHandlerDelegate> requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    for (SPTDataLoaderRequest *request in requests) {
+        [requestResponseHandlerDelegate requestResponseHandler:self cancelRequest:request];
+    }
+}
+
+- (void)completeWithResponse:(SPTDataLoaderResponse *)response
+{
+    [self.requestResponseHandler successfulResponse:response];
+    [self.delegate segmentedDownloadDidFinish:self];
+}
+
+- (void)failWithResponse:(SPTDataLoaderResponse *)response segment:(SPTDataLoaderSegmentedDownloadSegment *)segment
+{
+    [self cancelSegmentsExcept:segment];
+    [self.requestResponseHandler failedResponse:response];
+    [self.delegate segmentedDownloadDidFinish:self];
+}
+
+#pragma mark SPTDataLoaderRequestResponseHandler
+
+@synthesize requestResponseHandlerDelegate = _requestResponseHandlerDelegate;
+
+- (void)successfulResponse:(SPTDataLoaderResponse *)response
+{
+    SPTDataLoaderSegmentedDownloadSegment *segment = nil;
+    SPTDataLoaderResponse *completedResponse = nil;
+    SPTDataLoaderResponse *failedResponse = nil;
+    BOOL retry = NO;
+
+    @synchronized(self) {
+        segment = [self segmentForRequest:response.request];
+        if (segment == nil || self.finished) {
+            return;
+        }
+
+        BOOL valid = segment.verified && (self.passthrough || segment.receivedLength == segment.length);
+        if (valid) {
+            segment.completed = YES;
+            BOOL allCompleted = YES;
+            for (SPTDataLoaderSegmentedDownloadSegment *otherSegment in self.segments) {
+                allCompleted = allCompleted && otherSegment.completed;
+            }
+            if (allCompleted) {
+                self.finished = YES;
+                completedResponse = [self completedResponse];
+            }
+        } else if (segment.attemptCount <= self.request.maximumRetryCount) {
+            retry = YES;
+        } else {
+            self.finished = YES;
+            failedResponse = [self responseForRequestWithStatusCode:0 headers:nil resolvedURL:nil];
+            failedResponse.error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                                       code:SPTDataLoaderRequestErrorSegmentVerificationFailed
+                                                   userInfo:nil];
+        }
+    }
+
+    if (retry) {
+        [self performSegment:segment];
+    } else if (failedResponse != nil) {
+        [self failWithResponse:failedResponse segment:segment];
+    } else if (completedResponse != nil) {
+        [self completeWithResponse:completedResponse];
+    }
+}
+
+- (SPTDataLoaderResponse *)completedResponse
+{
+    SPTDataLoaderResponse *probeResponse = (SPTDataLoaderResponse * _Nonnull)self.probeResponse;
+    NSMutableDictionary<NSString *, NSString *> *headers = [probeResponse.responseHeaders mutableCopy] ?: [NSMutableDictionary new];
+    NSInteger statusCode = probeResponse.statusCode;
+    if (!self.passthrough) {
+        // Present the stitched ranges as the plain response the request asked for
+        for (NSString *header in headers.allKeys) {
+            if ([header caseInsensitiveCompare:SPTDataLoaderSegmentedDownloadContentRangeHeader] == NSOrderedSame
+                || [header caseInsensitiveCompare:SPTDataLoaderSegmentedDownloadContentLengthHeader] == NSOrderedSame) {
+                [headers removeObjectForKey:header];
+            }
+        }
+        headers[SPTDataLoaderSegmentedDownloadContentLengthHeader] = @(self.totalLength).stringValue;
+        statusCode = SPTDataLoaderResponseHTTPStatusCodeOK;
+    }
+
+    SPTDataLoaderResponse *response = [self responseForRequestWithStatusCode:statusCode
+                                                                     headers:headers
+                                                                 resolvedURL:probeResponse.resolvedURL];
+    response.body = self.buffer;
+    return response;
+}
+
+- (void)failedResponse:(SPTDataLoaderResponse *)response
+{
+    SPTDataLoaderSegmentedDownloadSegment *segment = nil;
+    SPTDataLoaderResponse *failedResponse = nil;
+    @synchronized(self) {
+        segment = [self segmentForRequest:response.request];
+        if (segment == nil || self.finished) {
+            return;
+        }
+        self.finished = YES;
+
+        // The segment has been retried by its task handler already
+        failedResponse = [self responseForRequestWithStatusCode:response.statusCode
+                                                        headers:response.responseHeaders
+                                                    resolvedURL:response.resolvedURL];
+        failedResponse.error = response.error;
+        failedResponse.body = response.body;
+    }
+
+    [self failWithResponse:failedResponse segment:segment];
+}
+
+- (void)cancelledRequest:(SPTDataLoaderRequest *)request
+{
+    SPTDataLoaderSegmentedDownloadSegment *segment = nil;
+    @synchronized(self) {
+        segment = [self segmentForRequest:request];
+        if (segment == nil || self.finished) {
+            return;
+        }
+        self.finished = YES;
+    }
+
+    [self cancelSegmentsExcept:segment];
+    [self.requestResponseHandler cancelledRequest:self.request];
+    [self.delegate segmentedDownloadDidFinish:self];
+}
+
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler
+{
+    @synchronized(self) {
+        SPTDataLoaderSegmentedDownloadSegment *segment = [self segmentForRequest:response.request];
+        if (segment != nil && segment.verified && !self.finished) {
+            if (self.passthrough) {
+                [self.buffer appendData:data];
+            } else if (segment.receivedLength + data.length <= segment.length) {
+                NSUInteger end = segment.offset + segment.receivedLength + data.length;
+                if (self.buffer.length < end) {
+                    self.buffer.length = end;
+                }
+                [self.buffer replaceBytesInRange:NSMakeRange(segment.offset + segment.receivedLength, data.length)
+                                       withBytes:data.bytes];
+            }
+            segment.receivedLength += data.length;
+        }
+    }
+    completionHandler();
+}
+
+- (void)receivedInitialResponse:(SPTDataLoaderResponse *)response
+{
+    NSArray<SPTDataLoaderSegmentedDownloadSegment *> *plannedSegments = nil;
+    SPTDataLoaderResponse *failedResponse = nil;
+    @synchronized(self) {
+        SPTDataLoaderSegmentedDownloadSegment *segment = [self segmentForRequest:response.request];
+        if (segment == nil || self.finished) {
+            return;
+        }
+
+        // Every attempt of a segment starts writing from its first byte again
+        segment.receivedLength = 0;
+        if (self.probeResponse == nil && [self exceedsMaximumResponseBodySizeWithProbeResponse:response]) {
+            // The total comes from the server, a resource larger than allowed is never planned or buffered
+            self.finished = YES;
+            failedResponse = [self responseForRequestWithStatusCode:response.statusCode
+                                                            headers:response.responseHeaders
+                                                        resolvedURL:response.resolvedURL];
+            failedResponse.error = [NSError errorWithDomain:SPTDataLoaderRequestErrorDomain
+                                                       code:SPTDataLoaderRequestErrorResponseTooLarge
+                                                   userInfo:@{ NSLocalizedDescriptionKey : @"The response body exceeds the maximum response body size" }];
+        } else if (self.probeResponse == nil) {
+            plannedSegments = [self planSegmentsWithProbeResponse:response probe:segment];
+        } else if (self.passthrough) {
+            self.buffer.length = 0;
+            segment.verified = YES;
+        } else {
+            segment.verified = [self verifyResponse:response forSegment:segment];
+        }
+    }
+
+    if (failedResponse != nil) {
+        [self cancelSegmentsExcept:nil];
+        [self.requestResponseHandler failedResponse:failedResponse];
+        [self.delegate segmentedDownloadDidFinish:self];
+        return;
+    }
+
+    for (SPTDataLoaderSegmentedDownloadSegment *segment in plannedSegments) {
+        [self performSegment:segment];
+    }
+}
+
+- (void)requestIsWaitingForConnectivity:(SPTDataLoaderRequest *)request
+{
+    [self.requestResponseHandler requestIsWaitingForConnectivity:self.request];
+}
+
+- (void)needsNewBodyStream:(void (^)(NSInputStream *))completionHandler
+                forRequest:(SPTDataLoaderRequest *)request
+{
+    completionHandler(request.bodyStream);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -5,14 +5,26 @@
 
 #import <SPTDataLoader/SPTDataLoaderService.h>
 
+@class SPTDataLoaderTraceContext;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol SPTDataLoaderServiceSessionSelector;
+@protocol SPTDataLoaderTimeProvider;
 
 
 @interface SPTDataLoaderService ()
 
 @property (nonatomic, strong) id<SPTDataLoaderServiceSessionSelector> sessionSelector;
+/**
+ The clock used for request timing, retries and timeouts
+ @discussion Factories created after it is set use the same clock.
+ */
+@property (nonatomic, strong) id<SPTDataLoaderTimeProvider> timeProvider;
+/**
+ The context shared with every factory, data loader and task handler of the service to trace their requests
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderTraceContext *traceContext;
 
 @end
 
@@ -9,21 +9,37 @@
 #import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
 #import <SPTDataLoader/SPTDataLoaderResolver.h>
 #import <SPTDataLoader/SPTDataLoaderConsumptionObserver.h>
+#import <SPTDataLoader/SPTDataLoaderMetricsRegistry.h>
 #import <SPTDataLoader/SPTDataLoaderServerTrustPolicy.h>
 
 #import "SPTDataLoaderFactory+Private.h"
+#import "SPTDataLoaderInFlightRequest+Private.h"
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderMetricsRegistry+Private.h"
+#import "SPTDataLoaderPreloader.h"
+#import "SPTDataLoaderRedirect+Private.h"
+#import "SPTDataLoaderRedirectCache.h"
 #import "SPTDataLoaderRequest+Private.h"
 #import "SPTDataLoaderRequestResponseHandler.h"
 #import "SPTDataLoaderResponse+Private.h"
 #import "SPTDataLoaderRequestTaskHandler.h"
+#import "SPTDataLoaderSegmentedDownload.h"
 #import "SPTDataLoaderServiceSessionSelector.h"
+#import "SPTDataLoaderTimeProviderImplementation.h"
+#import "SPTDataLoaderTraceContext.h"
 #import "NSDictionary+HeaderSize.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+static NSString * const SPTDataLoaderServicePrewarmSourceIdentifier = @"prewarm";
+
+typedef void (^SPTDataLoaderServicePrewarmHandler)(NSError * _Nullable error);
+
 @interface SPTDataLoaderService () <
     SPTDataLoaderRequestTaskHandlerDelegate,
+    SPTDataLoaderSegmentedDownloadDelegate,
     SPTDataLoaderRequestResponseHandlerDelegate,
+    SPTDataLoaderPreloaderDelegate,
     NSURLSessionDataDelegate,
     NSURLSessionTaskDelegate,
     NSURLSessionDownloadDelegate
@@ -31,10 +47,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, nullable) SPTDataLoaderRateLimiter *rateLimiter;
 @property (nonatomic, strong, nullable) SPTDataLoaderResolver *resolver;
+@property (nonatomic, strong) SPTDataLoaderRedirectCache *redirectCache;
+@property (nonatomic, strong) SPTDataLoaderPreloader *preloader;
 
 @property (nonatomic, strong) NSOperationQueue *sessionQueue;
-@property (nonatomic, strong) NSMutableArray<SPTDataLoaderRequestTaskHandler *> *handlers;
+@property (nonatomic, strong) NSMapTable<NSURLSessionTask *, SPTDataLoaderRequestTaskHandler *> *handlersByTask;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, SPTDataLoaderRequestTaskHandler *> *handlersByRequest;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableSet<SPTDataLoaderRequestTaskHandler *> *> *handlersByTag;
+@property (nonatomic, strong) SPTDataLoaderLock *handlersLock;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderSegmentedDownload *> *segmentedDownloads;
+@property (nonatomic, strong) SPTDataLoaderLock *segmentedDownloadsLock;
+@property (nonatomic, strong) NSMapTable<NSURLSessionTask *, SPTDataLoaderServicePrewarmHandler> *prewarmHandlers;
+@property (nonatomic, strong) SPTDataLoaderLock *prewarmHandlersLock;
 @property (nonatomic, strong) NSMapTable<id<SPTDataLoaderConsumptionObserver>, dispatch_queue_t> *consumptionObservers;
+@property (nonatomic, strong) SPTDataLoaderLock *consumptionObserversLock;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, NSNumber *> *authorisingRequests;
+@property (nonatomic, strong) SPTDataLoaderLock *authorisingRequestsLock;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, NSNumber *> *preloadWaitingRequests;
+@property (nonatomic, strong) SPTDataLoaderLock *preloadWaitingRequestsLock;
+@property (nonatomic, assign) NSUInteger watchdogGeneration;
+@property (nonatomic, strong) NSMapTable<SPTDataLoaderRequest *, NSNumber *> *reportedStuckRequests;
+@property (nonatomic, strong) SPTDataLoaderLock *watchdogLock;
 @property (nonatomic, strong) SPTDataLoaderServerTrustPolicy *serverTrustPolicy;
 @property (nonatomic, weak, nullable) NSFileManager *fileManager;
 @property (nonatomic, weak, nullable) Class dataClass;
@@ -111,6 +144,7 @@ NS_ASSUME_NONNULL_BEGIN
                              resolver:(nullable SPTDataLoaderResolver *)resolver
 {
     const NSUInteger SPTDataLoaderServiceMaxConcurrentOperations = 32;
+    const NSUInteger SPTDataLoaderServiceMaximumCachedRedirects = 256;
 
     self = [super init];
     if (self) {
@@ -120,11 +154,32 @@ NS_ASSUME_NONNULL_BEGIN
         _sessionQueue = [NSOperationQueue new];
         _sessionQueue.maxConcurrentOperationCount = SPTDataLoaderServiceMaxConcurrentOperations;
         _sessionQueue.name = NSStringFromClass(self.class);
+        _timeProvider = [SPTDataLoaderTimeProviderImplementation new];
         _sessionSelector = [[SPTDataLoaderServiceDefaultSessionSelector alloc] initWithConfiguration:configuration
                                                                                             delegate:self
                                                                                        delegateQueue:_sessionQueue];
-        _handlers = [NSMutableArray new];
+        _sessionSelector.timeProvider = _timeProvider;
+        _redirectCache = [SPTDataLoaderRedirectCache redirectCacheWithCapacity:SPTDataLoaderServiceMaximumCachedRedirects
+                                                                  timeProvider:_timeProvider];
+        _preloader = [SPTDataLoaderPreloader preloaderWithTimeProvider:_timeProvider delegate:self];
+        _traceContext = [SPTDataLoaderTraceContext new];
+        _metricsRegistry = [SPTDataLoaderMetricsRegistry new];
+        _handlersByTask = [NSMapTable strongToStrongObjectsMapTable];
+        _handlersByRequest = [NSMapTable strongToStrongObjectsMapTable];
+        _handlersByTag = [NSMutableDictionary new];
+        _handlersLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.handlers"];
+        _segmentedDownloads = [NSMutableArray new];
+        _segmentedDownloadsLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.segmentedDownloads"];
+        _prewarmHandlers = [NSMapTable strongToStrongObjectsMapTable];
+        _prewarmHandlersLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.prewarmHandlers"];
         _consumptionObservers = [NSMapTable weakToStrongObjectsMapTable];
+        _consumptionObserversLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.consumptionObservers"];
+        _authorisingRequests = [NSMapTable weakToStrongObjectsMapTable];
+        _authorisingRequestsLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.authorisingRequests"];
+        _preloadWaitingRequests = [NSMapTable weakToStrongObjectsMapTable];
+        _preloadWaitingRequestsLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.preloadWaitingRequests"];
+        _reportedStuckRequests = [NSMapTable weakToStrongObjectsMapTable];
+        _watchdogLock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderService.watchdog"];
 
         _fileManager = [NSFileManager defaultManager];
         _dataClass = [NSData class];
@@ -165,107 +220,702 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (SPTDataLoaderFactory *)createDataLoaderFactoryWithAuthorisers:(nullable NSArray<id<SPTDataLoaderAuthoriser>> *)authorisers
 {
-    return [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:self authorisers:authorisers];
+    SPTDataLoaderFactory *factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:self
+                                                                                                  authorisers:authorisers
+                                                                                                 timeProvider:self.timeProvider];
+    factory.traceContext = self.traceContext;
+    return factory;
+}
+
+- (nullable id<SPTDataLoaderTracer>)tracer
+{
+    return self.traceContext.tracer;
+}
+
+- (void)setTracer:(nullable id<SPTDataLoaderTracer>)tracer
+{
+    self.traceContext.tracer = tracer;
 }
 
 - (void)addConsumptionObserver:(id<SPTDataLoaderConsumptionObserver>)consumptionObserver on:(dispatch_queue_t)queue
 {
     if (consumptionObserver && queue) {
-        @synchronized(self.consumptionObservers) {
-            [self.consumptionObservers setObject:queue forKey:consumptionObserver];
-        }
+        [self.consumptionObserversLock lock];
+        [self.consumptionObservers setObject:queue forKey:consumptionObserver];
+        [self.consumptionObserversLock unlock];
     }
 }
 
 - (void)removeConsumptionObserver:(id<SPTDataLoaderConsumptionObserver>)consumptionObserver
 {
     if (consumptionObserver) {
-        @synchronized(self.consumptionObservers) {
-            [self.consumptionObservers removeObjectForKey:consumptionObserver];
-        }
+        [self.consumptionObserversLock lock];
+        [self.consumptionObservers removeObjectForKey:consumptionObserver];
+        [self.consumptionObserversLock unlock];
     }
 }
 
 - (nullable SPTDataLoaderRequestTaskHandler *)handlerForTask:(NSURLSessionTask *)task
 {
-    NSArray *handlers = nil;
-    @synchronized(self.handlers) {
-        handlers = [self.handlers copy];
-    }
-    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
-        if ([handler.task isEqual:task]) {
-            return handler;
-        }
+    SPTDataLoaderRequestTaskHandler *handler = nil;
+    [self.handlersLock lock];
+    handler = [self.handlersByTask objectForKey:task];
+    [self.handlersLock unlock];
+    return handler;
+}
+
+- (void)setTask:(NSURLSessionTask *)task ofHandler:(SPTDataLoaderRequestTaskHandler *)handler
+{
+    // Handlers are looked up by their task, so the task is only replaced together with the key
+    [self.handlersLock lock];
+    NSURLSessionTask *previousTask = handler.task;
+    if ([self.handlersByTask objectForKey:previousTask] == handler) {
+        [self.handlersByTask removeObjectForKey:previousTask];
+        [self.handlersByTask setObject:handler forKey:task];
     }
-    return nil;
+    handler.task = task;
+    [self.handlersLock unlock];
+}
+
+- (NSURLSessionTask *)createTaskForRequest:(SPTDataLoaderRequest *)request
+{
+    return [self createTaskForRequest:request additionalHeaders:nil];
 }
 
 - (NSURLSessionTask *)createTaskForRequest:(SPTDataLoaderRequest *)request
+                         additionalHeaders:(nullable NSDictionary<NSString *, NSString *> *)additionalHeaders
+{
+    return [self createTaskForRequest:request additionalHeaders:additionalHeaders loadsPreloadedResponse:NO];
+}
+
+- (NSURLSessionTask *)createTaskForRequest:(SPTDataLoaderRequest *)request
+                         additionalHeaders:(nullable NSDictionary<NSString *, NSString *> *)additionalHeaders
+                    loadsPreloadedResponse:(BOOL)loadsPreloadedResponse
 {
     NSURLSession *session = [self.sessionSelector URLSessionForRequest:request];
     NSURLRequest *urlRequest = request.urlRequest;
+    CFAbsoluteTime deadline = request.deadline;
+    NSTimeInterval remainingTime = deadline > 0.0 ? deadline - self.timeProvider.currentTime : 0.0;
+    BOOL shortensTimeout = remainingTime > 0.0 && remainingTime < urlRequest.timeoutInterval;
+    if (additionalHeaders.count > 0 || shortensTimeout || loadsPreloadedResponse) {
+        NSMutableURLRequest *mutableURLRequest = [urlRequest mutableCopy];
+        for (NSString *header in additionalHeaders) {
+            [mutableURLRequest setValue:additionalHeaders[header] forHTTPHeaderField:header];
+        }
+        if (shortensTimeout) {
+            // A task outliving the deadline of its request would only load a response nobody is waiting for
+            mutableURLRequest.timeoutInterval = remainingTime;
+        }
+        if (loadsPreloadedResponse) {
+            // Only this task reads the preloaded response, the request and its retries keep their own cache policy
+            mutableURLRequest.cachePolicy = NSURLRequestReturnCacheDataElseLoad;
+        }
+        urlRequest = mutableURLRequest;
+    }
 
-    if (request.backgroundPolicy == SPTDataLoaderRequestBackgroundPolicyAlways) {
-        return [session downloadTaskWithRequest:urlRequest];
+    NSURLSessionTask *task = nil;
+    NSURL *bodyFileURL = request.bodyFileURL;
+    if (bodyFileURL != nil) {
+        // Upload tasks stream the file from disk instead of holding the body in memory
+        task = [session uploadTaskWithRequest:urlRequest fromFile:(NSURL * _Nonnull)bodyFileURL];
+    } else if (request.backgroundPolicy == SPTDataLoaderRequestBackgroundPolicyAlways) {
+        task = [session downloadTaskWithRequest:urlRequest];
+    } else if (request.bodyStream != nil && request.compressesBody) {
+        // The session asks for the body stream of every streamed upload task, so each task compresses a fresh stream
+        task = [session uploadTaskWithStreamedRequest:urlRequest];
+    } else {
+        task = [session dataTaskWithRequest:urlRequest];
     }
+    task.priority = request.priority;
+    [self.sessionSelector URLSession:session didCreateTask:task];
 
-    return [session dataTaskWithRequest:urlRequest];
+    return task;
+}
+
+- (nullable NSURL *)resolvedURLForURL:(NSURL *)URL
+{
+    if (URL.host == nil || self.resolver == nil) {
+        return URL;
+    }
+
+    NSString *requestHost = (NSString * _Nonnull)URL.host;
+    NSString *hostAddress = [self.resolver addressForHost:requestHost];
+    if ([hostAddress isEqualToString:requestHost]) {
+        return URL;
+    }
+
+    NSURLComponents *requestComponents = [NSURLComponents componentsWithURL:URL resolvingAgainstBaseURL:NO];
+    requestComponents.host = hostAddress;
+    return requestComponents.URL;
+}
+
+- (NSArray<SPTDataLoaderRedirect *> *)cachedRedirectsFromURL:(NSURL *)URL method:(SPTDataLoaderRequestMethod)method
+{
+    const NSUInteger SPTDataLoaderServiceMaximumCachedRedirectHops = 10;
+
+    // Redirects are remembered by the URL that answered them, which is the URL after the resolver rewrote it
+    NSMutableArray<SPTDataLoaderRedirect *> *redirects = [NSMutableArray new];
+    NSMutableSet<NSURL *> *visitedURLs = [NSMutableSet setWithObject:URL];
+    while (redirects.count < SPTDataLoaderServiceMaximumCachedRedirectHops) {
+        SPTDataLoaderRedirect *redirect = [self.redirectCache redirectForURL:URL method:method];
+        NSURL *redirectURL = redirect != nil ? [self resolvedURLForURL:redirect.redirectURL] : nil;
+        if (redirect == nil || redirectURL == nil || [visitedURLs containsObject:(NSURL * _Nonnull)redirectURL]) {
+            break;
+        }
+        [redirects addObject:redirect];
+        [visitedURLs addObject:(NSURL * _Nonnull)redirectURL];
+        URL = (NSURL * _Nonnull)redirectURL;
+    }
+
+    return redirects;
 }
 
 - (void)performRequest:(SPTDataLoaderRequest *)request
 requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+{
+    SPTDataLoaderRequestTaskHandler *handler = [self taskHandlerForRequest:request requestResponseHandler:requestResponseHandler];
+    if (handler != nil) {
+        [self startTaskHandlers:@[ (SPTDataLoaderRequestTaskHandler * _Nonnull)handler ]];
+    }
+}
+
+- (nullable SPTDataLoaderRequestTaskHandler *)taskHandlerForRequest:(SPTDataLoaderRequest *)request
+                                             requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
 {
     if (request.URL == nil || request.cancellationToken.cancelled) {
-        return;
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        return nil;
     }
     if (self.sessionInvalidated) {
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
         [requestResponseHandler cancelledRequest:request];
-        return;
+        return nil;
+    }
+    if (request.needsBodyCompression) {
+        // Compressing a large body takes long enough to stall the caller, so it happens before the task is created
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            [request compressBody];
+            [self performRequest:request requestResponseHandler:requestResponseHandler];
+        });
+        return nil;
+    }
+    if ([SPTDataLoaderSegmentedDownload canPerformRequest:request]) {
+        SPTDataLoaderSegmentedDownload *segmentedDownload = [SPTDataLoaderSegmentedDownload segmentedDownloadWithRequest:request
+                                                                                                  requestResponseHandler:requestResponseHandler
+                                                                                          requestResponseHandlerDelegate:self
+                                                                                                            timeProvider:self.timeProvider
+                                                                                                                delegate:self];
+        segmentedDownload.maximumResponseBodySize = request.maximumResponseBodySize > 0 ? request.maximumResponseBodySize : self.maximumResponseBodySize;
+        [self.segmentedDownloadsLock lock];
+        [self.segmentedDownloads addObject:segmentedDownload];
+        [self.segmentedDownloadsLock unlock];
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        [segmentedDownload start];
+        return nil;
     }
 
-    if (request.URL.host != nil && self.resolver != nil) {
-        NSString *requestHost = request.URL.host;
-        NSString *hostAddress = [self.resolver addressForHost:requestHost];
-        if (![hostAddress isEqualToString:requestHost]) {
-            NSURLComponents *requestComponents = [NSURLComponents componentsWithURL:request.URL resolvingAgainstBaseURL:NO];
-            requestComponents.host = hostAddress;
-
-            NSURL *URL = requestComponents.URL;
+    NSURL *URL = [self resolvedURLForURL:(NSURL * _Nonnull)request.URL];
+    if (URL == nil) {
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        return nil;
+    }
+    // Looked up before the URL is resolved so that metrics are kept per host rather than per address
+    NSArray<SPTDataLoaderMetricsRecorder *> *metricsRecorders = [self.metricsRegistry metricsRecordersForRequest:request];
+    NSArray<SPTDataLoaderRedirect *> *cachedRedirects = @[];
+    if (!request.shouldStopRedirection) {
+        cachedRedirects = [self cachedRedirectsFromURL:(NSURL * _Nonnull)URL method:request.method];
+        SPTDataLoaderRedirect *lastCachedRedirect = cachedRedirects.lastObject;
+        if (lastCachedRedirect != nil) {
+            URL = [self resolvedURLForURL:lastCachedRedirect.redirectURL] ?: URL;
+        }
+    }
+    if (request.originalURL == nil) {
+        request.originalURL = request.URL;
+    }
+    request.URL = URL;
 
-            if (URL == nil) {
-                return;
-            }
+    return [self taskHandlerForRequest:request
+                requestResponseHandler:requestResponseHandler
+                      metricsRecorders:metricsRecorders
+                       cachedRedirects:cachedRedirects];
+}
 
-            request.URL = URL;
+- (nullable SPTDataLoaderRequestTaskHandler *)taskHandlerForRequest:(SPTDataLoaderRequest *)request
+                                             requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+                                                   metricsRecorders:(NSArray<SPTDataLoaderMetricsRecorder *> *)metricsRecorders
+                                                    cachedRedirects:(NSArray<SPTDataLoaderRedirect *> *)cachedRedirects
+{
+    if (request.cancellationToken.cancelled) {
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        return nil;
+    }
+    SPTDataLoaderPreloaderClaim claim = SPTDataLoaderPreloaderClaimNone;
+    if (request.method == SPTDataLoaderRequestMethodGet && self.preloader.policy != nil) {
+        // A resource another response asked to be preloaded is loaded from the cache, or waited for while in flight.
+        // The request is tracked before it is handed over, the preload may finish before the claim returns. Without a
+        // policy nothing is preloaded, so there is nothing to claim.
+        [self.preloadWaitingRequestsLock lock];
+        [self.preloadWaitingRequests setObject:@(self.timeProvider.currentTime) forKey:request];
+        [self.preloadWaitingRequestsLock unlock];
+        __weak __typeof(self) weakSelf = self;
+        claim = [self.preloader claimPreloadOfURL:(NSURL * _Nonnull)request.URL finishedHandler:^{
+            [weakSelf resumeRequestWaitingForPreload:request
+                              requestResponseHandler:requestResponseHandler
+                                    metricsRecorders:metricsRecorders
+                                     cachedRedirects:cachedRedirects];
+        }];
+        if (claim == SPTDataLoaderPreloaderClaimPending) {
+            return nil;
         }
+        [self stopWaitingForPreloadOfRequest:request];
     }
 
-    NSURLSessionTask *task = [self createTaskForRequest:request];
+    NSURLSessionTask *task = [self createTaskForRequest:request
+                                      additionalHeaders:nil
+                                 loadsPreloadedResponse:claim == SPTDataLoaderPreloaderClaimLoaded];
     SPTDataLoaderRequestTaskHandler *handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:task
                                                                                                              request:request
                                                                                               requestResponseHandler:requestResponseHandler
                                                                                                          rateLimiter:self.rateLimiter
+                                                                                                        timeProvider:self.timeProvider
                                                                                                             delegate:self];
-    @synchronized(self.handlers) {
-        [self.handlers addObject:handler];
+    handler.traceContext = self.traceContext;
+    handler.metricsRecorders = metricsRecorders;
+    handler.maximumResponseBodySize = request.maximumResponseBodySize > 0 ? request.maximumResponseBodySize : self.maximumResponseBodySize;
+    handler.tags = [self.class tagsForRequest:request];
+    for (SPTDataLoaderRedirect *redirect in cachedRedirects) {
+        [handler addRedirect:redirect];
+    }
+    return handler;
+}
+
+- (void)startTaskHandlers:(NSArray<SPTDataLoaderRequestTaskHandler *> *)handlers
+{
+    if (handlers.count == 0) {
+        return;
+    }
+
+    [self.handlersLock lock];
+    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
+        [self lockedAddHandler:handler];
+    }
+    [self.handlersLock unlock];
+    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:handler.request];
+        [handler start];
+    }
+}
+
+- (void)resumeRequestWaitingForPreload:(SPTDataLoaderRequest *)request
+                requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+                      metricsRecorders:(NSArray<SPTDataLoaderMetricsRecorder *> *)metricsRecorders
+                       cachedRedirects:(NSArray<SPTDataLoaderRedirect *> *)cachedRedirects
+{
+    // A request cancelled or timed out while it waited is no longer tracked and is not performed
+    if (![self stopWaitingForPreloadOfRequest:request]) {
+        return;
+    }
+    if (self.sessionInvalidated) {
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        [requestResponseHandler cancelledRequest:request];
+        return;
+    }
+
+    SPTDataLoaderRequestTaskHandler *handler = [self taskHandlerForRequest:request
+                                                    requestResponseHandler:requestResponseHandler
+                                                          metricsRecorders:metricsRecorders
+                                                           cachedRedirects:cachedRedirects];
+    if (handler != nil) {
+        [self startTaskHandlers:@[ (SPTDataLoaderRequestTaskHandler * _Nonnull)handler ]];
+    }
+}
+
+- (BOOL)stopWaitingForPreloadOfRequest:(SPTDataLoaderRequest *)request
+{
+    [self.preloadWaitingRequestsLock lock];
+    BOOL waiting = [self.preloadWaitingRequests objectForKey:request] != nil;
+    [self.preloadWaitingRequests removeObjectForKey:request];
+    [self.preloadWaitingRequestsLock unlock];
+    return waiting;
+}
+
+- (void)prewarmHosts:(NSArray<NSString *> *)hosts completion:(nullable SPTDataLoaderServicePrewarmCompletion)completion
+{
+    for (NSString *host in hosts) {
+        [self prewarmHost:host completion:completion];
     }
-    [handler start];
+}
+
+- (void)prewarmHost:(NSString *)host completion:(nullable SPTDataLoaderServicePrewarmCompletion)completion
+{
+    NSURLComponents *components = [NSURLComponents new];
+    components.scheme = @"https";
+    components.host = host;
+    components.path = @"/";
+
+    NSURL *URL = components.URL;
+    if (URL == nil) {
+        if (completion) {
+            completion(host, 0.0, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadURL userInfo:nil]);
+        }
+        return;
+    }
+
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL
+                                                        sourceIdentifier:SPTDataLoaderServicePrewarmSourceIdentifier];
+    request.method = SPTDataLoaderRequestMethodHead;
+
+    // Pre-warming holds back while a host is throttled, but does not use up the budget of the requests it warms up for
+    NSTimeInterval waitTime = [self.rateLimiter earliestTimeUntilRequestCanBeExecuted:request];
+    if (waitTime > 0.0) {
+        __weak __typeof(self) weakSelf = self;
+        [self.timeProvider dispatchAfter:waitTime queue:dispatch_get_global_queue(QOS_CLASS_UTILITY, 0) block:^{
+            [weakSelf prewarmHost:host completion:completion];
+        }];
+        return;
+    }
+
+    if (self.sessionInvalidated) {
+        if (completion) {
+            completion(host, 0.0, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+        }
+        return;
+    }
+
+    NSURL *resolvedURL = [self resolvedURLForURL:URL];
+    if (resolvedURL == nil) {
+        return;
+    }
+    request.URL = resolvedURL;
+
+    NSURLSessionTask *task = [self createTaskForRequest:request];
+    id<SPTDataLoaderTimeProvider> timeProvider = self.timeProvider;
+    CFAbsoluteTime startTime = timeProvider.currentTime;
+    SPTDataLoaderServicePrewarmHandler handler = ^(NSError * _Nullable error) {
+        if (completion) {
+            completion(host, timeProvider.currentTime - startTime, error);
+        }
+    };
+    [self.prewarmHandlersLock lock];
+    [self.prewarmHandlers setObject:handler forKey:task];
+    [self.prewarmHandlersLock unlock];
+    [task resume];
+}
+
+- (BOOL)finishPrewarmTask:(NSURLSessionTask *)task error:(nullable NSError *)error
+{
+    SPTDataLoaderServicePrewarmHandler handler = nil;
+    [self.prewarmHandlersLock lock];
+    handler = [self.prewarmHandlers objectForKey:task];
+    [self.prewarmHandlers removeObjectForKey:task];
+    [self.prewarmHandlersLock unlock];
+
+    if (handler == nil) {
+        return NO;
+    }
+
+    handler(error);
+    return YES;
 }
 
 - (void)cancelAllLoads
 {
-    NSArray *handlers = nil;
-    @synchronized(self.handlers) {
-        handlers = [self.handlers copy];
+    NSArray<SPTDataLoaderRequestTaskHandler *> *handlers = nil;
+    [self.handlersLock lock];
+    handlers = self.handlersByTask.objectEnumerator.allObjects;
+    [self.handlersLock unlock];
+    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
+        [handler cancel];
+    }
+    [self.preloader cancelAllPreloads];
+}
+
++ (NSSet<NSString *> *)tagsForRequest:(SPTDataLoaderRequest *)request
+{
+    NSString *sourceIdentifier = request.sourceIdentifier;
+    if (sourceIdentifier == nil) {
+        return request.tags;
+    }
+    return [request.tags setByAddingObject:sourceIdentifier];
+}
+
+- (void)lockedAddHandler:(SPTDataLoaderRequestTaskHandler *)handler
+{
+    [self.handlersByTask setObject:handler forKey:handler.task];
+    [self.handlersByRequest setObject:handler forKey:handler.request];
+    for (NSString *tag in handler.tags) {
+        NSMutableSet<SPTDataLoaderRequestTaskHandler *> *taggedHandlers = self.handlersByTag[tag];
+        if (taggedHandlers == nil) {
+            taggedHandlers = [NSMutableSet new];
+            self.handlersByTag[tag] = taggedHandlers;
+        }
+        [taggedHandlers addObject:handler];
+    }
+}
+
+- (void)lockedRemoveHandler:(SPTDataLoaderRequestTaskHandler *)handler
+{
+    if ([self.handlersByTask objectForKey:handler.task] == handler) {
+        [self.handlersByTask removeObjectForKey:handler.task];
+    }
+    if ([self.handlersByRequest objectForKey:handler.request] == handler) {
+        [self.handlersByRequest removeObjectForKey:handler.request];
+    }
+    for (NSString *tag in handler.tags) {
+        NSMutableSet<SPTDataLoaderRequestTaskHandler *> *taggedHandlers = self.handlersByTag[tag];
+        [taggedHandlers removeObject:handler];
+        if (taggedHandlers.count == 0) {
+            [self.handlersByTag removeObjectForKey:tag];
+        }
+    }
+}
+
+- (NSArray<SPTDataLoaderRequest *> *)waitingRequestsWithTag:(NSString *)tag
+{
+    // Only a handful of requests wait for authorisation or a preload at a time, so these are not indexed
+    NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray new];
+    [self.authorisingRequestsLock lock];
+    for (SPTDataLoaderRequest *request in self.authorisingRequests) {
+        if ([[self.class tagsForRequest:request] containsObject:tag]) {
+            [requests addObject:request];
+        }
     }
+    [self.authorisingRequestsLock unlock];
+    [self.preloadWaitingRequestsLock lock];
+    for (SPTDataLoaderRequest *request in self.preloadWaitingRequests) {
+        if ([[self.class tagsForRequest:request] containsObject:tag]) {
+            [requests addObject:request];
+        }
+    }
+    [self.preloadWaitingRequestsLock unlock];
+    return requests;
+}
+
+- (void)cancelRequestsWithTag:(NSString *)tag
+{
+    NSArray<SPTDataLoaderRequestTaskHandler *> *handlers = nil;
+    [self.handlersLock lock];
+    handlers = self.handlersByTag[tag].allObjects;
+    [self.handlersLock unlock];
+
+    NSMutableArray<SPTDataLoaderSegmentedDownload *> *segmentedDownloads = [NSMutableArray new];
+    [self.segmentedDownloadsLock lock];
+    for (SPTDataLoaderSegmentedDownload *segmentedDownload in self.segmentedDownloads) {
+        if ([[self.class tagsForRequest:segmentedDownload.request] containsObject:tag]) {
+            [segmentedDownloads addObject:segmentedDownload];
+        }
+    }
+    [self.segmentedDownloadsLock unlock];
+
+    // Cancelling calls back into the service and the data loaders, so none of the locks may be held
     for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
-        [handler.task cancel];
+        id<SPTDataLoaderCancellationToken> cancellationToken = handler.request.cancellationToken;
+        if (cancellationToken != nil) {
+            [cancellationToken cancel];
+        } else {
+            [handler cancel];
+        }
+    }
+    for (SPTDataLoaderSegmentedDownload *segmentedDownload in segmentedDownloads) {
+        id<SPTDataLoaderCancellationToken> cancellationToken = segmentedDownload.request.cancellationToken;
+        if (cancellationToken != nil) {
+            [cancellationToken cancel];
+        } else {
+            [segmentedDownload cancel];
+        }
+    }
+    // Requests waiting for authorisation or a preload have nothing to cancel but their tokens
+    for (SPTDataLoaderRequest *request in [self waitingRequestsWithTag:tag]) {
+        id<SPTDataLoaderCancellationToken> cancellationToken = request.cancellationToken;
+        if (cancellationToken != nil) {
+            [cancellationToken cancel];
+        } else if ([self stopWaitingForPreloadOfRequest:request]) {
+            [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        }
+    }
+    [self.preloader cancelPreloadsWithTag:tag];
+}
+
+- (void)setPriority:(float)priority forRequestsWithTag:(NSString *)tag
+{
+    NSArray<SPTDataLoaderRequestTaskHandler *> *handlers = nil;
+    [self.handlersLock lock];
+    handlers = self.handlersByTag[tag].allObjects;
+    [self.handlersLock unlock];
+
+    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
+        handler.request.priority = priority;
+        handler.task.priority = priority;
+    }
+    for (SPTDataLoaderRequest *request in [self waitingRequestsWithTag:tag]) {
+        request.priority = priority;
     }
 }
 
+- (void)setSessionPartitions:(NSArray<SPTDataLoaderSessionPartition *> *)sessionPartitions
+{
+    [self.sessionSelector setPartitions:sessionPartitions];
+}
+
+- (NSArray<SPTDataLoaderSessionStatistics *> *)sessionStatistics
+{
+    return [self.sessionSelector statistics];
+}
+
+- (NSArray<SPTDataLoaderInFlightRequest *> *)inFlightRequests
+{
+    CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+    NSMutableArray<SPTDataLoaderInFlightRequest *> *inFlightRequests = [NSMutableArray new];
+
+    [self.authorisingRequestsLock lock];
+    for (SPTDataLoaderRequest *request in self.authorisingRequests) {
+        CFAbsoluteTime authorisationStartTime = [[self.authorisingRequests objectForKey:request] doubleValue];
+        SPTDataLoaderInFlightRequest *inFlightRequest = [SPTDataLoaderInFlightRequest new];
+        inFlightRequest.request = request;
+        inFlightRequest.sourceIdentifier = request.sourceIdentifier;
+        inFlightRequest.state = SPTDataLoaderInFlightRequestStateAuthorising;
+        inFlightRequest.stateEntryTime = authorisationStartTime;
+        inFlightRequest.timeInState = MAX(currentTime - authorisationStartTime, 0.0);
+        inFlightRequest.age = MAX(currentTime - request.serviceEntryTime, 0.0);
+        [inFlightRequests addObject:inFlightRequest];
+    }
+    [self.authorisingRequestsLock unlock];
+
+    [self.preloadWaitingRequestsLock lock];
+    for (SPTDataLoaderRequest *request in self.preloadWaitingRequests) {
+        CFAbsoluteTime waitStartTime = [[self.preloadWaitingRequests objectForKey:request] doubleValue];
+        SPTDataLoaderInFlightRequest *inFlightRequest = [SPTDataLoaderInFlightRequest new];
+        inFlightRequest.request = request;
+        inFlightRequest.sourceIdentifier = request.sourceIdentifier;
+        inFlightRequest.state = SPTDataLoaderInFlightRequestStateWaitingForPreload;
+        inFlightRequest.stateEntryTime = waitStartTime;
+        inFlightRequest.timeInState = MAX(currentTime - waitStartTime, 0.0);
+        inFlightRequest.age = MAX(currentTime - request.serviceEntryTime, 0.0);
+        [inFlightRequests addObject:inFlightRequest];
+    }
+    [self.preloadWaitingRequestsLock unlock];
+
+    NSArray<SPTDataLoaderRequestTaskHandler *> *handlers = nil;
+    [self.handlersLock lock];
+    handlers = self.handlersByTask.objectEnumerator.allObjects;
+    [self.handlersLock unlock];
+    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
+        [inFlightRequests addObject:[handler inFlightRequest]];
+    }
+
+    [inFlightRequests sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:NSStringFromSelector(@selector(age)) ascending:NO] ]];
+    return inFlightRequests;
+}
+
+- (void)startWatchdogWithThreshold:(NSTimeInterval)threshold
+                             queue:(dispatch_queue_t)queue
+                           handler:(SPTDataLoaderServiceStuckRequestsHandler)handler
+{
+    NSUInteger generation = 0;
+    [self.watchdogLock lock];
+    generation = ++self.watchdogGeneration;
+    [self.reportedStuckRequests removeAllObjects];
+    [self.watchdogLock unlock];
+
+    [self scheduleWatchdogCheckWithGeneration:generation threshold:threshold queue:queue handler:handler];
+}
+
+- (void)stopWatchdog
+{
+    [self.watchdogLock lock];
+    self.watchdogGeneration++;
+    [self.reportedStuckRequests removeAllObjects];
+    [self.watchdogLock unlock];
+}
+
+- (void)scheduleWatchdogCheckWithGeneration:(NSUInteger)generation
+                                  threshold:(NSTimeInterval)threshold
+                                      queue:(dispatch_queue_t)queue
+                                    handler:(SPTDataLoaderServiceStuckRequestsHandler)handler
+{
+    const NSTimeInterval SPTDataLoaderServiceMinimumWatchdogInterval = 0.1;
+
+    __weak __typeof(self) weakSelf = self;
+    NSTimeInterval interval = MAX(threshold / 2.0, SPTDataLoaderServiceMinimumWatchdogInterval);
+    [self.timeProvider dispatchAfter:interval queue:dispatch_get_global_queue(QOS_CLASS_UTILITY, 0) block:^{
+        [weakSelf checkForStuckRequestsWithGeneration:generation threshold:threshold queue:queue handler:handler];
+    }];
+}
+
+- (void)checkForStuckRequestsWithGeneration:(NSUInteger)generation
+                                  threshold:(NSTimeInterval)threshold
+                                      queue:(dispatch_queue_t)queue
+                                    handler:(SPTDataLoaderServiceStuckRequestsHandler)handler
+{
+    NSArray<SPTDataLoaderInFlightRequest *> *inFlightRequests = [self inFlightRequests];
+
+    NSMutableArray<SPTDataLoaderInFlightRequest *> *stuckRequests = [NSMutableArray new];
+    [self.watchdogLock lock];
+    BOOL stopped = generation != self.watchdogGeneration;
+    if (!stopped) {
+        for (SPTDataLoaderInFlightRequest *inFlightRequest in inFlightRequests) {
+            if (inFlightRequest.timeInState < threshold) {
+                continue;
+            }
+            // Every check sees a stuck request again, it is only reported the first time for each state it enters
+            NSNumber *stateEntryTime = @(inFlightRequest.stateEntryTime);
+            NSNumber *reportedStateEntryTime = [self.reportedStuckRequests objectForKey:inFlightRequest.request];
+            if (![reportedStateEntryTime isEqualToNumber:stateEntryTime]) {
+                [self.reportedStuckRequests setObject:stateEntryTime forKey:inFlightRequest.request];
+                [stuckRequests addObject:inFlightRequest];
+            }
+        }
+    }
+    [self.watchdogLock unlock];
+    if (stopped) {
+        return;
+    }
+
+    if (stuckRequests.count > 0) {
+        dispatch_async(queue, ^{
+            handler(stuckRequests);
+        });
+    }
+    [self scheduleWatchdogCheckWithGeneration:generation threshold:threshold queue:queue handler:handler];
+}
+
+- (void)setTimeProvider:(id<SPTDataLoaderTimeProvider>)timeProvider
+{
+    _timeProvider = timeProvider;
+    self.sessionSelector.timeProvider = timeProvider;
+    self.redirectCache.timeProvider = timeProvider;
+    self.preloader.timeProvider = timeProvider;
+}
+
+- (nullable SPTDataLoaderPreloadPolicy *)preloadPolicy
+{
+    return self.preloader.policy;
+}
+
+- (void)setPreloadPolicy:(nullable SPTDataLoaderPreloadPolicy *)preloadPolicy
+{
+    self.preloader.policy = preloadPolicy;
+}
+
+- (NSUInteger)maximumCachedRedirects
+{
+    return self.redirectCache.capacity;
+}
+
+- (void)setMaximumCachedRedirects:(NSUInteger)maximumCachedRedirects
+{
+    self.redirectCache.capacity = maximumCachedRedirects;
+}
+
+- (void)removeAllCachedRedirects
+{
+    [self.redirectCache removeAllRedirects];
+}
+
 - (void)invalidateAndCancel
 {
     self.sessionInvalidated = YES;
+    [self.preloader cancelAllPreloads];
     [self.sessionSelector invalidateAndCancel];
 }
 
@@ -273,7 +923,27 @@ requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseH
 
 - (void)requestTaskHandlerNeedsNewTask:(SPTDataLoaderRequestTaskHandler *)requestTaskHandler
 {
-    requestTaskHandler.task = [self createTaskForRequest:requestTaskHandler.request];
+    SPTDataLoaderRequest *request = requestTaskHandler.request;
+    NSData *resumeData = requestTaskHandler.resumeData;
+    if (resumeData != nil && request.backgroundPolicy == SPTDataLoaderRequestBackgroundPolicyAlways) {
+        NSURLSession *session = [self.sessionSelector URLSessionForRequest:request];
+        NSURLSessionTask *task = [session downloadTaskWithResumeData:(NSData * _Nonnull)resumeData];
+        [self.sessionSelector URLSession:session didCreateTask:task];
+        [self setTask:task ofHandler:requestTaskHandler];
+        return;
+    }
+
+    [self setTask:[self createTaskForRequest:request additionalHeaders:requestTaskHandler.resumeHeaders]
+        ofHandler:requestTaskHandler];
+}
+
+#pragma mark SPTDataLoaderSegmentedDownloadDelegate
+
+- (void)segmentedDownloadDidFinish:(SPTDataLoaderSegmentedDownload *)segmentedDownload
+{
+    [self.segmentedDownloadsLock lock];
+    [self.segmentedDownloads removeObject:segmentedDownload];
+    [self.segmentedDownloadsLock unlock];
 }
 
 #pragma mark SPTDataLoaderRequestResponseHandlerDelegate
@@ -281,29 +951,77 @@ requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseH
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                 performRequest:(SPTDataLoaderRequest *)request
 {
-    if ([requestResponseHandler respondsToSelector:@selector(shouldAuthoriseRequest:)]) {
-        if ([requestResponseHandler shouldAuthoriseRequest:request]) {
-            if ([requestResponseHandler respondsToSelector:@selector(authoriseRequest:)]) {
-                [requestResponseHandler authoriseRequest:request];
-                return;
-            }
+    [self requestResponseHandler:requestResponseHandler performRequests:@[ request ]];
+}
+
+- (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+               performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+{
+    NSMutableArray<SPTDataLoaderRequestTaskHandler *> *handlers = [NSMutableArray arrayWithCapacity:requests.count];
+    for (SPTDataLoaderRequest *request in requests) {
+        if (request.serviceEntryTime == 0.0) {
+            request.serviceEntryTime = self.timeProvider.currentTime;
+        }
+        if ([self authoriseRequest:request requestResponseHandler:requestResponseHandler]) {
+            continue;
+        }
+        SPTDataLoaderRequestTaskHandler *handler = [self taskHandlerForRequest:request requestResponseHandler:requestResponseHandler];
+        if (handler != nil) {
+            [handlers addObject:(SPTDataLoaderRequestTaskHandler * _Nonnull)handler];
         }
     }
 
-    [self performRequest:request requestResponseHandler:requestResponseHandler];
+    // The group is registered under a single acquisition of the handlers lock before any of it starts
+    [self startTaskHandlers:handlers];
+}
+
+- (BOOL)authoriseRequest:(SPTDataLoaderRequest *)request
+  requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+{
+    if (![requestResponseHandler respondsToSelector:@selector(shouldAuthoriseRequest:)] ||
+        ![requestResponseHandler shouldAuthoriseRequest:request] ||
+        ![requestResponseHandler respondsToSelector:@selector(authoriseRequest:)]) {
+        return NO;
+    }
+
+    // Authorisers may call back before returning, so the request is tracked before it is handed over
+    [self.authorisingRequestsLock lock];
+    [self.authorisingRequests setObject:@(self.timeProvider.currentTime) forKey:request];
+    [self.authorisingRequestsLock unlock];
+    [requestResponseHandler authoriseRequest:request];
+    return YES;
 }
 
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                  cancelRequest:(SPTDataLoaderRequest *)request
 {
-    NSArray *handlers = nil;
-    @synchronized(self.handlers) {
-        handlers = [self.handlers copy];
+    [self.authorisingRequestsLock lock];
+    [self.authorisingRequests removeObjectForKey:request];
+    [self.authorisingRequestsLock unlock];
+    [self.preloader cancelPreloadsOfRequest:request];
+    if ([self stopWaitingForPreloadOfRequest:request]) {
+        // Dropping the request is enough, it is let go rather than performed once the preload finishes
+        [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
+        return;
     }
-    for (SPTDataLoaderRequestTaskHandler *handler in handlers) {
-        if ([handler.request isEqual:request]) {
-            [handler.task cancel];
-            break;
+
+    SPTDataLoaderRequestTaskHandler *handler = nil;
+    [self.handlersLock lock];
+    handler = [self.handlersByRequest objectForKey:request];
+    [self.handlersLock unlock];
+    if (handler != nil) {
+        [handler cancel];
+        return;
+    }
+
+    NSArray *segmentedDownloads = nil;
+    [self.segmentedDownloadsLock lock];
+    segmentedDownloads = [self.segmentedDownloads copy];
+    [self.segmentedDownloadsLock unlock];
+    for (SPTDataLoaderSegmentedDownload *segmentedDownload in segmentedDownloads) {
+        if ([segmentedDownload.request isEqual:request]) {
+            [segmentedDownload cancel];
+            return;
         }
     }
 }
@@ -311,6 +1029,9 @@ requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseH
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
              authorisedRequest:(SPTDataLoaderRequest *)request
 {
+    [self.authorisingRequestsLock lock];
+    [self.authorisingRequests removeObjectForKey:request];
+    [self.authorisingRequestsLock unlock];
     [self performRequest:request requestResponseHandler:requestResponseHandler];
 }
 
@@ -318,11 +1039,46 @@ requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseH
       failedToAuthoriseRequest:(SPTDataLoaderRequest *)request
                          error:(NSError *)error
 {
+    [self.authorisingRequestsLock lock];
+    [self.authorisingRequests removeObjectForKey:request];
+    [self.authorisingRequestsLock unlock];
+    [self.traceContext endPhase:SPTDataLoaderTracePhaseSubmission ofRequest:request];
     SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
     response.error = error;
     [requestResponseHandler failedResponse:response];
 }
 
+#pragma mark SPTDataLoaderPreloaderDelegate
+
+- (nullable NSURLSessionTask *)preloader:(SPTDataLoaderPreloader *)preloader taskForRequest:(SPTDataLoaderRequest *)request
+{
+    // Preloads are speculative, they are dropped rather than delayed when the service is rate limited. They are not
+    // counted as executed either, which would hold back the request that comes to claim them.
+    if (self.sessionInvalidated || [self.rateLimiter earliestTimeUntilRequestCanBeExecuted:request] > 0.0) {
+        return nil;
+    }
+
+    return [self createTaskForRequest:request];
+}
+
+- (void)preloader:(SPTDataLoaderPreloader *)preloader
+didPreloadResponse:(NSHTTPURLResponse *)response
+             data:(NSData *)data
+       forRequest:(SPTDataLoaderRequest *)request
+             task:(NSURLSessionTask *)task
+{
+    NSURLCache *URLCache = [self.sessionSelector URLSessionForRequest:request].configuration.URLCache;
+    if (URLCache == nil) {
+        return;
+    }
+
+    NSCachedURLResponse *cachedResponse = [[NSCachedURLResponse alloc] initWithResponse:response
+                                                                                   data:data
+                                                                               userInfo:nil
+                                                                          storagePolicy:NSURLCacheStorageAllowedInMemoryOnly];
+    [URLCache storeCachedResponse:cachedResponse forRequest:task.originalRequest ?: request.urlRequest];
+}
+
 #pragma mark NSURLSessionDataDelegate
 
 - (void)URLSession:(NSURLSession *)session
@@ -330,9 +1086,29 @@ requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseH
 didReceiveResponse:(NSURLResponse *)response
  completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
 {
+    // The connection to a pre-warmed host is established once its response arrives, the body is not needed
+    if ([self finishPrewarmTask:dataTask error:nil]) {
+        if (completionHandler) {
+            completionHandler(NSURLSessionResponseCancel);
+        }
+        return;
+    }
+
+    if ([self.preloader handlesTask:dataTask]) {
+        NSURLSessionResponseDisposition disposition = [self.preloader receiveResponse:response forTask:dataTask];
+        if (completionHandler) {
+            completionHandler(disposition);
+        }
+        return;
+    }
+
     SPTDataLoaderRequestTaskHandler *handler = [self handlerForTask:dataTask];
+    NSURLSessionResponseDisposition disposition = [handler receiveResponse:response];
+    if (handler != nil && disposition != NSURLSessionResponseCancel && [response isKindOfClass:[NSHTTPURLResponse class]]) {
+        [self.preloader preloadResourcesOfResponse:(NSHTTPURLResponse *)response request:handler.request tags:handler.tags];
+    }
     if (completionHandler) {
-        completionHandler([handler receiveResponse:response]);
+        completionHandler(disposition);
     }
 }
 
@@ -341,13 +1117,20 @@ didReceiveResponse:(NSURLResponse *)response
 didBecomeDownloadTask:(NSURLSessionDownloadTask *)downloadTask
 {
     SPTDataLoaderRequestTaskHandler *originalHandler = [self handlerForTask:dataTask];
-    originalHandler.task = downloadTask;
+    if (originalHandler != nil) {
+        [self setTask:downloadTask ofHandler:(SPTDataLoaderRequestTaskHandler * _Nonnull)originalHandler];
+    }
 }
 
 - (void)URLSession:(NSURLSession *)session
           dataTask:(NSURLSessionDataTask *)dataTask
     didReceiveData:(NSData *)data
 {
+    if ([self.preloader handlesTask:dataTask]) {
+        [self.preloader receiveData:data forTask:dataTask];
+        return;
+    }
+
     SPTDataLoaderRequestTaskHandler *handler = [self handlerForTask:dataTask];
     [handler receiveData:data];
 }
@@ -402,6 +1185,16 @@ didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
               task:(NSURLSessionTask *)task
 didCompleteWithError:(nullable NSError *)error
 {
+    [self.sessionSelector URLSession:session didCompleteTask:task error:error];
+
+    if ([self finishPrewarmTask:task error:error]) {
+        return;
+    }
+    if ([self.preloader handlesTask:task]) {
+        [self.preloader completeTask:task error:error];
+        return;
+    }
+
     SPTDataLoaderRequestTaskHandler *handler = [self handlerForTask:task];
     if (handler == nil) {
         return;
@@ -412,42 +1205,56 @@ didCompleteWithError:(nullable NSError *)error
         return;
     }
 
-    @synchronized(self.handlers) {
-        [self.handlers removeObject:handler];
-    }
-
-    @synchronized(self.consumptionObservers) {
-        for (id<SPTDataLoaderConsumptionObserver> consumptionObserver in self.consumptionObservers) {
-            dispatch_block_t observerBlock = ^ {
-                if (response == nil) {
-                    return;
-                }
-                int bytesSent = (int)task.countOfBytesSent;
-                int64_t bytesReceivedExpected = task.countOfBytesExpectedToReceive;
-                int bytesReceived;
-                if (bytesReceivedExpected == NSURLSessionTransferSizeUnknown) {
-                    bytesReceived = (int)task.countOfBytesReceived;
-                } else {
-                    bytesReceived = (int)bytesReceivedExpected;
-                }
+    [self.handlersLock lock];
+    [self lockedRemoveHandler:handler];
+    [self.handlersLock unlock];
+
+    SPTDataLoaderRequest *request = handler.request;
+    // Observers are called outside the lock, so they are free to remove themselves
+    NSMapTable<id<SPTDataLoaderConsumptionObserver>, dispatch_queue_t> *consumptionObservers = nil;
+    [self.consumptionObserversLock lock];
+    consumptionObservers = [self.consumptionObservers copy];
+    [self.consumptionObserversLock unlock];
+    for (id<SPTDataLoaderConsumptionObserver> consumptionObserver in consumptionObservers) {
+        dispatch_block_t observerBlock = ^ {
+            if (response == nil) {
+                return;
+            }
+            int bytesSent = (int)task.countOfBytesSent;
+            int uncompressedBytesSent = request.uncompressedBodyLength > 0 ? (int)request.uncompressedBodyLength : bytesSent;
+            int64_t bytesReceivedExpected = task.countOfBytesExpectedToReceive;
+            int bytesReceived;
+            if (bytesReceivedExpected == NSURLSessionTransferSizeUnknown) {
+                bytesReceived = (int)task.countOfBytesReceived;
+            } else {
+                bytesReceived = (int)bytesReceivedExpected;
+            }
 
-                bytesSent += task.currentRequest.allHTTPHeaderFields.byteSizeOfHeaders;
-                if ([task.response isKindOfClass:[NSHTTPURLResponse class]]) {
-                    NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)task.response;
-                    bytesReceived += httpResponse.allHeaderFields.byteSizeOfHeaders;
-                }
+            int byteSizeOfHeaders = (int)task.currentRequest.allHTTPHeaderFields.byteSizeOfHeaders;
+            bytesSent += byteSizeOfHeaders;
+            uncompressedBytesSent += byteSizeOfHeaders;
+            if ([task.response isKindOfClass:[NSHTTPURLResponse class]]) {
+                NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)task.response;
+                bytesReceived += httpResponse.allHeaderFields.byteSizeOfHeaders;
+            }
 
+            if ([consumptionObserver respondsToSelector:@selector(endedRequestWithResponse:bytesDownloaded:bytesUploaded:uncompressedBytesUploaded:)]) {
                 [consumptionObserver endedRequestWithResponse:response
                                               bytesDownloaded:bytesReceived
-                                                bytesUploaded:bytesSent];
-            };
-
-            dispatch_queue_t queue = [self.consumptionObservers objectForKey:consumptionObserver];
-            if ([NSThread isMainThread] && queue == dispatch_get_main_queue()) {
-                observerBlock();
+                                                bytesUploaded:bytesSent
+                                    uncompressedBytesUploaded:uncompressedBytesSent];
             } else {
-                dispatch_async(queue, observerBlock);
+                [consumptionObserver endedRequestWithResponse:response
+                                              bytesDownloaded:bytesReceived
+                                                bytesUploaded:bytesSent];
             }
+        };
+
+        dispatch_queue_t queue = [consumptionObservers objectForKey:consumptionObserver];
+        if ([NSThread isMainThread] && queue == dispatch_get_main_queue()) {
+            observerBlock();
+        } else {
+            dispatch_async(queue, observerBlock);
         }
     }
 }
@@ -490,6 +1297,26 @@ willPerformHTTPRedirection:(NSHTTPURLResponse *)response
         [newRequest addValue:value forHTTPHeaderField:header];
     }
 
+    NSURL *redirectedURL = response.URL;
+    if (redirectedURL != nil) {
+        // Only a chain of permanent redirects keeps the method of the request, so only then is the next hop reusable
+        BOOL followedTemporaryRedirect = NO;
+        for (SPTDataLoaderRedirect *redirect in handler.redirects) {
+            followedTemporaryRedirect = followedTemporaryRedirect
+                || (redirect.statusCode != SPTDataLoaderResponseHTTPStatusCodeMovedPermanently
+                    && redirect.statusCode != SPTDataLoaderResponseHTTPStatusCodePermanentRedirect);
+        }
+        if (!followedTemporaryRedirect) {
+            [self.redirectCache cacheRedirectResponse:response
+                                          redirectURL:(NSURL * _Nonnull)request.URL
+                                               method:handler.request.method];
+        }
+        [handler addRedirect:[SPTDataLoaderRedirect redirectWithURL:(NSURL * _Nonnull)redirectedURL
+                                                        redirectURL:(NSURL * _Nonnull)request.URL
+                                                         statusCode:response.statusCode
+                                                             cached:NO]];
+    }
+
     // Proceed with the updated request
     completionHandler(newRequest);
 }
@@ -508,6 +1335,18 @@ willPerformHTTPRedirection:(NSHTTPURLResponse *)response
     [handler noteWaitingForConnectivity];
 }
 
+- (void)URLSession:(NSURLSession *)session
+                               task:(NSURLSessionTask *)task
+    didReceiveInformationalResponse:(NSHTTPURLResponse *)response
+{
+    // 103 Early Hints name the resources to preload before the final response is ready
+    SPTDataLoaderRequestTaskHandler *handler = [self handlerForTask:task];
+    if (handler == nil) {
+        return;
+    }
+    [self.preloader preloadResourcesOfResponse:response request:handler.request tags:handler.tags];
+}
+
 #pragma mark NSURLSessionDownloadDelegate
 
 - (void)URLSession:(NSURLSession *)session
@@ -536,6 +1375,14 @@ didFinishDownloadingToURL:(NSURL *)location
     // Move tmp file to safe place to read on the session queue
     if ([fileManager moveItemAtPath:(NSString * _Nonnull) location.path toPath:filePath error:&fileError]) {
         [self.sessionQueue addOperationWithBlock:^{
+            // Check the size on disk so an oversized body is never read into memory
+            NSDictionary<NSFileAttributeKey, id> *attributes = [fileManager attributesOfItemAtPath:filePath error:nil];
+            if (attributes && ![handler acceptsDownloadedBodyOfLength:(int64_t)attributes.fileSize]) {
+                [fileManager removeItemAtPath:filePath error:nil];
+                [self URLSession:session task:downloadTask didCompleteWithError:nil];
+                return;
+            }
+
             NSError *readError;
             NSData *data = [self.dataClass dataWithContentsOfFile:filePath options:NSDataReadingUncached error:&readError];
 
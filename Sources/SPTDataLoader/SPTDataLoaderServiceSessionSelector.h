@@ -8,6 +8,9 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class SPTDataLoaderRequest;
+@class SPTDataLoaderSessionPartition;
+@class SPTDataLoaderSessionStatistics;
+@protocol SPTDataLoaderTimeProvider;
 
 
 /**
@@ -16,12 +19,36 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @protocol SPTDataLoaderServiceSessionSelector <NSObject>
 
+/**
+ The clock used to time tasks and tear down idle sessions
+ */
+@property (nonatomic, strong, nullable) id<SPTDataLoaderTimeProvider> timeProvider;
+
 - (NSURLSession *)URLSessionForRequest:(SPTDataLoaderRequest *)request;
 - (void)invalidateAndCancel;
+/**
+ Replaces the partitions requests are routed to
+ @param partitions The partitions, checked in order
+ */
+- (void)setPartitions:(NSArray<SPTDataLoaderSessionPartition *> *)partitions;
+/**
+ A snapshot of the traffic of every partition, beginning with the session created from the service configuration
+ */
+- (NSArray<SPTDataLoaderSessionStatistics *> *)statistics;
+/**
+ Called for every task created in a session returned by @c URLSessionForRequest:
+ */
+- (void)URLSession:(NSURLSession *)session didCreateTask:(NSURLSessionTask *)task;
+/**
+ Called when a task of the service completes, possibly more than once for the same task
+ */
+- (void)URLSession:(NSURLSession *)session didCompleteTask:(NSURLSessionTask *)task error:(nullable NSError *)error;
 @end
 
 /**
  Production implementation of @c SPTDataLoaderServiceSessionSelector .
+ @discussion Requests are split between a session that waits for connectivity and one that does not, and partitions
+ add further sessions that are created lazily and torn down once they go idle.
  */
 @interface SPTDataLoaderServiceDefaultSessionSelector: NSObject <SPTDataLoaderServiceSessionSelector>
 
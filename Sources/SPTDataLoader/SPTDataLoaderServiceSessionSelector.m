@@ -5,23 +5,79 @@
 
 #import "SPTDataLoaderServiceSessionSelector.h"
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderSessionPartition.h>
+
+#import "SPTDataLoaderSessionStatistics+Private.h"
+#import "SPTDataLoaderTimeProviderImplementation.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ The sessions of a single partition and the traffic they have carried
+ */
+@interface SPTDataLoaderServiceSessionPool : NSObject
+
+@property (nonatomic, strong, readonly, nullable) SPTDataLoaderSessionPartition *partition;
+@property (nonatomic, strong, readonly) NSURLSessionConfiguration *configuration;
+@property (nonatomic, strong, nullable) NSURLSession *nonWaitingSession;
+@property (nonatomic, strong, nullable) NSURLSession *waitingSession;
+@property (nonatomic, assign) CFAbsoluteTime idleSince;
+@property (nonatomic, assign) NSUInteger sessionCreationCount;
+@property (nonatomic, assign) NSUInteger taskCount;
+@property (nonatomic, assign) NSUInteger inFlightTaskCount;
+@property (nonatomic, assign) NSUInteger completedTaskCount;
+@property (nonatomic, assign) NSUInteger failedTaskCount;
+@property (nonatomic, assign) int64_t bytesSent;
+@property (nonatomic, assign) int64_t bytesReceived;
+@property (nonatomic, assign) NSTimeInterval totalTaskDuration;
+
+@end
+
+@implementation SPTDataLoaderServiceSessionPool
+
+- (instancetype)initWithPartition:(nullable SPTDataLoaderSessionPartition *)partition
+                    configuration:(NSURLSessionConfiguration *)configuration
+{
+    self = [super init];
+    if (self) {
+        _partition = partition;
+        _configuration = configuration;
+    }
+    return self;
+}
+
+- (void)finishTasksAndInvalidate
+{
+    [self.nonWaitingSession finishTasksAndInvalidate];
+    [self.waitingSession finishTasksAndInvalidate];
+    self.nonWaitingSession = nil;
+    self.waitingSession = nil;
+}
+
+- (void)invalidateAndCancel
+{
+    [self.nonWaitingSession invalidateAndCancel];
+    [self.waitingSession invalidateAndCancel];
+}
+
+@end
+
 @interface SPTDataLoaderServiceDefaultSessionSelector ()
 
 @property (nonatomic, strong, readonly) NSURLSessionConfiguration *configuration;
 @property (nonatomic, weak, readonly) id<NSURLSessionDelegate> delegate;
 @property (nonatomic, strong, readonly) NSOperationQueue *delegateQueue;
+@property (nonatomic, strong, readonly) SPTDataLoaderServiceSessionPool *defaultPool;
+@property (nonatomic, copy) NSArray<SPTDataLoaderServiceSessionPool *> *partitionPools;
+@property (nonatomic, strong, readonly) NSMapTable<NSURLSession *, SPTDataLoaderServiceSessionPool *> *poolsBySession;
+@property (nonatomic, strong, readonly) NSMapTable<NSURLSessionTask *, NSNumber *> *taskStartTimes;
 
 @end
 
 
 @implementation SPTDataLoaderServiceDefaultSessionSelector
-{
-    NSURLSession *_nonWaitingSession;
-    NSURLSession *_waitingSession;
-}
+
+@synthesize timeProvider = _timeProvider;
 
 - (instancetype)initWithConfiguration:(NSURLSessionConfiguration *)configuration
                              delegate:(id<NSURLSessionDelegate>)delegate
@@ -33,6 +89,11 @@ NS_ASSUME_NONNULL_BEGIN
         _configuration = [configuration copy];
         _delegate = delegate;
         _delegateQueue = delegateQueue;
+        _defaultPool = [[SPTDataLoaderServiceSessionPool alloc] initWithPartition:nil configuration:_configuration];
+        _partitionPools = @[];
+        _poolsBySession = [NSMapTable weakToStrongObjectsMapTable];
+        _taskStartTimes = [NSMapTable weakToStrongObjectsMapTable];
+        _timeProvider = [SPTDataLoaderTimeProviderImplementation new];
     }
 
     return self;
@@ -40,48 +101,208 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSURLSession *)URLSessionForRequest:(SPTDataLoaderRequest *)request
 {
-    if (request.waitsForConnectivity) {
-        return self.waitingSession;
-    } else {
-        return self.nonWaitingSession;
+    @synchronized(self) {
+        SPTDataLoaderServiceSessionPool *pool = [self poolForRequest:request];
+        // A session that has just been handed out must survive until its task has been created
+        pool.idleSince = self.timeProvider.currentTime;
+        if (request.waitsForConnectivity) {
+            return [self waitingSessionOfPool:pool];
+        } else {
+            return [self nonWaitingSessionOfPool:pool];
+        }
     }
 }
 
-- (NSURLSession *)waitingSession
+- (SPTDataLoaderServiceSessionPool *)poolForRequest:(SPTDataLoaderRequest *)request
 {
-    if (_waitingSession == nil) {
-        _waitingSession = [self createWaitingSession];
+    for (SPTDataLoaderServiceSessionPool *pool in self.partitionPools) {
+        if ([(SPTDataLoaderSessionPartition * _Nonnull)pool.partition matchesRequest:request]) {
+            return pool;
+        }
     }
-    return _waitingSession;
+    return self.defaultPool;
 }
 
-- (NSURLSession *)nonWaitingSession
+- (NSURLSession *)waitingSessionOfPool:(SPTDataLoaderServiceSessionPool *)pool
 {
-    if (_nonWaitingSession == nil) {
-        _nonWaitingSession = [NSURLSession sessionWithConfiguration:self.configuration
-                                                           delegate:self.delegate
-                                                      delegateQueue:self.delegateQueue];
+    if (pool.waitingSession == nil) {
+        pool.waitingSession = [self createWaitingSessionForPool:pool];
     }
-    return _nonWaitingSession;
+    return (NSURLSession * _Nonnull)pool.waitingSession;
 }
 
-- (NSURLSession *)createWaitingSession
+- (NSURLSession *)nonWaitingSessionOfPool:(SPTDataLoaderServiceSessionPool *)pool
+{
+    if (pool.nonWaitingSession == nil) {
+        pool.nonWaitingSession = [self createSessionWithConfiguration:pool.configuration forPool:pool];
+    }
+    return (NSURLSession * _Nonnull)pool.nonWaitingSession;
+}
+
+- (NSURLSession *)createWaitingSessionForPool:(SPTDataLoaderServiceSessionPool *)pool
 {
     if (@available(iOS 11.0, macOS 10.13, tvOS 11.0, watchOS 4.0, *)) {
-        NSURLSessionConfiguration *configuration = [self.configuration copy];
+        NSURLSessionConfiguration *configuration = [pool.configuration copy];
         configuration.waitsForConnectivity = YES;
-        return [NSURLSession sessionWithConfiguration:configuration
-                                             delegate:self.delegate
-                                        delegateQueue:self.delegateQueue];
+        return [self createSessionWithConfiguration:configuration forPool:pool];
     } else {
-        return self.nonWaitingSession;
+        return [self nonWaitingSessionOfPool:pool];
+    }
+}
+
+- (NSURLSession *)createSessionWithConfiguration:(NSURLSessionConfiguration *)configuration
+                                         forPool:(SPTDataLoaderServiceSessionPool *)pool
+{
+    NSURLSession *session = [NSURLSession sessionWithConfiguration:configuration
+                                                          delegate:self.delegate
+                                                     delegateQueue:self.delegateQueue];
+    [self.poolsBySession setObject:pool forKey:session];
+    pool.sessionCreationCount++;
+    return session;
+}
+
+- (NSURLSessionConfiguration *)configurationForPartition:(SPTDataLoaderSessionPartition *)partition
+{
+    NSURLSessionConfiguration *configuration = [partition.configuration copy];
+
+    NSMutableDictionary *headers = [self.configuration.HTTPAdditionalHeaders mutableCopy] ?: [NSMutableDictionary new];
+    [headers addEntriesFromDictionary:configuration.HTTPAdditionalHeaders ?: @{}];
+    configuration.HTTPAdditionalHeaders = headers;
+
+    NSMutableArray<Class> *protocolClasses = [self.configuration.protocolClasses mutableCopy] ?: [NSMutableArray new];
+    for (Class protocolClass in configuration.protocolClasses) {
+        if (![protocolClasses containsObject:protocolClass]) {
+            [protocolClasses addObject:protocolClass];
+        }
+    }
+    configuration.protocolClasses = protocolClasses;
+
+    return configuration;
+}
+
+- (void)setPartitions:(NSArray<SPTDataLoaderSessionPartition *> *)partitions
+{
+    @synchronized(self) {
+        NSMutableArray<SPTDataLoaderServiceSessionPool *> *pools = [NSMutableArray arrayWithCapacity:partitions.count];
+        NSMutableArray<SPTDataLoaderServiceSessionPool *> *removedPools = [self.partitionPools mutableCopy];
+        for (SPTDataLoaderSessionPartition *partition in partitions) {
+            SPTDataLoaderServiceSessionPool *pool = nil;
+            for (SPTDataLoaderServiceSessionPool *existingPool in removedPools) {
+                if (existingPool.partition == partition) {
+                    pool = existingPool;
+                    break;
+                }
+            }
+            if (pool != nil) {
+                [removedPools removeObject:(SPTDataLoaderServiceSessionPool * _Nonnull)pool];
+            } else {
+                pool = [[SPTDataLoaderServiceSessionPool alloc] initWithPartition:partition
+                                                                    configuration:[self configurationForPartition:partition]];
+            }
+            [pools addObject:(SPTDataLoaderServiceSessionPool * _Nonnull)pool];
+        }
+
+        for (SPTDataLoaderServiceSessionPool *pool in removedPools) {
+            [pool finishTasksAndInvalidate];
+        }
+        self.partitionPools = pools;
+    }
+}
+
+- (NSArray<SPTDataLoaderSessionStatistics *> *)statistics
+{
+    @synchronized(self) {
+        NSMutableArray<SPTDataLoaderSessionStatistics *> *statistics = [NSMutableArray new];
+        for (SPTDataLoaderServiceSessionPool *pool in [@[ self.defaultPool ] arrayByAddingObjectsFromArray:self.partitionPools]) {
+            SPTDataLoaderSessionStatistics *poolStatistics = [SPTDataLoaderSessionStatistics new];
+            poolStatistics.partitionName = pool.partition.name;
+            poolStatistics.sessionActive = pool.nonWaitingSession != nil || pool.waitingSession != nil;
+            poolStatistics.sessionCreationCount = pool.sessionCreationCount;
+            poolStatistics.taskCount = pool.taskCount;
+            poolStatistics.inFlightTaskCount = pool.inFlightTaskCount;
+            poolStatistics.failedTaskCount = pool.failedTaskCount;
+            poolStatistics.bytesSent = pool.bytesSent;
+            poolStatistics.bytesReceived = pool.bytesReceived;
+            if (pool.completedTaskCount > 0) {
+                poolStatistics.averageTaskDuration = pool.totalTaskDuration / pool.completedTaskCount;
+            }
+            [statistics addObject:poolStatistics];
+        }
+        return statistics;
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session didCreateTask:(NSURLSessionTask *)task
+{
+    @synchronized(self) {
+        SPTDataLoaderServiceSessionPool *pool = [self.poolsBySession objectForKey:session];
+        if (pool == nil) {
+            return;
+        }
+        pool.taskCount++;
+        pool.inFlightTaskCount++;
+        [self.taskStartTimes setObject:@(self.timeProvider.currentTime) forKey:task];
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session didCompleteTask:(NSURLSessionTask *)task error:(nullable NSError *)error
+{
+    SPTDataLoaderSessionPartition *idlePartition = nil;
+    @synchronized(self) {
+        NSNumber *startTime = [self.taskStartTimes objectForKey:task];
+        SPTDataLoaderServiceSessionPool *pool = [self.poolsBySession objectForKey:session];
+        if (startTime == nil || pool == nil) {
+            return;
+        }
+        [self.taskStartTimes removeObjectForKey:task];
+
+        CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+        pool.inFlightTaskCount--;
+        pool.completedTaskCount++;
+        pool.failedTaskCount += error != nil ? 1 : 0;
+        pool.bytesSent += task.countOfBytesSent;
+        pool.bytesReceived += task.countOfBytesReceived;
+        pool.totalTaskDuration += currentTime - startTime.doubleValue;
+
+        if (pool.inFlightTaskCount == 0 && pool.partition.idleTimeout > 0.0) {
+            pool.idleSince = currentTime;
+            idlePartition = pool.partition;
+        }
+    }
+
+    if (idlePartition != nil) {
+        __weak __typeof(self) weakSelf = self;
+        [self.timeProvider dispatchAfter:idlePartition.idleTimeout
+                                   queue:dispatch_get_global_queue(QOS_CLASS_UTILITY, 0)
+                                   block:^{
+                                       [weakSelf tearDownIdleSessions];
+                                   }];
+    }
+}
+
+- (void)tearDownIdleSessions
+{
+    @synchronized(self) {
+        CFAbsoluteTime currentTime = self.timeProvider.currentTime;
+        for (SPTDataLoaderServiceSessionPool *pool in self.partitionPools) {
+            NSTimeInterval idleTimeout = pool.partition.idleTimeout;
+            if (pool.inFlightTaskCount == 0 && idleTimeout > 0.0 && currentTime - pool.idleSince >= idleTimeout) {
+                [pool finishTasksAndInvalidate];
+            }
+        }
     }
 }
 
 - (void)invalidateAndCancel
 {
-    [self.waitingSession invalidateAndCancel];
-    [self.nonWaitingSession invalidateAndCancel];
+    @synchronized(self) {
+        [self waitingSessionOfPool:self.defaultPool];
+        [self nonWaitingSessionOfPool:self.defaultPool];
+        [self.defaultPool invalidateAndCancel];
+        for (SPTDataLoaderServiceSessionPool *pool in self.partitionPools) {
+            [pool invalidateAndCancel];
+        }
+    }
 }
 
 @end
@@ -0,0 +1,76 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderSessionPartition.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#import "SPTDataLoaderRequest+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderSessionPartition ()
+
+@property (nonatomic, copy, readonly, nullable) SPTDataLoaderSessionPartitionMatcher matcher;
+
+@end
+
+@implementation SPTDataLoaderSessionPartition
+
+#pragma mark SPTDataLoaderSessionPartition
+
++ (instancetype)partitionWithName:(NSString *)name
+                    configuration:(NSURLSessionConfiguration *)configuration
+                          matcher:(nullable SPTDataLoaderSessionPartitionMatcher)matcher
+{
+    return [[self alloc] initWithName:name configuration:configuration matcher:matcher];
+}
+
++ (instancetype)partitionWithName:(NSString *)name
+                    configuration:(NSURLSessionConfiguration *)configuration
+                            hosts:(NSSet<NSString *> *)hosts
+{
+    NSMutableSet<NSString *> *lowercaseHosts = [NSMutableSet setWithCapacity:hosts.count];
+    for (NSString *host in hosts) {
+        [lowercaseHosts addObject:host.lowercaseString];
+    }
+
+    return [self partitionWithName:name configuration:configuration matcher:^BOOL(SPTDataLoaderRequest *request) {
+        // Hosts are matched before resolution, the URL of the request may already point at a resolved address
+        NSString *host = (request.originalURL ?: request.URL).host.lowercaseString;
+        return host != nil && [lowercaseHosts containsObject:(NSString * _Nonnull)host];
+    }];
+}
+
+- (instancetype)initWithName:(NSString *)name
+               configuration:(NSURLSessionConfiguration *)configuration
+                     matcher:(nullable SPTDataLoaderSessionPartitionMatcher)matcher
+{
+    const NSTimeInterval SPTDataLoaderSessionPartitionDefaultIdleTimeout = 60.0;
+
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _configuration = [configuration copy];
+        _matcher = [matcher copy];
+        _idleTimeout = SPTDataLoaderSessionPartitionDefaultIdleTimeout;
+    }
+    return self;
+}
+
+- (BOOL)matchesRequest:(SPTDataLoaderRequest *)request
+{
+    NSString *sessionPartitionName = request.sessionPartitionName;
+    if (sessionPartitionName != nil) {
+        return [sessionPartitionName isEqualToString:self.name];
+    }
+
+    SPTDataLoaderSessionPartitionMatcher matcher = self.matcher;
+    return matcher != nil && matcher(request);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,24 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderSessionStatistics.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderSessionStatistics ()
+
+@property (nonatomic, copy, readwrite, nullable) NSString *partitionName;
+@property (nonatomic, assign, readwrite, getter = isSessionActive) BOOL sessionActive;
+@property (nonatomic, assign, readwrite) NSUInteger sessionCreationCount;
+@property (nonatomic, assign, readwrite) NSUInteger taskCount;
+@property (nonatomic, assign, readwrite) NSUInteger inFlightTaskCount;
+@property (nonatomic, assign, readwrite) NSUInteger failedTaskCount;
+@property (nonatomic, assign, readwrite) int64_t bytesSent;
+@property (nonatomic, assign, readwrite) int64_t bytesReceived;
+@property (nonatomic, assign, readwrite) NSTimeInterval averageTaskDuration;
+
+@end
+
+NS_ASSUME_NONNULL_END
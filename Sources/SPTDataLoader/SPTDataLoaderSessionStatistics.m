@@ -0,0 +1,26 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderSessionStatistics+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SPTDataLoaderSessionStatistics
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p partition = \"%@\"; tasks = %lu; in-flight = %lu; failed = %lu; average-duration = %.3f>",
+            self.class,
+            (void *)self,
+            self.partitionName,
+            (unsigned long)self.taskCount,
+            (unsigned long)self.inFlightTaskCount,
+            (unsigned long)self.failedTaskCount,
+            self.averageTaskDuration];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,102 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <SPTDataLoader/SPTDataLoaderSignpostTracer.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#include <os/signpost.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Signpost names have to be string literals, so every phase needs its own call
+#define SPTDataLoaderSignpostTracerPhaseCase(phase, name, body) \
+    case phase: { \
+        body(name); \
+        break; \
+    }
+
+#define SPTDataLoaderSignpostTracerSwitch(phase, body) \
+    switch (phase) { \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseSubmission, "submission", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseAuthorisation, "authorisation", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseRateLimiterWait, "rateLimiterWait", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseRetryBackoff, "retryBackoff", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseTask, "task", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseChunk, "chunk", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseCompletion, "completion", body) \
+        SPTDataLoaderSignpostTracerPhaseCase(SPTDataLoaderTracePhaseDelegateDelivery, "delegateDelivery", body) \
+    }
+
+@interface SPTDataLoaderSignpostTracer ()
+
+@property (nonatomic, copy, readwrite) NSString *subsystem;
+@property (nonatomic, strong) os_log_t log;
+
+@end
+
+@implementation SPTDataLoaderSignpostTracer
+
+#pragma mark SPTDataLoaderSignpostTracer
+
++ (instancetype)signpostTracerWithSubsystem:(NSString *)subsystem
+{
+    return [[self alloc] initWithSubsystem:subsystem];
+}
+
+- (instancetype)initWithSubsystem:(NSString *)subsystem
+{
+    self = [super init];
+    if (self) {
+        _subsystem = [subsystem copy];
+        _log = os_log_create(subsystem.UTF8String, OS_LOG_CATEGORY_POINTS_OF_INTEREST);
+    }
+
+    return self;
+}
+
+#pragma mark SPTDataLoaderTracer
+
+- (void)beganPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    os_log_t log = self.log;
+    if (!os_signpost_enabled(log)) {
+        return;
+    }
+
+    os_signpost_id_t signpostIdentifier = os_signpost_id_make_with_pointer(log, (__bridge const void *)request);
+    int64_t requestIdentifier = request.uniqueIdentifier;
+    const char *serviceKeyString = serviceKey.UTF8String;
+    const char *sourceIdentifierString = request.sourceIdentifier.UTF8String ?: "";
+#define SPTDataLoaderSignpostTracerBegin(name) \
+    os_signpost_interval_begin(log, signpostIdentifier, name, "request=%lld service=%{public}s source=%{public}s", \
+                               requestIdentifier, serviceKeyString, sourceIdentifierString)
+    SPTDataLoaderSignpostTracerSwitch(phase, SPTDataLoaderSignpostTracerBegin)
+#undef SPTDataLoaderSignpostTracerBegin
+}
+
+- (void)endedPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    os_log_t log = self.log;
+    if (!os_signpost_enabled(log)) {
+        return;
+    }
+
+    os_signpost_id_t signpostIdentifier = os_signpost_id_make_with_pointer(log, (__bridge const void *)request);
+#define SPTDataLoaderSignpostTracerEnd(name) os_signpost_interval_end(log, signpostIdentifier, name)
+    SPTDataLoaderSignpostTracerSwitch(phase, SPTDataLoaderSignpostTracerEnd)
+#undef SPTDataLoaderSignpostTracerEnd
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p subsystem = \"%@\">", self.class, (void *)self, self.subsystem];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
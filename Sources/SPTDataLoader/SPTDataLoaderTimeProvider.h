@@ -7,10 +7,26 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ The clock and scheduler the library measures and waits with
+ @discussion Every time dependent part of the library, such as rate limiting, retry backoff and request timeouts, reads
+ the time and schedules its waits through this protocol so that a virtual implementation can replace real time.
+ */
 @protocol SPTDataLoaderTimeProvider <NSObject>
 
+/**
+ The current absolute time
+ */
 @property (nonatomic, readonly) CFAbsoluteTime currentTime;
 
+/**
+ Schedules a block to run once a delay has passed
+ @param delay The number of seconds to wait before running the block
+ @param queue The queue to run the block on
+ @param block The block to run
+ */
+- (void)dispatchAfter:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,41 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Hands the phases of the requests of a service to its tracer
+ @discussion A service shares its context with every factory, data loader and task handler it creates, so that
+ replacing the tracer takes effect for requests already in flight. With no tracer every call returns after a single
+ check, which keeps tracing free for services that do not use it. A phase that ends without having begun, such as the
+ submission of a request retried after being authorised again, is not handed to the tracer.
+ */
+@interface SPTDataLoaderTraceContext : NSObject
+
+/**
+ The tracer the phases are handed to, or nil if tracing is disabled
+ */
+@property (atomic, strong, nullable) id<SPTDataLoaderTracer> tracer;
+
+/**
+ Tells the tracer that a request entered a phase
+ @param phase The phase that began
+ @param request The request that entered the phase
+ */
+- (void)beginPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request;
+/**
+ Tells the tracer that a request left a phase
+ @param phase The phase that ended
+ @param request The request that left the phase
+ */
+- (void)endPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request;
+
+@end
+
+NS_ASSUME_NONNULL_END
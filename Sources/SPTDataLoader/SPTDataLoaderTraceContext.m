@@ -0,0 +1,81 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderTraceContext.h"
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#import "SPTDataLoaderRateLimiter+Private.h"
+#import "SPTDataLoaderRequest+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+NSString *NSStringFromSPTDataLoaderTracePhase(SPTDataLoaderTracePhase phase)
+{
+    switch (phase) {
+        case SPTDataLoaderTracePhaseSubmission:
+            return @"submission";
+        case SPTDataLoaderTracePhaseAuthorisation:
+            return @"authorisation";
+        case SPTDataLoaderTracePhaseRateLimiterWait:
+            return @"rateLimiterWait";
+        case SPTDataLoaderTracePhaseRetryBackoff:
+            return @"retryBackoff";
+        case SPTDataLoaderTracePhaseTask:
+            return @"task";
+        case SPTDataLoaderTracePhaseChunk:
+            return @"chunk";
+        case SPTDataLoaderTracePhaseCompletion:
+            return @"completion";
+        case SPTDataLoaderTracePhaseDelegateDelivery:
+            return @"delegateDelivery";
+    }
+    return @"unknown";
+}
+
+@implementation SPTDataLoaderTraceContext
+
+#pragma mark SPTDataLoaderTraceContext
+
+- (void)beginPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request
+{
+    id<SPTDataLoaderTracer> tracer = self.tracer;
+    if (tracer == nil) {
+        return;
+    }
+
+    // Chunks of a request may overlap, so only their own begin and end pair them up
+    if (phase != SPTDataLoaderTracePhaseChunk) {
+        [request openTracePhase:phase];
+    }
+    [tracer beganPhase:phase ofRequest:request serviceKey:[self serviceKeyForRequest:request]];
+}
+
+- (void)endPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request
+{
+    id<SPTDataLoaderTracer> tracer = self.tracer;
+    if (tracer == nil) {
+        return;
+    }
+
+    if (phase != SPTDataLoaderTracePhaseChunk && ![request closeTracePhase:phase]) {
+        return;
+    }
+    [tracer endedPhase:phase ofRequest:request serviceKey:[self serviceKeyForRequest:request]];
+}
+
+- (NSString *)serviceKeyForRequest:(SPTDataLoaderRequest *)request
+{
+    NSString *serviceKey = request.traceServiceKey;
+    if (serviceKey == nil) {
+        serviceKey = [SPTDataLoaderRateLimiter serviceKeyFromURL:request.URL];
+        request.traceServiceKey = serviceKey;
+    }
+    return serviceKey;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
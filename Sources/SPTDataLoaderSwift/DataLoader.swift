@@ -21,10 +21,15 @@ public protocol DataLoader {
 public extension SPTDataLoaderFactory {
     /// Convenience method for creating a Swift `DataLoader`.
     /// - Parameter responseQueue: The `DispatchQueue` on which to perform response handling.
+    /// - Parameter serializationExecutor: The executor on which to serialize response values before they are
+    /// delivered on the response queue. When `nil`, serialization is performed on the response queue.
     /// - Returns: A new `DataLoader` instance.
-    func makeDataLoader(responseQueue: DispatchQueue = .global()) -> DataLoader {
+    func makeDataLoader(
+        responseQueue: DispatchQueue = .global(),
+        serializationExecutor: ResponseSerializationExecutor? = nil
+    ) -> DataLoader {
         let sptDataLoader = createDataLoader()
-        let dataLoaderWrapper = DataLoaderWrapper(dataLoader: sptDataLoader)
+        let dataLoaderWrapper = DataLoaderWrapper(dataLoader: sptDataLoader, serializationExecutor: serializationExecutor)
 
         sptDataLoader.delegate = dataLoaderWrapper
         sptDataLoader.delegateQueue = responseQueue
@@ -5,12 +5,14 @@ import Foundation
 
 final class DataLoaderWrapper: NSObject {
     private let dataLoader: SPTDataLoader
+    private let serializationExecutor: ResponseSerializationExecutor?
 
     private let accessLock = AccessLock()
     private var requests: [Int64: Request] = [:]
 
-    init(dataLoader: SPTDataLoader) {
+    init(dataLoader: SPTDataLoader, serializationExecutor: ResponseSerializationExecutor? = nil) {
         self.dataLoader = dataLoader
+        self.serializationExecutor = serializationExecutor
     }
 }
 
@@ -21,7 +23,10 @@ extension DataLoaderWrapper: DataLoader {
 
     func request(_ url: URL, sourceIdentifier: String?) -> Request {
         let sptRequest = SPTDataLoaderRequest(url: url, sourceIdentifier: sourceIdentifier)
-        let request = Request(request: sptRequest) { [weak self] request in
+        let serializationContext = serializationExecutor.map { executor in
+            Request.SerializationContext(executor: executor, deliveryQueue: dataLoader.delegateQueue)
+        }
+        let request = Request(request: sptRequest, serializationContext: serializationContext) { [weak self] request in
             guard let self = self else {
                 return nil
             }
@@ -0,0 +1,91 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+import CommonCrypto
+import Foundation
+
+/// A cache of decoded response values, handing back the value decoded from an identical earlier response.
+///
+/// Values are keyed by the request URL, the decoded type and a validator of the response: its `ETag` when it has
+/// one, a SHA-256 digest of the body otherwise. A hit skips decoding entirely, and with an `ETag` it skips hashing as
+/// well. The cost of a value is the size of the body it was decoded from, and values are evicted once the total
+/// exceeds the cost limit. Memory pressure empties the cache.
+///
+/// Cached values are shared between responses, so only value types or immutable classes should be cached. A cache
+/// must only be used with a single decoder configuration, since the decoder is not part of the key.
+public final class DecodedValueCache {
+    private let cache = NSCache<NSString, Entry>()
+    private let memoryPressureSource: DispatchSourceMemoryPressure
+
+    private final class Entry {
+        let value: Any
+
+        init(value: Any) {
+            self.value = value
+        }
+    }
+
+    /// Creates a new cache.
+    /// - Parameter totalCostLimit: The number of body bytes the cached values may have been decoded from in total.
+    public init(totalCostLimit: Int = 16 * 1024 * 1024) {
+        cache.totalCostLimit = totalCostLimit
+        cache.name = "com.spotify.sptdataloaderswift.decodedvalues"
+
+        memoryPressureSource = DispatchSource.makeMemoryPressureSource(eventMask: [.warning, .critical])
+        memoryPressureSource.setEventHandler { [cache] in
+            cache.removeAllObjects()
+        }
+        memoryPressureSource.resume()
+    }
+
+    deinit {
+        memoryPressureSource.cancel()
+    }
+
+    /// The number of body bytes the cached values may have been decoded from in total.
+    public var totalCostLimit: Int { cache.totalCostLimit }
+
+    /// Removes every cached value.
+    public func removeAllValues() {
+        cache.removeAllObjects()
+    }
+
+    func value<Value>(
+        _ type: Value.Type,
+        for response: SPTDataLoaderResponse,
+        body: Data,
+        decode: () throws -> Value
+    ) throws -> Value {
+        let key = DecodedValueCache.key(for: type, response: response, body: body)
+        if let value = cache.object(forKey: key)?.value as? Value {
+            return value
+        }
+
+        let value = try decode()
+        cache.setObject(Entry(value: value), forKey: key, cost: body.count)
+        return value
+    }
+
+    private static func key<Value>(for type: Value.Type, response: SPTDataLoaderResponse, body: Data) -> NSString {
+        let validator = entityTag(of: response).map { entityTag in "etag:\(entityTag)" } ?? "sha256:\(digest(of: body))"
+        return "\(String(reflecting: type))\n\(response.request.url.absoluteString)\n\(validator)" as NSString
+    }
+
+    private static func entityTag(of response: SPTDataLoaderResponse) -> String? {
+        let headers = response.responseHeaders
+        if let entityTag = headers["ETag"] {
+            return entityTag
+        }
+
+        return headers.first { name, _ in name.caseInsensitiveCompare("ETag") == .orderedSame }?.value
+    }
+
+    private static func digest(of data: Data) -> String {
+        var digest = [UInt8](repeating: 0, count: Int(CC_SHA256_DIGEST_LENGTH))
+        data.withUnsafeBytes { bytes in
+            _ = CC_SHA256(bytes.baseAddress, CC_LONG(data.count), &digest)
+        }
+
+        return digest.map { byte in String(format: "%02x", byte) }.joined()
+    }
+}
@@ -18,9 +18,10 @@ public extension Request {
 
     func decodablePublisher<Value: Decodable>(
         type: Value.Type = Value.self,
-        decoder: ResponseDecoder = JSONDecoder()
+        decoder: ResponseDecoder = JSONDecoder(),
+        cache: DecodedValueCache? = nil
     ) -> ResponsePublisher<Value> {
-        return ResponsePublisher(request: self, decodableType: type, decoder: decoder)
+        return ResponsePublisher(request: self, decodableType: type, decoder: decoder, cache: cache)
     }
 
     func jsonPublisher(options: JSONSerialization.ReadingOptions = []) -> ResponsePublisher<Any> {
@@ -79,9 +80,14 @@ private extension ResponsePublisher {
         }
     }
 
-    init(request: Request, decodableType: Value.Type, decoder: ResponseDecoder) where Value: Decodable {
+    init(
+        request: Request,
+        decodableType: Value.Type,
+        decoder: ResponseDecoder,
+        cache: DecodedValueCache?
+    ) where Value: Decodable {
         self.init(request: request) { completion in
-            request.responseDecodable(type: decodableType, decoder: decoder, completionHandler: completion)
+            request.responseDecodable(type: decodableType, decoder: decoder, cache: cache, completionHandler: completion)
         }
     }
 
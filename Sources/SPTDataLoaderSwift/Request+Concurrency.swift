@@ -17,9 +17,10 @@ public extension Request {
 
     func decodableTask<Value: Decodable>(
         type: Value.Type = Value.self,
-        decoder: ResponseDecoder = JSONDecoder()
+        decoder: ResponseDecoder = JSONDecoder(),
+        cache: DecodedValueCache? = nil
     ) -> ResponseTask<Value> {
-        return ResponseTask(request: self, decodableType: type, decoder: decoder)
+        return ResponseTask(request: self, decodableType: type, decoder: decoder, cache: cache)
     }
 
     func jsonTask(options: JSONSerialization.ReadingOptions = []) -> ResponseTask<Any> {
@@ -86,9 +87,14 @@ private extension ResponseTask {
         }
     }
 
-    init(request: Request, decodableType: Value.Type, decoder: ResponseDecoder) where Value: Decodable {
+    init(
+        request: Request,
+        decodableType: Value.Type,
+        decoder: ResponseDecoder,
+        cache: DecodedValueCache?
+    ) where Value: Decodable {
         self.init(request: request) { continuation in
-            request.responseDecodable(type: decodableType, decoder: decoder) { response in
+            request.responseDecodable(type: decodableType, decoder: decoder, cache: cache) { response in
                 continuation.resume(returning: response)
             }
         }
@@ -13,13 +13,24 @@ import Foundation
 /// existing value.
 public final class Request {
     private let request: SPTDataLoaderRequest
+    private let serializationContext: SerializationContext?
     private let executionHandler: (Request) -> SPTDataLoaderCancellationToken?
 
-    init(request: SPTDataLoaderRequest, executionHandler: @escaping (Request) -> SPTDataLoaderCancellationToken?) {
+    init(
+        request: SPTDataLoaderRequest,
+        serializationContext: SerializationContext? = nil,
+        executionHandler: @escaping (Request) -> SPTDataLoaderCancellationToken?
+    ) {
         self.request = request
+        self.serializationContext = serializationContext
         self.executionHandler = executionHandler
     }
 
+    struct SerializationContext {
+        let executor: ResponseSerializationExecutor
+        let deliveryQueue: DispatchQueue
+    }
+
     private enum State {
         case initialized
         case failed(error: Error)
@@ -130,6 +141,34 @@ public final class Request {
 
         handlers.forEach { handler in handler(responseState) }
     }
+
+    func addSerializingResponseHandler<Value>(
+        serializer: @escaping (SPTDataLoaderResponse) throws -> Value,
+        completionHandler: @escaping (Response<Value, Error>) -> Void
+    ) {
+        addResponseHandler { [request, serializationContext] state in
+            let makeResponse = {
+                Response(
+                    request: request,
+                    response: state.response,
+                    result: state.result.flatMap { response in Result { try serializer(response) } }
+                )
+            }
+
+            // Failed responses have nothing to serialize, so they are delivered without a queue hop.
+            guard let serializationContext = serializationContext, case .success = state.result else {
+                completionHandler(makeResponse())
+                return
+            }
+
+            serializationContext.executor.execute {
+                let response = makeResponse()
+                serializationContext.deliveryQueue.async {
+                    completionHandler(response)
+                }
+            }
+        }
+    }
 }
 
 // MARK: -
@@ -258,23 +297,17 @@ public extension Request {
 
     /// Adds a handler that receives a `Response` containing a decoded value.
     /// - Parameter decoder: The `ResponseDecoder` used to decode the value from response data.
+    /// - Parameter cache: The cache to reuse the value decoded from an identical earlier response from, if any.
     /// - Parameter completionHandler: The callback closure invoked upon completion.
     @discardableResult
     func responseDecodable<Value: Decodable>(
         type: Value.Type = Value.self,
         decoder: ResponseDecoder = JSONDecoder(),
+        cache: DecodedValueCache? = nil,
         completionHandler: @escaping (Response<Value, Error>) -> Void
     ) -> Self {
-        addResponseHandler { [request] state in
-            let response = Response(
-                request: request,
-                response: state.response,
-                result: state.result.flatMap { response in
-                    Result { try DecodableResponseSerializer<Value>(decoder: decoder).serialize(response: response) }
-                }
-            )
-            completionHandler(response)
-        }
+        let serializer = DecodableResponseSerializer<Value>(decoder: decoder, cache: cache)
+        addSerializingResponseHandler(serializer: serializer.serialize, completionHandler: completionHandler)
 
         return self
     }
@@ -287,16 +320,8 @@ public extension Request {
         options: JSONSerialization.ReadingOptions = [],
         completionHandler: @escaping (Response<Any, Error>) -> Void
     ) -> Self {
-        addResponseHandler { [request] state in
-            let response = Response(
-                request: request,
-                response: state.response,
-                result: state.result.flatMap { response in
-                    Result { try JSONResponseSerializer(options: options).serialize(response: response) }
-                }
-            )
-            completionHandler(response)
-        }
+        let serializer = JSONResponseSerializer(options: options)
+        addSerializingResponseHandler(serializer: serializer.serialize, completionHandler: completionHandler)
 
         return self
     }
@@ -309,16 +334,7 @@ public extension Request {
         serializer: Serializer,
         completionHandler: @escaping (Response<Serializer.Output, Error>) -> Void
     ) -> Self {
-        addResponseHandler { [request] state in
-            let response = Response(
-                request: request,
-                response: state.response,
-                result: state.result.flatMap { response in
-                    Result { try serializer.serialize(response: response) }
-                }
-            )
-            completionHandler(response)
-        }
+        addSerializingResponseHandler(serializer: serializer.serialize, completionHandler: completionHandler)
 
         return self
     }
@@ -0,0 +1,245 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+import Foundation
+
+/// A group of requests that are executed and cancelled as one unit.
+///
+/// At most `maximumConcurrentRequests` requests are executed at any time; the remaining requests are executed
+/// as earlier ones complete. The batch is executed upon attachment of its response handler, and only the first
+/// handler attached is used.
+public final class RequestBatch {
+    /// The requests in the batch.
+    public let requests: [Request]
+
+    /// The maximum number of requests that are executed at once.
+    public let maximumConcurrentRequests: Int
+
+    /// Creates a batch of requests.
+    /// - Parameter requests: The requests in the batch.
+    /// - Parameter maximumConcurrentRequests: The maximum number of requests to execute at once. Clamped to a
+    /// minimum of one.
+    public init(requests: [Request], maximumConcurrentRequests: Int = .max) {
+        self.requests = requests
+        self.maximumConcurrentRequests = max(maximumConcurrentRequests, 1)
+    }
+
+    private enum State {
+        case initialized
+        case executing
+        case completed
+        case cancelled
+    }
+
+    private let accessLock = AccessLock()
+    private var state: State = .initialized
+
+    private func execute<Value>(
+        handlerAttacher attachHandler: @escaping (Request, @escaping (Response<Value, Error>) -> Void) -> Void,
+        itemHandler: ((Int, Response<Value, Error>) -> Void)?,
+        completionHandler: @escaping ([Response<Value, Error>]) -> Void
+    ) {
+        var responses = [Response<Value, Error>?](repeating: nil, count: requests.count)
+        var nextIndex = 0
+        var inFlightCount = 0
+
+        func dequeueRequests() -> Range<Int> {
+            return accessLock.sync {
+                guard case .executing = state else {
+                    return 0..<0
+                }
+
+                let count = min(maximumConcurrentRequests - inFlightCount, requests.count - nextIndex)
+                guard count > 0 else {
+                    return 0..<0
+                }
+
+                let range = nextIndex..<nextIndex + count
+                nextIndex += count
+                inFlightCount += count
+
+                return range
+            }
+        }
+
+        func executeRequests(in range: Range<Int>) {
+            for index in range {
+                attachHandler(requests[index]) { response in
+                    completeRequest(at: index, response: response)
+                }
+            }
+        }
+
+        func completeRequest(at index: Int, response: Response<Value, Error>) {
+            var isExecuting = false
+            var completedResponses: [Response<Value, Error>]?
+
+            accessLock.sync {
+                guard case .executing = state else {
+                    return
+                }
+
+                isExecuting = true
+                responses[index] = response
+                inFlightCount -= 1
+
+                if nextIndex == requests.count && inFlightCount == 0 {
+                    state = .completed
+                    completedResponses = responses.compactMap { $0 }
+                }
+            }
+
+            guard isExecuting else {
+                return
+            }
+
+            itemHandler?(index, response)
+
+            if let completedResponses = completedResponses {
+                completionHandler(completedResponses)
+            } else {
+                executeRequests(in: dequeueRequests())
+            }
+        }
+
+        let shouldExecute: Bool = accessLock.sync {
+            guard case .initialized = state else {
+                return false
+            }
+
+            state = requests.isEmpty ? .completed : .executing
+            return true
+        }
+
+        guard shouldExecute else {
+            return
+        }
+
+        guard !requests.isEmpty else {
+            completionHandler([])
+            return
+        }
+
+        executeRequests(in: dequeueRequests())
+    }
+}
+
+// MARK: -
+
+public extension RequestBatch {
+    /// Cancels every request in the batch that has not yet completed.
+    ///
+    /// As with `Request`, no handlers are invoked once the batch has been cancelled.
+    func cancel() {
+        let shouldCancel: Bool = accessLock.sync {
+            switch state {
+            case .initialized, .executing:
+                state = .cancelled
+                return true
+            case .completed, .cancelled:
+                return false
+            }
+        }
+
+        guard shouldCancel else {
+            return
+        }
+
+        requests.forEach { request in request.cancel() }
+    }
+
+    /// A Boolean value indicating whether the batch has been cancelled.
+    var isCancelled: Bool {
+        return accessLock.sync {
+            guard case .cancelled = state else {
+                return false
+            }
+
+            return true
+        }
+    }
+}
+
+// MARK: -
+
+public extension RequestBatch {
+    /// Adds handlers that receive a `Response` containing data for each request and for the whole batch.
+    /// - Parameter itemHandler: The callback closure invoked with the index and response of each request.
+    /// - Parameter completionHandler: The callback closure invoked with the responses in request order once every
+    /// request has completed.
+    @discardableResult
+    func responseData(
+        itemHandler: ((Int, Response<Data, Error>) -> Void)? = nil,
+        completionHandler: @escaping ([Response<Data, Error>]) -> Void
+    ) -> Self {
+        execute(
+            handlerAttacher: { request, handler in request.responseData(completionHandler: handler) },
+            itemHandler: itemHandler,
+            completionHandler: completionHandler
+        )
+
+        return self
+    }
+
+    /// Adds handlers that receive a `Response` containing a decoded value for each request and for the whole batch.
+    /// - Parameter decoder: The `ResponseDecoder` used to decode the values from response data.
+    /// - Parameter cache: The cache to reuse values decoded from identical earlier responses from, if any.
+    /// - Parameter itemHandler: The callback closure invoked with the index and response of each request.
+    /// - Parameter completionHandler: The callback closure invoked with the responses in request order once every
+    /// request has completed.
+    @discardableResult
+    func responseDecodable<Value: Decodable>(
+        type: Value.Type = Value.self,
+        decoder: ResponseDecoder = JSONDecoder(),
+        cache: DecodedValueCache? = nil,
+        itemHandler: ((Int, Response<Value, Error>) -> Void)? = nil,
+        completionHandler: @escaping ([Response<Value, Error>]) -> Void
+    ) -> Self {
+        execute(
+            handlerAttacher: { request, handler in
+                request.responseDecodable(type: type, decoder: decoder, cache: cache, completionHandler: handler)
+            },
+            itemHandler: itemHandler,
+            completionHandler: completionHandler
+        )
+
+        return self
+    }
+
+    /// Adds handlers that receive a `Response` containing a serialized value for each request and for the whole
+    /// batch.
+    /// - Parameter serializer: The `ResponseSerializer` to use for serializing the response values.
+    /// - Parameter itemHandler: The callback closure invoked with the index and response of each request.
+    /// - Parameter completionHandler: The callback closure invoked with the responses in request order once every
+    /// request has completed.
+    @discardableResult
+    func responseSerializable<Serializer: ResponseSerializer>(
+        serializer: Serializer,
+        itemHandler: ((Int, Response<Serializer.Output, Error>) -> Void)? = nil,
+        completionHandler: @escaping ([Response<Serializer.Output, Error>]) -> Void
+    ) -> Self {
+        execute(
+            handlerAttacher: { request, handler in
+                request.responseSerializable(serializer: serializer, completionHandler: handler)
+            },
+            itemHandler: itemHandler,
+            completionHandler: completionHandler
+        )
+
+        return self
+    }
+}
+
+// MARK: -
+
+public extension DataLoader {
+    /// Creates a `RequestBatch` that retrieves the contents of several URLs as one unit.
+    /// - Parameter urls: The URLs for the requests in the batch.
+    /// - Parameter sourceIdentifier: The identifier for the request source. May be `nil`.
+    /// - Parameter maximumConcurrentRequests: The maximum number of requests to execute at once.
+    /// - Returns: A new `RequestBatch` instance.
+    func batch(_ urls: [URL], sourceIdentifier: String?, maximumConcurrentRequests: Int = .max) -> RequestBatch {
+        let requests = urls.map { url in request(url, sourceIdentifier: sourceIdentifier) }
+        return RequestBatch(requests: requests, maximumConcurrentRequests: maximumConcurrentRequests)
+    }
+}
@@ -0,0 +1,32 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+import Foundation
+
+/// An executor that performs response serialization away from the response queue.
+///
+/// Serializers attached to a `Request` run concurrently on the executor, bounded by its
+/// maximum concurrency, and their results are then delivered on the response queue.
+public final class ResponseSerializationExecutor {
+    private let operationQueue: OperationQueue
+
+    /// Creates a new executor.
+    /// - Parameter maximumConcurrency: The maximum number of responses serialized at the same time.
+    /// - Parameter qualityOfService: The quality of service used for serialization work.
+    public init(
+        maximumConcurrency: Int = ProcessInfo.processInfo.activeProcessorCount,
+        qualityOfService: QualityOfService = .userInitiated
+    ) {
+        operationQueue = OperationQueue()
+        operationQueue.name = "com.spotify.sptdataloaderswift.serialization"
+        operationQueue.maxConcurrentOperationCount = max(1, maximumConcurrency)
+        operationQueue.qualityOfService = qualityOfService
+    }
+
+    /// The maximum number of responses serialized at the same time.
+    public var maximumConcurrency: Int { operationQueue.maxConcurrentOperationCount }
+
+    func execute(_ work: @escaping () -> Void) {
+        operationQueue.addOperation(work)
+    }
+}
@@ -27,13 +27,20 @@ struct DataResponseSerializer: ResponseSerializer {
 
 struct DecodableResponseSerializer<Value: Decodable>: ResponseSerializer {
     let decoder: ResponseDecoder
+    var cache: DecodedValueCache?
 
     func serialize(response: SPTDataLoaderResponse) throws -> Value {
         guard let data = response.body else {
             throw ResponseSerializationError.dataNotFound
         }
 
-        return try decoder.decode(Value.self, from: data)
+        guard let cache = cache else {
+            return try decoder.decode(Value.self, from: data)
+        }
+
+        return try cache.value(Value.self, for: response, body: data) {
+            try decoder.decode(Value.self, from: data)
+        }
     }
 }
 
@@ -82,4 +82,72 @@
     [self waitForExpectationsWithTimeout:1.0 handler:nil];
 }
 
+- (void)testPerformRequestsCallsBatchCompletionWithResponsesInRequestOrder
+{
+    NSArray<SPTDataLoaderRequest *> *requests = @[ [SPTDataLoaderRequest new], [SPTDataLoaderRequest new], [SPTDataLoaderRequest new] ];
+    __block NSUInteger numberOfItemCompletions = 0;
+    __weak XCTestExpectation *expectation = [self expectationWithDescription:@"Expected batch completion"];
+    [self.dataLoaderBlockWrapper performRequests:requests
+                       maximumConcurrentRequests:0
+                                  itemCompletion:^(SPTDataLoaderResponse * _Nonnull response, NSError * _Nullable error) {
+                                      numberOfItemCompletions++;
+                                  }
+                                      completion:^(NSArray<SPTDataLoaderResponse *> * _Nonnull responses) {
+                                          XCTAssertEqual(responses.count, requests.count);
+                                          for (NSUInteger i = 0; i < requests.count; i++) {
+                                              XCTAssertEqual(responses[i].request.uniqueIdentifier, requests[i].uniqueIdentifier);
+                                          }
+                                          [expectation fulfill];
+                                      }];
+    NSArray<SPTDataLoaderRequest *> *currentRequests = self.dataLoader.currentRequests;
+    XCTAssertEqual(currentRequests.count, requests.count, @"The whole batch should be in flight without a limit");
+    for (SPTDataLoaderRequest *request in currentRequests.reverseObjectEnumerator) {
+        [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil]];
+    }
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertEqual(numberOfItemCompletions, requests.count);
+}
+
+- (void)testPerformRequestsRespectsMaximumConcurrentRequests
+{
+    NSArray<SPTDataLoaderRequest *> *requests = @[ [SPTDataLoaderRequest new], [SPTDataLoaderRequest new], [SPTDataLoaderRequest new] ];
+    __block BOOL completed = NO;
+    [self.dataLoaderBlockWrapper performRequests:requests
+                       maximumConcurrentRequests:2
+                                  itemCompletion:nil
+                                      completion:^(NSArray<SPTDataLoaderResponse *> * _Nonnull responses) {
+                                          completed = YES;
+                                      }];
+    XCTAssertEqual(self.dataLoader.currentRequests.count, 2u);
+    SPTDataLoaderRequest *request = self.dataLoader.currentRequests.firstObject;
+    [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil]];
+    XCTAssertEqual(self.dataLoader.currentRequests.count, 2u, @"The next request should be performed once one completes");
+    XCTAssertEqual(self.dataLoader.currentRequests.lastObject.uniqueIdentifier, requests.lastObject.uniqueIdentifier);
+    for (SPTDataLoaderRequest *currentRequest in self.dataLoader.currentRequests) {
+        [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:currentRequest response:nil]];
+    }
+    XCTAssertTrue(completed);
+}
+
+- (void)testCancellingBatchCompletesEveryRequestAsCancelled
+{
+    NSArray<SPTDataLoaderRequest *> *requests = @[ [SPTDataLoaderRequest new], [SPTDataLoaderRequest new], [SPTDataLoaderRequest new] ];
+    __weak XCTestExpectation *expectation = [self expectationWithDescription:@"Expected batch completion"];
+    id<SPTDataLoaderCancellationToken> cancellationToken = [self.dataLoaderBlockWrapper performRequests:requests
+                                                                               maximumConcurrentRequests:1
+                                                                                          itemCompletion:nil
+                                                                                              completion:^(NSArray<SPTDataLoaderResponse *> * _Nonnull responses) {
+                                                                                                  XCTAssertEqual(responses.count, requests.count);
+                                                                                                  for (SPTDataLoaderResponse *response in responses) {
+                                                                                                      XCTAssertEqual(response.error.code, NSURLErrorCancelled);
+                                                                                                  }
+                                                                                                  [expectation fulfill];
+                                                                                              }];
+    [cancellationToken cancel];
+    XCTAssertTrue(cancellationToken.cancelled);
+    XCTAssertNotNil(self.requestResponseHandlerDelegate.lastRequestCancelled, @"The request in flight should be cancelled");
+    XCTAssertEqual(self.dataLoader.currentRequests.count, 0u);
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
 @end
@@ -0,0 +1,147 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+#import <zlib.h>
+
+#import "SPTDataLoaderBodyCompressor.h"
+
+@interface SPTDataLoaderBodyCompressorTest : XCTestCase
+
+@property (nonatomic, strong) NSData *data;
+
+@end
+
+@implementation SPTDataLoaderBodyCompressorTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.data = [[@"" stringByPaddingToLength:256 * 1024 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+#pragma mark SPTDataLoaderBodyCompressorTest
+
+- (void)testContentEncoding
+{
+    XCTAssertNil([SPTDataLoaderBodyCompressor contentEncodingForCompression:SPTDataLoaderRequestBodyCompressionNone]);
+    XCTAssertEqualObjects([SPTDataLoaderBodyCompressor contentEncodingForCompression:SPTDataLoaderRequestBodyCompressionGzip], @"gzip");
+    XCTAssertEqualObjects([SPTDataLoaderBodyCompressor contentEncodingForCompression:SPTDataLoaderRequestBodyCompressionDeflate], @"deflate");
+}
+
+- (void)testGzipRoundTrip
+{
+    NSData *compressedData = [SPTDataLoaderBodyCompressor compressedData:self.data
+                                                             compression:SPTDataLoaderRequestBodyCompressionGzip];
+    XCTAssertLessThan(compressedData.length, self.data.length);
+    const uint8_t *bytes = compressedData.bytes;
+    XCTAssertEqual(bytes[0], 0x1f, @"The data should start with the gzip magic number");
+    XCTAssertEqual(bytes[1], 0x8b, @"The data should start with the gzip magic number");
+    XCTAssertEqualObjects([self inflatedData:compressedData], self.data);
+}
+
+- (void)testDeflateRoundTrip
+{
+    NSData *compressedData = [SPTDataLoaderBodyCompressor compressedData:self.data
+                                                             compression:SPTDataLoaderRequestBodyCompressionDeflate];
+    XCTAssertLessThan(compressedData.length, self.data.length);
+    XCTAssertEqualObjects([self inflatedData:compressedData], self.data);
+}
+
+- (void)testNoCompression
+{
+    XCTAssertNil([SPTDataLoaderBodyCompressor compressedData:self.data compression:SPTDataLoaderRequestBodyCompressionNone]);
+}
+
+- (void)testStreamRoundTrip
+{
+    __block NSUInteger readLength = 0;
+    NSInputStream *stream = [SPTDataLoaderBodyCompressor compressedStreamWithStream:[NSInputStream inputStreamWithData:self.data]
+                                                                        compression:SPTDataLoaderRequestBodyCompressionGzip
+                                                                        readHandler:^(NSUInteger length) {
+        @synchronized(self) {
+            readLength += length;
+        }
+    }
+                                                                     failureHandler:nil];
+
+    NSMutableData *compressedData = [NSMutableData data];
+    uint8_t buffer[4096];
+    [stream open];
+    NSInteger length = 0;
+    while ((length = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [compressedData appendBytes:buffer length:(NSUInteger)length];
+    }
+    [stream close];
+
+    XCTAssertEqual(length, 0, @"The stream should end without an error");
+    XCTAssertLessThan(compressedData.length, self.data.length);
+    XCTAssertEqualObjects([self inflatedData:compressedData], self.data);
+    @synchronized(self) {
+        XCTAssertEqual(readLength, self.data.length, @"The read handler should have been told about every byte");
+    }
+}
+
+- (void)testStreamReportsFailingSourceStream
+{
+    // Given a source stream that cannot be read
+    NSInputStream *sourceStream = [NSInputStream inputStreamWithFileAtPath:@"/nonexistent/spotify/body"];
+    __block NSError *failureError = nil;
+    NSInputStream *stream = [SPTDataLoaderBodyCompressor compressedStreamWithStream:sourceStream
+                                                                        compression:SPTDataLoaderRequestBodyCompressionGzip
+                                                                        readHandler:nil
+                                                                     failureHandler:^(NSError *error) {
+        @synchronized(self) {
+            failureError = error;
+        }
+    }];
+
+    // When the compressed stream is read to its end
+    NSMutableData *compressedData = [NSMutableData data];
+    uint8_t buffer[4096];
+    [stream open];
+    NSInteger length = 0;
+    while ((length = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [compressedData appendBytes:buffer length:(NSUInteger)length];
+    }
+    [stream close];
+
+    // Then the failure should have been reported before the stream ended, and the body should not be complete
+    @synchronized(self) {
+        XCTAssertNotNil(failureError, @"The failure handler should be told the source stream could not be read");
+    }
+    XCTAssertNil([self inflatedData:compressedData], @"The compressed stream should not end like a complete body");
+}
+
+#pragma mark Private
+
+- (NSData *)inflatedData:(NSData *)data
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // Detect gzip and zlib headers automatically
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        return nil;
+    }
+
+    NSMutableData *inflatedData = [NSMutableData data];
+    uint8_t buffer[4096];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        [inflatedData appendBytes:buffer length:sizeof(buffer) - stream.avail_out];
+    }
+    inflateEnd(&stream);
+
+    return status == Z_STREAM_END ? inflatedData : nil;
+}
+
+@end
@@ -0,0 +1,173 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoader.h>
+#import "SPTDataLoaderService+Private.h"
+
+#import "SPTDataLoaderLock.h"
+#import "SPTDataLoaderRequestResponseHandler.h"
+#import "NSURLSessionMock.h"
+#import "NSURLSessionDataTaskMock.h"
+#import "SPTDataLoaderRequestResponseHandlerMock.h"
+#import "SPTDataLoaderServiceSessionSelectorMock.h"
+
+@interface SPTDataLoaderService () <NSURLSessionDataDelegate, SPTDataLoaderRequestResponseHandlerDelegate>
+
+@end
+
+/**
+ Drives the data callbacks of many tasks at once, the way the session queue does
+
+ The benchmark only runs when `SPTDATALOADER_BENCHMARKS` is set in the test environment. The following variables tune it:
+ - `SPTDATALOADER_BENCHMARK_CALLBACKS`: data callbacks per task (default 20000)
+ - `SPTDATALOADER_BENCHMARK_CALLBACK_OUTPUT`: the path the JSON report is written to
+ */
+@interface SPTDataLoaderCallbackStressTest : XCTestCase
+
+@property (nonatomic, strong) SPTDataLoaderService *service;
+@property (nonatomic, strong) SPTDataLoaderFactory *factory;
+@property (nonatomic, strong) NSURLSessionMock *session;
+
+@end
+
+@implementation SPTDataLoaderCallbackStressTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.service = [SPTDataLoaderService dataLoaderServiceWithUserAgent:@"Spotify Test 1.0"
+                                                            rateLimiter:nil
+                                                               resolver:nil
+                                               customURLProtocolClasses:nil];
+    NSURLSessionMock *session = [NSURLSessionMock new];
+    self.session = session;
+    self.service.sessionSelector =
+    [[SPTDataLoaderServiceSessionSelectorMock alloc] initWithResolver:^NSURLSession *(SPTDataLoaderRequest *request) {
+        return session;
+    }];
+    self.factory = [self.service createDataLoaderFactoryWithAuthorisers:nil];
+}
+
+#pragma mark SPTDataLoaderCallbackStressTest
+
+- (NSArray<NSURLSessionDataTask *> *)startTaskCount:(NSUInteger)taskCount
+                            requestResponseHandlers:(NSMutableArray<SPTDataLoaderRequestResponseHandlerMock *> *)requestResponseHandlers
+{
+    id<SPTDataLoaderRequestResponseHandlerDelegate> factory = (id<SPTDataLoaderRequestResponseHandlerDelegate>)self.factory;
+    NSMutableArray<NSURLSessionDataTask *> *tasks = [NSMutableArray arrayWithCapacity:taskCount];
+    for (NSUInteger i = 0; i < taskCount; i++) {
+        SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+        SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                            sourceIdentifier:@"stress"];
+        request.chunks = YES;
+        [factory requestResponseHandler:requestResponseHandler performRequest:request];
+        [requestResponseHandlers addObject:requestResponseHandler];
+        [tasks addObject:self.session.lastDataTask];
+    }
+    return tasks;
+}
+
+- (NSTimeInterval)driveTasks:(NSArray<NSURLSessionDataTask *> *)tasks callbackCount:(NSUInteger)callbackCount
+{
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURLSession *session = self.session;
+    SPTDataLoaderService *service = self.service;
+
+    // Callbacks of a single task never overlap, callbacks of different tasks do
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    dispatch_apply(tasks.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t taskIndex) {
+        NSURLSessionDataTask *task = tasks[taskIndex];
+        for (NSUInteger i = 0; i < callbackCount; i++) {
+            [service URLSession:session dataTask:task didReceiveData:data];
+        }
+    });
+    return CFAbsoluteTimeGetCurrent() - startTime;
+}
+
+- (void)testConcurrentCallbacksReachTheirHandlers
+{
+    // Given
+    NSMutableArray<SPTDataLoaderRequestResponseHandlerMock *> *requestResponseHandlers = [NSMutableArray new];
+    NSArray<NSURLSessionDataTask *> *tasks = [self startTaskCount:32 requestResponseHandlers:requestResponseHandlers];
+
+    // When
+    [self driveTasks:tasks callbackCount:500];
+
+    // Then
+    for (SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler in requestResponseHandlers) {
+        XCTAssertEqual(requestResponseHandler.numberOfReceivedDataRequestCalls, 500u, @"Every chunk should reach the handler of its task exactly once");
+    }
+}
+
+- (void)testBenchmarkCallbackThroughputScalesWithConcurrentTasks
+{
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    if (environment[@"SPTDATALOADER_BENCHMARKS"] == nil) {
+        XCTSkip(@"Set SPTDATALOADER_BENCHMARKS to run the callback benchmark");
+    }
+
+    // Given
+    NSUInteger callbackCount = (NSUInteger)MAX([environment[@"SPTDATALOADER_BENCHMARK_CALLBACKS"] integerValue], 0);
+    if (callbackCount == 0) {
+        callbackCount = 20000;
+    }
+    NSArray<NSNumber *> *taskCounts = @[ @1, @2, @4, @8, @16, @32 ];
+
+    // When
+    NSMutableArray<NSDictionary *> *results = [NSMutableArray new];
+    for (NSNumber *taskCount in taskCounts) {
+        NSMutableArray<SPTDataLoaderRequestResponseHandlerMock *> *requestResponseHandlers = [NSMutableArray new];
+        NSArray<NSURLSessionDataTask *> *tasks = [self startTaskCount:taskCount.unsignedIntegerValue
+                                              requestResponseHandlers:requestResponseHandlers];
+
+        [SPTDataLoaderLock resetContentionProfile];
+        NSTimeInterval duration = [self driveTasks:tasks callbackCount:callbackCount];
+
+        NSMutableArray<NSDictionary *> *locks = [NSMutableArray new];
+        for (SPTDataLoaderLockContention *contention in [SPTDataLoaderLock contentionProfile]) {
+            if (contention.acquisitionCount == 0) {
+                continue;
+            }
+            [locks addObject:@{ @"name" : contention.name,
+                                @"acquisitions" : @(contention.acquisitionCount),
+                                @"contendedAcquisitions" : @(contention.contendedAcquisitionCount),
+                                @"waitTime" : @(contention.waitTime) }];
+        }
+        [results addObject:@{ @"tasks" : taskCount,
+                              @"callbacks" : @(taskCount.unsignedIntegerValue * callbackCount),
+                              @"duration" : @(duration),
+                              @"callbacksPerSecond" : @(taskCount.unsignedIntegerValue * callbackCount / duration),
+                              @"locks" : locks }];
+
+        for (NSURLSessionDataTask *task in tasks) {
+            [self.service URLSession:self.session task:task didCompleteWithError:nil];
+        }
+    }
+
+    NSDictionary *report = @{ @"date" : @([NSDate date].timeIntervalSince1970),
+                              @"processorCount" : @([NSProcessInfo processInfo].activeProcessorCount),
+                              @"results" : results };
+    NSData *reportData = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+    NSString *outputPath = environment[@"SPTDATALOADER_BENCHMARK_CALLBACK_OUTPUT"];
+    if (outputPath == nil) {
+        outputPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"sptdataloader-callback-benchmark.json"];
+    }
+    [reportData writeToFile:outputPath atomically:YES];
+    [self addAttachment:[XCTAttachment attachmentWithContentsOfFileAtURL:[NSURL fileURLWithPath:outputPath]]];
+
+    // Then
+    XCTAssertEqual(results.count, taskCounts.count);
+    if ([NSProcessInfo processInfo].activeProcessorCount > 1) {
+        double singleTaskThroughput = [results.firstObject[@"callbacksPerSecond"] doubleValue];
+        double concurrentThroughput = [results.lastObject[@"callbacksPerSecond"] doubleValue];
+        XCTAssertGreaterThan(concurrentThroughput, singleTaskThroughput, @"Callbacks of different tasks should not serialise on a lock");
+    }
+}
+
+@end
@@ -0,0 +1,121 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderChromeTraceRecorder.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+@interface SPTDataLoaderChromeTraceRecorderTest : XCTestCase
+
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) SPTDataLoaderChromeTraceRecorder *recorder;
+@property (nonatomic, strong) SPTDataLoaderRequest *request;
+
+@end
+
+@implementation SPTDataLoaderChromeTraceRecorderTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *fileName = [NSString stringWithFormat:@"%@.json", [NSUUID UUID].UUIDString];
+    self.fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    self.recorder = [SPTDataLoaderChromeTraceRecorder chromeTraceRecorderWithFileURL:self.fileURL error:nil];
+    self.request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                       sourceIdentifier:@"trace"];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.fileURL error:nil];
+    [super tearDown];
+}
+
+#pragma mark SPTDataLoaderChromeTraceRecorderTest
+
+- (nullable NSArray<NSDictionary *> *)recordedEventsWithSuffix:(NSString *)suffix
+{
+    NSMutableData *data = [NSMutableData dataWithContentsOfURL:self.fileURL];
+    [data appendData:(NSData * _Nonnull)[suffix dataUsingEncoding:NSUTF8StringEncoding]];
+    return [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+}
+
+- (void)testNotNil
+{
+    XCTAssertNotNil(self.recorder, @"The recorder should not be nil after its construction");
+}
+
+- (void)testFailsForUnwritableFile
+{
+    NSError *error = nil;
+    NSURL *fileURL = [NSURL fileURLWithPath:@"/nonexistent/directory/trace.json"];
+    SPTDataLoaderChromeTraceRecorder *recorder = [SPTDataLoaderChromeTraceRecorder chromeTraceRecorderWithFileURL:fileURL
+                                                                                                             error:&error];
+    XCTAssertNil(recorder);
+    XCTAssertNotNil(error, @"The reason the file could not be created should be returned");
+}
+
+- (void)testWritesAsyncEventsForPhases
+{
+    // Given
+    NSString * const serviceKey = @"https://spclient.wg.spotify.com/";
+
+    // When
+    [self.recorder beganPhase:SPTDataLoaderTracePhaseTask ofRequest:self.request serviceKey:serviceKey];
+    [self.recorder endedPhase:SPTDataLoaderTracePhaseTask ofRequest:self.request serviceKey:serviceKey];
+    [self.recorder close];
+
+    // Then
+    NSArray<NSDictionary *> *events = [self recordedEventsWithSuffix:@""];
+    XCTAssertEqual(events.count, 2u, @"The closed trace should be a complete JSON array");
+    NSDictionary *began = events.firstObject;
+    NSDictionary *ended = events.lastObject;
+    XCTAssertEqualObjects(began[@"ph"], @"b");
+    XCTAssertEqualObjects(ended[@"ph"], @"e");
+    XCTAssertEqualObjects(began[@"name"], @"task");
+    XCTAssertEqualObjects(began[@"cat"], @"SPTDataLoader");
+    XCTAssertEqualObjects(began[@"id"], @(self.request.uniqueIdentifier));
+    XCTAssertEqualObjects(began[@"id"], ended[@"id"], @"Both ends of a span should share the request identifier");
+    XCTAssertLessThanOrEqual([began[@"ts"] doubleValue], [ended[@"ts"] doubleValue]);
+    XCTAssertEqualObjects(began[@"args"][@"serviceKey"], serviceKey);
+    XCTAssertEqualObjects(began[@"args"][@"sourceIdentifier"], @"trace");
+    XCTAssertEqualObjects(began[@"args"][@"requestIdentifier"], @(self.request.uniqueIdentifier));
+}
+
+- (void)testFlushedTraceCanBeReadBeforeClosing
+{
+    [self.recorder beganPhase:SPTDataLoaderTracePhaseSubmission ofRequest:self.request serviceKey:@""];
+    [self.recorder flush];
+
+    NSArray<NSDictionary *> *events = [self recordedEventsWithSuffix:@"]"];
+    XCTAssertEqual(events.count, 1u, @"Flushing should write every recorded event");
+}
+
+- (void)testDropsEventsAfterClosing
+{
+    [self.recorder close];
+    [self.recorder beganPhase:SPTDataLoaderTracePhaseSubmission ofRequest:self.request serviceKey:@""];
+    [self.recorder flush];
+
+    XCTAssertEqual([self recordedEventsWithSuffix:@""].count, 0u);
+}
+
+- (void)testRecordsFromManyThreads
+{
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 100; i++) {
+            [self.recorder beganPhase:SPTDataLoaderTracePhaseChunk ofRequest:self.request serviceKey:@""];
+            [self.recorder endedPhase:SPTDataLoaderTracePhaseChunk ofRequest:self.request serviceKey:@""];
+        }
+    });
+    [self.recorder close];
+
+    XCTAssertEqual([self recordedEventsWithSuffix:@""].count, 1600u);
+}
+
+@end
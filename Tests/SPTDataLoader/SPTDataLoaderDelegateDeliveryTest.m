@@ -0,0 +1,179 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <mach/mach.h>
+
+#import <SPTDataLoader/SPTDataLoaderDelegate.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#import "SPTDataLoaderImplementation+Private.h"
+#import "SPTDataLoaderCancellationTokenFactoryMock.h"
+#import "SPTDataLoaderRequestResponseHandlerDelegateMock.h"
+#import "SPTDataLoaderResponse+Private.h"
+
+/**
+ Delivers completions to a data loader on the main queue at a steady rate, the way a busy service does
+
+ The benchmark only runs when `SPTDATALOADER_BENCHMARKS` is set in the test environment. The following variables tune it:
+ - `SPTDATALOADER_BENCHMARK_DELIVERY_RATE`: completions per second (default 1000)
+ - `SPTDATALOADER_BENCHMARK_DELIVERY_DURATION`: seconds completions are delivered for (default 2)
+ - `SPTDATALOADER_BENCHMARK_DELIVERY_OUTPUT`: the path the JSON report is written to
+ */
+@interface SPTDataLoaderDelegateDeliveryTest : XCTestCase <SPTDataLoaderDelegate>
+
+@property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerDelegateMock *requestResponseHandlerDelegate;
+@property (nonatomic, strong) SPTDataLoaderCancellationTokenFactoryMock *cancellationTokenFactory;
+@property (nonatomic, assign) NSUInteger expectedResponseCount;
+@property (nonatomic, assign) NSUInteger receivedResponseCount;
+@property (nonatomic, assign) CFAbsoluteTime lastResponseTime;
+@property (nonatomic, strong, nullable) XCTestExpectation *responsesExpectation;
+
+@end
+
+@implementation SPTDataLoaderDelegateDeliveryTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.requestResponseHandlerDelegate = [SPTDataLoaderRequestResponseHandlerDelegateMock new];
+    self.cancellationTokenFactory = [SPTDataLoaderCancellationTokenFactoryMock new];
+}
+
+#pragma mark SPTDataLoaderDelegate
+
+- (void)dataLoader:(SPTDataLoader *)dataLoader didReceiveSuccessfulResponse:(SPTDataLoaderResponse *)response
+{
+    self.receivedResponseCount++;
+    if (self.receivedResponseCount == self.expectedResponseCount) {
+        self.lastResponseTime = CFAbsoluteTimeGetCurrent();
+        [self.responsesExpectation fulfill];
+    }
+}
+
+- (void)dataLoader:(SPTDataLoader *)dataLoader didReceiveErrorResponse:(SPTDataLoaderResponse *)response
+{
+}
+
+#pragma mark SPTDataLoaderDelegateDeliveryTest
+
+static NSTimeInterval SPTDataLoaderDelegateDeliveryTestThreadCPUTime(void)
+{
+    thread_act_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    if (result != KERN_SUCCESS) {
+        return 0.0;
+    }
+    return info.user_time.seconds + info.user_time.microseconds / 1000000.0
+        + info.system_time.seconds + info.system_time.microseconds / 1000000.0;
+}
+
+- (SPTDataLoader *)dataLoaderWithRequestCount:(NSUInteger)requestCount
+                                     requests:(NSMutableArray<SPTDataLoaderRequest *> *)requests
+{
+    SPTDataLoader *dataLoader = [SPTDataLoader dataLoaderWithRequestResponseHandlerDelegate:self.requestResponseHandlerDelegate
+                                                                   cancellationTokenFactory:self.cancellationTokenFactory];
+    dataLoader.delegate = self;
+    for (NSUInteger i = 0; i < requestCount; i++) {
+        [dataLoader performRequest:[SPTDataLoaderRequest new]];
+        [requests addObject:self.requestResponseHandlerDelegate.lastRequestPerformed];
+    }
+    return dataLoader;
+}
+
+- (NSDictionary *)deliverResponsesWithDataLoader:(SPTDataLoader *)dataLoader
+                                        requests:(NSArray<SPTDataLoaderRequest *> *)requests
+                                            rate:(double)rate
+{
+    self.expectedResponseCount = requests.count;
+    self.receivedResponseCount = 0;
+    self.responsesExpectation = [self expectationWithDescription:@"Delivered responses"];
+
+    // The responses complete on a background queue at a steady rate, while the main thread waits for their delivery
+    __block CFAbsoluteTime lastCompletionTime = 0.0;
+    dispatch_semaphore_t completed = dispatch_semaphore_create(0);
+    NSTimeInterval startCPUTime = SPTDataLoaderDelegateDeliveryTestThreadCPUTime();
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSUInteger i = 0; i < requests.count; i++) {
+            NSTimeInterval delay = startTime + (double)i / rate - CFAbsoluteTimeGetCurrent();
+            if (delay > 0.0) {
+                usleep((useconds_t)(delay * 1000000.0));
+            }
+            [dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:requests[i] response:nil]];
+        }
+        lastCompletionTime = CFAbsoluteTimeGetCurrent();
+        dispatch_semaphore_signal(completed);
+    });
+    [self waitForExpectationsWithTimeout:(double)requests.count / rate + 10.0 handler:nil];
+    NSTimeInterval mainThreadCPUTime = SPTDataLoaderDelegateDeliveryTestThreadCPUTime() - startCPUTime;
+    dispatch_semaphore_wait(completed, DISPATCH_TIME_FOREVER);
+
+    return @{ @"completions" : @(requests.count),
+              @"duration" : @(self.lastResponseTime - startTime),
+              @"mainThreadCPUTime" : @(mainThreadCPUTime),
+              @"mainThreadCPUTimePerCompletion" : @(mainThreadCPUTime / (double)requests.count),
+              @"lastDeliveryLag" : @(MAX(self.lastResponseTime - lastCompletionTime, 0.0)) };
+}
+
+- (void)testBenchmarkMainThreadTimeSpentDeliveringCompletions
+{
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    if (environment[@"SPTDATALOADER_BENCHMARKS"] == nil) {
+        XCTSkip(@"Set SPTDATALOADER_BENCHMARKS to run the delegate delivery benchmark");
+    }
+
+    // Given
+    double rate = [environment[@"SPTDATALOADER_BENCHMARK_DELIVERY_RATE"] doubleValue];
+    if (rate <= 0.0) {
+        rate = 1000.0;
+    }
+    double duration = [environment[@"SPTDATALOADER_BENCHMARK_DELIVERY_DURATION"] doubleValue];
+    if (duration <= 0.0) {
+        duration = 2.0;
+    }
+    NSUInteger requestCount = (NSUInteger)MAX(rate * duration, 1.0);
+    NSArray<NSDictionary *> *variants = @[ @{ @"name" : @"immediate", @"coalesces" : @NO, @"interval" : @0.0 },
+                                           @{ @"name" : @"coalescedPerTurn", @"coalesces" : @YES, @"interval" : @0.0 },
+                                           @{ @"name" : @"coalescedEvery16ms", @"coalesces" : @YES, @"interval" : @0.016 } ];
+
+    // When
+    NSMutableArray<NSDictionary *> *results = [NSMutableArray new];
+    for (NSDictionary *variant in variants) {
+        NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray arrayWithCapacity:requestCount];
+        SPTDataLoader *dataLoader = [self dataLoaderWithRequestCount:requestCount requests:requests];
+        dataLoader.coalescesDelegateCalls = [variant[@"coalesces"] boolValue];
+        dataLoader.delegateCoalescingInterval = [variant[@"interval"] doubleValue];
+
+        NSMutableDictionary *result = [[self deliverResponsesWithDataLoader:dataLoader requests:requests rate:rate] mutableCopy];
+        result[@"name"] = variant[@"name"];
+        [results addObject:result];
+    }
+
+    NSDictionary *report = @{ @"date" : @([NSDate date].timeIntervalSince1970),
+                              @"completionsPerSecond" : @(rate),
+                              @"results" : results };
+    NSData *reportData = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+    NSString *outputPath = environment[@"SPTDATALOADER_BENCHMARK_DELIVERY_OUTPUT"];
+    if (outputPath == nil) {
+        outputPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"sptdataloader-delivery-benchmark.json"];
+    }
+    [reportData writeToFile:outputPath atomically:YES];
+    [self addAttachment:[XCTAttachment attachmentWithContentsOfFileAtURL:[NSURL fileURLWithPath:outputPath]]];
+
+    // Then
+    XCTAssertEqual(results.count, variants.count);
+    double immediateCPUTime = [results.firstObject[@"mainThreadCPUTime"] doubleValue];
+    double coalescedCPUTime = [results.lastObject[@"mainThreadCPUTime"] doubleValue];
+    XCTAssertLessThan(coalescedCPUTime, immediateCPUTime, @"Delivering completions in batches should take less of the main thread");
+}
+
+@end
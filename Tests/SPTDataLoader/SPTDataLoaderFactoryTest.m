@@ -7,13 +7,16 @@
 
 #import <SPTDataLoader/SPTDataLoaderFactory.h>
 
+#import <SPTDataLoader/SPTDataLoaderMutationQueue.h>
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 
 #import "SPTDataLoaderFactory+Private.h"
+#import "SPTDataLoaderRequest+Private.h"
 #import "SPTDataLoaderRequestResponseHandlerMock.h"
 #import "SPTDataLoaderResponse+Private.h"
 #import "SPTDataLoaderAuthoriserMock.h"
 #import "SPTDataLoaderRequestResponseHandlerDelegateMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
 
 @interface SPTDataLoaderFactory () <SPTDataLoaderRequestResponseHandlerDelegate, SPTDataLoaderAuthoriserDelegate>
 
@@ -26,6 +29,7 @@
 
 @property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerDelegateMock *delegate;
 @property (nonatomic, strong) SPTDataLoaderAuthoriserMock *authoriserMock;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
 
 @end
 
@@ -38,8 +42,10 @@
     [super setUp];
     self.delegate = [SPTDataLoaderRequestResponseHandlerDelegateMock new];
     self.authoriserMock = [SPTDataLoaderAuthoriserMock new];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
     self.factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:self.delegate
-                                                                                 authorisers:@[ self.authoriserMock ]];
+                                                                                 authorisers:@[ self.authoriserMock ]
+                                                                                timeProvider:self.timeProvider];
 }
 
 #pragma mark SPTDataLoaderFactoryTest
@@ -96,7 +102,7 @@
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
     SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
-    [self.factory receivedDataChunk:[NSData new] forResponse:response];
+    [self.factory receivedDataChunk:[NSData new] forResponse:response completionHandler:^{}];
     XCTAssertEqual(requestResponseHandler.numberOfReceivedDataRequestCalls, 1u, @"The factory did not relay a received data chunk response to the correct handler");
 }
 
@@ -113,7 +119,9 @@
 - (void)testShouldAuthoriseRequest
 {
     SPTDataLoaderAuthoriserMock *authoriser = [SPTDataLoaderAuthoriserMock new];
-    SPTDataLoaderFactory *factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:nil authorisers:@[ authoriser ]];
+    SPTDataLoaderFactory *factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:nil
+                                                                                                   authorisers:@[ authoriser ]
+                                                                                                  timeProvider:self.timeProvider];
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     BOOL shouldAuthorise = [factory shouldAuthoriseRequest:request];
     XCTAssertTrue(shouldAuthorise, @"The factory should mark the request as authorisable");
@@ -130,7 +138,9 @@
 - (void)testAuthoriseRequest
 {
     SPTDataLoaderAuthoriserMock *authoriser = [SPTDataLoaderAuthoriserMock new];
-    SPTDataLoaderFactory *factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:nil authorisers:@[ authoriser ]];
+    SPTDataLoaderFactory *factory = [SPTDataLoaderFactory dataLoaderFactoryWithRequestResponseHandlerDelegate:nil
+                                                                                                   authorisers:@[ authoriser ]
+                                                                                                  timeProvider:self.timeProvider];
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     [factory authoriseRequest:request];
     XCTAssertEqual(authoriser.numberOfCallsToAuthoriseRequest, 1u, @"The factory did not send an authorise request to the authoriser");
@@ -145,6 +155,63 @@
     XCTAssertEqual(request.cachePolicy, NSURLRequestReturnCacheDataDontLoad, @"The factory did not change the request cache policy to no load when being set to offline");
 }
 
+- (SPTDataLoaderMutationQueue *)attachMutationQueue
+{
+    NSString *fileName = [NSString stringWithFormat:@"SPTDataLoaderFactoryTest-%@.journal", [NSUUID UUID].UUIDString];
+    NSURL *journalURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:journalURL error:nil];
+    }];
+    SPTDataLoaderMutationQueue *mutationQueue = [SPTDataLoaderMutationQueue mutationQueueWithJournalURL:journalURL error:nil];
+    self.factory.mutationQueue = mutationQueue;
+    return (SPTDataLoaderMutationQueue * _Nonnull)mutationQueue;
+}
+
+- (void)testOfflineQueuesPersistentMutations
+{
+    SPTDataLoaderMutationQueue *mutationQueue = [self attachMutationQueue];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/playlist"]
+                                                        sourceIdentifier:nil];
+    request.method = SPTDataLoaderRequestMethodPost;
+    request.persistsWhenOffline = YES;
+    self.factory.offline = YES;
+
+    [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
+
+    XCTAssertEqual(self.delegate.requestsPerformed.count, 0u, @"A queued request should not reach the service");
+    XCTAssertEqual(requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    XCTAssertEqual(requestResponseHandler.lastReceivedResponse.error.code, SPTDataLoaderRequestErrorQueuedForReplay);
+    XCTAssertEqual(mutationQueue.pendingRequests.count, 1u);
+
+    self.factory.offline = NO;
+
+    XCTAssertEqual(self.delegate.requestsPerformed.count, 1u, @"Going back online should replay the queued request");
+    XCTAssertEqual(self.delegate.lastRequestPerformed.method, SPTDataLoaderRequestMethodPost);
+}
+
+- (void)testUnreachableFailureQueuesPersistentMutations
+{
+    SPTDataLoaderMutationQueue *mutationQueue = [self attachMutationQueue];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/playlist"]
+                                                        sourceIdentifier:nil];
+    request.method = SPTDataLoaderRequestMethodDelete;
+    request.persistsWhenOffline = YES;
+    [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
+
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotFindHost userInfo:nil];
+    response.error = error;
+    [self.factory failedResponse:response];
+
+    XCTAssertEqual(requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    NSError *queuedError = requestResponseHandler.lastReceivedResponse.error;
+    XCTAssertEqual(queuedError.code, SPTDataLoaderRequestErrorQueuedForReplay);
+    XCTAssertEqualObjects(queuedError.userInfo[NSUnderlyingErrorKey], error);
+    XCTAssertEqual(mutationQueue.pendingRequests.count, 1u);
+}
+
 - (void)testRelayToDelegateWhenPerformingRequest
 {
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
@@ -186,19 +253,44 @@
 
 - (void)testRequestTimeout
 {
-    self.factory.requestTimeoutQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
-    __weak XCTestExpectation *expectation = [self expectationWithDescription:@"Test timeout executes in time given"];
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
-    requestResponseHandler.failedResponseBlock = ^ {
-        [expectation fulfill];
-    };
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     request.timeout = 0.1;
     [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
-    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    [self.timeProvider advanceTimeBy:0.05];
+    XCTAssertEqual(requestResponseHandler.numberOfFailedResponseCalls, 0u, @"The request should not time out before its timeout");
+    [self.timeProvider advanceTimeBy:0.05];
     XCTAssertEqual(requestResponseHandler.numberOfFailedResponseCalls, 1u, @"The request should have been cancelled");
 }
 
+- (void)testRequestTimeoutCancelsTheRequestInFlight
+{
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
+    request.timeout = 0.1;
+    self.timeProvider.currentTime = 100.0;
+
+    [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
+    [self.timeProvider advanceTimeBy:0.1];
+
+    XCTAssertEqualWithAccuracy(request.deadline, 100.1, 0.000001, @"The deadline should be taken from the timeout");
+    XCTAssertEqualObjects(self.delegate.lastRequestCancelled, request, @"Whatever is left of the request should be torn down at the deadline");
+}
+
+- (void)testRequestTimeoutDoesNotCancelCompletedRequest
+{
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
+    request.timeout = 0.1;
+
+    [self.factory requestResponseHandler:requestResponseHandler performRequest:request];
+    [self.factory successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil]];
+    [self.timeProvider advanceTimeBy:0.1];
+
+    XCTAssertNil(self.delegate.lastRequestCancelled);
+    XCTAssertEqual(requestResponseHandler.numberOfFailedResponseCalls, 0u);
+}
+
 - (void)testForwardCancelToRequestResponseHandlerDelegate
 {
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
@@ -0,0 +1,134 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SPTDataLoaderHistogram+Private.h"
+
+@interface SPTDataLoaderHistogramTest : XCTestCase
+
+@property (nonatomic, strong) SPTDataLoaderHistogramRecorder *recorder;
+
+@end
+
+@implementation SPTDataLoaderHistogramTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.recorder = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:1.0];
+}
+
+#pragma mark SPTDataLoaderHistogramTest
+
+- (void)testEmptySnapshot
+{
+    SPTDataLoaderHistogram *histogram = [self.recorder snapshotResetting:NO];
+
+    XCTAssertEqual(histogram.count, 0u);
+    XCTAssertEqualWithAccuracy(histogram.minimum, 0.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.maximum, 0.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.mean, 0.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy([histogram valueAtPercentile:50.0], 0.0, DBL_EPSILON);
+}
+
+- (void)testSummaryStatistics
+{
+    // Given
+    for (NSUInteger value = 1; value <= 100; value++) {
+        [self.recorder recordValue:(double)value];
+    }
+
+    // When
+    SPTDataLoaderHistogram *histogram = [self.recorder snapshotResetting:NO];
+
+    // Then
+    XCTAssertEqual(histogram.count, 100u);
+    XCTAssertEqualWithAccuracy(histogram.minimum, 1.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.maximum, 100.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.sum, 5050.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.mean, 50.5, DBL_EPSILON);
+}
+
+- (void)testPercentilesStayWithinBucketPrecision
+{
+    // Given
+    for (NSUInteger value = 1; value <= 10000; value++) {
+        [self.recorder recordValue:(double)value];
+    }
+
+    // When
+    SPTDataLoaderHistogram *histogram = [self.recorder snapshotResetting:NO];
+
+    // Then
+    for (NSNumber *percentile in @[ @50.0, @90.0, @99.0, @99.9 ]) {
+        double expectedValue = percentile.doubleValue * 100.0;
+        XCTAssertEqualWithAccuracy([histogram valueAtPercentile:percentile.doubleValue], expectedValue, expectedValue / 16.0,
+                                   @"The percentile %@ should be within a sub-bucket of the true value", percentile);
+    }
+    XCTAssertEqualWithAccuracy([histogram valueAtPercentile:0.0], 1.0, DBL_EPSILON, @"The lowest percentile should be the minimum");
+    XCTAssertEqualWithAccuracy([histogram valueAtPercentile:100.0], 10000.0, DBL_EPSILON, @"The highest percentile should be the maximum");
+}
+
+- (void)testScaleKeepsFractions
+{
+    SPTDataLoaderHistogramRecorder *recorder = [SPTDataLoaderHistogramRecorder histogramRecorderWithScale:1000000.0];
+
+    [recorder recordValue:0.000250];
+    [recorder recordValue:1.5];
+
+    SPTDataLoaderHistogram *histogram = [recorder snapshotResetting:NO];
+    XCTAssertEqualWithAccuracy(histogram.minimum, 0.000250, 0.000001);
+    XCTAssertEqualWithAccuracy(histogram.maximum, 1.5, 0.000001);
+}
+
+- (void)testNegativeValuesCountAsZero
+{
+    [self.recorder recordValue:-5.0];
+
+    SPTDataLoaderHistogram *histogram = [self.recorder snapshotResetting:NO];
+    XCTAssertEqual(histogram.count, 1u);
+    XCTAssertEqualWithAccuracy(histogram.minimum, 0.0, DBL_EPSILON);
+}
+
+- (void)testSnapshotResetting
+{
+    // Given
+    [self.recorder recordValue:10.0];
+    [self.recorder recordValue:20.0];
+
+    // When
+    SPTDataLoaderHistogram *firstHistogram = [self.recorder snapshotResetting:YES];
+    [self.recorder recordValue:30.0];
+    SPTDataLoaderHistogram *secondHistogram = [self.recorder snapshotResetting:NO];
+
+    // Then
+    XCTAssertEqual(firstHistogram.count, 2u);
+    XCTAssertEqual(secondHistogram.count, 1u, @"Values recorded before the reset should not be counted again");
+    XCTAssertEqualWithAccuracy(secondHistogram.minimum, 30.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(secondHistogram.maximum, 30.0, DBL_EPSILON);
+}
+
+- (void)testConcurrentRecordingLosesNoValues
+{
+    // When
+    SPTDataLoaderHistogramRecorder *recorder = self.recorder;
+    dispatch_apply(16, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [recorder recordValue:(double)(iteration + 1)];
+        }
+    });
+
+    // Then
+    SPTDataLoaderHistogram *histogram = [recorder snapshotResetting:NO];
+    XCTAssertEqual(histogram.count, 16000u, @"No value should have been lost to a race");
+    XCTAssertEqualWithAccuracy(histogram.minimum, 1.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.maximum, 16.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(histogram.sum, 136000.0, DBL_EPSILON);
+}
+
+@end
@@ -0,0 +1,142 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SPTDataLoaderLock.h"
+
+@interface SPTDataLoaderLockTest : XCTestCase
+
+@end
+
+@implementation SPTDataLoaderLockTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    [SPTDataLoaderLock resetContentionProfile];
+}
+
+#pragma mark SPTDataLoaderLockTest
+
+- (nullable SPTDataLoaderLockContention *)contentionForName:(NSString *)name
+{
+    for (SPTDataLoaderLockContention *contention in [SPTDataLoaderLock contentionProfile]) {
+        if ([contention.name isEqualToString:name]) {
+            return contention;
+        }
+    }
+    return nil;
+}
+
+- (void)testLockIsMutuallyExclusive
+{
+    // Given
+    SPTDataLoaderLock *lock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderLockTest.exclusive"];
+    __block NSUInteger counter = 0;
+
+    // When
+    dispatch_apply(64, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [lock lock];
+            counter++;
+            [lock unlock];
+        }
+    });
+
+    // Then
+    XCTAssertEqual(counter, 64000u, @"No increment should have been lost to a race");
+}
+
+- (void)testPerformBlockHoldsTheLock
+{
+    SPTDataLoaderLock *lock = [SPTDataLoaderLock lockWithName:@"SPTDataLoaderLockTest.performBlock"];
+    NSMutableArray<NSNumber *> *values = [NSMutableArray new];
+
+    dispatch_apply(16, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 100; i++) {
+            [lock performBlock:^{
+                [values addObject:@(iteration)];
+            }];
+        }
+    });
+
+    XCTAssertEqual(values.count, 1600u);
+}
+
+- (void)testContentionProfileCountsAcquisitions
+{
+#if DEBUG
+    // Given
+    NSString * const name = @"SPTDataLoaderLockTest.acquisitions";
+    SPTDataLoaderLock *firstLock = [SPTDataLoaderLock lockWithName:name];
+    SPTDataLoaderLock *secondLock = [SPTDataLoaderLock lockWithName:name];
+
+    // When
+    for (NSUInteger i = 0; i < 3; i++) {
+        [firstLock lock];
+        [firstLock unlock];
+    }
+    [secondLock lock];
+    [secondLock unlock];
+
+    // Then
+    SPTDataLoaderLockContention *contention = [self contentionForName:name];
+    XCTAssertNotNil(contention);
+    XCTAssertEqual(contention.acquisitionCount, 4u, @"Locks sharing a name should be reported together");
+    XCTAssertEqual(contention.contendedAcquisitionCount, 0u, @"A single thread should never wait for the lock");
+    XCTAssertEqualWithAccuracy(contention.waitTime, 0.0, DBL_EPSILON);
+#endif
+}
+
+- (void)testContentionProfileMeasuresWaitTime
+{
+#if DEBUG
+    // Given
+    NSString * const name = @"SPTDataLoaderLockTest.wait";
+    SPTDataLoaderLock *lock = [SPTDataLoaderLock lockWithName:name];
+    dispatch_semaphore_t locked = dispatch_semaphore_create(0);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"The lock is released"];
+
+    // When
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [lock lock];
+        dispatch_semaphore_signal(locked);
+        [NSThread sleepForTimeInterval:0.05];
+        [lock unlock];
+        [expectation fulfill];
+    });
+    dispatch_semaphore_wait(locked, DISPATCH_TIME_FOREVER);
+    [lock lock];
+    [lock unlock];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // Then
+    SPTDataLoaderLockContention *contention = [self contentionForName:name];
+    XCTAssertEqual(contention.acquisitionCount, 2u);
+    XCTAssertEqual(contention.contendedAcquisitionCount, 1u, @"The second acquisition should have waited for the first");
+    XCTAssertGreaterThan(contention.waitTime, 0.01, @"The wait should cover most of the time the lock was held");
+#endif
+}
+
+- (void)testResetContentionProfile
+{
+#if DEBUG
+    NSString * const name = @"SPTDataLoaderLockTest.reset";
+    SPTDataLoaderLock *lock = [SPTDataLoaderLock lockWithName:name];
+    [lock lock];
+    [lock unlock];
+
+    [SPTDataLoaderLock resetContentionProfile];
+
+    XCTAssertEqual([self contentionForName:name].acquisitionCount, 0u);
+#else
+    XCTAssertEqual([SPTDataLoaderLock contentionProfile].count, 0u, @"Contention should only be collected in DEBUG builds");
+#endif
+}
+
+@end
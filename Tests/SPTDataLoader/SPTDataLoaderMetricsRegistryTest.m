@@ -0,0 +1,146 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderHistogram.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderMetricsRegistry+Private.h"
+
+@interface SPTDataLoaderMetricsRegistryTest : XCTestCase
+
+@property (nonatomic, strong) SPTDataLoaderMetricsRegistry *registry;
+
+@end
+
+@implementation SPTDataLoaderMetricsRegistryTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.registry = [SPTDataLoaderMetricsRegistry new];
+}
+
+#pragma mark SPTDataLoaderMetricsRegistryTest
+
+- (void)recordRequestWithURLString:(NSString *)URLString
+                  sourceIdentifier:(nullable NSString *)sourceIdentifier
+                        statusCode:(NSInteger)statusCode
+                       errorDomain:(nullable NSString *)errorDomain
+{
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:URLString]
+                                                        sourceIdentifier:sourceIdentifier];
+    SPTDataLoaderMetricsSample sample;
+    sample.latency = 0.2;
+    sample.timeToFirstByte = 0.1;
+    sample.queueWait = 0.05;
+    sample.bodySize = 1024;
+    sample.retryCount = 1;
+    sample.statusCode = statusCode;
+    for (SPTDataLoaderMetricsRecorder *recorder in [self.registry metricsRecordersForRequest:request]) {
+        [recorder recordSample:sample errorDomain:errorDomain];
+    }
+}
+
+- (nullable SPTDataLoaderMetrics *)metricsIn:(NSArray<SPTDataLoaderMetrics *> *)metrics
+                               withDimension:(SPTDataLoaderMetricsDimension)dimension
+                                         key:(NSString *)key
+{
+    for (SPTDataLoaderMetrics *keyMetrics in metrics) {
+        if (keyMetrics.dimension == dimension && [keyMetrics.key isEqualToString:key]) {
+            return keyMetrics;
+        }
+    }
+    return nil;
+}
+
+- (void)testEmptyRegistryHasNoMetrics
+{
+    XCTAssertEqual(self.registry.metrics.count, 0u);
+}
+
+- (void)testRequestsAreCountedPerServiceKeyAndSourceIdentifier
+{
+    // Given
+    [self recordRequestWithURLString:@"https://spclient.wg.spotify.com/thing/1" sourceIdentifier:@"search" statusCode:200 errorDomain:nil];
+    [self recordRequestWithURLString:@"https://spclient.wg.spotify.com/thing/2" sourceIdentifier:@"search" statusCode:200 errorDomain:nil];
+    [self recordRequestWithURLString:@"https://api.spotify.com/other" sourceIdentifier:nil statusCode:200 errorDomain:nil];
+
+    // When
+    NSArray<SPTDataLoaderMetrics *> *metrics = self.registry.metrics;
+
+    // Then
+    XCTAssertEqual(metrics.count, 3u);
+    SPTDataLoaderMetrics *thingMetrics = [self metricsIn:metrics
+                                           withDimension:SPTDataLoaderMetricsDimensionServiceKey
+                                                     key:@"https://spclient.wg.spotify.com/"];
+    XCTAssertEqual(thingMetrics.latency.count, 2u);
+    XCTAssertEqualWithAccuracy(thingMetrics.latency.maximum, 0.2, 0.000001);
+    XCTAssertEqualWithAccuracy(thingMetrics.timeToFirstByte.maximum, 0.1, 0.000001);
+    XCTAssertEqualWithAccuracy(thingMetrics.queueWait.maximum, 0.05, 0.000001);
+    XCTAssertEqualWithAccuracy(thingMetrics.bodySize.maximum, 1024.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(thingMetrics.retryCount.maximum, 1.0, DBL_EPSILON);
+    SPTDataLoaderMetrics *searchMetrics = [self metricsIn:metrics
+                                            withDimension:SPTDataLoaderMetricsDimensionSourceIdentifier
+                                                      key:@"search"];
+    XCTAssertEqual(searchMetrics.latency.count, 2u, @"Requests should be counted under their sourceIdentifier as well");
+}
+
+- (void)testStatusClassesAndErrorDomainsAreCounted
+{
+    // Given
+    NSString *serviceKey = @"https://spclient.wg.spotify.com/thing";
+    [self recordRequestWithURLString:serviceKey sourceIdentifier:nil statusCode:200 errorDomain:nil];
+    [self recordRequestWithURLString:serviceKey sourceIdentifier:nil statusCode:404 errorDomain:SPTDataLoaderResponseErrorDomain];
+    [self recordRequestWithURLString:serviceKey sourceIdentifier:nil statusCode:503 errorDomain:SPTDataLoaderResponseErrorDomain];
+    [self recordRequestWithURLString:serviceKey sourceIdentifier:nil statusCode:0 errorDomain:NSURLErrorDomain];
+    [self recordRequestWithURLString:serviceKey sourceIdentifier:nil statusCode:0 errorDomain:@"com.example.custom"];
+
+    // When
+    SPTDataLoaderMetrics *metrics = self.registry.metrics.firstObject;
+
+    // Then
+    NSDictionary<NSString *, NSNumber *> *expectedStatusClassCounts = @{ @"2xx" : @1, @"4xx" : @1, @"5xx" : @1, @"none" : @2 };
+    XCTAssertEqualObjects(metrics.statusClassCounts, expectedStatusClassCounts);
+    NSDictionary<NSString *, NSNumber *> *expectedErrorDomainCounts = @{ SPTDataLoaderResponseErrorDomain : @2,
+                                                                         NSURLErrorDomain : @1,
+                                                                         @"com.example.custom" : @1 };
+    XCTAssertEqualObjects(metrics.errorDomainCounts, expectedErrorDomainCounts);
+}
+
+- (void)testMetricsAndResetCountsEveryRequestOnce
+{
+    // Given
+    NSString *URLString = @"https://spclient.wg.spotify.com/thing";
+    [self recordRequestWithURLString:URLString sourceIdentifier:nil statusCode:200 errorDomain:nil];
+
+    // When
+    NSArray<SPTDataLoaderMetrics *> *firstMetrics = [self.registry metricsAndReset];
+    NSArray<SPTDataLoaderMetrics *> *emptyMetrics = self.registry.metrics;
+    [self recordRequestWithURLString:URLString sourceIdentifier:nil statusCode:500 errorDomain:SPTDataLoaderResponseErrorDomain];
+    NSArray<SPTDataLoaderMetrics *> *secondMetrics = [self.registry metricsAndReset];
+
+    // Then
+    XCTAssertEqual(firstMetrics.firstObject.latency.count, 1u);
+    XCTAssertEqual(emptyMetrics.count, 0u, @"Keys without requests since the reset should not be reported");
+    XCTAssertEqual(secondMetrics.firstObject.latency.count, 1u);
+    XCTAssertEqualObjects(secondMetrics.firstObject.statusClassCounts, @{ @"5xx" : @1 });
+    XCTAssertEqualObjects(secondMetrics.firstObject.errorDomainCounts, @{ SPTDataLoaderResponseErrorDomain : @1 });
+}
+
+- (void)testReset
+{
+    [self recordRequestWithURLString:@"https://spclient.wg.spotify.com/thing" sourceIdentifier:@"search" statusCode:200 errorDomain:nil];
+
+    [self.registry reset];
+
+    XCTAssertEqual(self.registry.metrics.count, 0u);
+}
+
+@end
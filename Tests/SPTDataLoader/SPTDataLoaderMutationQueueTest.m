@@ -0,0 +1,274 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderMutationQueue.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderMutationQueue+Private.h"
+#import "SPTDataLoaderResponse+Private.h"
+#import "SPTDataLoaderRequestResponseHandlerDelegateMock.h"
+
+@interface SPTDataLoaderMutationQueueTest : XCTestCase <SPTDataLoaderMutationQueueDelegate>
+
+@property (nonatomic, strong) NSURL *journalURL;
+@property (nonatomic, strong) SPTDataLoaderMutationQueue *mutationQueue;
+@property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerDelegateMock *requestResponseHandlerDelegate;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderResponse *> *replayedResponses;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderRequest *> *discardedRequests;
+
+@end
+
+@implementation SPTDataLoaderMutationQueueTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *fileName = [NSString stringWithFormat:@"SPTDataLoaderMutationQueueTest-%@.journal", [NSUUID UUID].UUIDString];
+    self.journalURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    self.requestResponseHandlerDelegate = [SPTDataLoaderRequestResponseHandlerDelegateMock new];
+    self.replayedResponses = [NSMutableArray new];
+    self.discardedRequests = [NSMutableArray new];
+    self.mutationQueue = [self openMutationQueue];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.journalURL error:nil];
+    [super tearDown];
+}
+
+#pragma mark SPTDataLoaderMutationQueueTest
+
+- (SPTDataLoaderMutationQueue *)openMutationQueue
+{
+    NSError *error = nil;
+    SPTDataLoaderMutationQueue *mutationQueue = [SPTDataLoaderMutationQueue mutationQueueWithJournalURL:self.journalURL
+                                                                                                  error:&error];
+    XCTAssertNotNil(mutationQueue, @"The journal could not be opened: %@", error);
+    mutationQueue.delegate = self;
+    return (SPTDataLoaderMutationQueue * _Nonnull)mutationQueue;
+}
+
+- (SPTDataLoaderRequest *)requestWithPath:(NSString *)path method:(SPTDataLoaderRequestMethod)method
+{
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:[@"https://spclient.wg.spotify.com" stringByAppendingString:path]];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"playlist"];
+    request.method = method;
+    return request;
+}
+
+- (SPTDataLoaderResponse *)responseForRequest:(SPTDataLoaderRequest *)request statusCode:(NSInteger)statusCode
+{
+    NSHTTPURLResponse *URLResponse = [[NSHTTPURLResponse alloc] initWithURL:request.URL
+                                                                 statusCode:statusCode
+                                                                HTTPVersion:@"HTTP/1.1"
+                                                               headerFields:nil];
+    return [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:URLResponse];
+}
+
+- (void)enqueueRequest:(SPTDataLoaderRequest *)request
+{
+    NSError *error = nil;
+    XCTAssertTrue([self.mutationQueue enqueueRequest:request error:&error], @"The request was not queued: %@", error);
+}
+
+- (void)drainDelegateQueue
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Delegate queue drained"];
+    dispatch_async(self.mutationQueue.delegateQueue, ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+- (void)testOnlyMutationsCanBeQueued
+{
+    XCTAssertTrue([self.mutationQueue canEnqueueRequest:[self requestWithPath:@"/a" method:SPTDataLoaderRequestMethodPost]]);
+    XCTAssertTrue([self.mutationQueue canEnqueueRequest:[self requestWithPath:@"/a" method:SPTDataLoaderRequestMethodDelete]]);
+    XCTAssertFalse([self.mutationQueue canEnqueueRequest:[self requestWithPath:@"/a" method:SPTDataLoaderRequestMethodGet]]);
+
+    SPTDataLoaderRequest *request = [self requestWithPath:@"/a" method:SPTDataLoaderRequestMethodPut];
+    request.bodyStream = [NSInputStream inputStreamWithData:[NSData data]];
+    XCTAssertFalse([self.mutationQueue canEnqueueRequest:request], @"A body stream cannot be written to the journal");
+    XCTAssertFalse([self.mutationQueue enqueueRequest:request error:nil]);
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 0u);
+}
+
+- (void)testJournalSurvivesReopening
+{
+    SPTDataLoaderRequest *request = [self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPost];
+    request.body = [@"{\"name\":\"Road trip\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    [request addValue:@"application/json" forHeader:@"Content-Type"];
+    request.maximumRetryCount = 3;
+    request.userInfo = @{ @"origin" : @"editor" };
+    [self enqueueRequest:request];
+    [self enqueueRequest:[self requestWithPath:@"/playlist/2" method:SPTDataLoaderRequestMethodDelete]];
+
+    self.mutationQueue = [self openMutationQueue];
+
+    NSArray<SPTDataLoaderRequest *> *pendingRequests = self.mutationQueue.pendingRequests;
+    XCTAssertEqual(pendingRequests.count, 2u);
+    SPTDataLoaderRequest *reopenedRequest = pendingRequests.firstObject;
+    XCTAssertEqualObjects(reopenedRequest.URL, request.URL);
+    XCTAssertEqual(reopenedRequest.method, SPTDataLoaderRequestMethodPost);
+    XCTAssertEqualObjects(reopenedRequest.body, request.body);
+    XCTAssertEqualObjects(reopenedRequest.headers[@"Content-Type"], @"application/json");
+    XCTAssertEqualObjects(reopenedRequest.sourceIdentifier, @"playlist");
+    XCTAssertEqual(reopenedRequest.maximumRetryCount, 3u);
+    XCTAssertEqualObjects(reopenedRequest.userInfo, request.userInfo);
+    XCTAssertEqual(pendingRequests.lastObject.method, SPTDataLoaderRequestMethodDelete, @"The order of the requests should survive");
+}
+
+- (void)testTornRecordIsIgnored
+{
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPost]];
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:self.journalURL error:nil];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:(NSData * _Nonnull)[@"{\"type\":\"append\",\"id\":\"" dataUsingEncoding:NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+
+    self.mutationQueue = [self openMutationQueue];
+
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 1u, @"A record torn by a crash should not be read back");
+}
+
+- (void)testReplaysInOrderOneAtATime
+{
+    [self enqueueRequest:[self requestWithPath:@"/1" method:SPTDataLoaderRequestMethodPost]];
+    [self enqueueRequest:[self requestWithPath:@"/2" method:SPTDataLoaderRequestMethodPost]];
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+
+    [self.mutationQueue replay];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u, @"Only one request should be replayed at a time by default");
+    SPTDataLoaderRequest *firstRequest = self.requestResponseHandlerDelegate.requestsPerformed.firstObject;
+    XCTAssertEqualObjects(firstRequest.URL.path, @"/1");
+
+    [self.mutationQueue successfulResponse:[self responseForRequest:firstRequest statusCode:SPTDataLoaderResponseHTTPStatusCodeOK]];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 2u);
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsPerformed.lastObject.URL.path, @"/2");
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 1u, @"The completed request should have left the journal");
+    [self drainDelegateQueue];
+    XCTAssertEqual(self.replayedResponses.count, 1u);
+}
+
+- (void)testConcurrentReplays
+{
+    for (NSUInteger i = 0; i < 5; ++i) {
+        [self enqueueRequest:[self requestWithPath:[NSString stringWithFormat:@"/%lu", (unsigned long)i]
+                                            method:SPTDataLoaderRequestMethodPut]];
+    }
+    self.mutationQueue.maximumConcurrentReplays = 3;
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+
+    [self.mutationQueue replay];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 3u);
+}
+
+- (void)testSuspendedQueueDoesNotReplay
+{
+    [self enqueueRequest:[self requestWithPath:@"/1" method:SPTDataLoaderRequestMethodPost]];
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    self.mutationQueue.suspended = YES;
+
+    [self.mutationQueue replay];
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 0u);
+
+    self.mutationQueue.suspended = NO;
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u, @"Resuming the queue should replay it");
+}
+
+- (void)testConnectivityFailurePausesReplay
+{
+    [self enqueueRequest:[self requestWithPath:@"/1" method:SPTDataLoaderRequestMethodPost]];
+    [self enqueueRequest:[self requestWithPath:@"/2" method:SPTDataLoaderRequestMethodPost]];
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    [self.mutationQueue replay];
+
+    SPTDataLoaderRequest *request = self.requestResponseHandlerDelegate.requestsPerformed.firstObject;
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+    response.error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNotConnectedToInternet userInfo:nil];
+    [self.mutationQueue failedResponse:response];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u, @"Replay should pause while the network is unreachable");
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 2u, @"The failed request should stay in the journal");
+
+    [self.mutationQueue replay];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 2u);
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsPerformed.lastObject.URL.path, @"/1", @"The failed request should be replayed first");
+}
+
+- (void)testServerErrorCompletesReplay
+{
+    [self enqueueRequest:[self requestWithPath:@"/1" method:SPTDataLoaderRequestMethodPost]];
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    [self.mutationQueue replay];
+
+    SPTDataLoaderRequest *request = self.requestResponseHandlerDelegate.requestsPerformed.firstObject;
+    [self.mutationQueue failedResponse:[self responseForRequest:request statusCode:SPTDataLoaderResponseHTTPStatusCodeBadRequest]];
+
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 0u);
+    [self drainDelegateQueue];
+    XCTAssertEqual(self.replayedResponses.firstObject.statusCode, SPTDataLoaderResponseHTTPStatusCodeBadRequest, @"The server's answer should reach the delegate");
+
+    self.mutationQueue = [self openMutationQueue];
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 0u, @"The completed request should not come back after a relaunch");
+}
+
+- (void)testCollapsesSupersededWrites
+{
+    self.mutationQueue.collapsesSupersededWrites = YES;
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPut]];
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPatch]];
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1/tracks" method:SPTDataLoaderRequestMethodPost]];
+    [self enqueueRequest:[self requestWithPath:@"/playlist/2" method:SPTDataLoaderRequestMethodPut]];
+
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodDelete]];
+
+    NSArray<SPTDataLoaderRequest *> *pendingRequests = self.mutationQueue.pendingRequests;
+    XCTAssertEqual(pendingRequests.count, 3u);
+    XCTAssertEqualObjects(pendingRequests[0].URL.path, @"/playlist/1/tracks");
+    XCTAssertEqualObjects(pendingRequests[1].URL.path, @"/playlist/2");
+    XCTAssertEqual(pendingRequests[2].method, SPTDataLoaderRequestMethodDelete);
+    [self drainDelegateQueue];
+    XCTAssertEqual(self.discardedRequests.count, 2u);
+}
+
+- (void)testDoesNotCollapseReplayingWrites
+{
+    self.mutationQueue.collapsesSupersededWrites = YES;
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPut]];
+    self.mutationQueue.requestResponseHandlerDelegate = self.requestResponseHandlerDelegate;
+    [self.mutationQueue replay];
+
+    [self enqueueRequest:[self requestWithPath:@"/playlist/1" method:SPTDataLoaderRequestMethodPut]];
+
+    XCTAssertEqual(self.mutationQueue.pendingRequests.count, 2u, @"A write that is on its way to the server cannot be dropped");
+}
+
+#pragma mark SPTDataLoaderMutationQueueDelegate
+
+- (void)mutationQueue:(SPTDataLoaderMutationQueue *)mutationQueue
+     didReplayRequest:(SPTDataLoaderRequest *)request
+             response:(SPTDataLoaderResponse *)response
+{
+    [self.replayedResponses addObject:response];
+}
+
+- (void)mutationQueue:(SPTDataLoaderMutationQueue *)mutationQueue
+didDiscardSupersededRequest:(SPTDataLoaderRequest *)request
+{
+    [self.discardedRequests addObject:request];
+}
+
+@end
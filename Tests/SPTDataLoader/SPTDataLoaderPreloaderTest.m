@@ -0,0 +1,299 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderPreloadPolicy.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+
+#import "SPTDataLoaderPreloader.h"
+#import "NSURLSessionDataTaskMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+@interface SPTDataLoaderPreloaderTest : XCTestCase <SPTDataLoaderPreloaderDelegate>
+
+@property (nonatomic, strong) SPTDataLoaderPreloader *preloader;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
+@property (nonatomic, strong) SPTDataLoaderRequest *request;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderRequest *> *preloadRequests;
+@property (nonatomic, strong) NSMutableArray<NSURLSessionDataTaskMock *> *preloadTasks;
+@property (nonatomic, strong) NSMutableArray<NSData *> *preloadedData;
+@property (nonatomic, assign) BOOL refusesTasks;
+
+@end
+
+@implementation SPTDataLoaderPreloaderTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.preloader = [SPTDataLoaderPreloader preloaderWithTimeProvider:self.timeProvider delegate:self];
+    self.preloader.policy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    self.request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"]
+                                       sourceIdentifier:@"-"];
+    self.preloadRequests = [NSMutableArray new];
+    self.preloadTasks = [NSMutableArray new];
+    self.preloadedData = [NSMutableArray new];
+}
+
+#pragma mark SPTDataLoaderPreloaderDelegate
+
+- (nullable NSURLSessionTask *)preloader:(SPTDataLoaderPreloader *)preloader taskForRequest:(SPTDataLoaderRequest *)request
+{
+    if (self.refusesTasks) {
+        return nil;
+    }
+    NSURLSessionDataTaskMock *task = [NSURLSessionDataTaskMock new];
+    [self.preloadRequests addObject:request];
+    [self.preloadTasks addObject:task];
+    return task;
+}
+
+- (void)preloader:(SPTDataLoaderPreloader *)preloader
+didPreloadResponse:(NSHTTPURLResponse *)response
+             data:(NSData *)data
+       forRequest:(SPTDataLoaderRequest *)request
+             task:(NSURLSessionTask *)task
+{
+    [self.preloadedData addObject:data];
+}
+
+#pragma mark SPTDataLoaderPreloaderTest
+
+- (NSHTTPURLResponse *)responseWithLinkHeader:(NSString *)linkHeader
+{
+    return [self responseWithURL:self.request.URL statusCode:200 headers:@{ @"Link": linkHeader }];
+}
+
+- (NSHTTPURLResponse *)responseWithURL:(NSURL *)URL
+                            statusCode:(NSInteger)statusCode
+                               headers:(NSDictionary<NSString *, NSString *> *)headers
+{
+    return (NSHTTPURLResponse * _Nonnull)[[NSHTTPURLResponse alloc] initWithURL:URL
+                                                                     statusCode:statusCode
+                                                                    HTTPVersion:@"1.1"
+                                                                   headerFields:headers];
+}
+
+- (void)finishPreloadTask:(NSURLSessionTask *)task body:(NSData *)body
+{
+    NSHTTPURLResponse *response = [self responseWithURL:self.request.URL statusCode:200 headers:@{}];
+    XCTAssertEqual([self.preloader receiveResponse:response forTask:task], NSURLSessionResponseAllow);
+    [self.preloader receiveData:body forTask:task];
+    [self.preloader completeTask:task error:nil];
+}
+
+- (void)testParsesPreloadLinks
+{
+    NSHTTPURLResponse *response = [self responseWithLinkHeader:@"</style.css>; rel=preload; as=style, "
+                                   @"<https://spclient.wg.spotify.com/a,b.json>; rel=\"prefetch preload\", "
+                                   @"</next>; rel=next, "
+                                   @"</style.css>; rel=preload"];
+
+    NSArray<NSURL *> *URLs = [SPTDataLoaderPreloader preloadURLsInResponse:response];
+
+    NSArray<NSURL *> *expectedURLs = @[ (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/style.css"],
+                                        (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/a,b.json"] ];
+    XCTAssertEqualObjects(URLs, expectedURLs);
+}
+
+- (void)testIgnoresResponsesWithoutPreloadLinks
+{
+    XCTAssertEqualObjects([SPTDataLoaderPreloader preloadURLsInResponse:[self responseWithURL:self.request.URL statusCode:200 headers:@{}]], @[]);
+    XCTAssertEqualObjects([SPTDataLoaderPreloader preloadURLsInResponse:[self responseWithLinkHeader:@"<mailto:a@spotify.com>; rel=preload"]], @[]);
+    XCTAssertEqualObjects([SPTDataLoaderPreloader preloadURLsInResponse:[self responseWithLinkHeader:@"/style.css; rel=preload"]], @[]);
+}
+
+- (void)testPreloadsSameHostResourcesWithTheHeadersAndTagsOfTheRequest
+{
+    // Given
+    [self.request addValue:@"Bearer token" forHeader:@"Authorization"];
+    NSHTTPURLResponse *response = [self responseWithLinkHeader:@"</style.css>; rel=preload, <https://cdn.spotify.com/image.jpg>; rel=preload"];
+
+    // When
+    [self.preloader preloadResourcesOfResponse:response request:self.request tags:[NSSet setWithObject:@"page"]];
+
+    // Then
+    XCTAssertEqual(self.preloadRequests.count, 1u, @"Only resources of the same host should be preloaded by default");
+    SPTDataLoaderRequest *preloadRequest = self.preloadRequests.firstObject;
+    XCTAssertEqualObjects(preloadRequest.URL.absoluteString, @"https://spclient.wg.spotify.com/style.css");
+    XCTAssertEqualObjects(preloadRequest.headers[@"Authorization"], @"Bearer token");
+    XCTAssertEqualObjects(preloadRequest.tags, [NSSet setWithObject:@"page"]);
+    XCTAssertEqual(preloadRequest.priority, NSURLSessionTaskPriorityLow);
+    XCTAssertEqual(self.preloadTasks.firstObject.numberOfCallsToResume, 1u);
+}
+
+- (void)testPreloadsAllowedHostsWithoutTheHeadersOfTheRequest
+{
+    // Given
+    SPTDataLoaderPreloadPolicy *policy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    policy.allowedHosts = [NSSet setWithObject:@"cdn.spotify.com"];
+    self.preloader.policy = policy;
+    [self.request addValue:@"Bearer token" forHeader:@"Authorization"];
+
+    // When
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"<https://CDN.spotify.com/image.jpg>; rel=preload"]
+                                       request:self.request
+                                          tags:nil];
+
+    // Then
+    XCTAssertEqual(self.preloadRequests.count, 1u);
+    XCTAssertNil(self.preloadRequests.firstObject.headers[@"Authorization"]);
+}
+
+- (void)testDoesNotPreloadWithoutPolicy
+{
+    self.preloader.policy = nil;
+
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</style.css>; rel=preload"] request:self.request tags:nil];
+
+    XCTAssertEqual(self.preloadRequests.count, 0u);
+}
+
+- (void)testLimitsConcurrentPreloads
+{
+    // Given
+    SPTDataLoaderPreloadPolicy *policy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    policy.maximumConcurrentPreloads = 2;
+    self.preloader.policy = policy;
+    NSHTTPURLResponse *response = [self responseWithLinkHeader:@"</a>; rel=preload, </b>; rel=preload, </c>; rel=preload"];
+
+    // When
+    [self.preloader preloadResourcesOfResponse:response request:self.request tags:nil];
+    [self finishPreloadTask:self.preloadTasks.firstObject body:[NSData data]];
+    [self.preloader preloadResourcesOfResponse:response request:self.request tags:nil];
+
+    // Then
+    XCTAssertEqual(self.preloadRequests.count, 3u, @"A completed preload should make room for the next one");
+    XCTAssertEqualObjects(self.preloadRequests.lastObject.URL.path, @"/c");
+}
+
+- (void)testCancelsPreloadsOverTheByteBudget
+{
+    // Given
+    SPTDataLoaderPreloadPolicy *policy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    policy.maximumBytes = 4;
+    self.preloader.policy = policy;
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+    NSURLSessionDataTaskMock *task = self.preloadTasks.firstObject;
+    XCTAssertEqual([self.preloader receiveResponse:[self responseWithURL:self.request.URL statusCode:200 headers:@{}] forTask:task],
+                   NSURLSessionResponseAllow);
+
+    // When
+    [self.preloader receiveData:[@"too large" dataUsingEncoding:NSUTF8StringEncoding] forTask:task];
+
+    // Then
+    XCTAssertEqual(task.numberOfCallsToCancel, 1u);
+}
+
+- (void)testDoesNotKeepUnsuccessfulResponses
+{
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+
+    NSURLSessionResponseDisposition disposition = [self.preloader receiveResponse:[self responseWithURL:self.request.URL statusCode:404 headers:@{}]
+                                                                          forTask:self.preloadTasks.firstObject];
+
+    XCTAssertEqual(disposition, NSURLSessionResponseCancel);
+}
+
+- (void)testClaimsLoadedPreloadOnce
+{
+    // Given
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+    NSURL *URL = (NSURL * _Nonnull)self.preloadRequests.firstObject.URL;
+    NSData *body = [@"body" dataUsingEncoding:NSUTF8StringEncoding];
+
+    // When
+    [self finishPreloadTask:self.preloadTasks.firstObject body:body];
+
+    // Then
+    XCTAssertEqualObjects(self.preloadedData, @[ body ]);
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimLoaded);
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimNone);
+}
+
+- (void)testPendingClaimWaitsForThePreload
+{
+    // Given
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+    NSURL *URL = (NSURL * _Nonnull)self.preloadRequests.firstObject.URL;
+    __block NSUInteger finishedCount = 0;
+    __block NSUInteger preloadedCountWhenFinished = 0;
+
+    // When
+    SPTDataLoaderPreloaderClaim claim = [self.preloader claimPreloadOfURL:URL finishedHandler:^{
+        finishedCount++;
+        preloadedCountWhenFinished = self.preloadedData.count;
+    }];
+    [self finishPreloadTask:self.preloadTasks.firstObject body:[NSData data]];
+
+    // Then
+    XCTAssertEqual(claim, SPTDataLoaderPreloaderClaimPending);
+    XCTAssertEqual(finishedCount, 1u);
+    XCTAssertEqual(preloadedCountWhenFinished, 1u, @"The response should be stored before the waiting request resumes");
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimLoaded);
+}
+
+- (void)testLoadedPreloadExpires
+{
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+    NSURL *URL = (NSURL * _Nonnull)self.preloadRequests.firstObject.URL;
+    [self finishPreloadTask:self.preloadTasks.firstObject body:[NSData data]];
+
+    [self.timeProvider advanceTimeBy:self.preloader.policy.timeToLive];
+
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimNone);
+}
+
+- (void)testCancellingTheRequestCancelsItsPreloads
+{
+    // Given
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+    NSURLSessionDataTaskMock *task = self.preloadTasks.firstObject;
+    NSURL *URL = (NSURL * _Nonnull)self.preloadRequests.firstObject.URL;
+    __block BOOL finished = NO;
+    [self.preloader claimPreloadOfURL:URL finishedHandler:^{
+        finished = YES;
+    }];
+
+    // When
+    [self.preloader cancelPreloadsOfRequest:self.request];
+    [self.preloader completeTask:task error:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+
+    // Then
+    XCTAssertEqual(task.numberOfCallsToCancel, 1u);
+    XCTAssertTrue(finished, @"The waiting request should be let go once the cancelled preload completes");
+    XCTAssertFalse([self.preloader handlesTask:task]);
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimNone);
+}
+
+- (void)testCancellingATagCancelsItsPreloads
+{
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"]
+                                       request:self.request
+                                          tags:[NSSet setWithObject:@"page"]];
+    NSURLSessionDataTaskMock *task = self.preloadTasks.firstObject;
+
+    [self.preloader cancelPreloadsWithTag:@"other"];
+    XCTAssertEqual(task.numberOfCallsToCancel, 0u);
+
+    [self.preloader cancelPreloadsWithTag:@"page"];
+    XCTAssertEqual(task.numberOfCallsToCancel, 1u);
+}
+
+- (void)testRefusedPreloadIsForgotten
+{
+    self.refusesTasks = YES;
+
+    [self.preloader preloadResourcesOfResponse:[self responseWithLinkHeader:@"</a>; rel=preload"] request:self.request tags:nil];
+
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/a"];
+    XCTAssertEqual([self.preloader claimPreloadOfURL:URL finishedHandler:^{}], SPTDataLoaderPreloaderClaimNone);
+}
+
+@end
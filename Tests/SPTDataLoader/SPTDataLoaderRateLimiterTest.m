@@ -6,9 +6,11 @@
 #import <XCTest/XCTest.h>
 
 #import "SPTDataLoaderRateLimiter+Private.h"
+#import "SPTDataLoaderResponse+Private.h"
 #import "SPTDataLoaderTimeProviderImplementation.h"
 #import "SPTDataLoaderTimeProviderMock.h"
 
+#import <SPTDataLoader/SPTDataLoaderConcurrencyLimit.h>
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 
 @interface SPTDataLoaderRateLimiterTest : XCTestCase
@@ -195,4 +197,163 @@
     XCTAssertEqualWithAccuracy(earliestTime, 0.0, 1.0, @"The earliest time until request can be executed was not reset despite an overwrite of the retry-after rule");
 }
 
+- (SPTDataLoaderRequest *)adaptiveRequest
+{
+    NSURL *URL = [NSURL URLWithString:@"https://spclient.wg.spotify.com/thingy"];
+    return [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:nil];
+}
+
+- (void)releaseRequest:(SPTDataLoaderRequest *)request statusCode:(NSInteger)statusCode roundTripTime:(NSTimeInterval)roundTripTime
+{
+    NSHTTPURLResponse *URLResponse = [[NSHTTPURLResponse alloc] initWithURL:request.URL
+                                                                 statusCode:statusCode
+                                                                HTTPVersion:@"HTTP/1.1"
+                                                               headerFields:nil];
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:URLResponse];
+    [self.rateLimiter releaseConcurrencyForRequest:request roundTripTime:roundTripTime response:response];
+}
+
+- (void)testAdaptiveConcurrencyIsOffByDefault
+{
+    // Given
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+
+    // When
+    NSUInteger acquiredCount = 0;
+    for (NSUInteger i = 0; i < 100; ++i) {
+        acquiredCount += [self.rateLimiter acquireConcurrencyForRequest:[request copy] waiter:^{}] ? 1 : 0;
+    }
+
+    // Then
+    XCTAssertEqual(acquiredCount, 100u, @"Requests should never wait for a place unless adaptive concurrency is turned on");
+    XCTAssertFalse([self.rateLimiter adaptiveConcurrencyForURL:request.URL]);
+    XCTAssertNil([self.rateLimiter concurrencyLimitForURL:request.URL]);
+}
+
+- (void)testAdaptiveConcurrencyQueuesRequestsOverTheLimit
+{
+    // Given
+    self.rateLimiter.initialConcurrencyLimit = 2;
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+    [self.rateLimiter setAdaptiveConcurrency:YES forURL:request.URL];
+    SPTDataLoaderRequest *secondRequest = [request copy];
+    SPTDataLoaderRequest *thirdRequest = [request copy];
+    __block NSUInteger waiterCalls = 0;
+
+    // When
+    BOOL firstAcquired = [self.rateLimiter acquireConcurrencyForRequest:request waiter:^{}];
+    BOOL secondAcquired = [self.rateLimiter acquireConcurrencyForRequest:secondRequest waiter:^{}];
+    BOOL thirdAcquired = [self.rateLimiter acquireConcurrencyForRequest:thirdRequest waiter:^{
+        waiterCalls++;
+    }];
+
+    // Then
+    XCTAssertTrue(firstAcquired);
+    XCTAssertTrue(secondAcquired);
+    XCTAssertFalse(thirdAcquired, @"The request over the limit should wait");
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = [self.rateLimiter concurrencyLimitForURL:request.URL];
+    XCTAssertEqual(concurrencyLimit.limit, 2u);
+    XCTAssertEqual(concurrencyLimit.inFlightCount, 2u);
+    XCTAssertEqual(concurrencyLimit.queuedCount, 1u);
+
+    [self.rateLimiter abandonConcurrencyForRequest:request];
+    XCTAssertEqual(waiterCalls, 1u, @"The waiting request should take the place that was given back");
+    XCTAssertEqual([self.rateLimiter concurrencyLimitForURL:request.URL].queuedCount, 0u);
+}
+
+- (void)testAdaptiveConcurrencyGrowsWhileTheLimitIsUsedUp
+{
+    // Given
+    self.rateLimiter.initialConcurrencyLimit = 2;
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+    SPTDataLoaderRequest *secondRequest = [request copy];
+    [self.rateLimiter setAdaptiveConcurrency:YES forURL:request.URL];
+    [self.rateLimiter acquireConcurrencyForRequest:request waiter:^{}];
+    [self.rateLimiter acquireConcurrencyForRequest:secondRequest waiter:^{}];
+
+    // When
+    [self releaseRequest:request statusCode:SPTDataLoaderResponseHTTPStatusCodeOK roundTripTime:0.1];
+    [self releaseRequest:secondRequest statusCode:SPTDataLoaderResponseHTTPStatusCodeOK roundTripTime:0.1];
+
+    // Then
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = [self.rateLimiter concurrencyLimitForURL:request.URL];
+    XCTAssertEqual(concurrencyLimit.limit, 3u, @"Only the answer that arrived while the limit was used up should raise it");
+    XCTAssertEqualWithAccuracy(concurrencyLimit.baselineRoundTripTime, 0.1, DBL_EPSILON);
+    XCTAssertEqual(concurrencyLimit.inFlightCount, 0u);
+}
+
+- (void)testAdaptiveConcurrencyHalvesOnServiceUnavailable
+{
+    // Given
+    self.rateLimiter.initialConcurrencyLimit = 8;
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+    SPTDataLoaderRequest *secondRequest = [request copy];
+    [self.rateLimiter setAdaptiveConcurrency:YES forURL:request.URL];
+    [self.rateLimiter acquireConcurrencyForRequest:request waiter:^{}];
+    [self.rateLimiter acquireConcurrencyForRequest:secondRequest waiter:^{}];
+
+    // When
+    [self releaseRequest:request statusCode:SPTDataLoaderResponseHTTPStatusCodeServiceUnavailable roundTripTime:0.01];
+    [self releaseRequest:secondRequest statusCode:SPTDataLoaderResponseHTTPStatusCodeServiceUnavailable roundTripTime:0.01];
+
+    // Then
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = [self.rateLimiter concurrencyLimitForURL:request.URL];
+    XCTAssertEqual(concurrencyLimit.limit, 4u, @"Congestion reported by the requests of one round-trip should cut the limit once");
+    XCTAssertEqual(concurrencyLimit.congestionSignalCount, 2u);
+    XCTAssertEqual(concurrencyLimit.decreaseCount, 1u);
+    XCTAssertEqualWithAccuracy(concurrencyLimit.baselineRoundTripTime, 0.0, DBL_EPSILON, @"Rejections should not count towards the round-trip time");
+}
+
+- (void)testAdaptiveConcurrencyHalvesOnLatencyGrowth
+{
+    // Given
+    self.rateLimiter.initialConcurrencyLimit = 16;
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+    [self.rateLimiter setAdaptiveConcurrency:YES forURL:request.URL];
+
+    // When
+    for (NSUInteger i = 0; i < 10; ++i) {
+        SPTDataLoaderRequest *sample = [request copy];
+        [self.rateLimiter acquireConcurrencyForRequest:sample waiter:^{}];
+        [self releaseRequest:sample statusCode:SPTDataLoaderResponseHTTPStatusCodeOK roundTripTime:i < 5 ? 0.1 : 1.0];
+    }
+
+    // Then
+    SPTDataLoaderConcurrencyLimit *concurrencyLimit = [self.rateLimiter concurrencyLimitForURL:request.URL];
+    XCTAssertEqual(concurrencyLimit.limit, 8u);
+    XCTAssertEqual(concurrencyLimit.decreaseCount, 1u);
+    XCTAssertEqual(concurrencyLimit.congestionSignalCount, 0u);
+    XCTAssertGreaterThan(concurrencyLimit.smoothedRoundTripTime, 2.0 * concurrencyLimit.baselineRoundTripTime);
+
+    self.timeProvider.currentTime += 2.0;
+    SPTDataLoaderRequest *sample = [request copy];
+    [self.rateLimiter acquireConcurrencyForRequest:sample waiter:^{}];
+    [self releaseRequest:sample statusCode:SPTDataLoaderResponseHTTPStatusCodeOK roundTripTime:1.0];
+    XCTAssertEqual([self.rateLimiter concurrencyLimitForURL:request.URL].limit, 4u, @"The limit should be cut again a round-trip later");
+}
+
+- (void)testTurningAdaptiveConcurrencyOffLetsWaitingRequestsThrough
+{
+    // Given
+    self.rateLimiter.initialConcurrencyLimit = 1;
+    SPTDataLoaderRequest *request = [self adaptiveRequest];
+    [self.rateLimiter setAdaptiveConcurrency:YES forURL:request.URL];
+    [self.rateLimiter acquireConcurrencyForRequest:request waiter:^{}];
+    __block NSUInteger waiterCalls = 0;
+    for (NSUInteger i = 0; i < 3; ++i) {
+        [self.rateLimiter acquireConcurrencyForRequest:[request copy] waiter:^{
+            waiterCalls++;
+        }];
+    }
+
+    // When
+    [self.rateLimiter setAdaptiveConcurrency:NO forURL:request.URL];
+
+    // Then
+    XCTAssertEqual(waiterCalls, 3u);
+    XCTAssertNil([self.rateLimiter concurrencyLimitForURL:request.URL]);
+    // Test no crash
+    [self releaseRequest:request statusCode:SPTDataLoaderResponseHTTPStatusCodeOK roundTripTime:0.1];
+}
+
 @end
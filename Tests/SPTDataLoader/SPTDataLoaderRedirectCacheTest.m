@@ -0,0 +1,164 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderRedirect.h>
+
+#import "SPTDataLoaderRedirectCache.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+@interface SPTDataLoaderRedirectCacheTest : XCTestCase
+
+@property (nonatomic, strong) SPTDataLoaderRedirectCache *redirectCache;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, strong) NSURL *redirectURL;
+
+@end
+
+@implementation SPTDataLoaderRedirectCacheTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.redirectCache = [SPTDataLoaderRedirectCache redirectCacheWithCapacity:2 timeProvider:self.timeProvider];
+    self.URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/thing"];
+    self.redirectURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"];
+}
+
+#pragma mark SPTDataLoaderRedirectCacheTest
+
+- (NSHTTPURLResponse *)responseWithURL:(NSURL *)URL
+                            statusCode:(NSInteger)statusCode
+                               headers:(NSDictionary<NSString *, NSString *> *)headers
+{
+    return (NSHTTPURLResponse * _Nonnull)[[NSHTTPURLResponse alloc] initWithURL:URL
+                                                                     statusCode:statusCode
+                                                                    HTTPVersion:@"1.1"
+                                                                   headerFields:headers];
+}
+
+- (void)testCachesMovedPermanentlyForGetRequests
+{
+    NSHTTPURLResponse *response = [self responseWithURL:self.URL statusCode:301 headers:@{}];
+
+    XCTAssertTrue([self.redirectCache cacheRedirectResponse:response
+                                                redirectURL:self.redirectURL
+                                                     method:SPTDataLoaderRequestMethodGet]);
+
+    SPTDataLoaderRedirect *redirect = [self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet];
+    XCTAssertEqualObjects(redirect.URL, self.URL);
+    XCTAssertEqualObjects(redirect.redirectURL, self.redirectURL);
+    XCTAssertEqual(redirect.statusCode, 301);
+    XCTAssertTrue(redirect.cached);
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodHead],
+                 @"Redirects should be kept per method");
+}
+
+- (void)testOnlyCachesMovedPermanentlyForMethodsItPreserves
+{
+    NSHTTPURLResponse *movedPermanently = [self responseWithURL:self.URL statusCode:301 headers:@{}];
+    NSHTTPURLResponse *permanentRedirect = [self responseWithURL:self.URL statusCode:308 headers:@{}];
+
+    XCTAssertFalse([self.redirectCache cacheRedirectResponse:movedPermanently
+                                                 redirectURL:self.redirectURL
+                                                      method:SPTDataLoaderRequestMethodPost]);
+    XCTAssertTrue([self.redirectCache cacheRedirectResponse:permanentRedirect
+                                                redirectURL:self.redirectURL
+                                                     method:SPTDataLoaderRequestMethodPost]);
+    XCTAssertEqual([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodPost].statusCode, 308);
+}
+
+- (void)testDoesNotCacheTemporaryRedirects
+{
+    for (NSNumber *statusCode in @[ @302, @303, @307 ]) {
+        NSHTTPURLResponse *response = [self responseWithURL:self.URL statusCode:statusCode.integerValue headers:@{}];
+        XCTAssertFalse([self.redirectCache cacheRedirectResponse:response
+                                                     redirectURL:self.redirectURL
+                                                          method:SPTDataLoaderRequestMethodGet]);
+    }
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+}
+
+- (void)testHonoursCacheControl
+{
+    NSHTTPURLResponse *noStore = [self responseWithURL:self.URL statusCode:301 headers:@{ @"Cache-Control" : @"no-store" }];
+    XCTAssertFalse([self.redirectCache cacheRedirectResponse:noStore
+                                                 redirectURL:self.redirectURL
+                                                      method:SPTDataLoaderRequestMethodGet]);
+
+    // Given
+    NSHTTPURLResponse *maxAge = [self responseWithURL:self.URL statusCode:301 headers:@{ @"Cache-Control" : @"public, max-age=60" }];
+    [self.redirectCache cacheRedirectResponse:maxAge redirectURL:self.redirectURL method:SPTDataLoaderRequestMethodGet];
+
+    // When
+    [self.timeProvider advanceTimeBy:59.0];
+
+    // Then
+    XCTAssertNotNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+    [self.timeProvider advanceTimeBy:1.0];
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet],
+                 @"The redirect should expire with its max-age");
+}
+
+- (void)testHonoursExpiresRelativeToDate
+{
+    NSDictionary *headers = @{ @"Date" : @"Mon, 05 Jan 2015 10:00:00 GMT", @"Expires" : @"Mon, 05 Jan 2015 10:02:00 GMT" };
+    NSHTTPURLResponse *response = [self responseWithURL:self.URL statusCode:301 headers:headers];
+    [self.redirectCache cacheRedirectResponse:response redirectURL:self.redirectURL method:SPTDataLoaderRequestMethodGet];
+
+    [self.timeProvider advanceTimeBy:119.0];
+    XCTAssertNotNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+    [self.timeProvider advanceTimeBy:1.0];
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+}
+
+- (void)testEvictsLeastRecentlyUsedRedirect
+{
+    // Given
+    NSURL *secondURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/second"];
+    NSURL *thirdURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/third"];
+    for (NSURL *URL in @[ self.URL, secondURL ]) {
+        NSHTTPURLResponse *response = [self responseWithURL:URL statusCode:301 headers:@{}];
+        [self.redirectCache cacheRedirectResponse:response redirectURL:self.redirectURL method:SPTDataLoaderRequestMethodGet];
+    }
+
+    // When
+    [self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet];
+    NSHTTPURLResponse *response = [self responseWithURL:thirdURL statusCode:301 headers:@{}];
+    [self.redirectCache cacheRedirectResponse:response redirectURL:self.redirectURL method:SPTDataLoaderRequestMethodGet];
+
+    // Then
+    XCTAssertNotNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+    XCTAssertNil([self.redirectCache redirectForURL:secondURL method:SPTDataLoaderRequestMethodGet]);
+    XCTAssertNotNil([self.redirectCache redirectForURL:thirdURL method:SPTDataLoaderRequestMethodGet]);
+}
+
+- (void)testZeroCapacityKeepsNothing
+{
+    self.redirectCache.capacity = 0;
+    NSHTTPURLResponse *response = [self responseWithURL:self.URL statusCode:301 headers:@{}];
+
+    XCTAssertFalse([self.redirectCache cacheRedirectResponse:response
+                                                 redirectURL:self.redirectURL
+                                                      method:SPTDataLoaderRequestMethodGet]);
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+}
+
+- (void)testRemoveAllRedirects
+{
+    NSHTTPURLResponse *response = [self responseWithURL:self.URL statusCode:301 headers:@{}];
+    [self.redirectCache cacheRedirectResponse:response redirectURL:self.redirectURL method:SPTDataLoaderRequestMethodGet];
+
+    [self.redirectCache removeAllRedirects];
+
+    XCTAssertNil([self.redirectCache redirectForURL:self.URL method:SPTDataLoaderRequestMethodGet]);
+}
+
+@end
@@ -11,8 +11,19 @@
 #import <SPTDataLoader/SPTDataLoaderResponse.h>
 #import <SPTDataLoader/SPTDataLoaderRequest.h>
 
+#import <SPTDataLoader/SPTDataLoaderHistogram.h>
+#import <SPTDataLoader/SPTDataLoaderMetrics.h>
+
+#import "SPTDataLoaderInFlightRequest+Private.h"
+#import "SPTDataLoaderMetricsRegistry+Private.h"
 #import "SPTDataLoaderRequestResponseHandlerMock.h"
 #import "SPTDataLoaderRequestTaskHandlerDelegateMock.h"
+#import "SPTDataLoaderRateLimiter+Private.h"
+#import "SPTDataLoaderRequest+Private.h"
+#import "SPTDataLoaderTimeProviderImplementation.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+#import "SPTDataLoaderTraceContext.h"
+#import "SPTDataLoaderTracerMock.h"
 #import "NSURLSessionTaskMock.h"
 
 @interface SPTDataLoaderRequestTaskHandler ()
@@ -31,6 +42,7 @@
 @property (nonatomic, strong) NSURLSessionTaskMock *task;
 @property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler;
 @property (nonatomic, strong) SPTDataLoaderRateLimiter *rateLimiter;
+@property (nonatomic, strong) id<SPTDataLoaderTimeProvider> timeProvider;
 @property (nonatomic, strong) SPTDataLoaderRequest *request;
 @property (nonatomic, strong) SPTDataLoaderRequestTaskHandlerDelegateMock *delegate;
 
@@ -47,6 +59,7 @@
     self.task = [NSURLSessionTaskMock new];
     self.requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
     self.rateLimiter = [SPTDataLoaderRateLimiter rateLimiterWithDefaultRequestsPerSecond:10.0];
+    self.timeProvider = [SPTDataLoaderTimeProviderImplementation new];
     self.request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
                                        sourceIdentifier:nil];
     self.delegate = [SPTDataLoaderRequestTaskHandlerDelegateMock new];
@@ -55,6 +68,7 @@
                                                                                  request:self.request
                                                                   requestResponseHandler:self.requestResponseHandler
                                                                              rateLimiter:self.rateLimiter
+                                                                            timeProvider:self.timeProvider
                                                                                 delegate:self.delegate];
 }
 
@@ -73,6 +87,66 @@
     XCTAssertEqual(self.requestResponseHandler.numberOfReceivedDataRequestCalls, 1u, @"The handler did not relay the received data onto its request response handler");
 }
 
+- (void)testReceiveDataCoalescesChunksSmallerThanMinimumChunkSize
+{
+    self.request.chunks = YES;
+    self.request.minimumChunkSize = 8;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.handler receiveData:data];
+    XCTAssertEqual(self.requestResponseHandler.numberOfReceivedDataRequestCalls, 0u, @"The handler relayed a chunk smaller than the minimum chunk size");
+    [self.handler receiveData:data];
+    XCTAssertEqual(self.requestResponseHandler.numberOfReceivedDataRequestCalls, 1u, @"The handler did not relay the coalesced chunk once it reached the minimum chunk size");
+}
+
+- (void)testCompletionFlushesCoalescedChunk
+{
+    self.request.chunks = YES;
+    self.request.minimumChunkSize = 1024;
+    [self.handler receiveData:[@"thing" dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:nil];
+    XCTAssertEqual(self.requestResponseHandler.numberOfReceivedDataRequestCalls, 1u, @"The handler did not flush the remaining coalesced data on completion");
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+}
+
+- (void)testTaskSuspendedWhileInFlightChunkWindowIsFull
+{
+    self.request.chunks = YES;
+    self.request.maximumInFlightChunks = 2;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.handler receiveData:data];
+    XCTAssertEqual(self.task.numberOfCallsToSuspend, 0u, @"The handler suspended the task before the in-flight chunk window was full");
+    [self.handler receiveData:data];
+    XCTAssertEqual(self.task.numberOfCallsToSuspend, 1u, @"The handler did not suspend the task when the in-flight chunk window was full");
+    self.requestResponseHandler.lastChunkCompletionHandler();
+    XCTAssertEqual(self.task.numberOfCallsToResume, 1u, @"The handler did not resume the task once a chunk was consumed");
+}
+
+- (void)testInFlightChunkWindowAppliesToRetriedTask
+{
+    // Given
+    [self useHandlerWithoutRateLimiter];
+    self.request.chunks = YES;
+    self.request.maximumInFlightChunks = 2;
+    self.request.maximumRetryCount = 1;
+    NSURLSessionTaskMock *retryTask = [NSURLSessionTaskMock new];
+    self.delegate.task = retryTask;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.handler start];
+    [self.handler receiveData:data];
+    [self.handler receiveData:data];
+    XCTAssertEqual(self.task.numberOfCallsToSuspend, 1u);
+
+    // When
+    XCTAssertNil([self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]]);
+
+    // Then
+    XCTAssertEqual(retryTask.numberOfCallsToResume, 0u, @"The retried task should wait while the consumer holds a full window of chunks");
+    self.requestResponseHandler.lastChunkCompletionHandler();
+    XCTAssertEqual(retryTask.numberOfCallsToResume, 1u, @"The retried task should start once a chunk was consumed");
+    [self.handler receiveData:data];
+    XCTAssertEqual(retryTask.numberOfCallsToSuspend, 1u, @"The retried task should be suspended once the window fills again");
+}
+
 - (void)testRelaySuccessfulResponse
 {
     [self.handler completeWithError:nil];
@@ -202,6 +276,61 @@
     XCTAssertEqual(self.requestResponseHandler.numberOfCancelledRequestCalls, 1u, @"The handler did not relay the failed response onto its request response handler");
 }
 
+- (void)testRejectsResponseAnnouncingTooLargeBody
+{
+    // Given
+    self.handler.maximumResponseBodySize = 32;
+    NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                                  statusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                                 HTTPVersion:@"1.1"
+                                                                headerFields:@{ @"Content-Length" : @"64" }];
+
+    // When
+    NSURLSessionResponseDisposition disposition = [self.handler receiveResponse:httpResponse];
+    [self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+
+    // Then
+    XCTAssertEqual(disposition, NSURLSessionResponseCancel, @"The body should not be loaded once its Content-Length exceeds the limit");
+    XCTAssertEqual(self.requestResponseHandler.numberOfReceivedInitialResponseCalls, 0u);
+    XCTAssertEqual(self.requestResponseHandler.numberOfCancelledRequestCalls, 0u, @"The request should fail rather than be cancelled");
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    NSError *error = self.requestResponseHandler.lastReceivedResponse.error;
+    XCTAssertEqualObjects(error.domain, SPTDataLoaderRequestErrorDomain);
+    XCTAssertEqual(error.code, SPTDataLoaderRequestErrorResponseTooLarge);
+}
+
+- (void)testCancelsResponseGrowingPastTheLimit
+{
+    // Given
+    self.handler.maximumResponseBodySize = 6;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.handler receiveResponse:[NSURLResponse new]];
+
+    // When
+    [self.handler receiveData:data];
+    [self.handler receiveData:data];
+    [self.handler receiveData:data];
+    [self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+
+    // Then
+    XCTAssertEqual(self.task.numberOfCallsToCancel, 1u, @"The task should be cancelled as soon as the body exceeds the limit");
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    XCTAssertEqual(self.requestResponseHandler.lastReceivedResponse.error.code, SPTDataLoaderRequestErrorResponseTooLarge);
+    XCTAssertNil(self.requestResponseHandler.lastReceivedResponse.body, @"The partial body should have been dropped");
+}
+
+- (void)testAcceptsResponseWithinTheLimit
+{
+    self.handler.maximumResponseBodySize = 10;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+    [self.handler receiveResponse:[NSURLResponse new]];
+    [self.handler receiveData:data];
+    [self.handler receiveData:data];
+    [self.handler completeWithError:nil];
+    XCTAssertEqual(self.task.numberOfCallsToCancel, 0u);
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+}
+
 - (void)testRetryWithRateLimiter
 {
     self.delegate.task = self.task;
@@ -223,6 +352,61 @@
     [self waitForExpectationsWithTimeout:2.0 handler:nil];
 }
 
+- (void)testRetryWaitsOnTimeProvider
+{
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    SPTDataLoaderRateLimiter *rateLimiter = [[SPTDataLoaderRateLimiter alloc] initWithDefaultRequestsPerSecond:1.0
+                                                                                                  timeProvider:timeProvider];
+    self.delegate.task = self.task;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:rateLimiter
+                                                                            timeProvider:timeProvider
+                                                                                delegate:self.delegate];
+    self.request.maximumRetryCount = 1;
+
+    [self.handler start];
+    [self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil]];
+    XCTAssertEqual(self.task.numberOfCallsToResume, 1u, @"The retry should wait for the rate limiter on the time provider");
+    XCTAssertEqual(timeProvider.numberOfScheduledBlocks, 1u, @"The retry should be scheduled on the time provider");
+
+    [timeProvider advanceTimeBy:1.0];
+    XCTAssertEqual(self.task.numberOfCallsToResume, 2u, @"The retry should be performed once the time provider reaches the rate limit");
+}
+
+- (void)testRetryOnlyStartsBeforeTheDeadline
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    SPTDataLoaderRateLimiter *rateLimiter = [[SPTDataLoaderRateLimiter alloc] initWithDefaultRequestsPerSecond:1.0
+                                                                                                  timeProvider:timeProvider];
+    self.delegate.task = self.task;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:rateLimiter
+                                                                            timeProvider:timeProvider
+                                                                                delegate:self.delegate];
+    self.request.maximumRetryCount = 3;
+    self.request.deadline = 102.5;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+
+    // When
+    [self.handler start];
+    [self.handler completeWithError:error];
+    [timeProvider advanceTimeBy:1.0];
+    [self.handler completeWithError:error];
+
+    // Then
+    XCTAssertEqual(self.task.numberOfCallsToResume, 2u, @"The first retry can be sent once the rate limiter allows it, before the deadline");
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u,
+                   @"The second retry would only be sent after the deadline once it has backed off, so the request should fail instead");
+    XCTAssertEqual(timeProvider.numberOfScheduledBlocks, 0u, @"Nothing should be left waiting to be retried");
+}
+
 - (void)testCompletingWhenDeallocatingDuringFlight
 {
     [self.handler start];
@@ -277,9 +461,347 @@
                                                                                  request:self.request
                                                                   requestResponseHandler:self.requestResponseHandler
                                                                              rateLimiter:self.rateLimiter
+                                                                            timeProvider:self.timeProvider
                                                                                 delegate:self.delegate];
     XCTAssertFalse(self.handler.mayRedirect);
 
 }
 
+- (void)testRetryResumesBodyWithRange
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes", @"ETag" : @"\"v1\"" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssertNil([self.handler completeWithError:error]);
+    NSDictionary *expectedHeaders = @{ @"Range" : @"bytes=6-", @"If-Range" : @"\"v1\"" };
+    XCTAssertEqualObjects(self.handler.resumeHeaders, expectedHeaders, @"The retry should ask for the rest of the body");
+
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodePartialContent
+                                                       headers:@{ @"Content-Range" : @"bytes 6-10/11" }]];
+    [self.handler receiveData:[@"World" dataUsingEncoding:NSUTF8StringEncoding]];
+    SPTDataLoaderResponse *response = [self.handler completeWithError:nil];
+
+    XCTAssertEqualObjects(response.body, [@"Hello World" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqual(response.statusCode, SPTDataLoaderResponseHTTPStatusCodeOK, @"The consumer should see the original response");
+    XCTAssertNil(response.error);
+    XCTAssertEqual(self.requestResponseHandler.numberOfReceivedInitialResponseCalls, 1u);
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+}
+
+- (void)testRetryRestartsWhenServerIgnoresRange
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    NSDictionary *headers = @{ @"Accept-Ranges" : @"bytes", @"Last-Modified" : @"Wed, 21 Oct 2015 07:28:00 GMT" };
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK headers:headers]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+    XCTAssertEqualObjects(self.handler.resumeHeaders[@"If-Range"], headers[@"Last-Modified"]);
+
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK headers:headers]];
+    [self.handler receiveData:[@"Hello World" dataUsingEncoding:NSUTF8StringEncoding]];
+    SPTDataLoaderResponse *response = [self.handler completeWithError:nil];
+
+    XCTAssertEqualObjects(response.body, [@"Hello World" dataUsingEncoding:NSUTF8StringEncoding], @"A full response should replace the partial body");
+}
+
+- (void)testRetryRestartsWhenRangeDoesNotContinueBody
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes", @"ETag" : @"\"v1\"" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+    NSUInteger numberOfCallsToResume = self.task.numberOfCallsToResume;
+
+    NSURLSessionResponseDisposition disposition =
+        [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodePartialContent
+                                                           headers:@{ @"Content-Range" : @"bytes 0-4/11" }]];
+    XCTAssertEqual(disposition, NSURLSessionResponseCancel, @"A range that does not continue the body should not be delivered");
+    XCTAssertNil([self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]]);
+    XCTAssertNil(self.handler.resumeHeaders, @"The restart should ask for the whole body");
+    XCTAssertFalse(self.handler.cancelled);
+    XCTAssertEqual(self.task.numberOfCallsToResume, numberOfCallsToResume + 1);
+
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK headers:@{}]];
+    [self.handler receiveData:[@"Hello World" dataUsingEncoding:NSUTF8StringEncoding]];
+    SPTDataLoaderResponse *response = [self.handler completeWithError:nil];
+
+    XCTAssertEqualObjects(response.body, [@"Hello World" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqual(self.requestResponseHandler.numberOfCancelledRequestCalls, 0u);
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+}
+
+- (void)testCancelWinsOverPendingRestartWithoutRange
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    // Given a retry whose ranged response did not continue the body
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes", @"ETag" : @"\"v1\"" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodePartialContent
+                                                       headers:@{ @"Content-Range" : @"bytes 0-4/11" }]];
+    NSUInteger numberOfCallsToResume = self.task.numberOfCallsToResume;
+
+    // When the caller cancels before the task comes back
+    [self.handler cancel];
+    SPTDataLoaderResponse *response = [self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+
+    // Then
+    XCTAssertNil(response);
+    XCTAssertTrue(self.handler.cancelled);
+    XCTAssertEqual(self.task.numberOfCallsToResume, numberOfCallsToResume, @"A cancelled request should not restart");
+    XCTAssertEqual(self.requestResponseHandler.numberOfCancelledRequestCalls, 1u);
+}
+
+- (void)testRetryRestartsWhenBodyIsEncoded
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes",
+                                                                  @"ETag" : @"\"v1\"",
+                                                                  @"Content-Encoding" : @"gzip" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+
+    XCTAssertNil(self.handler.resumeHeaders, @"The decoded length is no offset into a gzip encoded body");
+}
+
+- (void)testRetryResumesBodyWithIdentityEncoding
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes",
+                                                                  @"ETag" : @"\"v1\"",
+                                                                  @"Content-Encoding" : @"identity" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+
+    XCTAssertEqualObjects(self.handler.resumeHeaders[@"Range"], @"bytes=6-");
+}
+
+- (void)testRetryRestartsWithoutStrongValidator
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+
+    [self.handler start];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                       headers:@{ @"Accept-Ranges" : @"bytes", @"ETag" : @"W/\"v1\"" }]];
+    [self.handler receiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.handler completeWithError:error];
+
+    XCTAssertNil(self.handler.resumeHeaders, @"A weak validator cannot guarantee the rest of the body matches");
+}
+
+- (void)testRetryKeepsDownloadResumeData
+{
+    [self useHandlerWithoutRateLimiter];
+    self.request.maximumRetryCount = 1;
+    NSData *resumeData = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                         code:NSURLErrorNetworkConnectionLost
+                                     userInfo:@{ NSURLSessionDownloadTaskResumeData : resumeData }];
+
+    [self.handler start];
+    [self.handler completeWithError:error];
+
+    XCTAssertEqualObjects(self.handler.resumeData, resumeData);
+}
+
+- (void)testTracesRateLimiterWaitAndRetryBackoff
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    SPTDataLoaderRateLimiter *rateLimiter = [[SPTDataLoaderRateLimiter alloc] initWithDefaultRequestsPerSecond:1.0
+                                                                                                  timeProvider:timeProvider];
+    self.delegate.task = self.task;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:rateLimiter
+                                                                            timeProvider:timeProvider
+                                                                                delegate:self.delegate];
+    SPTDataLoaderTracerMock *tracer = [SPTDataLoaderTracerMock new];
+    self.handler.traceContext = [SPTDataLoaderTraceContext new];
+    self.handler.traceContext.tracer = tracer;
+    self.request.maximumRetryCount = 2;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+
+    // When
+    [self.handler start];
+    [self.handler completeWithError:error];
+    [timeProvider advanceTimeBy:1.0];
+    [self.handler completeWithError:error];
+    [timeProvider advanceTimeBy:1.0];
+    while ([timeProvider runNextScheduledBlock]) {
+    }
+
+    // Then
+    XCTAssertEqual(self.task.numberOfCallsToResume, 3u);
+    NSArray<NSString *> *expectedBackoff = @[ @"+retryBackoff", @"-retryBackoff" ];
+    XCTAssertEqualObjects([tracer eventsForPhase:SPTDataLoaderTracePhaseRetryBackoff], expectedBackoff,
+                          @"Only the second retry should back off");
+    NSArray<NSString *> *rateLimiterWaits = [tracer eventsForPhase:SPTDataLoaderTracePhaseRateLimiterWait];
+    XCTAssertGreaterThan(rateLimiterWaits.count, 2u);
+    for (NSUInteger i = 0; i < rateLimiterWaits.count; i++) {
+        XCTAssertEqualObjects(rateLimiterWaits[i], i % 2 == 0 ? @"+rateLimiterWait" : @"-rateLimiterWait",
+                              @"Every rate limiter wait should end before the next one begins");
+    }
+    NSArray<NSString *> *expectedTasks = @[ @"+task", @"-task", @"+task", @"-task", @"+task" ];
+    XCTAssertEqualObjects([tracer eventsForPhase:SPTDataLoaderTracePhaseTask], expectedTasks);
+    XCTAssertEqualObjects(tracer.lastServiceKey, @"https://spclient.wg.spotify.com/");
+}
+
+- (void)testTracesEveryChunkUntilItIsConsumed
+{
+    SPTDataLoaderTracerMock *tracer = [SPTDataLoaderTracerMock new];
+    self.handler.traceContext = [SPTDataLoaderTraceContext new];
+    self.handler.traceContext.tracer = tracer;
+    self.request.chunks = YES;
+    NSData *data = [@"thing" dataUsingEncoding:NSUTF8StringEncoding];
+
+    [self.handler receiveData:data];
+    [self.handler receiveData:data];
+    self.requestResponseHandler.lastChunkCompletionHandler();
+
+    NSArray<NSString *> *expectedChunks = @[ @"+chunk", @"+chunk", @"-chunk" ];
+    XCTAssertEqualObjects([tracer eventsForPhase:SPTDataLoaderTracePhaseChunk], expectedChunks);
+}
+
+- (void)testRecordsMetricsOnceTheRequestCompletes
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:nil
+                                                                            timeProvider:timeProvider
+                                                                                delegate:self.delegate];
+    SPTDataLoaderMetricsRegistry *registry = [SPTDataLoaderMetricsRegistry new];
+    self.handler.metricsRecorders = [registry metricsRecordersForRequest:self.request];
+
+    // When
+    [self.handler start];
+    [timeProvider advanceTimeBy:0.25];
+    [self.handler receiveResponse:[self responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK headers:@{}]];
+    [self.handler receiveData:[@"thing" dataUsingEncoding:NSUTF8StringEncoding]];
+    [timeProvider advanceTimeBy:0.25];
+    [self.handler completeWithError:nil];
+
+    // Then
+    SPTDataLoaderMetrics *metrics = registry.metrics.firstObject;
+    XCTAssertEqual(metrics.latency.count, 1u);
+    XCTAssertEqualWithAccuracy(metrics.latency.maximum, 0.5, 0.000001);
+    XCTAssertEqualWithAccuracy(metrics.timeToFirstByte.maximum, 0.25, 0.000001);
+    XCTAssertEqualWithAccuracy(metrics.queueWait.maximum, 0.0, 0.000001);
+    XCTAssertEqualWithAccuracy(metrics.bodySize.maximum, 5.0, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(metrics.retryCount.maximum, 0.0, DBL_EPSILON);
+    XCTAssertEqualObjects(metrics.statusClassCounts, @{ @"2xx" : @1 });
+}
+
+- (void)testDoesNotRecordMetricsOfCancelledRequests
+{
+    SPTDataLoaderMetricsRegistry *registry = [SPTDataLoaderMetricsRegistry new];
+    self.handler.metricsRecorders = [registry metricsRecordersForRequest:self.request];
+
+    [self.handler start];
+    [self.handler completeWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+
+    XCTAssertEqual(registry.metrics.count, 0u, @"Cancelled requests should not skew the metrics");
+}
+
+- (void)testInFlightRequestFollowsTheStateOfTheRequest
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    SPTDataLoaderRateLimiter *rateLimiter = [[SPTDataLoaderRateLimiter alloc] initWithDefaultRequestsPerSecond:1.0
+                                                                                                  timeProvider:timeProvider];
+    self.delegate.task = self.task;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:rateLimiter
+                                                                            timeProvider:timeProvider
+                                                                                delegate:self.delegate];
+    self.request.maximumRetryCount = 2;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    XCTAssertEqual(self.handler.inFlightRequest.state, SPTDataLoaderInFlightRequestStateQueued);
+
+    // When
+    [self.handler start];
+    SPTDataLoaderInFlightRequest *running = self.handler.inFlightRequest;
+    [self.handler completeWithError:error];
+    SPTDataLoaderInFlightRequest *rateLimited = self.handler.inFlightRequest;
+    [timeProvider advanceTimeBy:1.0];
+    [self.handler receiveData:[@"thing" dataUsingEncoding:NSUTF8StringEncoding]];
+    SPTDataLoaderInFlightRequest *streaming = self.handler.inFlightRequest;
+    [self.handler completeWithError:error];
+    [timeProvider advanceTimeBy:1.0];
+    SPTDataLoaderInFlightRequest *backingOff = self.handler.inFlightRequest;
+
+    // Then
+    XCTAssertEqual(running.state, SPTDataLoaderInFlightRequestStateRunning);
+    XCTAssertEqual(running.retryCount, 0u);
+    XCTAssertEqual(rateLimited.state, SPTDataLoaderInFlightRequestStateRateLimited);
+    XCTAssertEqual(streaming.state, SPTDataLoaderInFlightRequestStateStreaming);
+    XCTAssertEqual(streaming.retryCount, 1u);
+    XCTAssertEqual(streaming.receivedByteCount, 5);
+    XCTAssertEqual(backingOff.state, SPTDataLoaderInFlightRequestStateBackingOff);
+    XCTAssertEqualWithAccuracy(backingOff.age, 2.0, 0.000001);
+    XCTAssertEqualWithAccuracy(backingOff.timeInState, 0.0, 0.000001);
+}
+
+#pragma mark Private
+
+- (void)useHandlerWithoutRateLimiter
+{
+    self.delegate.task = self.task;
+    self.handler = [SPTDataLoaderRequestTaskHandler dataLoaderRequestTaskHandlerWithTask:self.task
+                                                                                 request:self.request
+                                                                  requestResponseHandler:self.requestResponseHandler
+                                                                             rateLimiter:nil
+                                                                            timeProvider:[SPTDataLoaderTimeProviderMock new]
+                                                                                delegate:self.delegate];
+}
+
+- (NSHTTPURLResponse *)responseWithStatusCode:(SPTDataLoaderResponseHTTPStatusCode)statusCode
+                                      headers:(NSDictionary<NSString *, NSString *> *)headers
+{
+    return [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                       statusCode:statusCode
+                                      HTTPVersion:@"1.1"
+                                     headerFields:headers];
+}
+
 @end
@@ -127,6 +127,15 @@
     self.request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyAlways;
     self.request.bodyStream = inputStream;
     self.request.shouldStopRedirection = YES;
+    self.request.maximumInFlightChunks = 4;
+    self.request.minimumChunkSize = 16384;
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    self.request.minimumCompressedBodySize = 64;
+    self.request.segmentCount = 4;
+    self.request.minimumSegmentSize = 65536;
+    self.request.bodyFileURL = [NSURL fileURLWithPath:@"/tmp/upload"];
+    self.request.sessionPartitionName = @"bulk";
+    self.request.persistsWhenOffline = YES;
     SPTDataLoaderRequest *request = [self.request copy];
     XCTAssertEqual(request.maximumRetryCount, self.request.maximumRetryCount, @"The retry count was not copied correctly");
     XCTAssertEqualObjects(request.body, self.request.body, @"The body was not copied correctly");
@@ -138,6 +147,15 @@
     XCTAssertEqual(request.backgroundPolicy, self.request.backgroundPolicy, @"The background policy was not copied correctly");
     XCTAssertEqual(request.bodyStream, self.request.bodyStream, @"The body stream was not copied correctly");
     XCTAssertEqual(request.shouldStopRedirection, self.request.shouldStopRedirection, @"The stop redirection was not copied correctly");
+    XCTAssertEqual(request.maximumInFlightChunks, self.request.maximumInFlightChunks, @"The maximum in-flight chunks were not copied correctly");
+    XCTAssertEqual(request.minimumChunkSize, self.request.minimumChunkSize, @"The minimum chunk size was not copied correctly");
+    XCTAssertEqual(request.bodyCompression, self.request.bodyCompression, @"The body compression was not copied correctly");
+    XCTAssertEqual(request.minimumCompressedBodySize, self.request.minimumCompressedBodySize, @"The minimum compressed body size was not copied correctly");
+    XCTAssertEqual(request.segmentCount, self.request.segmentCount, @"The segment count was not copied correctly");
+    XCTAssertEqual(request.minimumSegmentSize, self.request.minimumSegmentSize, @"The minimum segment size was not copied correctly");
+    XCTAssertEqualObjects(request.bodyFileURL, self.request.bodyFileURL, @"The body file URL was not copied correctly");
+    XCTAssertEqualObjects(request.sessionPartitionName, self.request.sessionPartitionName, @"The session partition name was not copied correctly");
+    XCTAssertEqual(request.persistsWhenOffline, self.request.persistsWhenOffline, @"The offline persistence was not copied correctly");
 }
 
 - (void)testAcceptLanguage
@@ -203,6 +221,19 @@
     XCTAssertNotNil(request.HTTPBodyStream, @"Should have created an HTTP body stream");
 }
 
+- (void)testFileURLIsNotLoadedIntoUrlRequest
+{
+    self.request.body = [@"body" dataUsingEncoding:NSUTF8StringEncoding];
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    self.request.minimumCompressedBodySize = 0;
+    self.request.bodyFileURL = [NSURL fileURLWithPath:@"/tmp/upload"];
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertNil(request.HTTPBody, @"The file should be left to the upload task");
+    XCTAssertNil(request.HTTPBodyStream);
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Encoding"]);
+    XCTAssertFalse(self.request.needsBodyCompression);
+}
+
 - (void)testHeadMethod
 {
     self.request.method = SPTDataLoaderRequestMethodHead;
@@ -215,4 +246,63 @@
     XCTAssertEqualObjects(self.request.urlRequest.HTTPMethod, @"PATCH");
 }
 
+- (void)testURLRequestCompressedBody
+{
+    NSData *data = [[@"" stringByPaddingToLength:4096 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    self.request.body = data;
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    XCTAssertTrue(self.request.needsBodyCompression);
+
+    [self.request compressBody];
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertFalse(self.request.needsBodyCompression);
+    XCTAssertEqualObjects(request.allHTTPHeaderFields[@"Content-Encoding"], @"gzip");
+    XCTAssertLessThan(request.HTTPBody.length, data.length, @"The body should have been compressed");
+    XCTAssertEqual(@([request.allHTTPHeaderFields[@"Content-Length"] integerValue]).unsignedIntegerValue, request.HTTPBody.length, @"The content-length header should be the compressed length");
+    XCTAssertEqual(self.request.uncompressedBodyLength, (int64_t)data.length);
+}
+
+- (void)testURLRequestSkipsCompressionBelowMinimumSize
+{
+    self.request.body = [@"Test" dataUsingEncoding:NSUTF8StringEncoding];
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionDeflate;
+    XCTAssertFalse(self.request.needsBodyCompression, @"Bodies below the minimum size should not be compressed");
+
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Encoding"]);
+    XCTAssertEqualObjects(request.HTTPBody, self.request.body);
+}
+
+- (void)testURLRequestRespectsExistingContentEncoding
+{
+    self.request.body = [[@"" stringByPaddingToLength:4096 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    [self.request addValue:@"br" forHeader:@"content-encoding"];
+    XCTAssertFalse(self.request.needsBodyCompression, @"Bodies that are encoded already should not be compressed");
+
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertEqualObjects([request valueForHTTPHeaderField:@"Content-Encoding"], @"br");
+    XCTAssertEqualObjects(request.HTTPBody, self.request.body);
+}
+
+- (void)testCompressedStreamIsNotWrappedByUrlRequest
+{
+    self.request.bodyStream = [NSInputStream inputStreamWithData:[@"Test" dataUsingEncoding:NSUTF8StringEncoding]];
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertEqualObjects(request.allHTTPHeaderFields[@"Content-Encoding"], @"gzip");
+    XCTAssertEqual(request.HTTPBodyStream, self.request.bodyStream, @"The stream should be compressed per task, not by the URL request");
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Length"]);
+}
+
+- (void)testStreamOfDownloadTaskIsNotCompressed
+{
+    self.request.bodyStream = [NSInputStream inputStreamWithData:[@"Test" dataUsingEncoding:NSUTF8StringEncoding]];
+    self.request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    self.request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyAlways;
+    NSURLRequest *request = self.request.urlRequest;
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Encoding"]);
+    XCTAssertEqual(request.HTTPBodyStream, self.request.bodyStream);
+}
+
 @end
@@ -6,16 +6,12 @@
 #import <XCTest/XCTest.h>
 
 #import "SPTDataLoaderResolverAddress.h"
-
-@interface SPTDataLoaderResolverAddress (Tests)
-
-@property (nonatomic, assign) CFAbsoluteTime lastFailedTime;
-
-@end
+#import "SPTDataLoaderTimeProviderMock.h"
 
 @interface SPTDataLoaderResolverAddressTest : XCTestCase
 
 @property (nonatomic, strong) SPTDataLoaderResolverAddress *address;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
 
 @end
 
@@ -26,7 +22,10 @@
 - (void)setUp
 {
     [super setUp];
-    self.address = [SPTDataLoaderResolverAddress dataLoaderResolverAddressWithAddress:@"192.168.0.1"];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.timeProvider.currentTime = CFAbsoluteTimeGetCurrent();
+    self.address = [SPTDataLoaderResolverAddress dataLoaderResolverAddressWithAddress:@"192.168.0.1"
+                                                                         timeProvider:self.timeProvider];
 }
 
 #pragma mark SPTDataLoaderResolverAddressTest
@@ -53,4 +52,20 @@
     XCTAssertTrue(self.address.reachable, @"The address should be reachable");
 }
 
+- (void)testReachableAgainAfterStalePeriod
+{
+    [self.address failedToReach];
+    [self.timeProvider advanceTimeBy:60.0 * 60.0 + 1.0];
+    XCTAssertTrue(self.address.reachable, @"The address should be reachable once the stale period has passed");
+}
+
+- (void)testUnreachablePeriodIsConfigurable
+{
+    self.address.unreachablePeriod = 10.0;
+    [self.address failedToReach];
+    XCTAssertFalse(self.address.reachable);
+    [self.timeProvider advanceTimeBy:11.0];
+    XCTAssertTrue(self.address.reachable, @"The address should be reachable once its unreachable period has passed");
+}
+
 @end
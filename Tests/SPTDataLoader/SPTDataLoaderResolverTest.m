@@ -7,9 +7,18 @@
 
 #import <SPTDataLoader/SPTDataLoaderResolver.h>
 
+#import "SPTDataLoaderResolver+Private.h"
+#import "SPTDataLoaderResolverAddressSourceMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+static NSString * const SPTDataLoaderResolverTestHost = @"spclient.wg.spotify.com";
+
 @interface SPTDataLoaderResolverTest : XCTestCase
 
 @property (nonatomic, strong) SPTDataLoaderResolver *resolver;
+@property (nonatomic, strong) SPTDataLoaderResolverAddressSourceMock *addressSource;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
+@property (nonatomic, strong) NSURL *persistenceURL;
 
 @end
 
@@ -21,10 +30,28 @@
 {
     [super setUp];
     self.resolver = [SPTDataLoaderResolver new];
+    self.addressSource = [SPTDataLoaderResolverAddressSourceMock new];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.timeProvider.currentTime = CFAbsoluteTimeGetCurrent();
+    NSString *fileName = [NSString stringWithFormat:@"SPTDataLoaderResolverTest-%@.json", [NSUUID UUID].UUIDString];
+    self.persistenceURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.persistenceURL error:nil];
+    [super tearDown];
 }
 
 #pragma mark SPTDataLoaderResolverTest
 
+- (SPTDataLoaderResolver *)resolverWithAddressSource:(nullable id<SPTDataLoaderResolverAddressSource>)addressSource
+{
+    return [[SPTDataLoaderResolver alloc] initWithAddressSource:addressSource
+                                                 persistenceURL:self.persistenceURL
+                                                   timeProvider:self.timeProvider];
+}
+
 - (void)testNotNil
 {
     XCTAssertNotNil(self.resolver, @"The resolver should not be nil after construction");
@@ -56,4 +83,121 @@
     XCTAssertEqualObjects(host, URL.host, @"The address should not be overridden if unreachable");
 }
 
+- (void)testLookupResolvesInTheBackgroundWithoutWaiting
+{
+    // Given
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:self.addressSource];
+
+    // When
+    NSString *firstAddress = [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    NSString *secondAddress = [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.1" ] timeToLive:60.0];
+
+    // Then
+    XCTAssertEqualObjects(firstAddress, SPTDataLoaderResolverTestHost, @"The lookup should not wait for the source");
+    XCTAssertEqualObjects(secondAddress, SPTDataLoaderResolverTestHost);
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 1u, @"A host should only be resolved once at a time");
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], @"192.168.0.1");
+}
+
+- (void)testServesExpiredAddressesWhileRefreshing
+{
+    // Given
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:self.addressSource];
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.1" ] timeToLive:60.0];
+
+    // When
+    self.timeProvider.currentTime += 120.0;
+    NSString *staleAddress = [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.2" ] timeToLive:60.0];
+
+    // Then
+    XCTAssertEqualObjects(staleAddress, @"192.168.0.1", @"Expired addresses should be used until new ones arrive");
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 2u);
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], @"192.168.0.2");
+}
+
+- (void)testFailedResolutionKeepsTheAddresses
+{
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:self.addressSource];
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.1" ] timeToLive:60.0];
+
+    self.timeProvider.currentTime += 120.0;
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:nil timeToLive:0.0];
+
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], @"192.168.0.1");
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 2u, @"A failed resolution should not be retried on every lookup");
+}
+
+- (void)testRefreshesHostsInUseBeforeTheyExpire
+{
+    // Given
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:self.addressSource];
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.1" ] timeToLive:60.0];
+
+    // When
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.timeProvider advanceTimeBy:50.0];
+
+    // Then
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 2u, @"A host that is looked up should be refreshed before it expires");
+}
+
+- (void)testDoesNotRefreshHostsThatAreNoLongerUsed
+{
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:self.addressSource];
+    [resolver addressForHost:SPTDataLoaderResolverTestHost];
+    [self.addressSource completeWithAddresses:@[ @"192.168.0.1" ] timeToLive:60.0];
+
+    [self.timeProvider advanceTimeBy:120.0];
+
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 1u);
+}
+
+- (void)testExpiredAddressesAreNotUsedWithoutASource
+{
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:nil];
+    [resolver setAddresses:@[ @"192.168.0.1" ] forHost:SPTDataLoaderResolverTestHost timeToLive:60.0];
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], @"192.168.0.1");
+
+    self.timeProvider.currentTime += 61.0;
+
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], SPTDataLoaderResolverTestHost);
+}
+
+- (void)testAddressesArePersistedAcrossInstances
+{
+    // Given
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:nil];
+    [resolver setAddresses:@[ @"192.168.0.1", @"192.168.0.2" ] forHost:SPTDataLoaderResolverTestHost timeToLive:60.0];
+    [resolver markAddressAsUnreachable:@"192.168.0.1"];
+    [resolver flush];
+
+    // When
+    SPTDataLoaderResolver *relaunchedResolver = [self resolverWithAddressSource:self.addressSource];
+    self.timeProvider.currentTime += 120.0;
+    NSString *address = [relaunchedResolver addressForHost:SPTDataLoaderResolverTestHost];
+
+    // Then
+    XCTAssertEqualObjects(address, @"192.168.0.2", @"The first lookup should use the reachable address of the earlier launch");
+    XCTAssertEqual(self.addressSource.numberOfResolveCalls, 1u, @"The expired addresses should be refreshed");
+}
+
+- (void)testUnreachablePeriodIsConfigurable
+{
+    SPTDataLoaderResolver *resolver = [self resolverWithAddressSource:nil];
+    resolver.unreachablePeriod = 10.0;
+    [resolver setAddresses:@[ @"192.168.0.1" ] forHost:SPTDataLoaderResolverTestHost];
+    [resolver markAddressAsUnreachable:@"192.168.0.1"];
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], SPTDataLoaderResolverTestHost);
+
+    self.timeProvider.currentTime += 11.0;
+
+    XCTAssertEqualObjects([resolver addressForHost:SPTDataLoaderResolverTestHost], @"192.168.0.1");
+}
+
 @end
@@ -0,0 +1,216 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderSegmentedDownload.h"
+#import "SPTDataLoaderResponse+Private.h"
+#import "SPTDataLoaderRequestResponseHandlerDelegateMock.h"
+#import "SPTDataLoaderRequestResponseHandlerMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+@interface SPTDataLoaderSegmentedDownloadTest : XCTestCase <SPTDataLoaderSegmentedDownloadDelegate>
+
+@property (nonatomic, strong) SPTDataLoaderSegmentedDownload *segmentedDownload;
+@property (nonatomic, strong) SPTDataLoaderRequest *request;
+@property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler;
+@property (nonatomic, strong) SPTDataLoaderRequestResponseHandlerDelegateMock *requestResponseHandlerDelegate;
+@property (nonatomic, strong) NSData *resource;
+@property (nonatomic, assign) NSUInteger numberOfCallsToDidFinish;
+
+@end
+
+@implementation SPTDataLoaderSegmentedDownloadTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    self.resource = [@"0123456789" dataUsingEncoding:NSUTF8StringEncoding];
+    self.request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/asset"]
+                                       sourceIdentifier:nil];
+    self.request.segmentCount = 3;
+    self.request.minimumSegmentSize = 4;
+    self.requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    self.requestResponseHandlerDelegate = [SPTDataLoaderRequestResponseHandlerDelegateMock new];
+    self.segmentedDownload = [SPTDataLoaderSegmentedDownload segmentedDownloadWithRequest:self.request
+                                                                   requestResponseHandler:self.requestResponseHandler
+                                                           requestResponseHandlerDelegate:self.requestResponseHandlerDelegate
+                                                                             timeProvider:[SPTDataLoaderTimeProviderMock new]
+                                                                                 delegate:self];
+}
+
+#pragma mark SPTDataLoaderSegmentedDownloadTest
+
+- (void)testCanPerformRequest
+{
+    XCTAssertTrue([SPTDataLoaderSegmentedDownload canPerformRequest:self.request]);
+    self.request.chunks = YES;
+    XCTAssertFalse([SPTDataLoaderSegmentedDownload canPerformRequest:self.request], @"Chunked requests should not be segmented");
+    self.request.chunks = NO;
+    self.request.segmentCount = 1;
+    XCTAssertFalse([SPTDataLoaderSegmentedDownload canPerformRequest:self.request], @"A single segment is a regular download");
+}
+
+- (void)testSegmentsAreStitchedIntoSingleResponse
+{
+    [self.segmentedDownload start];
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u, @"Only the probe should be performed before the size is known");
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsPerformed[0].headers[@"Range"], @"bytes=0-3");
+
+    [self respondToRequest:self.requestResponseHandlerDelegate.requestsPerformed[0] contentRange:nil];
+    NSArray<SPTDataLoaderRequest *> *requests = self.requestResponseHandlerDelegate.requestsPerformed;
+    XCTAssertEqual(requests.count, 3u);
+    XCTAssertEqualObjects(requests[1].headers[@"Range"], @"bytes=4-6");
+    XCTAssertEqualObjects(requests[2].headers[@"Range"], @"bytes=7-9");
+    XCTAssertEqualObjects(requests[1].headers[@"If-Range"], @"\"v1\"", @"The segments should be tied to the probed resource");
+
+    [self respondToRequest:requests[2] contentRange:nil];
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 0u, @"The response should wait for every segment");
+    [self respondToRequest:requests[1] contentRange:nil];
+
+    SPTDataLoaderResponse *response = self.requestResponseHandler.lastReceivedResponse;
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+    XCTAssertEqual(response.request, self.request);
+    XCTAssertEqual(response.statusCode, SPTDataLoaderResponseHTTPStatusCodeOK);
+    XCTAssertEqualObjects(response.body, self.resource);
+    XCTAssertEqualObjects(response.responseHeaders[@"Content-Length"], @"10");
+    XCTAssertNil(response.responseHeaders[@"Content-Range"]);
+    XCTAssertEqual(self.numberOfCallsToDidFinish, 1u);
+}
+
+- (void)testRegularDownloadWhenServerIgnoresRange
+{
+    [self.segmentedDownload start];
+    SPTDataLoaderRequest *probe = self.requestResponseHandlerDelegate.requestsPerformed[0];
+    NSHTTPURLResponse *URLResponse = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                                 statusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                                HTTPVersion:@"1.1"
+                                                               headerFields:@{}];
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:probe response:URLResponse];
+    [self.segmentedDownload receivedInitialResponse:response];
+    [self.segmentedDownload receivedDataChunk:self.resource forResponse:response completionHandler:^{}];
+    [self.segmentedDownload successfulResponse:response];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u);
+    XCTAssertEqualObjects(self.requestResponseHandler.lastReceivedResponse.body, self.resource);
+}
+
+- (void)testMismatchedSegmentIsRetriedIndividually
+{
+    self.request.maximumRetryCount = 1;
+    [self.segmentedDownload start];
+    [self respondToRequest:self.requestResponseHandlerDelegate.requestsPerformed[0] contentRange:nil];
+    NSArray<SPTDataLoaderRequest *> *requests = [self.requestResponseHandlerDelegate.requestsPerformed copy];
+
+    [self respondToRequest:requests[1] contentRange:@"bytes 4-6/11"];
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 4u, @"Only the mismatched segment should be retried");
+    SPTDataLoaderRequest *retry = self.requestResponseHandlerDelegate.requestsPerformed.lastObject;
+    XCTAssertEqualObjects(retry.headers[@"Range"], @"bytes=4-6");
+
+    [self respondToRequest:retry contentRange:nil];
+    [self respondToRequest:requests[2] contentRange:nil];
+    XCTAssertEqual(self.requestResponseHandler.numberOfSuccessfulDataResponseCalls, 1u);
+    XCTAssertEqualObjects(self.requestResponseHandler.lastReceivedResponse.body, self.resource);
+}
+
+- (void)testMismatchedSegmentFailsOnceRetriesAreExhausted
+{
+    [self.segmentedDownload start];
+    [self respondToRequest:self.requestResponseHandlerDelegate.requestsPerformed[0] contentRange:nil];
+    NSArray<SPTDataLoaderRequest *> *requests = [self.requestResponseHandlerDelegate.requestsPerformed copy];
+
+    [self respondToRequest:requests[1] contentRange:@"bytes 0-2/10"];
+
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    XCTAssertEqual(self.requestResponseHandler.lastReceivedResponse.error.code, SPTDataLoaderRequestErrorSegmentVerificationFailed);
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsCancelled, @[ requests[2] ], @"The remaining segment should be cancelled");
+}
+
+- (void)testResourceLargerThanMaximumResponseBodySizeIsNotPlanned
+{
+    self.segmentedDownload.maximumResponseBodySize = 1024;
+    [self.segmentedDownload start];
+    SPTDataLoaderRequest *probe = self.requestResponseHandlerDelegate.requestsPerformed[0];
+    NSHTTPURLResponse *URLResponse = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                                 statusCode:SPTDataLoaderResponseHTTPStatusCodePartialContent
+                                                                HTTPVersion:@"1.1"
+                                                               headerFields:@{ @"Content-Range" : @"bytes 0-3/1099511627776" }];
+    [self.segmentedDownload receivedInitialResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:probe response:URLResponse]];
+
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 1u, @"No segments should be planned for the announced total");
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsCancelled, @[ probe ]);
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    XCTAssertEqual(self.requestResponseHandler.lastReceivedResponse.error.code, SPTDataLoaderRequestErrorResponseTooLarge);
+    XCTAssertEqual(self.numberOfCallsToDidFinish, 1u);
+}
+
+- (void)testFailedSegmentFailsDownload
+{
+    [self.segmentedDownload start];
+    [self respondToRequest:self.requestResponseHandlerDelegate.requestsPerformed[0] contentRange:nil];
+    NSArray<SPTDataLoaderRequest *> *requests = [self.requestResponseHandlerDelegate.requestsPerformed copy];
+
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:requests[2] response:nil];
+    response.error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+    [self.segmentedDownload failedResponse:response];
+
+    XCTAssertEqual(self.requestResponseHandler.numberOfFailedResponseCalls, 1u);
+    XCTAssertEqual(self.requestResponseHandler.lastReceivedResponse.request, self.request);
+    XCTAssertEqual(self.requestResponseHandler.lastReceivedResponse.error.code, NSURLErrorNetworkConnectionLost);
+    XCTAssertEqualObjects(self.requestResponseHandlerDelegate.requestsCancelled, @[ requests[1] ]);
+}
+
+- (void)testCancelledSegmentCancelsDownload
+{
+    [self.segmentedDownload start];
+    [self respondToRequest:self.requestResponseHandlerDelegate.requestsPerformed[0] contentRange:nil];
+    NSArray<SPTDataLoaderRequest *> *requests = [self.requestResponseHandlerDelegate.requestsPerformed copy];
+
+    [self.segmentedDownload cancel];
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsCancelled.count, 2u);
+    [self.segmentedDownload cancelledRequest:requests[1]];
+    [self.segmentedDownload cancelledRequest:requests[2]];
+
+    XCTAssertEqual(self.requestResponseHandler.numberOfCancelledRequestCalls, 1u);
+    XCTAssertEqual(self.numberOfCallsToDidFinish, 1u);
+}
+
+#pragma mark SPTDataLoaderSegmentedDownloadDelegate
+
+- (void)segmentedDownloadDidFinish:(SPTDataLoaderSegmentedDownload *)segmentedDownload
+{
+    self.numberOfCallsToDidFinish++;
+}
+
+#pragma mark Private
+
+- (void)respondToRequest:(SPTDataLoaderRequest *)request contentRange:(nullable NSString *)contentRange
+{
+    NSString *range = [request.headers[@"Range"] substringFromIndex:@"bytes=".length];
+    NSArray<NSString *> *bounds = [range componentsSeparatedByString:@"-"];
+    NSUInteger firstByte = (NSUInteger)bounds[0].integerValue;
+    NSUInteger lastByte = (NSUInteger)bounds[1].integerValue;
+    NSDictionary *headers = @{
+        @"Content-Range" : contentRange ?: [NSString stringWithFormat:@"bytes %lu-%lu/%lu", (unsigned long)firstByte, (unsigned long)lastByte, (unsigned long)self.resource.length],
+        @"ETag" : @"\"v1\"",
+    };
+    NSHTTPURLResponse *URLResponse = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                                 statusCode:SPTDataLoaderResponseHTTPStatusCodePartialContent
+                                                                HTTPVersion:@"1.1"
+                                                               headerFields:headers];
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:URLResponse];
+
+    [self.segmentedDownload receivedInitialResponse:response];
+    NSData *data = [self.resource subdataWithRange:NSMakeRange(firstByte, lastByte - firstByte + 1)];
+    [self.segmentedDownload receivedDataChunk:data forResponse:response completionHandler:^{}];
+    [self.segmentedDownload successfulResponse:response];
+}
+
+@end
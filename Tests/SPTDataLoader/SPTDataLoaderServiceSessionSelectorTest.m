@@ -0,0 +1,172 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderSessionPartition.h>
+#import <SPTDataLoader/SPTDataLoaderSessionStatistics.h>
+
+#import "SPTDataLoaderServiceSessionSelector.h"
+#import "NSURLSessionDataTaskMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+@interface SPTDataLoaderServiceSessionSelectorTest : XCTestCase <NSURLSessionDelegate>
+
+@property (nonatomic, strong) SPTDataLoaderServiceDefaultSessionSelector *sessionSelector;
+@property (nonatomic, strong) SPTDataLoaderTimeProviderMock *timeProvider;
+@property (nonatomic, strong) SPTDataLoaderSessionPartition *bulkPartition;
+@property (nonatomic, strong) SPTDataLoaderSessionPartition *apiPartition;
+
+@end
+
+@implementation SPTDataLoaderServiceSessionSelectorTest
+
+#pragma mark XCTestCase
+
+- (void)setUp
+{
+    [super setUp];
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    configuration.HTTPAdditionalHeaders = @{ @"User-Agent" : @"Spotify Test 1.0" };
+    self.sessionSelector = [[SPTDataLoaderServiceDefaultSessionSelector alloc] initWithConfiguration:configuration
+                                                                                            delegate:self
+                                                                                       delegateQueue:[NSOperationQueue new]];
+    self.timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.sessionSelector.timeProvider = self.timeProvider;
+
+    NSURLSessionConfiguration *bulkConfiguration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    bulkConfiguration.HTTPMaximumConnectionsPerHost = 2;
+    self.bulkPartition = [SPTDataLoaderSessionPartition partitionWithName:@"bulk"
+                                                            configuration:bulkConfiguration
+                                                                  matcher:^BOOL(SPTDataLoaderRequest *request) {
+                                                                      return [request.sourceIdentifier isEqualToString:@"downloads"];
+                                                                  }];
+    self.bulkPartition.idleTimeout = 10.0;
+    self.apiPartition = [SPTDataLoaderSessionPartition partitionWithName:@"api"
+                                                           configuration:[NSURLSessionConfiguration ephemeralSessionConfiguration]
+                                                                   hosts:[NSSet setWithObject:@"API.spotify.com"]];
+    [self.sessionSelector setPartitions:@[ self.bulkPartition, self.apiPartition ]];
+}
+
+- (void)tearDown
+{
+    [self.sessionSelector invalidateAndCancel];
+    [super tearDown];
+}
+
+#pragma mark SPTDataLoaderServiceSessionSelectorTest
+
+- (void)testPartitionSessionsAreCreatedLazily
+{
+    NSArray<SPTDataLoaderSessionStatistics *> *statistics = [self.sessionSelector statistics];
+    XCTAssertEqual(statistics.count, 3u);
+    XCTAssertNil(statistics[0].partitionName, @"The service configuration should come first");
+    XCTAssertEqualObjects(statistics[1].partitionName, @"bulk");
+    XCTAssertEqualObjects(statistics[2].partitionName, @"api");
+    for (SPTDataLoaderSessionStatistics *partitionStatistics in statistics) {
+        XCTAssertFalse(partitionStatistics.sessionActive);
+        XCTAssertEqual(partitionStatistics.sessionCreationCount, 0u);
+    }
+}
+
+- (void)testRequestsAreRoutedToPartitions
+{
+    NSURLSession *defaultSession = [self.sessionSelector URLSessionForRequest:[self requestWithURLString:@"https://spclient.wg.spotify.com" sourceIdentifier:nil]];
+    NSURLSession *bulkSession = [self.sessionSelector URLSessionForRequest:[self requestWithURLString:@"https://spclient.wg.spotify.com" sourceIdentifier:@"downloads"]];
+    NSURLSession *apiSession = [self.sessionSelector URLSessionForRequest:[self requestWithURLString:@"https://api.spotify.com/v1/me" sourceIdentifier:nil]];
+
+    XCTAssertNotEqual(defaultSession, bulkSession);
+    XCTAssertNotEqual(defaultSession, apiSession);
+    XCTAssertNotEqual(bulkSession, apiSession);
+    XCTAssertEqual(bulkSession.configuration.HTTPMaximumConnectionsPerHost, 2);
+    XCTAssertEqualObjects(apiSession.configuration.HTTPAdditionalHeaders[@"User-Agent"], @"Spotify Test 1.0", @"Partitions should inherit the headers of the service");
+
+    SPTDataLoaderRequest *namedRequest = [self requestWithURLString:@"https://api.spotify.com/v1/me" sourceIdentifier:nil];
+    namedRequest.sessionPartitionName = @"bulk";
+    XCTAssertEqual([self.sessionSelector URLSessionForRequest:namedRequest], bulkSession, @"The named partition should win over matchers");
+    namedRequest.sessionPartitionName = @"unknown";
+    XCTAssertEqual([self.sessionSelector URLSessionForRequest:namedRequest], defaultSession);
+}
+
+- (void)testStatisticsCountTasksOfPartition
+{
+    SPTDataLoaderRequest *request = [self requestWithURLString:@"https://api.spotify.com/v1/me" sourceIdentifier:nil];
+    NSURLSession *session = [self.sessionSelector URLSessionForRequest:request];
+    NSURLSessionDataTaskMock *succeedingTask = [NSURLSessionDataTaskMock new];
+    NSURLSessionDataTaskMock *failingTask = [NSURLSessionDataTaskMock new];
+    [self.sessionSelector URLSession:session didCreateTask:succeedingTask];
+    [self.sessionSelector URLSession:session didCreateTask:failingTask];
+
+    self.timeProvider.currentTime += 2.0;
+    [self.sessionSelector URLSession:session didCompleteTask:succeedingTask error:nil];
+    XCTAssertEqual([self.sessionSelector statistics][2].inFlightTaskCount, 1u);
+
+    self.timeProvider.currentTime += 2.0;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    [self.sessionSelector URLSession:session didCompleteTask:failingTask error:error];
+    [self.sessionSelector URLSession:session didCompleteTask:failingTask error:error];
+
+    SPTDataLoaderSessionStatistics *statistics = [self.sessionSelector statistics][2];
+    XCTAssertEqual(statistics.taskCount, 2u);
+    XCTAssertEqual(statistics.inFlightTaskCount, 0u);
+    XCTAssertEqual(statistics.failedTaskCount, 1u, @"A task completing twice should only be counted once");
+    XCTAssertEqualWithAccuracy(statistics.averageTaskDuration, 3.0, DBL_EPSILON);
+    XCTAssertEqual([self.sessionSelector statistics][0].taskCount, 0u);
+}
+
+- (void)testIdleSessionIsTornDown
+{
+    SPTDataLoaderRequest *request = [self requestWithURLString:@"https://spclient.wg.spotify.com" sourceIdentifier:@"downloads"];
+    NSURLSession *session = [self.sessionSelector URLSessionForRequest:request];
+    NSURLSessionDataTaskMock *task = [NSURLSessionDataTaskMock new];
+    [self.sessionSelector URLSession:session didCreateTask:task];
+    [self.sessionSelector URLSession:session didCompleteTask:task error:nil];
+
+    [self.timeProvider advanceTimeBy:9.0];
+    XCTAssertTrue([self.sessionSelector statistics][1].sessionActive);
+    [self.timeProvider advanceTimeBy:1.0];
+    XCTAssertFalse([self.sessionSelector statistics][1].sessionActive, @"The session should be torn down after its idle timeout");
+
+    NSURLSession *newSession = [self.sessionSelector URLSessionForRequest:request];
+    XCTAssertNotEqual(newSession, session);
+    XCTAssertEqual([self.sessionSelector statistics][1].sessionCreationCount, 2u);
+}
+
+- (void)testBusySessionIsNotTornDown
+{
+    SPTDataLoaderRequest *request = [self requestWithURLString:@"https://spclient.wg.spotify.com" sourceIdentifier:@"downloads"];
+    NSURLSession *session = [self.sessionSelector URLSessionForRequest:request];
+    NSURLSessionDataTaskMock *firstTask = [NSURLSessionDataTaskMock new];
+    NSURLSessionDataTaskMock *secondTask = [NSURLSessionDataTaskMock new];
+    [self.sessionSelector URLSession:session didCreateTask:firstTask];
+    [self.sessionSelector URLSession:session didCompleteTask:firstTask error:nil];
+    [self.sessionSelector URLSession:session didCreateTask:secondTask];
+
+    [self.timeProvider advanceTimeBy:60.0];
+
+    XCTAssertTrue([self.sessionSelector statistics][1].sessionActive);
+    XCTAssertEqual([self.sessionSelector URLSessionForRequest:request], session);
+}
+
+- (void)testReplacedPartitionsAreInvalidated
+{
+    SPTDataLoaderRequest *request = [self requestWithURLString:@"https://api.spotify.com/v1/me" sourceIdentifier:nil];
+    NSURLSession *apiSession = [self.sessionSelector URLSessionForRequest:request];
+
+    [self.sessionSelector setPartitions:@[ self.bulkPartition ]];
+
+    XCTAssertEqual([self.sessionSelector statistics].count, 2u);
+    XCTAssertNotEqual([self.sessionSelector URLSessionForRequest:request], apiSession);
+}
+
+#pragma mark Private
+
+- (SPTDataLoaderRequest *)requestWithURLString:(NSString *)URLString sourceIdentifier:(nullable NSString *)sourceIdentifier
+{
+    return [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:URLString] sourceIdentifier:sourceIdentifier];
+}
+
+@end
@@ -4,6 +4,7 @@
  */
 
 #import <XCTest/XCTest.h>
+#import <zlib.h>
 
 #import <SPTDataLoader/SPTDataLoader.h>
 #import "SPTDataLoaderService+Private.h"
@@ -19,6 +20,7 @@
 #import "SPTDataLoaderConsumptionObserverMock.h"
 #import "NSURLSessionDataTaskMock.h"
 #import "NSURLSessionDownloadTaskMock.h"
+#import "NSURLSessionUploadTaskMock.h"
 #import "SPTDataLoaderRequest+Private.h"
 #import "NSURLSessionTaskMock.h"
 #import "SPTDataLoaderServerTrustPolicyMock.h"
@@ -27,16 +29,20 @@
 #import "NSFileManagerMock.h"
 #import "NSDataMock.h"
 #import "SPTDataLoaderServiceSessionSelectorMock.h"
+#import "SPTDataLoaderDelegateMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+#import "SPTDataLoaderTracerMock.h"
 
 @interface SPTDataLoaderService () <NSURLSessionDataDelegate, SPTDataLoaderRequestResponseHandlerDelegate, SPTDataLoaderCancellationTokenDelegate, NSURLSessionTaskDelegate, NSURLSessionDownloadDelegate>
 
 @property (nonatomic, strong) NSOperationQueue *sessionQueue;
-@property (nonatomic, strong) NSMutableArray *handlers;
+@property (nonatomic, strong) NSMapTable<NSURLSessionTask *, SPTDataLoaderRequestTaskHandler *> *handlersByTask;
 @property (nonatomic, strong) SPTDataLoaderServerTrustPolicy *serverTrustPolicy;
 @property (nonatomic, weak) NSFileManager * _Nullable fileManager;
 @property (nonatomic, weak) Class _Nullable dataClass;
 
 - (void)cancelAllLoads;
+- (void)setTask:(NSURLSessionTask *)task ofHandler:(SPTDataLoaderRequestTaskHandler *)handler;
 
 @end
 
@@ -150,6 +156,132 @@
     XCTAssertEqualObjects(request.URL.absoluteString, @"https://192.168.0.1/thing");
 }
 
+- (void)testUnreachableFailureQueuesURLBeforeResolution
+{
+    NSString *fileName = [NSString stringWithFormat:@"SPTDataLoaderServiceTest-%@.journal", [NSUUID UUID].UUIDString];
+    NSURL *journalURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtURL:journalURL error:nil];
+    }];
+    SPTDataLoaderMutationQueue *mutationQueue = [SPTDataLoaderMutationQueue mutationQueueWithJournalURL:journalURL error:nil];
+    SPTDataLoaderFactory *factory = [self.service createDataLoaderFactoryWithAuthorisers:nil];
+    factory.mutationQueue = mutationQueue;
+    [self.resolver setAddresses:@[ @"192.168.0.1" ] forHost:@"spclient.wg.spotify.com"];
+
+    // Given
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/playlist"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:nil];
+    request.method = SPTDataLoaderRequestMethodDelete;
+    request.persistsWhenOffline = YES;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [factory requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    XCTAssertEqualObjects(request.URL.absoluteString, @"https://192.168.0.1/playlist");
+
+    // When
+    [self.service URLSession:self.session
+                        task:self.session.lastDataTask
+        didCompleteWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotFindHost userInfo:nil]];
+
+    // Then
+    XCTAssertEqual(requestResponseHandlerMock.lastReceivedResponse.error.code, SPTDataLoaderRequestErrorQueuedForReplay);
+    XCTAssertEqual(mutationQueue.pendingRequests.count, 1u);
+    XCTAssertEqualObjects(mutationQueue.pendingRequests.firstObject.URL, URL,
+                          @"The journal should keep the URL the request was made for rather than its resolved address");
+}
+
+- (void)testHostPartitionMatchesHostBeforeResolution
+{
+    SPTDataLoaderService *service = [SPTDataLoaderService dataLoaderServiceWithUserAgent:@"Spotify Test 1.0"
+                                                                            rateLimiter:nil
+                                                                               resolver:self.resolver
+                                                               customURLProtocolClasses:nil];
+    [self addTeardownBlock:^{
+        [service invalidateAndCancel];
+    }];
+    [service setSessionPartitions:@[ [SPTDataLoaderSessionPartition partitionWithName:@"api"
+                                                                        configuration:[NSURLSessionConfiguration ephemeralSessionConfiguration]
+                                                                                hosts:[NSSet setWithObject:@"api.spotify.com"]] ]];
+    [self.resolver setAddresses:@[ @"192.168.0.1" ] forHost:@"api.spotify.com"];
+
+    // Given
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://api.spotify.com/v1/me"]
+                                                        sourceIdentifier:nil];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+
+    // When
+    [service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+
+    // Then
+    XCTAssertEqualObjects(request.URL.host, @"192.168.0.1");
+    NSArray<SPTDataLoaderSessionStatistics *> *statistics = [service sessionStatistics];
+    XCTAssertTrue(statistics[1].sessionActive, @"The request should be routed on the host it was made for");
+    XCTAssertFalse(statistics[0].sessionActive);
+}
+
+{
+    [self.resolver setAddresses:@[ @"192.168.0.1" ] forHost:@"spclient.wg.spotify.com"];
+    [self.service prewarmHosts:@[ @"spclient.wg.spotify.com" ] completion:nil];
+    XCTAssertEqualObjects(self.session.lastRequest.URL.absoluteString, @"https://192.168.0.1/");
+    XCTAssertEqualObjects(self.session.lastRequest.HTTPMethod, @"HEAD");
+    XCTAssertEqual(self.session.lastDataTask.numberOfCallsToResume, 1u, @"The service did not start the pre-warm task");
+}
+
+- (void)testPrewarmHostReportedWarmOnResponse
+{
+    __block NSString *warmHost = nil;
+    __block NSError *warmError = [NSError errorWithDomain:@"never.called" code:0 userInfo:nil];
+    [self.service prewarmHosts:@[ @"spclient.wg.spotify.com" ] completion:^(NSString *host, NSTimeInterval duration, NSError *error) {
+        warmHost = host;
+        warmError = error;
+        XCTAssertGreaterThanOrEqual(duration, 0.0);
+    }];
+    __block NSURLSessionResponseDisposition responseDisposition = NSURLSessionResponseAllow;
+    [self.service URLSession:self.session
+                    dataTask:self.session.lastDataTask
+          didReceiveResponse:[NSURLResponse new]
+           completionHandler:^(NSURLSessionResponseDisposition disposition) {
+               responseDisposition = disposition;
+           }];
+    XCTAssertEqualObjects(warmHost, @"spclient.wg.spotify.com");
+    XCTAssertNil(warmError);
+    XCTAssertEqual(responseDisposition, NSURLSessionResponseCancel, @"The pre-warm task should not load the response body");
+}
+
+- (void)testPrewarmHostReportsConnectionError
+{
+    NSError *connectionError = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorSecureConnectionFailed userInfo:nil];
+    __block NSUInteger numberOfCallsToCompletion = 0;
+    __block NSError *warmError = nil;
+    [self.service prewarmHosts:@[ @"spclient.wg.spotify.com" ] completion:^(NSString *host, NSTimeInterval duration, NSError *error) {
+        numberOfCallsToCompletion++;
+        warmError = error;
+    }];
+    [self.service URLSession:self.session task:self.session.lastDataTask didCompleteWithError:connectionError];
+    [self.service URLSession:self.session task:self.session.lastDataTask didCompleteWithError:connectionError];
+    XCTAssertEqual(numberOfCallsToCompletion, 1u);
+    XCTAssertEqualObjects(warmError, connectionError);
+}
+
+- (void)testPrewarmHostRespectsRateLimiter
+{
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/"];
+    [self.rateLimiter setRequestsPerSecond:1.0 forURL:URL];
+    [self.rateLimiter executedRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:nil]];
+    [self.service prewarmHosts:@[ @"spclient.wg.spotify.com" ] completion:nil];
+    XCTAssertNil(self.session.lastDataTask, @"The pre-warm should wait while the host is throttled");
+}
+
+- (void)testPrewarmHostDoesNotUseRateLimiterBudget
+{
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/"];
+    [self.rateLimiter setRequestsPerSecond:1.0 forURL:URL];
+    [self.service prewarmHosts:@[ @"spclient.wg.spotify.com" ] completion:nil];
+    XCTAssertNotNil(self.session.lastDataTask);
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:nil];
+    XCTAssertEqualWithAccuracy([self.rateLimiter earliestTimeUntilRequestCanBeExecuted:request], 0.0, DBL_EPSILON,
+                               @"The pre-warm should leave the budget of the host to the requests it warms up for");
+}
+
 - (void)testAuthenticatingRequest
 {
     SPTDataLoaderAuthoriserMock *authoriserMock = [SPTDataLoaderAuthoriserMock new];
@@ -195,6 +327,26 @@
     XCTAssertTrue(calledCompletionHandler, @"The service did not call the URL sessions completion handler");
 }
 
+- (void)testPerformRequestsStartsATaskForEveryRequestInTheBatch
+{
+    // Given
+    NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 3; i++) {
+        SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
+        request.URL = (NSURL * _Nonnull)[NSURL URLWithString:[NSString stringWithFormat:@"https://spclient.wg.spotify.com/thing/%lu", (unsigned long)i]];
+        [requests addObject:request];
+    }
+
+    // When
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    [self.service requestResponseHandler:nil performRequests:requests];
+#pragma clang diagnostic pop
+
+    // Then
+    XCTAssertEqual(self.service.handlersByTask.count, 3u);
+}
+
 - (void)testStartingWithDownloadTask
 {
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
@@ -236,7 +388,7 @@
 #pragma clang diagnostic ignored "-Wnonnull"
     [self.service requestResponseHandler:nil performRequest:request];
 #pragma clang diagnostic pop
-    NSURLSessionTask *task = ((SPTDataLoaderRequestTaskHandler *)[self.service.handlers lastObject]).task;
+    NSURLSessionTask *task = self.service.handlersByTask.keyEnumerator.nextObject;
 
     NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc] initWithURL:request.URL
                                                                   statusCode:SPTDataLoaderResponseHTTPStatusCodeMovedPermanently
@@ -283,7 +435,7 @@
 #pragma clang diagnostic ignored "-Wnonnull"
     [self.service requestResponseHandler:nil performRequest:request];
 #pragma clang diagnostic pop
-    NSURLSessionTask *task = ((SPTDataLoaderRequestTaskHandler *)[self.service.handlers lastObject]).task;
+    NSURLSessionTask *task = self.service.handlersByTask.keyEnumerator.nextObject;
 
     NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc] initWithURL:request.URL
                                                                   statusCode:SPTDataLoaderResponseHTTPStatusCodeMovedPermanently
@@ -369,6 +521,40 @@
     XCTAssertEqual(requestResponseHandlerMock.numberOfSuccessfulDataResponseCalls, 1u, @"The service did not call successfully received response on the request response handler");
 }
 
+- (void)testSessionDownloadTaskLargerThanMaximumResponseBodySizeIsNotRead
+{
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
+    request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyOnDemand;
+    request.maximumResponseBodySize = 1024;
+    request.URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+
+    NSURLSessionDownloadTask *downloadTask = [self.session downloadTaskWithRequest:[NSURLRequest new]];
+    [self.service URLSession:self.session dataTask:self.session.lastDataTask didBecomeDownloadTask:downloadTask];
+
+    // Given
+    self.fileManager.fileSize = @(1024 * 1024);
+
+    // When
+    NSURL *tmpFileURL = (NSURL * _Nonnull)[NSURL URLWithString:@"file:///tmp/foo/bar.tmp"];
+    [self.service URLSession:self.session downloadTask:self.session.lastDownloadTask didFinishDownloadingToURL:tmpFileURL];
+
+    __block XCTestExpectation *expectation = [self expectationWithDescription:@"Service session queue did not continue after handling download data"];
+    [self.service.sessionQueue addOperationWithBlock:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    // Then
+    XCTAssertEqual(requestResponseHandlerMock.numberOfSuccessfulDataResponseCalls, 0u);
+    XCTAssertEqual(requestResponseHandlerMock.numberOfFailedResponseCalls, 1u);
+    NSError *error = requestResponseHandlerMock.lastReceivedResponse.error;
+    XCTAssertEqualObjects(error.domain, SPTDataLoaderRequestErrorDomain);
+    XCTAssertEqual(error.code, SPTDataLoaderRequestErrorResponseTooLarge);
+    XCTAssertNil(requestResponseHandlerMock.lastReceivedResponse.body, @"The downloaded file should not have been read");
+}
+
 - (void)testSessionWillCacheResponse
 {
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
@@ -417,9 +603,9 @@
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTask *task = [NSURLSessionDataTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     [self.service URLSession:self.session task:task didCompleteWithError:nil];
     XCTAssertEqual(consumptionObserver.numberOfCallsToEndedRequest, 1, @"There should be 1 call to the consumption observer when a request ends");
@@ -568,9 +754,9 @@
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     NSDictionary *headerFields = @{ @"Content-Size" : @"1000" };
     NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:URL
@@ -592,7 +778,7 @@
 #pragma clang diagnostic ignored "-Wnonnull"
     [self.service requestResponseHandler:nil performRequest:request];
 #pragma clang diagnostic pop
-    NSURLSessionTask *task = ((SPTDataLoaderRequestTaskHandler *)[self.service.handlers lastObject]).task;
+    NSURLSessionTask *task = self.service.handlersByTask.keyEnumerator.nextObject;
 
     [self.resolver setAddresses:@[ @"newhost" ] forHost:@"localhost"];
 
@@ -628,7 +814,7 @@
     [cancellationToken cancel];
     request.cancellationToken = cancellationToken;
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
-    XCTAssertEqual(self.service.handlers.count, 0u);
+    XCTAssertEqual(self.service.handlersByTask.count, 0u);
 }
 
 - (void)testDoNotPerformRequestThatHasNoURL
@@ -636,7 +822,7 @@
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
-    XCTAssertEqual(self.service.handlers.count, 0u);
+    XCTAssertEqual(self.service.handlersByTask.count, 0u);
 }
 
 - (void)testCancellingRequestFromHandler
@@ -645,13 +831,95 @@
     NSURL *URL = [NSURL URLWithString:@"https://localhost"];
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@""];
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionDataTaskMock *task = [NSURLSessionDataTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
     [self.service requestResponseHandler:requestResponseHandlerMock cancelRequest:request];
     XCTAssertEqual(task.numberOfCallsToCancel, 1u);
 }
 
+- (NSURLSessionDataTaskMock *)performRequestWithSourceIdentifier:(NSString *)sourceIdentifier tags:(NSSet<NSString *> *)tags
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:sourceIdentifier];
+    request.tags = tags;
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+    return self.session.lastDataTask;
+}
+
+- (void)testCancellingRequestsWithTag
+{
+    // Given
+    NSURLSessionDataTaskMock *prefetchTask = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet setWithObject:@"prefetch"]];
+    NSURLSessionDataTaskMock *feedTask = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet set]];
+    NSURLSessionDataTaskMock *otherPrefetchTask = [self performRequestWithSourceIdentifier:@"search" tags:[NSSet setWithObject:@"prefetch"]];
+
+    // When
+    [self.service cancelRequestsWithTag:@"prefetch"];
+
+    // Then
+    XCTAssertEqual(prefetchTask.numberOfCallsToCancel, 1u);
+    XCTAssertEqual(otherPrefetchTask.numberOfCallsToCancel, 1u);
+    XCTAssertEqual(feedTask.numberOfCallsToCancel, 0u, @"Requests without the tag should keep running");
+}
+
+- (void)testCancellingRequestsWithSourceIdentifierAsTag
+{
+    NSURLSessionDataTaskMock *feedTask = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet set]];
+    NSURLSessionDataTaskMock *searchTask = [self performRequestWithSourceIdentifier:@"search" tags:[NSSet set]];
+
+    [self.service cancelRequestsWithTag:@"feed"];
+
+    XCTAssertEqual(feedTask.numberOfCallsToCancel, 1u, @"A request should be tagged with its sourceIdentifier");
+    XCTAssertEqual(searchTask.numberOfCallsToCancel, 0u);
+}
+
+- (void)testCancellingRequestsWithTagGoesThroughTheirCancellationTokens
+{
+    // Given
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"feed"];
+    SPTDataLoaderCancellationTokenDelegateMock *delegate = [SPTDataLoaderCancellationTokenDelegateMock new];
+    SPTDataLoaderCancellationTokenImplementation *cancellationToken = [SPTDataLoaderCancellationTokenImplementation cancellationTokenImplementationWithDelegate:delegate
+                                                                                                                                                   cancelObject:request];
+    request.cancellationToken = cancellationToken;
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+
+    // When
+    [self.service cancelRequestsWithTag:@"feed"];
+
+    // Then
+    XCTAssertTrue(cancellationToken.cancelled);
+    XCTAssertEqual(delegate.numberOfCallsToCancellationTokenDidCancel, 1u, @"The data loader owning the token should be told about the cancellation");
+}
+
+- (void)testCompletedRequestsAreNotCancelledByTag
+{
+    NSURLSessionDataTaskMock *task = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet setWithObject:@"prefetch"]];
+    [self.service URLSession:self.session task:task didCompleteWithError:nil];
+
+    [self.service cancelRequestsWithTag:@"prefetch"];
+
+    XCTAssertEqual(task.numberOfCallsToCancel, 0u);
+    XCTAssertEqual(self.service.handlersByTask.count, 0u);
+}
+
+- (void)testSettingPriorityForRequestsWithTag
+{
+    // Given
+    NSURLSessionDataTaskMock *prefetchTask = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet setWithObject:@"prefetch"]];
+    NSURLSessionDataTaskMock *feedTask = [self performRequestWithSourceIdentifier:@"feed" tags:[NSSet set]];
+    SPTDataLoaderRequestTaskHandler *prefetchHandler = [self.service.handlersByTask objectForKey:prefetchTask];
+
+    // When
+    [self.service setPriority:NSURLSessionTaskPriorityLow forRequestsWithTag:@"prefetch"];
+
+    // Then
+    XCTAssertEqualWithAccuracy(prefetchTask.priority, NSURLSessionTaskPriorityLow, FLT_EPSILON);
+    XCTAssertEqualWithAccuracy(prefetchHandler.request.priority, NSURLSessionTaskPriorityLow, FLT_EPSILON, @"Retries should keep the new priority");
+    XCTAssertEqualWithAccuracy(feedTask.priority, NSURLSessionTaskPriorityDefault, FLT_EPSILON);
+}
+
 - (void)testNotRemovingHandlerIfRetrying
 {
     SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
@@ -660,14 +928,14 @@
     request.maximumRetryCount = 10;
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
 
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorDNSLookupFailed userInfo:nil];
     [self.service URLSession:self.session task:task didCompleteWithError:error];
 
-    XCTAssertEqual(self.service.handlers.count, 1u);
+    XCTAssertEqual(self.service.handlersByTask.count, 1u);
 }
 
 - (void)testRecreateTaskOnDidComplete
@@ -678,9 +946,9 @@
     request.maximumRetryCount = 10;
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
 
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorDNSLookupFailed userInfo:nil];
     [self.service URLSession:self.session task:task didCompleteWithError:error];
@@ -697,9 +965,9 @@
     request.maximumRetryCount = 10;
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
 
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     NSURLSessionTaskMock *otherTask = [NSURLSessionTaskMock new];
     NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorDNSLookupFailed userInfo:nil];
@@ -716,9 +984,9 @@
     request.maximumRetryCount = 10;
     [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
 
-    SPTDataLoaderRequestTaskHandler *handler = self.service.handlers.firstObject;
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
     NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
-    handler.task = task;
+    [self.service setTask:task ofHandler:handler];
 
     NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
     [self.service URLSession:self.session task:task didCompleteWithError:error];
@@ -766,4 +1034,589 @@
     XCTAssertEqual(requestResponseHandlerMock.numberOfCancelledRequestCalls, 1u);
 }
 
+- (void)testCompressingBodyBeforeCreatingTask
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.method = SPTDataLoaderRequestMethodPost;
+    request.body = [[@"" stringByPaddingToLength:4096 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"handlersByTask.count == 1"] evaluatedWithObject:self.service handler:nil];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    XCTAssertEqual(self.service.handlersByTask.count, 0u, @"The task should not be created until the body has been compressed");
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    NSURLRequest *urlRequest = self.session.lastRequest;
+    XCTAssertEqualObjects([urlRequest valueForHTTPHeaderField:@"Content-Encoding"], @"gzip");
+    XCTAssertLessThan(urlRequest.HTTPBody.length, request.body.length);
+}
+
+- (void)testCompressingFreshBodyStreamForEveryTask
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.method = SPTDataLoaderRequestMethodPost;
+    request.maximumRetryCount = 1;
+    NSData *body = [[@"" stringByPaddingToLength:256 * 1024 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    request.bodyStream = [NSInputStream inputStreamWithData:body];
+    request.bodyCompression = SPTDataLoaderRequestBodyCompressionGzip;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    requestResponseHandlerMock.bodyStreamData = body;
+
+    // Given
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    NSURLSessionUploadTask *task = self.session.lastUploadTask;
+    XCTAssertNotNil(task, @"A body stream should be uploaded by a streamed upload task");
+    XCTAssertEqualObjects([self.session.lastRequest valueForHTTPHeaderField:@"Content-Encoding"], @"gzip");
+    XCTAssertEqualObjects([self inflatedData:[self dataOfBodyStreamForTask:task]], body);
+
+    // When
+    [self.service URLSession:self.session
+                        task:task
+        didCompleteWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+
+    // Then
+    NSURLSessionUploadTask *retriedTask = self.session.lastUploadTask;
+    XCTAssertNotEqual(retriedTask, task, @"The retry should have created a new task");
+    XCTAssertEqualObjects([self inflatedData:[self dataOfBodyStreamForTask:retriedTask]], body,
+                          @"The retry should upload the whole body compressed from a new stream");
+    XCTAssertEqual(requestResponseHandlerMock.numberOfNewBodyStreamCalls, 2u);
+}
+
+- (void)testUncompressedBodyStreamUsesDataTask
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.method = SPTDataLoaderRequestMethodPost;
+    NSInputStream *bodyStream = [NSInputStream inputStreamWithData:[@"spotify" dataUsingEncoding:NSUTF8StringEncoding]];
+    request.bodyStream = bodyStream;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+
+    XCTAssertNotNil(self.session.lastDataTask, @"A body stream that is not compressed should be sent by a data task");
+    XCTAssertNil(self.session.lastUploadTask);
+    XCTAssertEqual(self.session.lastRequest.HTTPBodyStream, bodyStream);
+    XCTAssertNil([self.session.lastRequest valueForHTTPHeaderField:@"Content-Encoding"]);
+}
+
+- (void)testConsumptionObserverReportsUncompressedBytesUploaded
+{
+    __weak XCTestExpectation *expectation = [self expectationWithDescription:@"Test consumption observer uncompressed bytes"];
+    SPTDataLoaderConsumptionObserverMock *consumptionObserver = [SPTDataLoaderConsumptionObserverMock new];
+    consumptionObserver.endedRequestCallback = ^ {
+        [expectation fulfill];
+    };
+    [self.service addConsumptionObserver:consumptionObserver
+                                      on:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0)];
+
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.method = SPTDataLoaderRequestMethodPost;
+    request.body = [[@"" stringByPaddingToLength:4096 withString:@"spotify" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    request.bodyCompression = SPTDataLoaderRequestBodyCompressionDeflate;
+    [request compressBody];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    SPTDataLoaderRequestTaskHandler *handler = self.service.handlersByTask.objectEnumerator.nextObject;
+    NSURLSessionTaskMock *task = [NSURLSessionTaskMock new];
+    [self.service setTask:task ofHandler:handler];
+
+    [self.service URLSession:self.session task:task didCompleteWithError:nil];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertEqual(consumptionObserver.lastBytesUploaded, 0);
+    XCTAssertEqual(consumptionObserver.lastUncompressedBytesUploaded, 4096);
+}
+
+- (void)testRetryResumesWithRangeHeaders
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.maximumRetryCount = 1;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    NSURLSessionDataTask *task = self.session.lastDataTask;
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:URL
+                                                              statusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                             HTTPVersion:@"1.1"
+                                                            headerFields:@{ @"Accept-Ranges" : @"bytes", @"ETag" : @"\"v1\"" }];
+    [self.service URLSession:self.session dataTask:task didReceiveResponse:response completionHandler:^(NSURLSessionResponseDisposition disposition) {}];
+    [self.service URLSession:self.session dataTask:task didReceiveData:[@"Hello " dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.service URLSession:self.session
+                        task:task
+        didCompleteWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+
+    XCTAssertNotEqual(self.session.lastDataTask, task, @"The retry should have created a new task");
+    XCTAssertEqualObjects([self.session.lastRequest valueForHTTPHeaderField:@"Range"], @"bytes=6-");
+    XCTAssertEqualObjects([self.session.lastRequest valueForHTTPHeaderField:@"If-Range"], @"\"v1\"");
+}
+
+- (void)testRetryResumesDownloadTaskWithResumeData
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.maximumRetryCount = 1;
+    request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyAlways;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    NSURLSessionDownloadTask *task = self.session.lastDownloadTask;
+
+    NSData *resumeData = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                         code:NSURLErrorNetworkConnectionLost
+                                     userInfo:@{ NSURLSessionDownloadTaskResumeData : resumeData }];
+    [self.service URLSession:self.session task:task didCompleteWithError:error];
+
+    XCTAssertEqualObjects(self.session.lastResumeData, resumeData);
+    XCTAssertNotEqual(self.session.lastDownloadTask, task);
+}
+
+- (void)testSegmentedDownloadStartsWithRangedProbe
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.segmentCount = 4;
+    request.minimumSegmentSize = 1024;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+
+    XCTAssertEqualObjects([self.session.lastRequest valueForHTTPHeaderField:@"Range"], @"bytes=0-1023");
+
+    [self.service requestResponseHandler:requestResponseHandlerMock cancelRequest:request];
+    XCTAssertEqual(self.session.lastDataTask.numberOfCallsToCancel, 1u, @"Cancelling the request should cancel its segments");
+}
+
+- (void)testFileBodyIsUploadedFromFile
+{
+    NSURL *URL = [NSURL URLWithString:@"https://localhost"];
+    NSURL *fileURL = [NSURL fileURLWithPath:@"/tmp/upload"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.method = SPTDataLoaderRequestMethodPost;
+    request.bodyFileURL = fileURL;
+    request.backgroundPolicy = SPTDataLoaderRequestBackgroundPolicyAlways;
+    request.maximumRetryCount = 1;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+
+    NSURLSessionUploadTask *task = self.session.lastUploadTask;
+    XCTAssertNotNil(task);
+    XCTAssertNil(self.session.lastDownloadTask, @"The file should not be uploaded by a download task");
+    XCTAssertEqualObjects(self.session.lastUploadFileURL, fileURL);
+
+    self.session.lastUploadFileURL = nil;
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil];
+    [self.service URLSession:self.session task:task didCompleteWithError:error];
+
+    XCTAssertNotEqual(self.session.lastUploadTask, task, @"The retry should have created a new upload task");
+    XCTAssertEqualObjects(self.session.lastUploadFileURL, fileURL);
+}
+
+- (void)testTracerFollowsRequestFromSubmissionToDelegate
+{
+    // Given
+    SPTDataLoaderTracerMock *tracer = [SPTDataLoaderTracerMock new];
+    self.service.tracer = tracer;
+    SPTDataLoaderFactory *factory = [self.service createDataLoaderFactoryWithAuthorisers:@[ [SPTDataLoaderAuthoriserMock new] ]];
+    SPTDataLoader *dataLoader = [factory createDataLoader];
+    SPTDataLoaderDelegateMock *delegate = [SPTDataLoaderDelegateMock new];
+    dataLoader.delegate = delegate;
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:@"trace"];
+
+    // When
+    [dataLoader performRequest:request];
+    [self.service URLSession:self.session task:self.session.lastDataTask didCompleteWithError:nil];
+
+    // Then
+    NSArray<NSString *> *expectedEvents = @[ @"+submission",
+                                             @"+authorisation",
+                                             @"-authorisation",
+                                             @"-submission",
+                                             @"+rateLimiterWait",
+                                             @"-rateLimiterWait",
+                                             @"+task",
+                                             @"-task",
+                                             @"+completion",
+                                             @"-completion",
+                                             @"+delegateDelivery",
+                                             @"-delegateDelivery" ];
+    XCTAssertEqualObjects(tracer.events, expectedEvents, @"Every phase of the request should be traced in order");
+    XCTAssertEqual(delegate.numberOfCallsToSuccessfulResponse, 1u);
+}
+
+- (void)testTracerNotCalledOnceRemoved
+{
+    SPTDataLoaderTracerMock *tracer = [SPTDataLoaderTracerMock new];
+    self.service.tracer = tracer;
+    self.service.tracer = nil;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandlerMock = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:nil];
+
+    [self.service requestResponseHandler:requestResponseHandlerMock performRequest:request];
+    [self.service URLSession:self.session task:self.session.lastDataTask didCompleteWithError:nil];
+
+    XCTAssertEqual(tracer.events.count, 0u);
+}
+
+- (void)testTaskTimeoutShrinksToTheTimeLeftBeforeTheDeadline
+{
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    self.service.timeProvider = timeProvider;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:nil];
+    request.deadline = 105.0;
+
+    [self.service requestResponseHandler:requestResponseHandler performRequest:request];
+
+    XCTAssertEqualWithAccuracy(self.session.lastRequest.timeoutInterval, 5.0, 0.000001);
+}
+
+- (nullable SPTDataLoaderInFlightRequest *)inFlightRequestFor:(SPTDataLoaderRequest *)request
+{
+    for (SPTDataLoaderInFlightRequest *inFlightRequest in [self.service inFlightRequests]) {
+        if (inFlightRequest.request == request) {
+            return inFlightRequest;
+        }
+    }
+    return nil;
+}
+
+- (void)testInFlightRequestsFollowRequestsUntilTheyComplete
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    self.service.timeProvider = timeProvider;
+    SPTDataLoaderRequestResponseHandlerMock *authorisingHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    authorisingHandler.authorising = YES;
+    SPTDataLoaderRequest *authorisingRequest = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://api.spotify.com/authorised"]
+                                                                   sourceIdentifier:@"login"];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:@"search"];
+
+    // When
+    [self.service requestResponseHandler:authorisingHandler performRequest:authorisingRequest];
+    [timeProvider advanceTimeBy:2.0];
+    [self.service requestResponseHandler:requestResponseHandler performRequest:request];
+    NSURLSessionDataTask *task = self.session.lastDataTask;
+    [timeProvider advanceTimeBy:3.0];
+    [self.service URLSession:self.session dataTask:task didReceiveData:[@"thing" dataUsingEncoding:NSUTF8StringEncoding]];
+    [timeProvider advanceTimeBy:1.0];
+
+    // Then
+    NSArray<SPTDataLoaderInFlightRequest *> *inFlightRequests = [self.service inFlightRequests];
+    XCTAssertEqual(inFlightRequests.count, 2u);
+    XCTAssertEqual(inFlightRequests.firstObject.request, authorisingRequest, @"The oldest request should come first");
+    SPTDataLoaderInFlightRequest *authorising = [self inFlightRequestFor:authorisingRequest];
+    XCTAssertEqual(authorising.state, SPTDataLoaderInFlightRequestStateAuthorising);
+    XCTAssertEqualObjects(authorising.sourceIdentifier, @"login");
+    XCTAssertEqualWithAccuracy(authorising.age, 6.0, 0.000001);
+    XCTAssertEqualWithAccuracy(authorising.timeInState, 6.0, 0.000001);
+    SPTDataLoaderInFlightRequest *streaming = [self inFlightRequestFor:request];
+    XCTAssertEqual(streaming.state, SPTDataLoaderInFlightRequestStateStreaming);
+    XCTAssertEqualObjects(streaming.sourceIdentifier, @"search");
+    XCTAssertEqualWithAccuracy(streaming.age, 4.0, 0.000001);
+    XCTAssertEqualWithAccuracy(streaming.timeInState, 1.0, 0.000001);
+    XCTAssertEqual(streaming.receivedByteCount, 5);
+    XCTAssertEqual(streaming.retryCount, 0u);
+
+    [self.service URLSession:self.session task:task didCompleteWithError:nil];
+    [self.service requestResponseHandler:authorisingHandler authorisedRequest:authorisingRequest];
+    XCTAssertNil([self inFlightRequestFor:request], @"A completed request should no longer be in flight");
+    XCTAssertEqual([self inFlightRequestFor:authorisingRequest].state, SPTDataLoaderInFlightRequestStateRunning,
+                   @"An authorised request should move on to its task");
+}
+
+- (void)testWatchdogReportsStuckRequestsOnce
+{
+    // Given
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    timeProvider.currentTime = 100.0;
+    self.service.timeProvider = timeProvider;
+    SPTDataLoaderRequestResponseHandlerMock *authorisingHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    authorisingHandler.authorising = YES;
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:nil];
+    dispatch_queue_t queue = dispatch_queue_create("com.spotify.dataloader.test.watchdog", DISPATCH_QUEUE_SERIAL);
+    NSMutableArray<SPTDataLoaderInFlightRequest *> *reportedRequests = [NSMutableArray new];
+    [self.service startWatchdogWithThreshold:10.0 queue:queue handler:^(NSArray<SPTDataLoaderInFlightRequest *> *stuckRequests) {
+        [reportedRequests addObjectsFromArray:stuckRequests];
+    }];
+    [self.service requestResponseHandler:authorisingHandler performRequest:request];
+
+    // When
+    [timeProvider advanceTimeBy:5.0];
+    dispatch_sync(queue, ^{});
+    NSUInteger reportedBeforeThreshold = reportedRequests.count;
+    [timeProvider advanceTimeBy:30.0];
+    dispatch_sync(queue, ^{});
+
+    // Then
+    XCTAssertEqual(reportedBeforeThreshold, 0u);
+    XCTAssertEqual(reportedRequests.count, 1u, @"A request stuck in the same state should only be reported once");
+    XCTAssertEqual(reportedRequests.firstObject.request, request);
+    XCTAssertEqual(reportedRequests.firstObject.state, SPTDataLoaderInFlightRequestStateAuthorising);
+    XCTAssertGreaterThanOrEqual(reportedRequests.firstObject.timeInState, 10.0);
+}
+
+- (void)testStoppedWatchdogReportsNothing
+{
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    self.service.timeProvider = timeProvider;
+    SPTDataLoaderRequestResponseHandlerMock *authorisingHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    authorisingHandler.authorising = YES;
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"]
+                                                        sourceIdentifier:nil];
+    dispatch_queue_t queue = dispatch_queue_create("com.spotify.dataloader.test.watchdog", DISPATCH_QUEUE_SERIAL);
+    __block NSUInteger numberOfReports = 0;
+    [self.service startWatchdogWithThreshold:1.0 queue:queue handler:^(NSArray<SPTDataLoaderInFlightRequest *> *stuckRequests) {
+        numberOfReports++;
+    }];
+    [self.service requestResponseHandler:authorisingHandler performRequest:request];
+
+    [self.service stopWatchdog];
+    [timeProvider advanceTimeBy:10.0];
+    dispatch_sync(queue, ^{});
+
+    XCTAssertEqual(numberOfReports, 0u);
+    XCTAssertEqual(timeProvider.numberOfScheduledBlocks, 0u, @"A stopped watchdog should not schedule further checks");
+}
+
+- (void)followRedirectFromURL:(NSURL *)URL toURL:(NSURL *)redirectURL statusCode:(NSInteger)statusCode task:(NSURLSessionTask *)task
+{
+    NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc] initWithURL:URL
+                                                                  statusCode:statusCode
+                                                                 HTTPVersion:@"1.1"
+                                                                headerFields:@{ }];
+    [self.service URLSession:self.session
+                        task:task
+  willPerformHTTPRedirection:(NSHTTPURLResponse * _Nonnull)httpResponse
+                  newRequest:[NSURLRequest requestWithURL:redirectURL]
+           completionHandler:^(NSURLRequest *newURLRequest) {}];
+}
+
+- (void)testPermanentRedirectIsAppliedToLaterRequests
+{
+    // Given
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/thing"];
+    NSURL *redirectURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"];
+    SPTDataLoaderRequestResponseHandlerMock *firstHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:firstHandler performRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"]];
+    NSURLSessionDataTaskMock *firstTask = self.session.lastDataTask;
+    [self followRedirectFromURL:URL toURL:redirectURL statusCode:SPTDataLoaderResponseHTTPStatusCodeMovedPermanently task:firstTask];
+    [self.service URLSession:self.session task:firstTask didCompleteWithError:nil];
+
+    // When
+    SPTDataLoaderRequestResponseHandlerMock *secondHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    [self.service requestResponseHandler:secondHandler performRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"]];
+    [self.service URLSession:self.session task:self.session.lastDataTask didCompleteWithError:nil];
+
+    // Then
+    XCTAssertEqualObjects(self.session.lastRequest.URL, redirectURL, @"The request should be sent straight to the new location");
+    XCTAssertEqual(firstHandler.lastReceivedResponse.redirects.count, 1u);
+    XCTAssertFalse(firstHandler.lastReceivedResponse.redirects.firstObject.cached);
+    XCTAssertEqual(secondHandler.lastReceivedResponse.redirects.count, 1u);
+    XCTAssertTrue(secondHandler.lastReceivedResponse.redirects.firstObject.cached);
+    XCTAssertEqualObjects(secondHandler.lastReceivedResponse.redirects.firstObject.redirectURL, redirectURL);
+}
+
+- (void)testCachedRedirectsAreNotAppliedToRequestsStoppingRedirection
+{
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/thing"];
+    NSURL *redirectURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new]
+                          performRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"]];
+    [self followRedirectFromURL:URL toURL:redirectURL statusCode:SPTDataLoaderResponseHTTPStatusCodeMovedPermanently task:self.session.lastDataTask];
+
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    request.shouldStopRedirection = YES;
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+
+    XCTAssertEqualObjects(self.session.lastRequest.URL, URL);
+}
+
+- (void)testTemporaryRedirectIsNotAppliedToLaterRequests
+{
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://legacy.spotify.com/thing"];
+    NSURL *redirectURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/thing"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new]
+                          performRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"]];
+    [self followRedirectFromURL:URL toURL:redirectURL statusCode:SPTDataLoaderResponseHTTPStatusCodeFound task:self.session.lastDataTask];
+
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new]
+                          performRequest:[SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"]];
+
+    XCTAssertEqualObjects(self.session.lastRequest.URL, URL);
+}
+
+- (NSURLSessionDataTaskMock *)receiveLinkHeader:(NSString *)linkHeader forRequest:(SPTDataLoaderRequest *)request
+{
+    NSURLSessionDataTaskMock *task = self.session.lastDataTask;
+    NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc] initWithURL:request.URL
+                                                                  statusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                                 HTTPVersion:@"1.1"
+                                                                headerFields:@{ @"Link": linkHeader }];
+    [self.service URLSession:self.session
+                    dataTask:task
+          didReceiveResponse:(NSHTTPURLResponse * _Nonnull)httpResponse
+           completionHandler:^(NSURLSessionResponseDisposition disposition) {}];
+    return task;
+}
+
+- (void)testPreloadedResourceIsLoadedFromTheCache
+{
+    // Given
+    self.service.preloadPolicy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    NSURL *URL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"];
+    NSURL *preloadURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/style.css"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:URL sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+    NSURLSessionDataTaskMock *task = [self receiveLinkHeader:@"</style.css>; rel=preload" forRequest:request];
+    NSURLSessionDataTaskMock *preloadTask = self.session.lastDataTask;
+    XCTAssertNotEqual(preloadTask, task, @"The Link header should have started a preload");
+    XCTAssertEqualObjects(self.session.lastRequest.URL, preloadURL);
+
+    // When
+    NSHTTPURLResponse *preloadResponse = [[NSHTTPURLResponse alloc] initWithURL:preloadURL
+                                                                     statusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                                    HTTPVersion:@"1.1"
+                                                                   headerFields:@{ }];
+    [self.service URLSession:self.session
+                    dataTask:preloadTask
+          didReceiveResponse:(NSHTTPURLResponse * _Nonnull)preloadResponse
+           completionHandler:^(NSURLSessionResponseDisposition disposition) {}];
+    [self.service URLSession:self.session task:preloadTask didCompleteWithError:nil];
+    SPTDataLoaderRequest *claimingRequest = [SPTDataLoaderRequest requestWithURL:preloadURL sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:claimingRequest];
+
+    // Then
+    XCTAssertEqualObjects(self.session.lastRequest.URL, preloadURL);
+    XCTAssertEqual(self.session.lastRequest.cachePolicy, NSURLRequestReturnCacheDataElseLoad);
+    XCTAssertEqual(claimingRequest.cachePolicy, NSURLRequestUseProtocolCachePolicy, @"Only the task should load from the cache");
+}
+
+- (void)testCancellingRequestWaitingForPreload
+{
+    // Given
+    self.service.preloadPolicy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    NSURL *preloadURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/style.css"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"]
+                                                        sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+    [self receiveLinkHeader:@"</style.css>; rel=preload" forRequest:request];
+    NSURLSessionDataTaskMock *preloadTask = self.session.lastDataTask;
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *waitingRequest = [SPTDataLoaderRequest requestWithURL:preloadURL sourceIdentifier:@"waiting"];
+    [self.service requestResponseHandler:requestResponseHandler performRequest:waitingRequest];
+    XCTAssertEqual(self.session.lastDataTask, preloadTask, @"The request should wait for the preload in flight");
+    XCTAssertEqual([self inFlightRequestFor:waitingRequest].state, SPTDataLoaderInFlightRequestStateWaitingForPreload);
+
+    // When
+    [self.service requestResponseHandler:requestResponseHandler cancelRequest:waitingRequest];
+    [self.service URLSession:self.session task:preloadTask didCompleteWithError:nil];
+
+    // Then
+    XCTAssertNil([self inFlightRequestFor:waitingRequest]);
+    XCTAssertEqual(self.session.lastDataTask, preloadTask, @"A cancelled request should not be performed once the preload finishes");
+}
+
+- (void)testCancellingTagDropsRequestWaitingForPreload
+{
+    // Given
+    self.service.preloadPolicy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    NSURL *preloadURL = (NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/style.css"];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"]
+                                                        sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+    [self receiveLinkHeader:@"</style.css>; rel=preload" forRequest:request];
+    NSURLSessionDataTaskMock *preloadTask = self.session.lastDataTask;
+    SPTDataLoaderRequest *waitingRequest = [SPTDataLoaderRequest requestWithURL:preloadURL sourceIdentifier:@"waiting"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:waitingRequest];
+
+    // When
+    [self.service cancelRequestsWithTag:@"waiting"];
+    [self.service URLSession:self.session task:preloadTask didCompleteWithError:nil];
+
+    // Then
+    XCTAssertEqual(self.session.lastDataTask, preloadTask, @"A request whose tag was cancelled should not be performed");
+}
+
+- (void)testCancellingRequestCancelsItsPreloads
+{
+    self.service.preloadPolicy = [SPTDataLoaderPreloadPolicy preloadPolicy];
+    SPTDataLoaderRequestResponseHandlerMock *requestResponseHandler = [SPTDataLoaderRequestResponseHandlerMock new];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"]
+                                                        sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:requestResponseHandler performRequest:request];
+    [self receiveLinkHeader:@"</style.css>; rel=preload" forRequest:request];
+    NSURLSessionDataTaskMock *preloadTask = self.session.lastDataTask;
+
+    [self.service requestResponseHandler:requestResponseHandler cancelRequest:request];
+
+    XCTAssertEqual(preloadTask.numberOfCallsToCancel, 1u);
+}
+
+- (void)testLinkHeadersAreIgnoredWithoutPreloadPolicy
+{
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:@"https://spclient.wg.spotify.com/page"]
+                                                        sourceIdentifier:@"-"];
+    [self.service requestResponseHandler:[SPTDataLoaderRequestResponseHandlerMock new] performRequest:request];
+
+    NSURLSessionDataTaskMock *task = [self receiveLinkHeader:@"</style.css>; rel=preload" forRequest:request];
+
+    XCTAssertEqual(self.session.lastDataTask, task);
+}
+
+#pragma mark Private
+
+- (NSData *)dataOfBodyStreamForTask:(NSURLSessionTask *)task
+{
+    __block NSInputStream *bodyStream = nil;
+    [self.service URLSession:self.session task:task needNewBodyStream:^(NSInputStream * _Nullable stream) {
+        bodyStream = stream;
+    }];
+
+    NSMutableData *data = [NSMutableData data];
+    uint8_t buffer[4096];
+    [bodyStream open];
+    NSInteger length = 0;
+    while ((length = [bodyStream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [data appendBytes:buffer length:(NSUInteger)length];
+    }
+    [bodyStream close];
+    return data;
+}
+
+- (NSData *)inflatedData:(NSData *)data
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // Detect gzip and zlib headers automatically
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        return nil;
+    }
+
+    NSMutableData *inflatedData = [NSMutableData data];
+    uint8_t buffer[4096];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        [inflatedData appendBytes:buffer length:sizeof(buffer) - stream.avail_out];
+    }
+    inflateEnd(&stream);
+
+    return status == Z_STREAM_END ? inflatedData : nil;
+}
+
 @end
@@ -103,10 +103,25 @@
     request.chunks = YES;
     [self.dataLoader performRequest:request];
     SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
-    [self.dataLoader receivedDataChunk:[NSData new] forResponse:response];
+    [self.dataLoader receivedDataChunk:[NSData new] forResponse:response completionHandler:^{}];
     XCTAssertEqual(self.delegate.numberOfCallsToReceiveDataChunk, 1u, @"The data loader did not relay a received data chunk response to the delegate");
 }
 
+- (void)testReceivedDataChunkCompletesAfterDelegateConsumesIt
+{
+    self.delegate.supportChunks = YES;
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
+    request.chunks = YES;
+    [self.dataLoader performRequest:request];
+    SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
+    __block NSUInteger numberOfCallsToCompletionHandler = 0;
+    [self.dataLoader receivedDataChunk:[NSData new] forResponse:response completionHandler:^{
+        XCTAssertEqual(self.delegate.numberOfCallsToReceiveDataChunk, 1u, @"The chunk was acknowledged before the delegate received it");
+        numberOfCallsToCompletionHandler++;
+    }];
+    XCTAssertEqual(numberOfCallsToCompletionHandler, 1u, @"The data loader did not acknowledge the consumed data chunk");
+}
+
 - (void)testRelayReceivedInitialResponseToDelegate
 {
     self.delegate.supportChunks = YES;
@@ -163,6 +178,42 @@
     XCTAssertEqual(self.delegate.numberOfCallsToErrorResponse, 1u);
 }
 
+- (void)testPerformRequestsReturnsCancellationTokenForEveryRequest
+{
+    NSArray<SPTDataLoaderRequest *> *requests = @[ [SPTDataLoaderRequest new], [SPTDataLoaderRequest new], [SPTDataLoaderRequest new] ];
+    NSArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens = [self.dataLoader performRequests:requests];
+    XCTAssertEqual(cancellationTokens.count, 3u);
+    XCTAssertEqual(self.dataLoader.currentRequests.count, 3u);
+    for (NSUInteger i = 0; i < requests.count; i++) {
+        SPTDataLoaderRequest *request = cancellationTokens[i].objectToCancel;
+        XCTAssertEqual(request.uniqueIdentifier, requests[i].uniqueIdentifier, @"The cancellation tokens are not in the order of the requests");
+    }
+    XCTAssertEqual(self.requestResponseHandlerDelegate.lastRequestPerformed.uniqueIdentifier, requests.lastObject.uniqueIdentifier);
+}
+
+- (void)testPerformRequestsHandsTheWholeBatchOverInOneCall
+{
+    // Given
+    NSArray<SPTDataLoaderRequest *> *requests = @[ [SPTDataLoaderRequest new], [SPTDataLoaderRequest new], [SPTDataLoaderRequest new] ];
+
+    // When
+    [self.dataLoader performRequests:requests];
+
+    // Then
+    XCTAssertEqual(self.requestResponseHandlerDelegate.numberOfCallsToPerformRequests, 1u);
+    XCTAssertEqual(self.requestResponseHandlerDelegate.requestsPerformed.count, 3u);
+}
+
+- (void)testPerformRequestsSkipsRequestsThatCannotBePerformed
+{
+    SPTDataLoaderRequest *chunkedRequest = [SPTDataLoaderRequest new];
+    chunkedRequest.chunks = YES;
+    NSArray<id<SPTDataLoaderCancellationToken>> *cancellationTokens = [self.dataLoader performRequests:@[ [SPTDataLoaderRequest new], chunkedRequest ]];
+    XCTAssertEqual(cancellationTokens.count, 1u);
+    XCTAssertEqual(self.dataLoader.currentRequests.count, 1u);
+    XCTAssertEqual(self.delegate.numberOfCallsToErrorResponse, 1u);
+}
+
 - (void)testNoCallsToReceiveInitialResponseIfRequestDoesNotSupportChunks
 {
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
@@ -202,8 +253,12 @@
     SPTDataLoaderRequest *request = [SPTDataLoaderRequest new];
     SPTDataLoaderResponse *response = [SPTDataLoaderResponse dataLoaderResponseWithRequest:request response:nil];
     NSData *data = [NSData data];
-    [self.dataLoader receivedDataChunk:data forResponse:response];
+    __block BOOL calledCompletionHandler = NO;
+    [self.dataLoader receivedDataChunk:data forResponse:response completionHandler:^{
+        calledCompletionHandler = YES;
+    }];
     XCTAssertEqual(self.delegate.numberOfCallsToReceiveDataChunk, 0u);
+    XCTAssertTrue(calledCompletionHandler, @"The data loader did not acknowledge a chunk it dropped");
 }
 
 - (void)testSuccessfulResponseDoesNotEchoToDelegateWithReceivedInitialResponseRequest
@@ -284,4 +339,56 @@
     XCTAssertNil(cancellationToken, @"The data loader did not release the cancellation token");
 }
 
+- (void)testCoalescedDelegateCallsAreMadeTogetherInOrder
+{
+    // Given
+    self.dataLoader.coalescesDelegateCalls = YES;
+    NSMutableArray<SPTDataLoaderRequest *> *requests = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 3; ++i) {
+        [self.dataLoader performRequest:[SPTDataLoaderRequest new]];
+        [requests addObject:self.requestResponseHandlerDelegate.lastRequestPerformed];
+    }
+
+    // When
+    [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:requests[0] response:nil]];
+    [self.dataLoader failedResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:requests[1] response:nil]];
+    [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:requests[2] response:nil]];
+
+    // Then
+    XCTAssertEqual(self.delegate.numberOfCallsToSuccessfulResponse, 0u, @"Coalesced delegate calls should not be made synchronously");
+    __block NSUInteger numberOfErrorResponsesAtFirstResponse = 0;
+    __weak __typeof(self) weakSelf = self;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Coalesced delegate calls"];
+    self.delegate.receivedSuccessfulBlock = ^{
+        if (weakSelf.delegate.numberOfCallsToSuccessfulResponse == 1) {
+            numberOfErrorResponsesAtFirstResponse = weakSelf.delegate.numberOfCallsToErrorResponse;
+        } else {
+            [expectation fulfill];
+        }
+    };
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertEqual(numberOfErrorResponsesAtFirstResponse, 0u, @"The error response should be delivered after the first successful response");
+    XCTAssertEqual(self.delegate.numberOfCallsToErrorResponse, 1u);
+    XCTAssertEqual(self.delegate.numberOfCallsToSuccessfulResponse, 2u);
+}
+
+- (void)testCoalescedDelegateCallsWaitForTheCoalescingInterval
+{
+    self.dataLoader.coalescesDelegateCalls = YES;
+    self.dataLoader.delegateCoalescingInterval = 0.05;
+    self.dataLoader.delegateQueue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Coalesced delegate call"];
+    self.delegate.receivedSuccessfulBlock = ^{
+        [expectation fulfill];
+    };
+    [self.dataLoader performRequest:[SPTDataLoaderRequest new]];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+    [self.dataLoader successfulResponse:[SPTDataLoaderResponse dataLoaderResponseWithRequest:self.requestResponseHandlerDelegate.lastRequestPerformed
+                                                                                     response:nil]];
+
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - startTime, 0.05);
+}
+
 @end
@@ -25,4 +25,20 @@
     XCTAssertEqualWithAccuracy(expectedTime, actualTime, 0.1, @"The currentTime is not equal to the system time given by CFAbsoluteTimeGetCurrent()");
 }
 
+- (void)testDispatchAfterRunsBlockOnQueue
+{
+    // Given
+    SPTDataLoaderTimeProviderImplementation *timeProvider = [SPTDataLoaderTimeProviderImplementation new];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"The scheduled block ran"];
+
+    // When
+    [timeProvider dispatchAfter:0.01 queue:dispatch_get_main_queue() block:^{
+        // Then
+        XCTAssertTrue([NSThread isMainThread], @"The scheduled block did not run on the requested queue");
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
 @end
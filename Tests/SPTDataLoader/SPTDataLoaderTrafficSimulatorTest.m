@@ -0,0 +1,157 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+
+#import "SPTDataLoaderTrafficSimulator.h"
+
+@interface SPTDataLoaderTrafficSimulatorTest : XCTestCase
+
+@end
+
+@implementation SPTDataLoaderTrafficSimulatorTest
+
+#pragma mark SPTDataLoaderTrafficSimulatorTest
+
+- (void)testRetriesAreReplayedInVirtualTime
+{
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:0.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        if (attempt < 2) {
+            return [SPTDataLoaderSimulatedResponse responseWithError:error latency:0.1];
+        }
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK latency:0.1];
+    }];
+    simulator.requestConfiguration = ^(SPTDataLoaderRequest *request, NSUInteger requestIndex) {
+        request.maximumRetryCount = 2;
+    };
+
+    SPTDataLoaderTrafficSimulatorReport *report = [simulator runWithRequestCount:1000];
+
+    XCTAssertEqual(report.successfulRequestCount, 1000u, @"Every request should succeed on its last retry");
+    XCTAssertEqual(report.attemptCount, 3000u, @"Every request should have been attempted three times");
+    XCTAssertEqualWithAccuracy(report.retryAmplification, 3.0, DBL_EPSILON);
+    XCTAssertGreaterThanOrEqual(report.scheduledWaitCount, 1000u, @"The second retry of every request should back off on the clock");
+    XCTAssertGreaterThan(report.latencyP50, 1.0, @"The backoff should be part of the virtual latency");
+}
+
+- (void)testRetryAfterDelaysFollowingRequests
+{
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:100.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        if (requestIndex == 0) {
+            return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeServiceUnavailable
+                                                                  latency:0.1
+                                                                  headers:@{ @"Retry-After" : @"10" }];
+        }
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK latency:0.1];
+    }];
+    simulator.arrivalInterval = 1.0;
+
+    SPTDataLoaderTrafficSimulatorReport *report = [simulator runWithRequestCount:3];
+
+    XCTAssertEqual(report.failedRequestCount, 1u);
+    XCTAssertEqual(report.successfulRequestCount, 2u);
+    XCTAssertEqualWithAccuracy(report.maximumQueueingDelay, 9.1, 0.01, @"The second request should wait for the Retry-After of the first");
+    XCTAssertEqualWithAccuracy(report.virtualDuration, 10.2, 0.01);
+}
+
+- (void)testSlowResponsesTimeOut
+{
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:0.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK latency:30.0];
+    }];
+    simulator.requestConfiguration = ^(SPTDataLoaderRequest *request, NSUInteger requestIndex) {
+        request.timeout = 5.0;
+    };
+
+    SPTDataLoaderTrafficSimulatorReport *report = [simulator runWithRequestCount:10];
+
+    XCTAssertEqual(report.failedRequestCount, 10u, @"Every request should time out before its response arrives");
+    XCTAssertEqualWithAccuracy(report.latencyP99, 5.0, 0.001);
+}
+
+- (void)testMixedTrafficReportsRetryAmplification
+{
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:0.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        if (requestIndex % 10 == 0 && attempt == 0) {
+            return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeInternalServerError latency:0.05];
+        }
+        NSTimeInterval latency = requestIndex % 100 == 0 ? 2.0 : 0.05;
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK latency:latency];
+    }];
+    simulator.requestConfiguration = ^(SPTDataLoaderRequest *request, NSUInteger requestIndex) {
+        request.maximumRetryCount = 1;
+    };
+
+    SPTDataLoaderTrafficSimulatorReport *report = [simulator runWithRequestCount:10000];
+
+    XCTAssertEqual(report.successfulRequestCount, 10000u);
+    XCTAssertEqual(report.attemptCount, 11000u);
+    XCTAssertEqualWithAccuracy(report.retryAmplification, 1.1, DBL_EPSILON);
+    XCTAssertEqualWithAccuracy(report.latencyP99, 2.05, 0.001, @"The slow responses should show up in the tail latency");
+    XCTAssertGreaterThan(report.virtualDuration, 100.0, @"The traffic should span 100 virtual seconds");
+}
+
+- (SPTDataLoaderTrafficSimulatorReport *)runCongestedServerWithAdaptiveConcurrency:(BOOL)adaptsConcurrency
+{
+    // The server answers 8 requests at base latency and slows down linearly beyond that. Between 10 and 20 seconds it
+    // only manages 2, and it sheds load with 503 once it holds 4 times what it can manage
+    __block __weak SPTDataLoaderTrafficSimulator *weakSimulator = nil;
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:0.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        NSTimeInterval elapsedTime = weakSimulator.elapsedTime;
+        double capacity = elapsedTime >= 10.0 && elapsedTime < 20.0 ? 2.0 : 8.0;
+        double load = weakSimulator.inFlightAttemptCount;
+        if (load > 4.0 * capacity) {
+            return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeServiceUnavailable latency:0.01];
+        }
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK
+                                                              latency:0.1 * MAX(1.0, load / capacity)];
+    }];
+    weakSimulator = simulator;
+    simulator.arrivalInterval = 0.02;
+    simulator.adaptsConcurrency = adaptsConcurrency;
+    simulator.requestConfiguration = ^(SPTDataLoaderRequest *request, NSUInteger requestIndex) {
+        request.maximumRetryCount = 2;
+    };
+    return [simulator runWithRequestCount:3000];
+}
+
+- (void)testAdaptiveConcurrencyKeepsCongestedServerAnswering
+{
+    SPTDataLoaderTrafficSimulatorReport *staticReport = [self runCongestedServerWithAdaptiveConcurrency:NO];
+    SPTDataLoaderTrafficSimulatorReport *adaptiveReport = [self runCongestedServerWithAdaptiveConcurrency:YES];
+
+    XCTAssertGreaterThan(staticReport.failedRequestCount, 0u, @"Sending everything should overload the server while it is congested");
+    XCTAssertEqual(adaptiveReport.failedRequestCount, 0u, @"Holding requests back should keep the server from shedding them");
+    XCTAssertLessThan(adaptiveReport.attemptCount, staticReport.attemptCount, @"Fewer rejections should mean fewer retries");
+    XCTAssertLessThan(adaptiveReport.latencyP50, 0.2, @"Requests outside the congestion should not queue");
+    XCTAssertLessThan(adaptiveReport.maximumQueueingDelay, 10.0, @"The queue should drain within the length of the congestion");
+}
+
+- (SPTDataLoaderTrafficSimulatorReport *)runFastServerWithAdaptiveConcurrency:(BOOL)adaptsConcurrency
+{
+    SPTDataLoaderTrafficSimulator *simulator = [SPTDataLoaderTrafficSimulator trafficSimulatorWithRequestsPerSecond:0.0 script:^SPTDataLoaderSimulatedResponse *(NSUInteger requestIndex, NSUInteger attempt) {
+        return [SPTDataLoaderSimulatedResponse responseWithStatusCode:SPTDataLoaderResponseHTTPStatusCodeOK latency:0.05];
+    }];
+    simulator.arrivalInterval = 0.001;
+    simulator.adaptsConcurrency = adaptsConcurrency;
+    return [simulator runWithRequestCount:5000];
+}
+
+- (void)testAdaptiveConcurrencyKeepsUpWithFastServer
+{
+    SPTDataLoaderTrafficSimulatorReport *staticReport = [self runFastServerWithAdaptiveConcurrency:NO];
+    SPTDataLoaderTrafficSimulatorReport *adaptiveReport = [self runFastServerWithAdaptiveConcurrency:YES];
+
+    XCTAssertEqual(adaptiveReport.successfulRequestCount, 5000u);
+    XCTAssertGreaterThanOrEqual(adaptiveReport.maximumInFlightAttemptCount, 50u, @"The limit should grow to the 50 requests the traffic needs in flight");
+    XCTAssertLessThanOrEqual(adaptiveReport.virtualDuration, staticReport.virtualDuration * 1.05, @"The limit should not hold back throughput");
+    XCTAssertLessThan(adaptiveReport.latencyP99, 0.5);
+}
+
+@end
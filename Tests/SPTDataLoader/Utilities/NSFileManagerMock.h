@@ -7,4 +7,6 @@
 
 @interface NSFileManagerMock : NSFileManager
 
+@property (nonatomic, strong) NSNumber *fileSize;
+
 @end
@@ -14,6 +14,12 @@
     return YES;
 }
 
+- (NSDictionary<NSFileAttributeKey, id> *)attributesOfItemAtPath:(NSString *)path
+                                                           error:(NSError * _Nullable __autoreleasing *)error
+{
+    return self.fileSize ? @{ NSFileSize : self.fileSize } : nil;
+}
+
 - (BOOL)removeItemAtPath:(NSString *)path
                    error:(NSError * _Nullable __autoreleasing *)error
 {
@@ -19,5 +19,6 @@
 @property (atomic, readonly) int64_t countOfBytesReceived;
 @property (atomic, readonly) int64_t countOfBytesExpectedToSend;
 @property (atomic, readonly) int64_t countOfBytesExpectedToReceive;
+@property (atomic, assign) float priority;
 
 @end
@@ -13,6 +13,7 @@
 @synthesize countOfBytesExpectedToReceive = _countOfBytesExpectedToReceive;
 @synthesize currentRequest;
 @synthesize response;
+@synthesize priority;
 
 - (instancetype)init
 {
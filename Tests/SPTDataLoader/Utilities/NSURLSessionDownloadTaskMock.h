@@ -17,5 +17,6 @@
 
 @property (atomic, readonly) int64_t countOfBytesSent;
 @property (atomic, readonly) int64_t countOfBytesReceived;
+@property (atomic, assign) float priority;
 
 @end
@@ -11,6 +11,7 @@
 @synthesize countOfBytesReceived;
 @synthesize currentRequest;
 @synthesize response;
+@synthesize priority;
 
 - (void)resume
 {
@@ -7,10 +7,15 @@
 
 @class NSURLSessionDataTaskMock;
 @class NSURLSessionDownloadTaskMock;
+@class NSURLSessionUploadTaskMock;
 
 @interface NSURLSessionMock : NSURLSession
 
 @property (nonatomic, strong) NSURLSessionDataTaskMock *lastDataTask;
 @property (nonatomic, strong) NSURLSessionDownloadTaskMock *lastDownloadTask;
+@property (nonatomic, strong) NSURLSessionUploadTaskMock *lastUploadTask;
+@property (nonatomic, strong) NSURL *lastUploadFileURL;
+@property (nonatomic, strong) NSURLRequest *lastRequest;
+@property (nonatomic, strong) NSData *lastResumeData;
 
 @end
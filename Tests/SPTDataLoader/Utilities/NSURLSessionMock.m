@@ -6,19 +6,44 @@
 #import "NSURLSessionMock.h"
 #import "NSURLSessionDataTaskMock.h"
 #import "NSURLSessionDownloadTaskMock.h"
+#import "NSURLSessionUploadTaskMock.h"
 
 @implementation NSURLSessionMock
 
 - (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
 {
+    self.lastRequest = request;
     self.lastDataTask = [NSURLSessionDataTaskMock new];
     return self.lastDataTask;
 }
 
 - (NSURLSessionDownloadTask *)downloadTaskWithRequest:(NSURLRequest *)request
 {
+    self.lastRequest = request;
     self.lastDownloadTask = [NSURLSessionDownloadTaskMock new];
     return self.lastDownloadTask;
 }
 
+- (NSURLSessionDownloadTask *)downloadTaskWithResumeData:(NSData *)resumeData
+{
+    self.lastResumeData = resumeData;
+    self.lastDownloadTask = [NSURLSessionDownloadTaskMock new];
+    return self.lastDownloadTask;
+}
+
+- (NSURLSessionUploadTask *)uploadTaskWithStreamedRequest:(NSURLRequest *)request
+{
+    self.lastRequest = request;
+    self.lastUploadTask = [NSURLSessionUploadTaskMock new];
+    return self.lastUploadTask;
+}
+
+- (NSURLSessionUploadTask *)uploadTaskWithRequest:(NSURLRequest *)request fromFile:(NSURL *)fileURL
+{
+    self.lastRequest = request;
+    self.lastUploadFileURL = fileURL;
+    self.lastUploadTask = [NSURLSessionUploadTaskMock new];
+    return self.lastUploadTask;
+}
+
 @end
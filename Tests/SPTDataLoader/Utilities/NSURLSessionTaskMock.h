@@ -9,6 +9,7 @@
 
 @property (nonatomic, assign) NSUInteger numberOfCallsToResume;
 @property (nonatomic, assign) NSUInteger numberOfCallsToCancel;
+@property (nonatomic, assign) NSUInteger numberOfCallsToSuspend;
 @property (nonatomic, strong, readwrite, nullable) dispatch_block_t resumeCallback;
 @property (nonatomic, strong, readwrite, nullable) NSURLResponse *mockResponse;
 
@@ -19,5 +20,6 @@
 @property (atomic, readonly) int64_t countOfBytesExpectedToSend;
 @property (atomic, readonly) int64_t countOfBytesExpectedToReceive;
 @property (atomic, nullable, readonly, copy) NSURLRequest *currentRequest;
+@property (atomic, assign) float priority;
 
 @end
@@ -12,6 +12,7 @@
 @synthesize countOfBytesExpectedToSend = _countOfBytesExpectedToSend;
 @synthesize countOfBytesExpectedToReceive = _countOfBytesExpectedToReceive;
 @synthesize currentRequest;
+@synthesize priority;
 
 - (instancetype)init
 {
@@ -38,6 +39,11 @@
     self.numberOfCallsToCancel++;
 }
 
+- (void)suspend
+{
+    self.numberOfCallsToSuspend++;
+}
+
 - (NSURLResponse *)response
 {
     return self.mockResponse;
@@ -0,0 +1,26 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "NSURLSessionUploadTaskMock.h"
+
+@implementation NSURLSessionUploadTaskMock
+
+@synthesize countOfBytesSent;
+@synthesize countOfBytesReceived;
+@synthesize currentRequest;
+@synthesize response;
+@synthesize priority;
+
+- (void)resume
+{
+    self.numberOfCallsToResume++;
+}
+
+- (void)cancel
+{
+    self.numberOfCallsToCancel++;
+}
+
+@end
@@ -12,5 +12,7 @@
 @property (nonatomic, assign) NSInteger numberOfCallsToEndedRequest;
 @property (nonatomic, strong, readwrite, nullable) dispatch_block_t endedRequestCallback;
 @property (nonatomic, assign, readwrite) NSInteger lastBytesDownloaded;
+@property (nonatomic, assign, readwrite) NSInteger lastBytesUploaded;
+@property (nonatomic, assign, readwrite) NSInteger lastUncompressedBytesUploaded;
 
 @end
@@ -10,9 +10,22 @@
 - (void)endedRequestWithResponse:(SPTDataLoaderResponse *)response
                  bytesDownloaded:(int)bytesDownloaded
                    bytesUploaded:(int)bytesUploaded
+{
+    [self endedRequestWithResponse:response
+                   bytesDownloaded:bytesDownloaded
+                     bytesUploaded:bytesUploaded
+         uncompressedBytesUploaded:bytesUploaded];
+}
+
+- (void)endedRequestWithResponse:(SPTDataLoaderResponse *)response
+                 bytesDownloaded:(int)bytesDownloaded
+                   bytesUploaded:(int)bytesUploaded
+       uncompressedBytesUploaded:(int)uncompressedBytesUploaded
 {
     self.numberOfCallsToEndedRequest++;
     self.lastBytesDownloaded = bytesDownloaded;
+    self.lastBytesUploaded = bytesUploaded;
+    self.lastUncompressedBytesUploaded = uncompressedBytesUploaded;
     if (self.endedRequestCallback) {
         self.endedRequestCallback();
     }
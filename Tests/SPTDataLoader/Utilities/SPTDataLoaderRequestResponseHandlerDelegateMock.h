@@ -16,5 +16,8 @@ typedef id<SPTDataLoaderCancellationToken> (^SPTCancellationTokenCreator)(void);
 @property (nonatomic, strong) SPTDataLoaderRequest *lastRequestAuthorised;
 @property (nonatomic, strong) SPTDataLoaderRequest *lastRequestFailed;
 @property (nonatomic, strong, readwrite) SPTDataLoaderRequest *lastRequestCancelled;
+@property (nonatomic, strong, readonly) NSMutableArray<SPTDataLoaderRequest *> *requestsPerformed;
+@property (nonatomic, strong, readonly) NSMutableArray<SPTDataLoaderRequest *> *requestsCancelled;
+@property (nonatomic, assign, readonly) NSUInteger numberOfCallsToPerformRequests;
 
 @end
@@ -7,10 +7,29 @@
 
 @implementation SPTDataLoaderRequestResponseHandlerDelegateMock
 
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _requestsPerformed = [NSMutableArray new];
+        _requestsCancelled = [NSMutableArray new];
+    }
+    return self;
+}
+
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
                 performRequest:(SPTDataLoaderRequest *)request
 {
     self.lastRequestPerformed = request;
+    [self.requestsPerformed addObject:request];
+}
+
+- (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
+               performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+{
+    _numberOfCallsToPerformRequests++;
+    self.lastRequestPerformed = requests.lastObject;
+    [self.requestsPerformed addObjectsFromArray:requests];
 }
 
 - (void)requestResponseHandler:(id<SPTDataLoaderRequestResponseHandler>)requestResponseHandler
@@ -30,6 +49,7 @@
                  cancelRequest:(SPTDataLoaderRequest *)request
 {
     self.lastRequestCancelled = request;
+    [self.requestsCancelled addObject:request];
 }
 
 @end
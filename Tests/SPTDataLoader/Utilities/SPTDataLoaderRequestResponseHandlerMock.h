@@ -18,7 +18,9 @@
 @property (nonatomic, assign, readonly) NSUInteger numberOfReceivedInitialResponseCalls;
 @property (nonatomic, assign, readonly) NSUInteger numberOfNewBodyStreamCalls;
 @property (nonatomic, strong, readonly) SPTDataLoaderResponse *lastReceivedResponse;
+@property (nonatomic, strong, readonly) dispatch_block_t lastChunkCompletionHandler;
 @property (nonatomic, assign, readwrite, getter = isAuthorising) BOOL authorising;
 @property (nonatomic, strong, readwrite) dispatch_block_t failedResponseBlock;
+@property (nonatomic, strong, readwrite) NSData *bodyStreamData;
 
 @end
@@ -14,6 +14,7 @@
 @property (nonatomic, assign, readwrite) NSUInteger numberOfReceivedInitialResponseCalls;
 @property (nonatomic, assign, readwrite) NSUInteger numberOfNewBodyStreamCalls;
 @property (nonatomic, strong, readwrite) SPTDataLoaderResponse *lastReceivedResponse;
+@property (nonatomic, strong, readwrite) dispatch_block_t lastChunkCompletionHandler;
 
 @end
 
@@ -41,10 +42,13 @@
     self.numberOfCancelledRequestCalls++;
 }
 
-- (void)receivedDataChunk:(NSData *)data forResponse:(SPTDataLoaderResponse *)response
+- (void)receivedDataChunk:(NSData *)data
+              forResponse:(SPTDataLoaderResponse *)response
+        completionHandler:(dispatch_block_t)completionHandler
 {
     self.numberOfReceivedDataRequestCalls++;
     self.lastReceivedResponse = response;
+    self.lastChunkCompletionHandler = completionHandler;
 }
 
 - (void)receivedInitialResponse:(SPTDataLoaderResponse *)response
@@ -70,7 +74,8 @@
                 forRequest:(SPTDataLoaderRequest *)request
 {
     self.numberOfNewBodyStreamCalls++;
-    completionHandler([[NSInputStream alloc] init]);
+    NSData *bodyStreamData = self.bodyStreamData;
+    completionHandler(bodyStreamData != nil ? [NSInputStream inputStreamWithData:bodyStreamData] : [[NSInputStream alloc] init]);
 }
 
 @end
@@ -0,0 +1,24 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderResolverAddressSource.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderResolverAddressSourceMock : NSObject <SPTDataLoaderResolverAddressSource>
+
+@property (nonatomic, assign, readonly) NSUInteger numberOfResolveCalls;
+@property (nonatomic, copy, readonly, nullable) NSString *lastResolvedHost;
+
+/**
+ Completes the oldest resolution that has not been completed yet
+ */
+- (void)completeWithAddresses:(nullable NSArray<NSString *> *)addresses timeToLive:(NSTimeInterval)timeToLive;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,46 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderResolverAddressSourceMock.h"
+
+@interface SPTDataLoaderResolverAddressSourceMock ()
+
+@property (nonatomic, assign, readwrite) NSUInteger numberOfResolveCalls;
+@property (nonatomic, copy, readwrite, nullable) NSString *lastResolvedHost;
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderResolverAddressSourceCompletion> *pendingCompletions;
+
+@end
+
+@implementation SPTDataLoaderResolverAddressSourceMock
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _pendingCompletions = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)completeWithAddresses:(nullable NSArray<NSString *> *)addresses timeToLive:(NSTimeInterval)timeToLive
+{
+    SPTDataLoaderResolverAddressSourceCompletion completion = self.pendingCompletions.firstObject;
+    if (completion == nil) {
+        return;
+    }
+    [self.pendingCompletions removeObjectAtIndex:0];
+    completion(addresses, timeToLive);
+}
+
+#pragma mark SPTDataLoaderResolverAddressSource
+
+- (void)resolveAddressesForHost:(NSString *)host completion:(SPTDataLoaderResolverAddressSourceCompletion)completion
+{
+    self.numberOfResolveCalls++;
+    self.lastResolvedHost = host;
+    [self.pendingCompletions addObject:completion];
+}
+
+@end
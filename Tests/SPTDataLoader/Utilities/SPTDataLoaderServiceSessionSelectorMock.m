@@ -15,6 +15,8 @@
 
 @implementation SPTDataLoaderServiceSessionSelectorMock
 
+@synthesize timeProvider;
+
 - (instancetype)initWithResolver:(NSURLSession *(^)(SPTDataLoaderRequest *))resolver
 {
     self = [super init];
@@ -35,4 +37,21 @@
 {
 }
 
+- (void)setPartitions:(NSArray<SPTDataLoaderSessionPartition *> *)partitions
+{
+}
+
+- (NSArray<SPTDataLoaderSessionStatistics *> *)statistics
+{
+    return @[];
+}
+
+- (void)URLSession:(NSURLSession *)session didCreateTask:(NSURLSessionTask *)task
+{
+}
+
+- (void)URLSession:(NSURLSession *)session didCompleteTask:(NSURLSessionTask *)task error:(nullable NSError *)error
+{
+}
+
 @end
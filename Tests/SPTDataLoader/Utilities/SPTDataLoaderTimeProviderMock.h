@@ -7,9 +7,27 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ A virtual clock, time only moves when the test sets or advances it
+ @discussion Blocks scheduled through the time provider are held until the clock passes their fire time, and are then
+ run synchronously on the thread advancing the clock, regardless of the queue they were scheduled on.
+ */
 @interface SPTDataLoaderTimeProviderMock: NSObject <SPTDataLoaderTimeProvider>
 
 @property (nonatomic, readwrite) CFAbsoluteTime currentTime;
+@property (nonatomic, assign, readonly) NSUInteger numberOfScheduledBlocks;
+@property (nonatomic, assign, readonly) NSUInteger numberOfCallsToDispatchAfter;
+
+/**
+ Moves the clock forward, running every block scheduled to fire on the way in fire time order
+ @param interval The number of seconds to move the clock forward by
+ */
+- (void)advanceTimeBy:(NSTimeInterval)interval;
+/**
+ Moves the clock to the earliest scheduled block and runs it
+ @return YES if a block was run, NO if nothing was scheduled
+ */
+- (BOOL)runNextScheduledBlock;
 
 @end
 
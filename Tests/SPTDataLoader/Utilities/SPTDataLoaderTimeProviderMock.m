@@ -5,8 +5,99 @@
 
 #import "SPTDataLoaderTimeProviderMock.h"
 
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderTimeProviderMockScheduledBlock : NSObject
+
+@property (nonatomic, assign) CFAbsoluteTime fireTime;
+@property (nonatomic, copy) dispatch_block_t block;
+
+@end
+
+@implementation SPTDataLoaderTimeProviderMockScheduledBlock
+
+@end
+
+@interface SPTDataLoaderTimeProviderMock ()
+
+@property (nonatomic, strong) NSMutableArray<SPTDataLoaderTimeProviderMockScheduledBlock *> *scheduledBlocks;
+@property (nonatomic, assign, readwrite) NSUInteger numberOfCallsToDispatchAfter;
+
+@end
+
 @implementation SPTDataLoaderTimeProviderMock
 
 @synthesize currentTime;
 
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _scheduledBlocks = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (NSUInteger)numberOfScheduledBlocks
+{
+    @synchronized(self) {
+        return self.scheduledBlocks.count;
+    }
+}
+
+- (void)dispatchAfter:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block
+{
+    SPTDataLoaderTimeProviderMockScheduledBlock *scheduledBlock = [SPTDataLoaderTimeProviderMockScheduledBlock new];
+    scheduledBlock.block = block;
+
+    @synchronized(self) {
+        self.numberOfCallsToDispatchAfter++;
+        scheduledBlock.fireTime = self.currentTime + MAX(delay, 0.0);
+
+        // Blocks with the same fire time run in the order they were scheduled
+        NSUInteger index = [self.scheduledBlocks indexOfObject:scheduledBlock
+                                                 inSortedRange:NSMakeRange(0, self.scheduledBlocks.count)
+                                                       options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                                               usingComparator:^NSComparisonResult(SPTDataLoaderTimeProviderMockScheduledBlock *lhs,
+                                                                                   SPTDataLoaderTimeProviderMockScheduledBlock *rhs) {
+                                                   if (lhs.fireTime < rhs.fireTime) {
+                                                       return NSOrderedAscending;
+                                                   }
+                                                   return lhs.fireTime > rhs.fireTime ? NSOrderedDescending : NSOrderedSame;
+                                               }];
+        [self.scheduledBlocks insertObject:scheduledBlock atIndex:index];
+    }
+}
+
+- (void)advanceTimeBy:(NSTimeInterval)interval
+{
+    CFAbsoluteTime targetTime = self.currentTime + interval;
+    while ([self runNextScheduledBlockBefore:targetTime]) {
+    }
+    self.currentTime = MAX(self.currentTime, targetTime);
+}
+
+- (BOOL)runNextScheduledBlock
+{
+    return [self runNextScheduledBlockBefore:DBL_MAX];
+}
+
+- (BOOL)runNextScheduledBlockBefore:(CFAbsoluteTime)time
+{
+    SPTDataLoaderTimeProviderMockScheduledBlock *scheduledBlock = nil;
+    @synchronized(self) {
+        scheduledBlock = self.scheduledBlocks.firstObject;
+        if (scheduledBlock == nil || scheduledBlock.fireTime > time) {
+            return NO;
+        }
+        [self.scheduledBlocks removeObjectAtIndex:0];
+        self.currentTime = MAX(self.currentTime, scheduledBlock.fireTime);
+    }
+
+    scheduledBlock.block();
+    return YES;
+}
+
 @end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,24 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SPTDataLoaderTracerMock : NSObject <SPTDataLoaderTracer>
+
+/**
+ Every phase in the order it began or ended, such as "+task" and "-task"
+ */
+@property (nonatomic, copy, readonly) NSArray<NSString *> *events;
+@property (nonatomic, copy, readonly, nullable) NSString *lastServiceKey;
+
+- (NSArray<NSString *> *)eventsForPhase:(SPTDataLoaderTracePhase)phase;
+
+@end
+
+NS_ASSUME_NONNULL_END
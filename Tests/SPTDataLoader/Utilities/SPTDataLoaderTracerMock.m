@@ -0,0 +1,60 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderTracerMock.h"
+
+@interface SPTDataLoaderTracerMock ()
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *mutableEvents;
+@property (nonatomic, copy, readwrite, nullable) NSString *lastServiceKey;
+
+@end
+
+@implementation SPTDataLoaderTracerMock
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _mutableEvents = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (NSArray<NSString *> *)events
+{
+    @synchronized(self) {
+        return [self.mutableEvents copy];
+    }
+}
+
+- (NSArray<NSString *> *)eventsForPhase:(SPTDataLoaderTracePhase)phase
+{
+    NSString *phaseName = NSStringFromSPTDataLoaderTracePhase(phase);
+    NSPredicate *predicate = [NSPredicate predicateWithBlock:^BOOL(NSString *event, NSDictionary *bindings) {
+        return [[event substringFromIndex:1] isEqualToString:phaseName];
+    }];
+    return [self.events filteredArrayUsingPredicate:predicate];
+}
+
+- (void)recordEvent:(NSString *)event serviceKey:(NSString *)serviceKey
+{
+    @synchronized(self) {
+        [self.mutableEvents addObject:event];
+        self.lastServiceKey = serviceKey;
+    }
+}
+
+- (void)beganPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    [self recordEvent:[@"+" stringByAppendingString:NSStringFromSPTDataLoaderTracePhase(phase)] serviceKey:serviceKey];
+}
+
+- (void)endedPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey
+{
+    [self recordEvent:[@"-" stringByAppendingString:NSStringFromSPTDataLoaderTracePhase(phase)] serviceKey:serviceKey];
+}
+
+@end
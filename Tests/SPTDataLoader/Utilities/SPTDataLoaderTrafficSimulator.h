@@ -0,0 +1,135 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The answer the simulated network gives to a single attempt of a request
+ */
+@interface SPTDataLoaderSimulatedResponse : NSObject
+
+@property (nonatomic, assign, readonly) NSInteger statusCode;
+@property (nonatomic, assign, readonly) NSTimeInterval latency;
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, NSString *> *headers;
+@property (nonatomic, strong, readonly, nullable) NSError *error;
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode latency:(NSTimeInterval)latency;
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode
+                               latency:(NSTimeInterval)latency
+                               headers:(nullable NSDictionary<NSString *, NSString *> *)headers;
++ (instancetype)responseWithError:(NSError *)error latency:(NSTimeInterval)latency;
+
+@end
+
+/**
+ Decides how the simulated network answers an attempt
+ @param requestIndex The index of the request in the simulated traffic
+ @param attempt The zero based attempt of the request, greater than zero for retries
+ */
+typedef SPTDataLoaderSimulatedResponse * _Nonnull (^SPTDataLoaderTrafficSimulatorScript)(NSUInteger requestIndex, NSUInteger attempt);
+
+/**
+ The outcome of a simulation, times are in virtual seconds unless stated otherwise
+ */
+@interface SPTDataLoaderTrafficSimulatorReport : NSObject
+
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger successfulRequestCount;
+@property (nonatomic, assign) NSUInteger failedRequestCount;
+/**
+ The number of times a request reached the network, including retries
+ */
+@property (nonatomic, assign) NSUInteger attemptCount;
+/**
+ The largest number of attempts the simulated network was answering at the same time
+ */
+@property (nonatomic, assign) NSUInteger maximumInFlightAttemptCount;
+/**
+ The number of attempts per request
+ */
+@property (nonatomic, assign) double retryAmplification;
+/**
+ The number of waits the library scheduled for rate limiting, retry backoff and timeouts
+ */
+@property (nonatomic, assign) NSUInteger scheduledWaitCount;
+/**
+ The time between a request being performed and its first attempt reaching the network
+ */
+@property (nonatomic, assign) NSTimeInterval averageQueueingDelay;
+@property (nonatomic, assign) NSTimeInterval maximumQueueingDelay;
+/**
+ The time between a request being performed and its delegate callback
+ */
+@property (nonatomic, assign) NSTimeInterval latencyP50;
+@property (nonatomic, assign) NSTimeInterval latencyP99;
+/**
+ The time between the first request being performed and the last request completing
+ */
+@property (nonatomic, assign) NSTimeInterval virtualDuration;
+/**
+ The real time the simulation took
+ */
+@property (nonatomic, assign) NSTimeInterval wallClockDuration;
+/**
+ The real time the library and the scheduler spent per request
+ */
+@property (nonatomic, assign) NSTimeInterval schedulingOverheadPerRequest;
+
+@end
+
+/**
+ Replays synthetic traffic through a real SPTDataLoaderService against a simulated session in virtual time
+ @discussion Requests are performed at a fixed interval and every attempt is answered by the script once its latency
+ has passed. The service, its rate limiter and the simulated network share a virtual clock, so hours of retries,
+ Retry-After waits and slow responses run in as long as the library takes to process them. The simulation runs
+ synchronously and must be started on the main thread.
+ */
+@interface SPTDataLoaderTrafficSimulator : NSObject
+
+/**
+ The interval between two requests being performed, defaults to 10 milliseconds
+ */
+@property (nonatomic, assign) NSTimeInterval arrivalInterval;
+/**
+ Called for every request before it is performed, to set retry counts, timeouts and the like
+ */
+@property (nonatomic, copy, nullable) void (^requestConfiguration)(SPTDataLoaderRequest *request, NSUInteger requestIndex);
+/**
+ Whether the service limits the requests in flight adaptively, defaults to NO
+ */
+@property (nonatomic, assign) BOOL adaptsConcurrency;
+/**
+ The virtual time since the simulation started, for scripts whose network changes over time
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval elapsedTime;
+/**
+ The number of attempts the simulated network is answering, including the one the script is called for
+ @discussion Scripts use this to model a server that slows down or sheds load as it gets busier
+ */
+@property (nonatomic, assign, readonly) NSUInteger inFlightAttemptCount;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Class constructor
+ @param requestsPerSecond The default rate limit of the service, or 0.0 for no rate limiter
+ @param script The block answering every attempt
+ */
++ (instancetype)trafficSimulatorWithRequestsPerSecond:(double)requestsPerSecond
+                                               script:(SPTDataLoaderTrafficSimulatorScript)script;
+
+/**
+ Performs the requests and runs the virtual clock until all of them have completed
+ @param requestCount The number of requests to perform
+ */
+- (SPTDataLoaderTrafficSimulatorReport *)runWithRequestCount:(NSUInteger)requestCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,490 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import "SPTDataLoaderTrafficSimulator.h"
+
+#import <SPTDataLoader/SPTDataLoaderDelegate.h>
+#import <SPTDataLoader/SPTDataLoaderFactory.h>
+#import <SPTDataLoader/SPTDataLoaderImplementation.h>
+#import <SPTDataLoader/SPTDataLoaderRateLimiter.h>
+#import <SPTDataLoader/SPTDataLoaderRequest.h>
+#import <SPTDataLoader/SPTDataLoaderResponse.h>
+#import <SPTDataLoader/SPTDataLoaderService.h>
+
+#import "SPTDataLoaderRateLimiter+Private.h"
+#import "SPTDataLoaderService+Private.h"
+#import "SPTDataLoaderServiceSessionSelectorMock.h"
+#import "SPTDataLoaderTimeProviderMock.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString * const SPTDataLoaderTrafficSimulatorBaseURL = @"https://simulator.spotify.com/requests/";
+
+typedef struct {
+    CFAbsoluteTime performTime;
+    CFAbsoluteTime firstAttemptTime;
+    CFAbsoluteTime completionTime;
+    NSUInteger attemptCount;
+    BOOL completed;
+    BOOL succeeded;
+} SPTDataLoaderTrafficSimulatorRecord;
+
+@interface SPTDataLoaderService () <NSURLSessionDataDelegate, NSURLSessionTaskDelegate>
+
+@end
+
+@class SPTDataLoaderSimulatedTask;
+
+@protocol SPTDataLoaderSimulatedTaskDelegate <NSObject>
+
+- (void)simulatedTaskDidResume:(SPTDataLoaderSimulatedTask *)task;
+- (void)simulatedTaskDidCancel:(SPTDataLoaderSimulatedTask *)task;
+
+@end
+
+#pragma mark -
+
+@interface SPTDataLoaderSimulatedTask : NSURLSessionDataTask
+
+@property (nonatomic, strong) NSURLRequest *simulatedRequest;
+@property (nonatomic, weak) id<SPTDataLoaderSimulatedTaskDelegate> delegate;
+@property (nonatomic, assign) BOOL started;
+@property (nonatomic, assign) BOOL cancelled;
+@property (nonatomic, assign) BOOL answered;
+
+@end
+
+@implementation SPTDataLoaderSimulatedTask
+
+- (nullable NSURLRequest *)originalRequest
+{
+    return self.simulatedRequest;
+}
+
+- (nullable NSURLRequest *)currentRequest
+{
+    return self.simulatedRequest;
+}
+
+- (void)resume
+{
+    // Resuming after a suspension does not start another attempt
+    if (self.started || self.cancelled) {
+        return;
+    }
+    self.started = YES;
+    [self.delegate simulatedTaskDidResume:self];
+}
+
+- (void)suspend
+{
+}
+
+- (void)cancel
+{
+    if (self.cancelled) {
+        return;
+    }
+    self.cancelled = YES;
+    [self.delegate simulatedTaskDidCancel:self];
+}
+
+@end
+
+#pragma mark -
+
+@interface SPTDataLoaderSimulatedSession : NSURLSession
+
+@property (nonatomic, weak) id<SPTDataLoaderSimulatedTaskDelegate> taskDelegate;
+
+@end
+
+@implementation SPTDataLoaderSimulatedSession
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+{
+    SPTDataLoaderSimulatedTask *task = [SPTDataLoaderSimulatedTask new];
+    task.simulatedRequest = request;
+    task.delegate = self.taskDelegate;
+    return task;
+}
+
+@end
+
+#pragma mark -
+
+@implementation SPTDataLoaderSimulatedResponse
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode latency:(NSTimeInterval)latency
+{
+    return [self responseWithStatusCode:statusCode latency:latency headers:nil];
+}
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode
+                               latency:(NSTimeInterval)latency
+                               headers:(nullable NSDictionary<NSString *, NSString *> *)headers
+{
+    return [[self alloc] initWithStatusCode:statusCode latency:latency headers:headers error:nil];
+}
+
++ (instancetype)responseWithError:(NSError *)error latency:(NSTimeInterval)latency
+{
+    return [[self alloc] initWithStatusCode:0 latency:latency headers:nil error:error];
+}
+
+- (instancetype)initWithStatusCode:(NSInteger)statusCode
+                           latency:(NSTimeInterval)latency
+                           headers:(nullable NSDictionary<NSString *, NSString *> *)headers
+                             error:(nullable NSError *)error
+{
+    self = [super init];
+    if (self) {
+        _statusCode = statusCode;
+        _latency = latency;
+        _headers = [headers copy];
+        _error = error;
+    }
+    return self;
+}
+
+@end
+
+#pragma mark -
+
+@implementation SPTDataLoaderTrafficSimulatorReport
+
+@end
+
+#pragma mark -
+
+@interface SPTDataLoaderTrafficSimulator () <SPTDataLoaderDelegate, SPTDataLoaderSimulatedTaskDelegate>
+
+@property (nonatomic, assign, readonly) double requestsPerSecond;
+@property (nonatomic, copy, readonly) SPTDataLoaderTrafficSimulatorScript script;
+
+@property (nonatomic, strong, nullable) SPTDataLoaderTimeProviderMock *timeProvider;
+@property (nonatomic, strong, nullable) SPTDataLoaderService *service;
+@property (nonatomic, strong, nullable) SPTDataLoaderSimulatedSession *session;
+@property (nonatomic, strong, nullable) SPTDataLoader *dataLoader;
+@property (nonatomic, strong, nullable) NSMutableData *records;
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger simulatorScheduledBlockCount;
+@property (nonatomic, assign) CFAbsoluteTime virtualStartTime;
+@property (nonatomic, assign, readwrite) NSUInteger inFlightAttemptCount;
+@property (nonatomic, assign) NSUInteger maximumInFlightAttemptCount;
+
+@end
+
+@implementation SPTDataLoaderTrafficSimulator
+
++ (instancetype)trafficSimulatorWithRequestsPerSecond:(double)requestsPerSecond
+                                               script:(SPTDataLoaderTrafficSimulatorScript)script
+{
+    return [[self alloc] initWithRequestsPerSecond:requestsPerSecond script:script];
+}
+
+- (instancetype)initWithRequestsPerSecond:(double)requestsPerSecond script:(SPTDataLoaderTrafficSimulatorScript)script
+{
+    const NSTimeInterval SPTDataLoaderTrafficSimulatorDefaultArrivalInterval = 0.01;
+
+    self = [super init];
+    if (self) {
+        _requestsPerSecond = requestsPerSecond;
+        _script = [script copy];
+        _arrivalInterval = SPTDataLoaderTrafficSimulatorDefaultArrivalInterval;
+    }
+    return self;
+}
+
+- (SPTDataLoaderTrafficSimulatorReport *)runWithRequestCount:(NSUInteger)requestCount
+{
+    NSAssert([NSThread isMainThread], @"The simulation relies on synchronous delegate delivery on the main thread");
+
+    [self setUpWithRequestCount:requestCount];
+    SPTDataLoaderTimeProviderMock *timeProvider = (SPTDataLoaderTimeProviderMock * _Nonnull)self.timeProvider;
+
+    CFAbsoluteTime wallClockStartTime = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime virtualStartTime = self.virtualStartTime;
+    NSUInteger initialDispatchCount = timeProvider.numberOfCallsToDispatchAfter;
+
+    if (requestCount > 0) {
+        [self scheduleBlockAfter:0.0 block:^{
+            [self performRequestAtIndex:0];
+        }];
+    }
+    while ([timeProvider runNextScheduledBlock]) {
+    }
+
+    SPTDataLoaderTrafficSimulatorReport *report = [self reportWithVirtualStartTime:virtualStartTime];
+    report.maximumInFlightAttemptCount = self.maximumInFlightAttemptCount;
+    report.wallClockDuration = CFAbsoluteTimeGetCurrent() - wallClockStartTime;
+    report.schedulingOverheadPerRequest = requestCount > 0 ? report.wallClockDuration / requestCount : 0.0;
+    report.scheduledWaitCount = timeProvider.numberOfCallsToDispatchAfter - initialDispatchCount - self.simulatorScheduledBlockCount;
+
+    [self tearDown];
+    return report;
+}
+
+#pragma mark Simulation
+
+- (void)setUpWithRequestCount:(NSUInteger)requestCount
+{
+    SPTDataLoaderTimeProviderMock *timeProvider = [SPTDataLoaderTimeProviderMock new];
+    // Start from the wall clock so that Retry-After dates resolve to sensible virtual times
+    timeProvider.currentTime = CFAbsoluteTimeGetCurrent();
+
+    SPTDataLoaderRateLimiter *rateLimiter = nil;
+    if (self.requestsPerSecond > 0.0 || self.adaptsConcurrency) {
+        // Adaptive concurrency lives in the rate limiter, which then limits the rate to no more than once a microsecond
+        const double SPTDataLoaderTrafficSimulatorUnlimitedRequestsPerSecond = 1000000.0;
+        double requestsPerSecond = self.requestsPerSecond > 0.0 ? self.requestsPerSecond : SPTDataLoaderTrafficSimulatorUnlimitedRequestsPerSecond;
+        rateLimiter = [[SPTDataLoaderRateLimiter alloc] initWithDefaultRequestsPerSecond:requestsPerSecond
+                                                                            timeProvider:timeProvider];
+        [rateLimiter setAdaptiveConcurrency:self.adaptsConcurrency
+                                     forURL:(NSURL * _Nonnull)[NSURL URLWithString:SPTDataLoaderTrafficSimulatorBaseURL]];
+    }
+
+    SPTDataLoaderSimulatedSession *session = [SPTDataLoaderSimulatedSession new];
+    session.taskDelegate = self;
+
+    SPTDataLoaderService *service = [SPTDataLoaderService dataLoaderServiceWithUserAgent:@"SPTDataLoaderTrafficSimulator"
+                                                                             rateLimiter:rateLimiter
+                                                                                resolver:nil
+                                                                customURLProtocolClasses:nil];
+    service.timeProvider = timeProvider;
+    service.sessionSelector = [[SPTDataLoaderServiceSessionSelectorMock alloc] initWithResolver:^NSURLSession *(SPTDataLoaderRequest *request) {
+        return session;
+    }];
+
+    SPTDataLoader *dataLoader = [[service createDataLoaderFactoryWithAuthorisers:nil] createDataLoader];
+    dataLoader.delegate = self;
+
+    self.timeProvider = timeProvider;
+    self.service = service;
+    self.session = session;
+    self.dataLoader = dataLoader;
+    self.requestCount = requestCount;
+    self.records = [NSMutableData dataWithLength:requestCount * sizeof(SPTDataLoaderTrafficSimulatorRecord)];
+    self.simulatorScheduledBlockCount = 0;
+    self.virtualStartTime = timeProvider.currentTime;
+    self.inFlightAttemptCount = 0;
+    self.maximumInFlightAttemptCount = 0;
+}
+
+- (void)tearDown
+{
+    [self.service invalidateAndCancel];
+    self.timeProvider = nil;
+    self.service = nil;
+    self.session = nil;
+    self.dataLoader = nil;
+    self.records = nil;
+}
+
+- (NSTimeInterval)elapsedTime
+{
+    return self.timeProvider.currentTime - self.virtualStartTime;
+}
+
+- (void)finishAttemptOfTask:(SPTDataLoaderSimulatedTask *)task
+{
+    if (task.started && !task.answered) {
+        task.answered = YES;
+        self.inFlightAttemptCount--;
+    }
+}
+
+- (SPTDataLoaderTrafficSimulatorRecord *)recordAtIndex:(NSUInteger)index
+{
+    return ((SPTDataLoaderTrafficSimulatorRecord *)self.records.mutableBytes) + index;
+}
+
+- (NSUInteger)requestIndexForURL:(nullable NSURL *)URL
+{
+    return (NSUInteger)URL.lastPathComponent.integerValue;
+}
+
+- (void)scheduleBlockAfter:(NSTimeInterval)delay block:(dispatch_block_t)block
+{
+    self.simulatorScheduledBlockCount++;
+    [self.timeProvider dispatchAfter:delay queue:dispatch_get_main_queue() block:block];
+}
+
+- (void)performRequestAtIndex:(NSUInteger)index
+{
+    if (index + 1 < self.requestCount) {
+        [self scheduleBlockAfter:self.arrivalInterval block:^{
+            [self performRequestAtIndex:index + 1];
+        }];
+    }
+
+    NSString *URLString = [SPTDataLoaderTrafficSimulatorBaseURL stringByAppendingFormat:@"%lu", (unsigned long)index];
+    SPTDataLoaderRequest *request = [SPTDataLoaderRequest requestWithURL:(NSURL * _Nonnull)[NSURL URLWithString:URLString]
+                                                        sourceIdentifier:@"simulator"];
+    if (self.requestConfiguration) {
+        self.requestConfiguration(request, index);
+    }
+
+    [self recordAtIndex:index]->performTime = self.timeProvider.currentTime;
+    [self.dataLoader performRequest:request];
+}
+
+- (void)completeRequest:(SPTDataLoaderRequest *)request succeeded:(BOOL)succeeded
+{
+    NSUInteger index = [self requestIndexForURL:request.URL];
+    if (index >= self.requestCount) {
+        return;
+    }
+
+    SPTDataLoaderTrafficSimulatorRecord *record = [self recordAtIndex:index];
+    if (record->completed) {
+        return;
+    }
+    record->completed = YES;
+    record->succeeded = succeeded;
+    record->completionTime = self.timeProvider.currentTime;
+}
+
+#pragma mark Report
+
+static int SPTDataLoaderTrafficSimulatorCompareTimes(const void *lhs, const void *rhs)
+{
+    const NSTimeInterval lhsTime = *(const NSTimeInterval *)lhs;
+    const NSTimeInterval rhsTime = *(const NSTimeInterval *)rhs;
+    return (lhsTime > rhsTime) - (lhsTime < rhsTime);
+}
+
+static NSTimeInterval SPTDataLoaderTrafficSimulatorPercentile(const NSTimeInterval *sortedTimes, NSUInteger count, double percentile)
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    NSUInteger index = (NSUInteger)ceil((count - 1) * percentile);
+    return sortedTimes[MIN(index, count - 1)];
+}
+
+- (SPTDataLoaderTrafficSimulatorReport *)reportWithVirtualStartTime:(CFAbsoluteTime)virtualStartTime
+{
+    SPTDataLoaderTrafficSimulatorReport *report = [SPTDataLoaderTrafficSimulatorReport new];
+    report.requestCount = self.requestCount;
+
+    NSMutableData *latencyData = [NSMutableData dataWithLength:self.requestCount * sizeof(NSTimeInterval)];
+    NSTimeInterval *latencies = latencyData.mutableBytes;
+    NSUInteger completedCount = 0;
+    NSUInteger attemptedCount = 0;
+    NSTimeInterval totalQueueingDelay = 0.0;
+    CFAbsoluteTime lastCompletionTime = virtualStartTime;
+
+    for (NSUInteger index = 0; index < self.requestCount; index++) {
+        SPTDataLoaderTrafficSimulatorRecord *record = [self recordAtIndex:index];
+        report.attemptCount += record->attemptCount;
+
+        if (record->attemptCount > 0) {
+            NSTimeInterval queueingDelay = record->firstAttemptTime - record->performTime;
+            totalQueueingDelay += queueingDelay;
+            report.maximumQueueingDelay = MAX(report.maximumQueueingDelay, queueingDelay);
+            attemptedCount++;
+        }
+
+        if (!record->completed) {
+            continue;
+        }
+        if (record->succeeded) {
+            report.successfulRequestCount++;
+        } else {
+            report.failedRequestCount++;
+        }
+        latencies[completedCount++] = record->completionTime - record->performTime;
+        lastCompletionTime = MAX(lastCompletionTime, record->completionTime);
+    }
+
+    qsort(latencies, completedCount, sizeof(NSTimeInterval), SPTDataLoaderTrafficSimulatorCompareTimes);
+
+    report.retryAmplification = self.requestCount > 0 ? (double)report.attemptCount / self.requestCount : 0.0;
+    report.averageQueueingDelay = attemptedCount > 0 ? totalQueueingDelay / attemptedCount : 0.0;
+    report.latencyP50 = SPTDataLoaderTrafficSimulatorPercentile(latencies, completedCount, 0.5);
+    report.latencyP99 = SPTDataLoaderTrafficSimulatorPercentile(latencies, completedCount, 0.99);
+    report.virtualDuration = lastCompletionTime - virtualStartTime;
+    return report;
+}
+
+#pragma mark SPTDataLoaderSimulatedTaskDelegate
+
+- (void)simulatedTaskDidResume:(SPTDataLoaderSimulatedTask *)task
+{
+    NSURL *URL = task.simulatedRequest.URL;
+    NSUInteger index = [self requestIndexForURL:URL];
+    if (index >= self.requestCount) {
+        return;
+    }
+
+    SPTDataLoaderTrafficSimulatorRecord *record = [self recordAtIndex:index];
+    if (record->attemptCount == 0) {
+        record->firstAttemptTime = self.timeProvider.currentTime;
+    }
+    self.inFlightAttemptCount++;
+    self.maximumInFlightAttemptCount = MAX(self.maximumInFlightAttemptCount, self.inFlightAttemptCount);
+    SPTDataLoaderSimulatedResponse *simulatedResponse = self.script(index, record->attemptCount++);
+
+    __weak __typeof(self) weakSelf = self;
+    [self scheduleBlockAfter:simulatedResponse.latency block:^{
+        [weakSelf deliverSimulatedResponse:simulatedResponse forTask:task URL:URL];
+    }];
+}
+
+- (void)simulatedTaskDidCancel:(SPTDataLoaderSimulatedTask *)task
+{
+    [self finishAttemptOfTask:task];
+    __weak __typeof(self) weakSelf = self;
+    [self scheduleBlockAfter:0.0 block:^{
+        __strong __typeof(self) strongSelf = weakSelf;
+        [strongSelf.service URLSession:(NSURLSession * _Nonnull)strongSelf.session
+                                  task:task
+                  didCompleteWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+    }];
+}
+
+- (void)deliverSimulatedResponse:(SPTDataLoaderSimulatedResponse *)simulatedResponse
+                         forTask:(SPTDataLoaderSimulatedTask *)task
+                             URL:(NSURL *)URL
+{
+    SPTDataLoaderService *service = self.service;
+    NSURLSession *session = self.session;
+    if (task.cancelled || service == nil || session == nil) {
+        return;
+    }
+    [self finishAttemptOfTask:task];
+
+    if (simulatedResponse.error == nil) {
+        NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:URL
+                                                                  statusCode:simulatedResponse.statusCode
+                                                                 HTTPVersion:@"HTTP/1.1"
+                                                                headerFields:simulatedResponse.headers];
+        [service URLSession:session dataTask:task didReceiveResponse:(NSURLResponse * _Nonnull)response completionHandler:^(NSURLSessionResponseDisposition disposition) {
+        }];
+    }
+    [service URLSession:session task:task didCompleteWithError:simulatedResponse.error];
+}
+
+#pragma mark SPTDataLoaderDelegate
+
+- (void)dataLoader:(SPTDataLoader *)dataLoader didReceiveSuccessfulResponse:(SPTDataLoaderResponse *)response
+{
+    [self completeRequest:response.request succeeded:YES];
+}
+
+- (void)dataLoader:(SPTDataLoader *)dataLoader didReceiveErrorResponse:(SPTDataLoaderResponse *)response
+{
+    [self completeRequest:response.request succeeded:NO];
+}
+
+- (void)dataLoader:(SPTDataLoader *)dataLoader didCancelRequest:(SPTDataLoaderRequest *)request
+{
+    [self completeRequest:request succeeded:NO];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
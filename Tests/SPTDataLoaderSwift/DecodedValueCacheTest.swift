@@ -0,0 +1,213 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+@testable import SPTDataLoaderSwift
+
+import Foundation
+import XCTest
+
+/// Tests of the decoded value cache, and a benchmark of the CPU time spent on repeat fetches of a large model.
+///
+/// The benchmark only runs when `SPTDATALOADER_BENCHMARKS` is set in the test environment. The following variables
+/// tune it:
+/// - `SPTDATALOADER_BENCHMARK_DECODING_ITEMS`: items in the decoded model (default 10000)
+/// - `SPTDATALOADER_BENCHMARK_DECODING_FETCHES`: repeat fetches of the model (default 100)
+/// - `SPTDATALOADER_BENCHMARK_DECODING_OUTPUT`: the path the JSON report is written to
+class DecodedValueCacheTest: XCTestCase {
+    private let url = URL(string: "https://spclient.wg.spotify.com/thing")!
+    private let body = "{\"foo\": \"bar\"}".data(using: .utf8)
+
+    func test_serialization_shouldReuseDecodedValue_whenEntityTagMatches() throws {
+        // Given
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let serializer = DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+
+        // When
+        let first = try serializer.serialize(response: makeResponse(body: body, headers: ["ETag": "\"1\""]))
+        let second = try serializer.serialize(response: makeResponse(body: body, headers: ["etag": "\"1\""]))
+
+        // Then
+        XCTAssertEqual(first, second)
+        XCTAssertEqual(decoder.decodeCount, 1, "The second response should not have been decoded")
+    }
+
+    func test_serialization_shouldDecode_whenEntityTagChanges() throws {
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let serializer = DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+
+        _ = try serializer.serialize(response: makeResponse(body: body, headers: ["ETag": "\"1\""]))
+        _ = try serializer.serialize(response: makeResponse(body: body, headers: ["ETag": "\"2\""]))
+
+        XCTAssertEqual(decoder.decodeCount, 2)
+    }
+
+    func test_serialization_shouldReuseDecodedValue_whenBodyIsIdenticalWithoutEntityTag() throws {
+        // Given
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let serializer = DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+        let otherBody = "{\"foo\": \"baz\"}".data(using: .utf8)
+
+        // When
+        _ = try serializer.serialize(response: makeResponse(body: body))
+        _ = try serializer.serialize(response: makeResponse(body: body))
+        let changed = try serializer.serialize(response: makeResponse(body: otherBody))
+
+        // Then
+        XCTAssertEqual(decoder.decodeCount, 2, "Only the changed body should have been decoded again")
+        XCTAssertEqual(changed.foo, "baz")
+    }
+
+    func test_serialization_shouldDecode_whenURLOrTypeDiffers() throws {
+        // Given
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let otherURL = URL(string: "https://spclient.wg.spotify.com/other")!
+
+        // When
+        _ = try DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+            .serialize(response: makeResponse(body: body))
+        _ = try DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+            .serialize(response: makeResponse(url: otherURL, body: body))
+        _ = try DecodableResponseSerializer<[String: String]>(decoder: decoder, cache: cache)
+            .serialize(response: makeResponse(body: body))
+
+        // Then
+        XCTAssertEqual(decoder.decodeCount, 3)
+    }
+
+    func test_serialization_shouldNotCacheFailures() {
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let serializer = DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+        let invalidBody = "{\"foo\": 123}".data(using: .utf8)
+
+        XCTAssertThrowsError(try serializer.serialize(response: makeResponse(body: invalidBody)))
+        XCTAssertThrowsError(try serializer.serialize(response: makeResponse(body: invalidBody)))
+        XCTAssertEqual(decoder.decodeCount, 2)
+    }
+
+    func test_removeAllValues_shouldForgetDecodedValues() throws {
+        let cache = DecodedValueCache()
+        let decoder = CountingDecoder()
+        let serializer = DecodableResponseSerializer<TestDecodable>(decoder: decoder, cache: cache)
+
+        _ = try serializer.serialize(response: makeResponse(body: body))
+        cache.removeAllValues()
+        _ = try serializer.serialize(response: makeResponse(body: body))
+
+        XCTAssertEqual(decoder.decodeCount, 2)
+    }
+
+    func test_benchmark_shouldSpendLessCPUTime_whenRepeatFetchesAreCached() throws {
+        let environment = ProcessInfo.processInfo.environment
+        guard environment["SPTDATALOADER_BENCHMARKS"] != nil else {
+            throw XCTSkip("Set SPTDATALOADER_BENCHMARKS to run the decoding benchmark")
+        }
+
+        // Given
+        let itemCount = environment["SPTDATALOADER_BENCHMARK_DECODING_ITEMS"].flatMap(Int.init) ?? 10000
+        let fetchCount = environment["SPTDATALOADER_BENCHMARK_DECODING_FETCHES"].flatMap(Int.init) ?? 100
+        let model = BenchmarkModel(items: (0..<itemCount).map { index in BenchmarkModel.Item(index: index) })
+        let modelBody = try JSONEncoder().encode(model)
+        let decoder = JSONDecoder()
+
+        // When
+        let variants: [(name: String, headers: [String: String]?)] = [
+            ("uncached", nil),
+            ("etag", ["ETag": "\"1\""]),
+            ("bodyHash", [:]),
+        ]
+        var results: [[String: Any]] = []
+        for (name, headers) in variants {
+            let cache = headers.map { _ in DecodedValueCache(totalCostLimit: 4 * modelBody.count) }
+            let serializer = DecodableResponseSerializer<BenchmarkModel>(decoder: decoder, cache: cache)
+            let cpuTime = try measureCPUTime {
+                for _ in 0..<fetchCount {
+                    _ = try serializer.serialize(response: makeResponse(body: modelBody, headers: headers ?? [:]))
+                }
+            }
+            results.append([
+                "name": name,
+                "fetches": fetchCount,
+                "bodySize": modelBody.count,
+                "cpuTime": cpuTime,
+                "cpuTimePerFetch": cpuTime / Double(fetchCount),
+            ])
+        }
+
+        let report: [String: Any] = [
+            "date": Date().timeIntervalSince1970,
+            "items": itemCount,
+            "results": results,
+        ]
+        let outputPath = environment["SPTDATALOADER_BENCHMARK_DECODING_OUTPUT"]
+            ?? (NSTemporaryDirectory() as NSString).appendingPathComponent("sptdataloader-decoding-benchmark.json")
+        let reportURL = URL(fileURLWithPath: outputPath)
+        try JSONSerialization.data(withJSONObject: report, options: .prettyPrinted).write(to: reportURL)
+        add(XCTAttachment(contentsOfFile: reportURL))
+
+        // Then
+        let cpuTimes = results.compactMap { result in result["cpuTime"] as? Double }
+        XCTAssertEqual(cpuTimes.count, 3)
+        XCTAssertLessThan(cpuTimes[1], cpuTimes[0], "Fetches validated by ETag should not be decoded again")
+        XCTAssertLessThan(cpuTimes[2], cpuTimes[0], "Hashing an identical body should be cheaper than decoding it")
+    }
+}
+
+// MARK: - Helpers
+
+private extension DecodedValueCacheTest {
+    final class CountingDecoder: ResponseDecoder {
+        private let decoder = JSONDecoder()
+        private(set) var decodeCount = 0
+
+        func decode<T: Decodable>(_ type: T.Type, from data: Data) throws -> T {
+            decodeCount += 1
+            return try decoder.decode(type, from: data)
+        }
+    }
+
+    struct BenchmarkModel: Codable {
+        struct Item: Codable {
+            let identifier: Int
+            let name: String
+            let uri: String
+            let duration: Double
+            let explicit: Bool
+            let artists: [String]
+
+            init(index: Int) {
+                identifier = index
+                name = "Track \(index)"
+                uri = "spotify:track:\(index)"
+                duration = Double(index) * 1.5
+                explicit = index.isMultiple(of: 2)
+                artists = ["Artist \(index)", "Featured \(index)"]
+            }
+        }
+
+        let items: [Item]
+    }
+
+    func makeResponse(url: URL? = nil, body: Data?, headers: [String: String] = [:]) -> DataLoaderResponseFake {
+        let request = SPTDataLoaderRequest(url: url ?? self.url, sourceIdentifier: nil)
+        return DataLoaderResponseFake(request: request, body: body, headers: headers)
+    }
+
+    func measureCPUTime(_ work: () throws -> Void) rethrows -> TimeInterval {
+        func processCPUTime() -> TimeInterval {
+            var usage = rusage()
+            getrusage(RUSAGE_SELF, &usage)
+            let user = TimeInterval(usage.ru_utime.tv_sec) + TimeInterval(usage.ru_utime.tv_usec) / 1_000_000
+            let system = TimeInterval(usage.ru_stime.tv_sec) + TimeInterval(usage.ru_stime.tv_usec) / 1_000_000
+            return user + system
+        }
+
+        let start = processCPUTime()
+        try work()
+        return processCPUTime() - start
+    }
+}
@@ -0,0 +1,233 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+@testable import SPTDataLoaderSwift
+
+import Foundation
+import XCTest
+
+/// End-to-end benchmarks against a loopback HTTP server.
+///
+/// These only run when `SPTDATALOADER_BENCHMARKS` is set in the test environment. The following variables tune a run:
+/// - `SPTDATALOADER_BENCHMARK_REQUESTS`: requests per driver and concurrency level (default 1000)
+/// - `SPTDATALOADER_BENCHMARK_LATENCY`: server latency in seconds (default 0.005)
+/// - `SPTDATALOADER_BENCHMARK_PAYLOAD`: response body size in bytes (default 16384)
+/// - `SPTDATALOADER_BENCHMARK_ERROR_RATE`: fraction of responses failing with a 500 (default 0)
+/// - `SPTDATALOADER_BENCHMARK_LABEL`: the label of the report, such as a commit hash
+/// - `SPTDATALOADER_BENCHMARK_OUTPUT`: the path the JSON report is written to
+///
+/// The segmented download benchmark fetches a single large resource from a server that throttles every connection:
+/// - `SPTDATALOADER_BENCHMARK_SEGMENTED_PAYLOAD`: resource size in bytes (default 4 MiB)
+/// - `SPTDATALOADER_BENCHMARK_CONNECTION_BANDWIDTH`: bytes per second per connection (default 1 MiB)
+/// - `SPTDATALOADER_BENCHMARK_SEGMENTED_OUTPUT`: the path the JSON report is written to
+class LoopbackBenchmarkTest: XCTestCase {
+    private let environment = ProcessInfo.processInfo.environment
+    private let concurrencyLevels = [1, 8, 32]
+    private let segmentCounts = [1, 2, 4, 8]
+
+    func test_benchmark_shouldWriteReport_whenRunAgainstLoopbackServer() throws {
+        guard environment["SPTDATALOADER_BENCHMARKS"] != nil else {
+            throw XCTSkip("Set SPTDATALOADER_BENCHMARKS to run the loopback benchmarks")
+        }
+        guard #available(macOS 10.14, iOS 12.0, tvOS 12.0, watchOS 5.0, *) else {
+            throw XCTSkip("The loopback server requires Network.framework")
+        }
+
+        // Given
+        var serverConfiguration = LoopbackServer.Configuration()
+        serverConfiguration.latency = environment["SPTDATALOADER_BENCHMARK_LATENCY"].flatMap(Double.init) ?? 0.005
+        serverConfiguration.payloadSize = environment["SPTDATALOADER_BENCHMARK_PAYLOAD"].flatMap(Int.init) ?? 16 * 1024
+        serverConfiguration.errorRate = environment["SPTDATALOADER_BENCHMARK_ERROR_RATE"].flatMap(Double.init) ?? 0
+        let requestCount = environment["SPTDATALOADER_BENCHMARK_REQUESTS"].flatMap(Int.init) ?? 1000
+
+        let server = try LoopbackServer(configuration: serverConfiguration)
+        let url = try server.start()
+        defer { server.stop() }
+
+        let drivers: [(name: String, makeDriver: (Int) -> LoopbackBenchmark.Driver)] = [
+            ("URLSession", makeURLSessionDriver),
+            ("SPTDataLoader", makeBlockWrapperDriver),
+            ("DataLoader", makeSwiftDataLoaderDriver),
+        ]
+
+        // When
+        var results: [LoopbackBenchmark.Result] = []
+        for concurrency in concurrencyLevels {
+            for (name, makeDriver) in drivers {
+                let benchmark = LoopbackBenchmark(
+                    name: name,
+                    concurrency: concurrency,
+                    requestCount: requestCount,
+                    payloadSize: serverConfiguration.payloadSize,
+                    serverLatency: serverConfiguration.latency
+                )
+                let result = benchmark.run(url: url, timeout: 300, driver: makeDriver(concurrency))
+                results.append(try XCTUnwrap(result, "\(name) at concurrency \(concurrency) timed out"))
+            }
+        }
+
+        let report = LoopbackBenchmark.Report(
+            label: environment["SPTDATALOADER_BENCHMARK_LABEL"] ?? "local",
+            date: Date(),
+            results: results
+        )
+        let reportURL = try report.write()
+
+        // Then
+        XCTAssertEqual(results.count, concurrencyLevels.count * drivers.count)
+        XCTAssertTrue(FileManager.default.fileExists(atPath: reportURL.path))
+        add(XCTAttachment(contentsOfFile: reportURL))
+    }
+
+    func test_benchmark_shouldScaleThroughputWithSegmentCount_whenConnectionsAreThrottled() throws {
+        guard environment["SPTDATALOADER_BENCHMARKS"] != nil else {
+            throw XCTSkip("Set SPTDATALOADER_BENCHMARKS to run the loopback benchmarks")
+        }
+        guard #available(macOS 10.14, iOS 12.0, tvOS 12.0, watchOS 5.0, *) else {
+            throw XCTSkip("The loopback server requires Network.framework")
+        }
+
+        // Given
+        var serverConfiguration = LoopbackServer.Configuration()
+        serverConfiguration.payloadSize = environment["SPTDATALOADER_BENCHMARK_SEGMENTED_PAYLOAD"].flatMap(Int.init) ?? 4 * 1024 * 1024
+        serverConfiguration.bytesPerSecondPerConnection = environment["SPTDATALOADER_BENCHMARK_CONNECTION_BANDWIDTH"]
+            .flatMap(Int.init) ?? 1024 * 1024
+        let requestCount = 3
+
+        let server = try LoopbackServer(configuration: serverConfiguration)
+        let url = try server.start()
+        defer { server.stop() }
+
+        // When
+        var results: [LoopbackBenchmark.Result] = []
+        for segmentCount in segmentCounts {
+            let benchmark = LoopbackBenchmark(
+                name: "SPTDataLoader segments=\(segmentCount)",
+                concurrency: 1,
+                requestCount: requestCount,
+                payloadSize: serverConfiguration.payloadSize,
+                serverLatency: serverConfiguration.latency
+            )
+            let driver = makeSegmentedDriver(segmentCount: segmentCount, payloadSize: serverConfiguration.payloadSize)
+            let result = benchmark.run(url: url, timeout: 600, driver: driver)
+            results.append(try XCTUnwrap(result, "\(segmentCount) segments timed out"))
+        }
+
+        let report = LoopbackBenchmark.Report(
+            label: environment["SPTDATALOADER_BENCHMARK_LABEL"] ?? "local",
+            date: Date(),
+            results: results
+        )
+        let reportURL = try report.write(outputVariable: "SPTDATALOADER_BENCHMARK_SEGMENTED_OUTPUT")
+
+        // Then
+        XCTAssertTrue(results.allSatisfy { $0.failedRequestCount == 0 })
+        let singleSegment = try XCTUnwrap(results.first)
+        let mostSegments = try XCTUnwrap(results.last)
+        XCTAssertGreaterThan(
+            mostSegments.requestsPerSecond,
+            singleSegment.requestsPerSecond * 2,
+            "Segments should spread the download over throttled connections"
+        )
+        add(XCTAttachment(contentsOfFile: reportURL))
+    }
+
+    // MARK: Drivers
+
+    private func makeConfiguration(concurrency: Int) -> URLSessionConfiguration {
+        let configuration = URLSessionConfiguration.ephemeral
+        configuration.httpMaximumConnectionsPerHost = concurrency
+        configuration.httpShouldUsePipelining = false
+        configuration.urlCache = nil
+        return configuration
+    }
+
+    private static func sample(statusCode: Int, headers: [AnyHashable: Any]?, error: Error?) -> LoopbackBenchmark.Sample {
+        let serverTime = headers?
+            .first { key, _ in (key as? String)?.caseInsensitiveCompare(LoopbackBenchmark.serverTimeHeader) == .orderedSame }
+            .flatMap { _, value in (value as? String).flatMap(Double.init) }
+        return LoopbackBenchmark.Sample(serverTime: serverTime, succeeded: error == nil && statusCode == 200)
+    }
+
+    /// Plain `URLSession`, the baseline the library overhead is measured against.
+    private func makeURLSessionDriver(concurrency: Int) -> LoopbackBenchmark.Driver {
+        let session = URLSession(configuration: makeConfiguration(concurrency: concurrency))
+
+        return { url, completion in
+            session.dataTask(with: url) { _, response, error in
+                let httpResponse = response as? HTTPURLResponse
+                completion(Self.sample(
+                    statusCode: httpResponse?.statusCode ?? 0,
+                    headers: httpResponse?.allHeaderFields,
+                    error: error
+                ))
+            }.resume()
+        }
+    }
+
+    /// `SPTDataLoaderService` and `SPTDataLoader` through the block wrapper.
+    private func makeBlockWrapperDriver(concurrency: Int) -> LoopbackBenchmark.Driver {
+        let service = SPTDataLoaderService(
+            configuration: makeConfiguration(concurrency: concurrency),
+            rateLimiter: nil,
+            resolver: nil
+        )
+        let dataLoader = service.createDataLoaderFactory(with: nil).createDataLoader()
+        dataLoader.delegateQueue = DispatchQueue(label: "com.spotify.sptdataloader.benchmark.delegate")
+        let blockWrapper = SPTDataLoaderBlockWrapper(dataLoader: dataLoader)
+
+        return { url, completion in
+            let request = SPTDataLoaderRequest(url: url, sourceIdentifier: "benchmark")
+            _ = blockWrapper.perform(request) { response, error in
+                completion(Self.sample(
+                    statusCode: response.statusCode.rawValue,
+                    headers: response.responseHeaders,
+                    error: error
+                ))
+            }
+        }
+    }
+
+    /// `SPTDataLoaderService` splitting every download into `segmentCount` ranges.
+    private func makeSegmentedDriver(segmentCount: Int, payloadSize: Int) -> LoopbackBenchmark.Driver {
+        let service = SPTDataLoaderService(
+            configuration: makeConfiguration(concurrency: segmentCount),
+            rateLimiter: nil,
+            resolver: nil
+        )
+        let dataLoader = service.createDataLoaderFactory(with: nil).createDataLoader()
+        let blockWrapper = SPTDataLoaderBlockWrapper(dataLoader: dataLoader)
+
+        return { url, completion in
+            let request = SPTDataLoaderRequest(url: url, sourceIdentifier: "benchmark")
+            request.segmentCount = segmentCount
+            request.minimumSegmentSize = max(payloadSize / (segmentCount * 4), 64 * 1024)
+            _ = blockWrapper.perform(request) { response, error in
+                let complete = response.body?.count == payloadSize
+                completion(Self.sample(
+                    statusCode: complete ? response.statusCode.rawValue : 0,
+                    headers: response.responseHeaders,
+                    error: error
+                ))
+            }
+        }
+    }
+
+    /// The Swift `DataLoader`.
+    private func makeSwiftDataLoaderDriver(concurrency: Int) -> LoopbackBenchmark.Driver {
+        let service = SPTDataLoaderService(
+            configuration: makeConfiguration(concurrency: concurrency),
+            rateLimiter: nil,
+            resolver: nil
+        )
+        let dataLoader = service.createDataLoaderFactory(with: nil).makeDataLoader()
+
+        return { url, completion in
+            dataLoader.request(url, sourceIdentifier: "benchmark").responseData { response in
+                let sptResponse = response.response
+                let statusCode = sptResponse?.statusCode.rawValue ?? 0
+                completion(Self.sample(statusCode: statusCode, headers: sptResponse?.responseHeaders, error: response.error))
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+@testable import SPTDataLoaderSwift
+
+import Foundation
+import XCTest
+
+class RequestBatchTest: XCTestCase {
+    private var executedRequests: [SPTDataLoaderRequest] = []
+
+    override func setUp() {
+        super.setUp()
+        executedRequests = []
+    }
+
+    private func makeRequests(count: Int) throws -> [(request: Request, sptRequest: SPTDataLoaderRequest)] {
+        return try (0..<count).map { index in
+            let url = try XCTUnwrap(URL(string: "https://foo.bar/\(index).json"))
+            let sptRequest = SPTDataLoaderRequest(url: url, sourceIdentifier: nil)
+            let request = Request(request: sptRequest) { [unowned self] _ in
+                self.executedRequests.append(sptRequest)
+                return CancellationTokenFake()
+            }
+
+            return (request, sptRequest)
+        }
+    }
+
+    // MARK: Execution
+
+    func test_batch_shouldExecuteAllRequests_whenUnlimited() throws {
+        // Given
+        let requests = try makeRequests(count: 3)
+        let batch = RequestBatch(requests: requests.map { $0.request })
+
+        // When
+        batch.responseData { _ in }
+
+        // Then
+        XCTAssertEqual(executedRequests, requests.map { $0.sptRequest })
+    }
+
+    func test_batch_shouldExecuteNextRequest_whenInFlightRequestCompletes() throws {
+        // Given
+        let requests = try makeRequests(count: 3)
+        let batch = RequestBatch(requests: requests.map { $0.request }, maximumConcurrentRequests: 2)
+
+        // When
+        batch.responseData { _ in }
+        let executedBeforeCompletion = executedRequests
+        requests[0].request.processResponse(DataLoaderResponseFake(request: requests[0].sptRequest))
+
+        // Then
+        XCTAssertEqual(executedBeforeCompletion, [requests[0].sptRequest, requests[1].sptRequest])
+        XCTAssertEqual(executedRequests, requests.map { $0.sptRequest })
+    }
+
+    // MARK: Completion
+
+    func test_batch_shouldCompleteWithResponsesInRequestOrder_whenAllRequestsComplete() throws {
+        // Given
+        let requests = try makeRequests(count: 3)
+        let batch = RequestBatch(requests: requests.map { $0.request })
+
+        // When
+        var itemIndices: [Int] = []
+        var batchResponses: [Response<Data, Error>]?
+        batch.responseData(
+            itemHandler: { index, _ in itemIndices.append(index) },
+            completionHandler: { batchResponses = $0 }
+        )
+        for (request, sptRequest) in requests.reversed() {
+            let body = Data(sptRequest.url.lastPathComponent.utf8)
+            request.processResponse(DataLoaderResponseFake(request: sptRequest, body: body))
+        }
+
+        // Then
+        let responses = try XCTUnwrap(batchResponses)
+        XCTAssertEqual(itemIndices, [2, 1, 0])
+        XCTAssertEqual(
+            try responses.map { try $0.result.get() },
+            requests.map { Data($0.sptRequest.url.lastPathComponent.utf8) }
+        )
+    }
+
+    func test_batch_shouldCompleteImmediately_whenEmpty() {
+        // Given
+        let batch = RequestBatch(requests: [])
+
+        // When
+        var batchResponses: [Response<Data, Error>]?
+        batch.responseData { batchResponses = $0 }
+
+        // Then
+        XCTAssertEqual(batchResponses?.count, 0)
+    }
+
+    // MARK: Cancellation
+
+    func test_batch_shouldCancelRequestsAndNotComplete_whenCancelled() throws {
+        // Given
+        let requests = try makeRequests(count: 3)
+        let batch = RequestBatch(requests: requests.map { $0.request }, maximumConcurrentRequests: 1)
+
+        // When
+        var didComplete = false
+        batch.responseData { _ in didComplete = true }
+        batch.cancel()
+        requests[0].request.processResponse(DataLoaderResponseFake(request: requests[0].sptRequest))
+
+        // Then
+        XCTAssertTrue(batch.isCancelled)
+        XCTAssertTrue(requests.allSatisfy { $0.request.isCancelled })
+        XCTAssertEqual(executedRequests, [requests[0].sptRequest])
+        XCTAssertFalse(didComplete)
+    }
+}
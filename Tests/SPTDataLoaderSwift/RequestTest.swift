@@ -725,6 +725,38 @@ class RequestTest: XCTestCase {
         XCTAssertEqual(actualResponse.response, responseFake)
     }
 
+    func test_decodableResponseHandler_shouldDeliverOnDeliveryQueue_whenSerializationContextIsPresent() throws {
+        // Given
+        let url = try XCTUnwrap(URL(string: "https://foo.bar/baz.json"))
+        let sptRequest = SPTDataLoaderRequest(url: url, sourceIdentifier: nil)
+        let responseBody = "{\"foo\": \"bar\"}".data(using: .utf8)
+        let responseFake = DataLoaderResponseFake(request: sptRequest, body: responseBody)
+        let deliveryQueueKey = DispatchSpecificKey<Void>()
+        let deliveryQueue = DispatchQueue(label: "com.spotify.sptdataloaderswift.test.delivery")
+        deliveryQueue.setSpecific(key: deliveryQueueKey, value: ())
+        let serializationContext = Request.SerializationContext(
+            executor: ResponseSerializationExecutor(maximumConcurrency: 2),
+            deliveryQueue: deliveryQueue
+        )
+
+        // When
+        let responseExpectation = expectation(description: "Response expected")
+        var response: Response<TestDecodable, Error>?
+        var isDeliveredOnDeliveryQueue = false
+        Request(request: sptRequest, serializationContext: serializationContext) { _ in
+            return CancellationTokenFake()
+        }.responseDecodable {
+            response = $0
+            isDeliveredOnDeliveryQueue = DispatchQueue.getSpecific(key: deliveryQueueKey) != nil
+            responseExpectation.fulfill()
+        }.processResponse(responseFake)
+        wait(for: [responseExpectation], timeout: 1)
+
+        // Then
+        XCTAssertTrue(isDeliveredOnDeliveryQueue)
+        XCTAssertEqual(response?.value, TestDecodable(foo: "bar"))
+    }
+
     // MARK: JSON Response Handler
 
     func test_jsonResponseHandler_shouldReceiveFailure_whenErrorIsPresent() throws {
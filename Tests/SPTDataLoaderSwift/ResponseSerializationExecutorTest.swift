@@ -0,0 +1,113 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+@testable import SPTDataLoaderSwift
+
+import Foundation
+import XCTest
+
+class ResponseSerializationExecutorTest: XCTestCase {
+    private struct Payload: Decodable {
+        let items: [Item]
+
+        struct Item: Decodable {
+            let identifier: Int
+            let name: String
+            let tags: [String]
+        }
+    }
+
+    private static let payloadCount = 100
+    private static let payloadBody = makePayloadBody(approximateSize: 1024 * 1024)
+
+    // MARK: Concurrency
+
+    func test_executor_shouldClampMaximumConcurrency_whenNotPositive() {
+        // Given
+        let executor = ResponseSerializationExecutor(maximumConcurrency: 0)
+
+        // Then
+        XCTAssertEqual(executor.maximumConcurrency, 1)
+    }
+
+    func test_executor_shouldNotExceedMaximumConcurrency_whenSaturated() {
+        // Given
+        let executor = ResponseSerializationExecutor(maximumConcurrency: 2)
+        let accessLock = AccessLock()
+        var runningCount = 0
+        var maximumRunningCount = 0
+
+        // When
+        let group = DispatchGroup()
+        for _ in 0..<20 {
+            group.enter()
+            executor.execute {
+                accessLock.sync {
+                    runningCount += 1
+                    maximumRunningCount = max(maximumRunningCount, runningCount)
+                }
+                Thread.sleep(forTimeInterval: 0.005)
+                accessLock.sync { runningCount -= 1 }
+                group.leave()
+            }
+        }
+
+        // Then
+        XCTAssertEqual(group.wait(timeout: .now() + 5), .success)
+        XCTAssertLessThanOrEqual(maximumRunningCount, 2)
+    }
+
+    // MARK: Benchmarks
+
+    // Decodes 100 payloads of ~1 MB each; compare the two measurements to see wall-clock scaling with core count.
+
+    func test_benchmark_decodeConcurrentPayloads_onSingleCore() {
+        measureConcurrentDecoding(maximumConcurrency: 1)
+    }
+
+    func test_benchmark_decodeConcurrentPayloads_onAllCores() {
+        measureConcurrentDecoding(maximumConcurrency: ProcessInfo.processInfo.activeProcessorCount)
+    }
+
+    private func measureConcurrentDecoding(maximumConcurrency: Int) {
+        let executor = ResponseSerializationExecutor(maximumConcurrency: maximumConcurrency)
+        let deliveryQueue = DispatchQueue(label: "com.spotify.sptdataloaderswift.test.delivery")
+        let url = URL(string: "https://foo.bar/baz.json")!
+
+        measure {
+            let group = DispatchGroup()
+
+            for _ in 0..<Self.payloadCount {
+                let sptRequest = SPTDataLoaderRequest(url: url, sourceIdentifier: nil)
+                let responseFake = DataLoaderResponseFake(request: sptRequest, body: Self.payloadBody)
+                let serializationContext = Request.SerializationContext(executor: executor, deliveryQueue: deliveryQueue)
+
+                group.enter()
+                Request(request: sptRequest, serializationContext: serializationContext) { _ in
+                    return CancellationTokenFake()
+                }.responseDecodable(type: Payload.self) { response in
+                    XCTAssertNotNil(response.value)
+                    group.leave()
+                }.processResponse(responseFake)
+            }
+
+            XCTAssertEqual(group.wait(timeout: .now() + 60), .success)
+        }
+    }
+
+    private static func makePayloadBody(approximateSize: Int) -> Data {
+        var json = "{\"items\":["
+        var identifier = 0
+
+        while json.utf8.count < approximateSize {
+            if identifier > 0 {
+                json += ","
+            }
+            json += "{\"identifier\":\(identifier),\"name\":\"item-\(identifier)\",\"tags\":[\"foo\",\"bar\",\"baz\"]}"
+            identifier += 1
+        }
+
+        json += "]}"
+        return Data(json.utf8)
+    }
+}
@@ -0,0 +1,179 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+import Foundation
+
+/// Drives a request function at a fixed concurrency and collects throughput, latency and resource usage.
+struct LoopbackBenchmark {
+    /// The response header in which the server reports the time it spent on a request, in seconds.
+    static let serverTimeHeader = "X-Server-Time"
+
+    /// The outcome of a single request, as reported by the driver.
+    struct Sample {
+        /// The time the server reported spending on the request, if the response carried it.
+        let serverTime: TimeInterval?
+        let succeeded: Bool
+    }
+
+    /// Performs one request against the given URL and calls the completion exactly once.
+    typealias Driver = (_ url: URL, _ completion: @escaping (Sample) -> Void) -> Void
+
+    struct Result: Codable {
+        let driver: String
+        let concurrency: Int
+        let requestCount: Int
+        let failedRequestCount: Int
+        let payloadSize: Int
+        let serverLatency: TimeInterval
+        let duration: TimeInterval
+        let requestsPerSecond: Double
+        let latencyP50: TimeInterval
+        let latencyP99: TimeInterval
+        let latencyP999: TimeInterval
+        let overheadPerRequest: TimeInterval
+        let cpuTime: TimeInterval
+        let cpuTimePerRequest: TimeInterval
+        let mallocBlocksInUseDelta: Int
+        let mallocBytesInUseDelta: Int
+    }
+
+    struct Report: Codable {
+        let label: String
+        let date: Date
+        let results: [Result]
+    }
+
+    let name: String
+    let concurrency: Int
+    let requestCount: Int
+    let payloadSize: Int
+    let serverLatency: TimeInterval
+
+    func run(url: URL, timeout: TimeInterval, driver: @escaping Driver) -> Result? {
+        let lock = NSLock()
+        var latencies: [TimeInterval] = []
+        var overheads: [TimeInterval] = []
+        var failedRequestCount = 0
+        var startedRequestCount = 0
+        latencies.reserveCapacity(requestCount)
+        overheads.reserveCapacity(requestCount)
+
+        let group = DispatchGroup()
+
+        func startNextRequest() {
+            lock.lock()
+            guard startedRequestCount < requestCount else {
+                lock.unlock()
+                return
+            }
+            startedRequestCount += 1
+            lock.unlock()
+
+            group.enter()
+            let startTime = DispatchTime.now().uptimeNanoseconds
+            driver(url) { sample in
+                let latency = Double(DispatchTime.now().uptimeNanoseconds - startTime) / 1e9
+
+                lock.lock()
+                latencies.append(latency)
+                overheads.append(latency - (sample.serverTime ?? 0))
+                failedRequestCount += sample.succeeded ? 0 : 1
+                lock.unlock()
+
+                startNextRequest()
+                group.leave()
+            }
+        }
+
+        let resourcesBefore = ResourceUsage.current()
+        let startTime = DispatchTime.now().uptimeNanoseconds
+
+        for _ in 0..<concurrency {
+            startNextRequest()
+        }
+
+        guard group.wait(timeout: .now() + timeout) == .success else {
+            return nil
+        }
+
+        let duration = Double(DispatchTime.now().uptimeNanoseconds - startTime) / 1e9
+        let resourcesAfter = ResourceUsage.current()
+        let cpuTime = resourcesAfter.cpuTime - resourcesBefore.cpuTime
+
+        latencies.sort()
+
+        return Result(
+            driver: name,
+            concurrency: concurrency,
+            requestCount: requestCount,
+            failedRequestCount: failedRequestCount,
+            payloadSize: payloadSize,
+            serverLatency: serverLatency,
+            duration: duration,
+            requestsPerSecond: Double(requestCount) / duration,
+            latencyP50: percentile(0.5, of: latencies),
+            latencyP99: percentile(0.99, of: latencies),
+            latencyP999: percentile(0.999, of: latencies),
+            overheadPerRequest: overheads.reduce(0, +) / Double(max(overheads.count, 1)),
+            cpuTime: cpuTime,
+            cpuTimePerRequest: cpuTime / Double(requestCount),
+            mallocBlocksInUseDelta: resourcesAfter.mallocBlocksInUse - resourcesBefore.mallocBlocksInUse,
+            mallocBytesInUseDelta: resourcesAfter.mallocBytesInUse - resourcesBefore.mallocBytesInUse
+        )
+    }
+
+    private func percentile(_ percentile: Double, of sortedValues: [TimeInterval]) -> TimeInterval {
+        guard !sortedValues.isEmpty else {
+            return 0
+        }
+
+        let index = Int((Double(sortedValues.count - 1) * percentile).rounded(.up))
+        return sortedValues[min(index, sortedValues.count - 1)]
+    }
+}
+
+// MARK: -
+
+extension LoopbackBenchmark.Report {
+    /// Writes the report as JSON to the path in `outputVariable`, or to the temporary directory when unset.
+    func write(
+        environment: [String: String] = ProcessInfo.processInfo.environment,
+        outputVariable: String = "SPTDATALOADER_BENCHMARK_OUTPUT"
+    ) throws -> URL {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        encoder.dateEncodingStrategy = .iso8601
+
+        let url = environment[outputVariable].map { URL(fileURLWithPath: $0) }
+            ?? URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("SPTDataLoaderBenchmark-\(label).json")
+        try encoder.encode(self).write(to: url, options: .atomic)
+
+        return url
+    }
+}
+
+// MARK: -
+
+private struct ResourceUsage {
+    let cpuTime: TimeInterval
+    let mallocBlocksInUse: Int
+    let mallocBytesInUse: Int
+
+    static func current() -> ResourceUsage {
+        var usage = rusage()
+        getrusage(RUSAGE_SELF, &usage)
+
+        var statistics = malloc_statistics_t()
+        malloc_zone_statistics(nil, &statistics)
+
+        return ResourceUsage(
+            cpuTime: usage.ru_utime.timeInterval + usage.ru_stime.timeInterval,
+            mallocBlocksInUse: Int(statistics.blocks_in_use),
+            mallocBytesInUse: Int(statistics.size_in_use)
+        )
+    }
+}
+
+private extension timeval {
+    var timeInterval: TimeInterval { TimeInterval(tv_sec) + TimeInterval(tv_usec) / 1e6 }
+}
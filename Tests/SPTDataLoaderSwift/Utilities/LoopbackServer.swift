@@ -0,0 +1,189 @@
+// Copyright Spotify AB.
+// SPDX-License-Identifier: Apache-2.0
+
+import Foundation
+import Network
+
+/// A minimal HTTP/1.1 server listening on the loopback interface, used to measure the library end to end.
+///
+/// Every request is answered after `latency` with a body of `payloadSize` bytes, or with a 500 status code at the
+/// configured `errorRate`. The time the server spent on a request is reported in the
+/// `LoopbackBenchmark.serverTimeHeader` header, so that callers can subtract it from the latency they observe.
+///
+/// Single `Range` requests are answered with a 206 carrying a strong `ETag`, and `bytesPerSecondPerConnection` caps
+/// how fast each connection sends, which models a server that limits the bandwidth of a single stream.
+@available(macOS 10.14, iOS 12.0, tvOS 12.0, watchOS 5.0, *)
+final class LoopbackServer {
+    struct Configuration {
+        var latency: TimeInterval = 0
+        var payloadSize: Int = 1024
+        var errorRate: Double = 0
+        /// The bandwidth of every connection, or 0 for no limit.
+        var bytesPerSecondPerConnection: Int = 0
+    }
+
+    /// The number of slices a throttled connection sends its bytes in every second.
+    private static let throttleSlicesPerSecond = 20
+    private static let entityTag = "\"loopback\""
+
+    let configuration: Configuration
+
+    private let listener: NWListener
+    private let queue = DispatchQueue(label: "com.spotify.sptdataloader.loopbackserver", attributes: .concurrent)
+    private let payload: Data
+
+    init(configuration: Configuration) throws {
+        self.configuration = configuration
+        self.payload = Data(repeating: 0x2A, count: configuration.payloadSize)
+
+        let parameters = NWParameters.tcp
+        parameters.requiredInterfaceType = .loopback
+        parameters.allowLocalEndpointReuse = true
+        listener = try NWListener(using: parameters)
+    }
+
+    /// Starts listening and returns the base URL of the server once it is ready.
+    func start(timeout: TimeInterval = 5) throws -> URL {
+        let readySemaphore = DispatchSemaphore(value: 0)
+        var startError: Error?
+
+        listener.stateUpdateHandler = { state in
+            switch state {
+            case .ready:
+                readySemaphore.signal()
+            case .failed(let error):
+                startError = error
+                readySemaphore.signal()
+            default:
+                break
+            }
+        }
+        listener.newConnectionHandler = { [weak self] connection in
+            self?.accept(connection)
+        }
+        listener.start(queue: queue)
+
+        guard readySemaphore.wait(timeout: .now() + timeout) == .success else {
+            throw URLError(.timedOut)
+        }
+        if let startError = startError {
+            throw startError
+        }
+        guard let port = listener.port?.rawValue, let url = URL(string: "http://127.0.0.1:\(port)/") else {
+            throw URLError(.cannotConnectToHost)
+        }
+
+        return url
+    }
+
+    func stop() {
+        listener.cancel()
+    }
+
+    // MARK: Connection handling
+
+    private func accept(_ connection: NWConnection) {
+        connection.start(queue: queue)
+        receive(on: connection, buffer: Data())
+    }
+
+    private func receive(on connection: NWConnection, buffer: Data) {
+        connection.receive(minimumIncompleteLength: 1, maximumLength: 64 * 1024) { [weak self] data, _, isComplete, error in
+            guard let self = self else {
+                return
+            }
+
+            var buffer = buffer
+            data.map { buffer.append($0) }
+
+            // Requests are bodiless GETs, so every header terminator marks a complete request
+            let terminator = Data("\r\n\r\n".utf8)
+            while let range = buffer.range(of: terminator) {
+                let head = String(decoding: buffer[buffer.startIndex..<range.lowerBound], as: UTF8.self)
+                buffer.removeSubrange(buffer.startIndex..<range.upperBound)
+                self.respond(on: connection, byteRange: self.byteRange(inHead: head), receivedAt: DispatchTime.now())
+            }
+
+            if isComplete || error != nil {
+                connection.cancel()
+            } else {
+                self.receive(on: connection, buffer: buffer)
+            }
+        }
+    }
+
+    /// Returns the bytes a `Range: bytes=<first>-[<last>]` header asks for, clamped to the payload.
+    private func byteRange(inHead head: String) -> ClosedRange<Int>? {
+        let prefix = "range: bytes="
+        guard
+            let line = head.components(separatedBy: "\r\n").first(where: { $0.lowercased().hasPrefix(prefix) }),
+            !payload.isEmpty
+        else {
+            return nil
+        }
+
+        let bounds = line.dropFirst(prefix.count).split(separator: "-", omittingEmptySubsequences: false)
+        guard bounds.count == 2, let firstByte = Int(bounds[0]), firstByte < payload.count else {
+            return nil
+        }
+        let lastByte = bounds[1].isEmpty ? payload.count - 1 : Int(bounds[1]).map { min($0, payload.count - 1) }
+        guard let lastByte = lastByte, firstByte <= lastByte else {
+            return nil
+        }
+
+        return firstByte...lastByte
+    }
+
+    private func respond(on connection: NWConnection, byteRange: ClosedRange<Int>?, receivedAt: DispatchTime) {
+        let failed = Double.random(in: 0..<1) < configuration.errorRate
+
+        queue.asyncAfter(deadline: receivedAt + configuration.latency) { [weak self, payload] in
+            var status = "HTTP/1.1 200 OK"
+            var body = payload
+            var rangeHeaders: [String] = []
+            if failed {
+                status = "HTTP/1.1 500 Internal Server Error"
+                body = Data()
+            } else if let byteRange = byteRange {
+                status = "HTTP/1.1 206 Partial Content"
+                body = payload.subdata(in: byteRange.lowerBound..<(byteRange.upperBound + 1))
+                rangeHeaders = ["Content-Range: bytes \(byteRange.lowerBound)-\(byteRange.upperBound)/\(payload.count)"]
+            }
+
+            let serverTime = Double(DispatchTime.now().uptimeNanoseconds - receivedAt.uptimeNanoseconds) / 1e9
+            let head = ([
+                status,
+                "Content-Length: \(body.count)",
+                "Content-Type: application/octet-stream",
+                "Accept-Ranges: bytes",
+                "ETag: \(Self.entityTag)",
+                "Connection: keep-alive",
+                "\(LoopbackBenchmark.serverTimeHeader): \(serverTime)",
+            ] + rangeHeaders + [
+                "",
+                "",
+            ]).joined(separator: "\r\n")
+
+            self?.send(Data(head.utf8) + body, on: connection)
+        }
+    }
+
+    private func send(_ data: Data, on connection: NWConnection) {
+        guard configuration.bytesPerSecondPerConnection > 0 else {
+            connection.send(content: data, completion: .idempotent)
+            return
+        }
+
+        let sliceSize = max(configuration.bytesPerSecondPerConnection / Self.throttleSlicesPerSecond, 1)
+        let slice = data.prefix(sliceSize)
+        let remainder = data.dropFirst(slice.count)
+        connection.send(content: slice, completion: .contentProcessed { [weak self] error in
+            guard let self = self, error == nil, !remainder.isEmpty else {
+                return
+            }
+            self.queue.asyncAfter(deadline: .now() + 1 / Double(Self.throttleSlicesPerSecond)) {
+                self.send(remainder, on: connection)
+            }
+        })
+    }
+}
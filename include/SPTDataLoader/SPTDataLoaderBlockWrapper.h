@@ -11,6 +11,7 @@
 @protocol SPTDataLoaderCancellationToken;
 
 typedef void (^SPTDataLoaderBlockCompletion)(SPTDataLoaderResponse * _Nonnull response, NSError *_Nullable error);
+typedef void (^SPTDataLoaderBlockBatchCompletion)(NSArray<SPTDataLoaderResponse *> * _Nonnull responses);
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -31,6 +32,21 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable id<SPTDataLoaderCancellationToken>)performRequest:(SPTDataLoaderRequest *)request
                                                    completion:(SPTDataLoaderBlockCompletion)completion;
 
+/// Performs a batch of requests as one unit and returns a cancellation token associated with the whole batch.
+/// @discussion At most `maximumConcurrentRequests` requests are in flight at any time, the rest are performed as
+/// earlier ones complete. Every request receives exactly one item completion, requests that are cancelled receive a
+/// response with an `NSURLErrorCancelled` error. Once every request has completed the batch completion is called
+/// with the responses in the order of the requests.
+/// @param requests The objects describing the kind of requests to be performed
+/// @param maximumConcurrentRequests The maximum number of requests in flight at once, or 0 for no limit
+/// @param itemCompletion A completion block called with the response and an error object of each request
+/// @param completion A completion block called once with the responses of every request in the batch
+/// @return A cancellation token that cancels every request in the batch that has not yet completed
+- (id<SPTDataLoaderCancellationToken>)performRequests:(NSArray<SPTDataLoaderRequest *> *)requests
+                            maximumConcurrentRequests:(NSUInteger)maximumConcurrentRequests
+                                       itemCompletion:(nullable SPTDataLoaderBlockCompletion)itemCompletion
+                                           completion:(SPTDataLoaderBlockBatchCompletion)completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
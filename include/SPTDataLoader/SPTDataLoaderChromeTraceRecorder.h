@@ -0,0 +1,50 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A tracer that records the phases of requests to a file in the Chrome trace-event format
+ @discussion Every phase becomes an async span keyed by the uniqueIdentifier of its request, carrying the service key
+ and the sourceIdentifier of the request, so a recorded session can be opened in chrome://tracing or Perfetto. Events
+ are buffered and written on a private queue, the threads the requests run on only pay for handing them over. The
+ file is a JSON array that is only terminated on close, which trace viewers accept, so a file that was flushed but
+ never closed can still be loaded.
+ */
+@interface SPTDataLoaderChromeTraceRecorder : NSObject <SPTDataLoaderTracer>
+
+/**
+ The file the trace is written to
+ */
+@property (nonatomic, copy, readonly) NSURL *fileURL;
+
+/**
+ Class constructor
+ @param fileURL The file to write the trace to, it is replaced if it exists
+ @param error Set to the reason the file could not be created
+ @return The recorder, or nil if the file could not be created
+ */
++ (nullable instancetype)chromeTraceRecorderWithFileURL:(NSURL *)fileURL error:(NSError * _Nullable * _Nullable)error;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Writes every event recorded so far to the file, returning once they have been written
+ */
+- (void)flush;
+/**
+ Writes every event recorded so far, terminates the trace and closes the file
+ @discussion Events of phases that end after the recorder has been closed are dropped. Closing is also done when the
+ recorder is deallocated.
+ */
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
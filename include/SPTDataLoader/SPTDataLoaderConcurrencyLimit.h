@@ -0,0 +1,50 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A snapshot of the adaptive concurrency limit of a service and the signals it was derived from
+ */
+@interface SPTDataLoaderConcurrencyLimit : NSObject
+
+/**
+ The service the limit applies to, made of the scheme, host and first path component of its URLs
+ */
+@property (nonatomic, copy, readonly) NSString *service;
+/**
+ The number of requests allowed in flight at the same time
+ */
+@property (nonatomic, assign, readonly) NSUInteger limit;
+/**
+ The number of requests currently in flight
+ */
+@property (nonatomic, assign, readonly) NSUInteger inFlightCount;
+/**
+ The number of requests waiting for a request in flight to complete
+ */
+@property (nonatomic, assign, readonly) NSUInteger queuedCount;
+/**
+ The round-trip time the service answers in when it is not congested
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval baselineRoundTripTime;
+/**
+ The moving average of recent round-trip times
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval smoothedRoundTripTime;
+/**
+ The number of 429 and 503 responses and timeouts received from the service
+ */
+@property (nonatomic, assign, readonly) NSUInteger congestionSignalCount;
+/**
+ The number of times the limit has been cut
+ */
+@property (nonatomic, assign, readonly) NSUInteger decreaseCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
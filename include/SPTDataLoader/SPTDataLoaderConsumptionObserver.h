@@ -24,6 +24,20 @@ NS_ASSUME_NONNULL_BEGIN
                  bytesDownloaded:(int)bytesDownloaded
                    bytesUploaded:(int)bytesUploaded;
 
+@optional
+
+/**
+ Called instead of endedRequestWithResponse:bytesDownloaded:bytesUploaded: when a request ends
+ @param response The response the request was ended with
+ @param bytesDownloaded The amount of bytes downloaded
+ @param bytesUploaded The amount of bytes uploaded
+ @param uncompressedBytesUploaded The amount of bytes uploaded had the body not been compressed
+ */
+- (void)endedRequestWithResponse:(SPTDataLoaderResponse *)response
+                 bytesDownloaded:(int)bytesDownloaded
+                   bytesUploaded:(int)bytesUploaded
+       uncompressedBytesUploaded:(int)uncompressedBytesUploaded;
+
 @end
 
 NS_ASSUME_NONNULL_END
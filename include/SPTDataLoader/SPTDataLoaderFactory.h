@@ -7,6 +7,7 @@
 
 @class SPTDataLoader;
 @class SPTDataLoaderBlockWrapper;
+@class SPTDataLoaderMutationQueue;
 @protocol SPTDataLoaderAuthoriser;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -26,6 +27,13 @@ NS_ASSUME_NONNULL_BEGIN
  @discussion The NSArray consists of objects conforming to the SPTDataLoaderAuthoriser protocol
  */
 @property (nonatomic, copy, readonly, nullable) NSArray<id<SPTDataLoaderAuthoriser>> *authorisers;
+/**
+ The queue keeping requests that could not reach the server to replay them later
+ @discussion The default is nil. Requests with persistsWhenOffline are queued when they are made while the factory is
+ offline or fail before reaching the network. Replays are performed through this factory, and start when the factory
+ goes back online or another request through it succeeds
+ */
+@property (nonatomic, strong, nullable) SPTDataLoaderMutationQueue *mutationQueue;
 
 /**
  Creates a data loader
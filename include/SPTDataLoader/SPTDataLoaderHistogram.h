@@ -0,0 +1,47 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A snapshot of the distribution of recorded values
+ @discussion Values are counted in logarithmic buckets of 16 linear steps each, so a percentile is reported within about
+ 6% of the true value no matter its magnitude, while the memory a histogram takes stays fixed.
+ */
+@interface SPTDataLoaderHistogram : NSObject
+
+/**
+ The number of values recorded
+ */
+@property (nonatomic, assign, readonly) uint64_t count;
+/**
+ The smallest value recorded, or 0 if none was
+ */
+@property (nonatomic, assign, readonly) double minimum;
+/**
+ The largest value recorded, or 0 if none was
+ */
+@property (nonatomic, assign, readonly) double maximum;
+/**
+ The sum of the values recorded
+ */
+@property (nonatomic, assign, readonly) double sum;
+/**
+ The average of the values recorded, or 0 if none was
+ */
+@property (nonatomic, assign, readonly) double mean;
+
+/**
+ The value that a percentage of the recorded values are smaller than or equal to
+ @param percentile The percentage, between 0 and 100
+ @return The largest value of the bucket the percentile falls in, or 0 if no value was recorded
+ */
+- (double)valueAtPercentile:(double)percentile;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -27,6 +27,19 @@ NS_ASSUME_NONNULL_BEGIN
  @discussion By default this is the main queue.
  */
 @property (nonatomic, strong) dispatch_queue_t delegateQueue;
+/**
+ Whether the delegate selectors are gathered and called together rather than dispatched one at a time.
+ @discussion By default every call is dispatched to the delegate queue on its own, or made straight away when the
+ delegate queue is the main queue and the call happens on the main thread. When set, calls are queued and made by a
+ single block on the delegate queue in the order they happened, which spares a busy delegate queue one block per call.
+ Calls are never made synchronously in this mode.
+ */
+@property (nonatomic, assign) BOOL coalescesDelegateCalls;
+/**
+ The number of seconds delegate calls are gathered for before they are made, when coalescing them.
+ @discussion By default this is 0, and the calls gathered are made on the next turn of the delegate queue.
+ */
+@property (nonatomic, assign) NSTimeInterval delegateCoalescingInterval;
 /**
  The requests currently under flight in the data loader
  */
@@ -43,6 +56,15 @@ NS_ASSUME_NONNULL_BEGIN
  @return A cancellation token associated with the request, or `nil` if the request coulnd’t be performed.
  */
 - (nullable id<SPTDataLoaderCancellationToken>)performRequest:(SPTDataLoaderRequest *)request;
+/**
+ Performs a group of requests and returns the cancellation tokens associated with them.
+ @discussion The requests are registered with the data loader as one unit, which is cheaper than performing them one
+ at a time. Requests that can’t be performed are reported to the receiver’s delegate as with `performRequest:` and
+ have no cancellation token in the returned array.
+ @param requests The objects describing the kind of requests to be performed
+ @return The cancellation tokens associated with the requests that could be performed, in the order of the requests.
+ */
+- (NSArray<id<SPTDataLoaderCancellationToken>> *)performRequests:(NSArray<SPTDataLoaderRequest *> *)requests;
 
 #pragma mark Cancelling Loads
 
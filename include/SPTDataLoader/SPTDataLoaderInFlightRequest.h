@@ -0,0 +1,74 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What a request the service has taken on is waiting for
+ */
+typedef NS_ENUM(NSInteger, SPTDataLoaderInFlightRequestState) {
+    /// Accepted by the service but not yet checked against the rate limiter
+    SPTDataLoaderInFlightRequestStateQueued,
+    /// Waiting for an authoriser to authorise it
+    SPTDataLoaderInFlightRequestStateAuthorising,
+    /// Waiting for the preload of its URL to finish, to be loaded from the cache
+    SPTDataLoaderInFlightRequestStateWaitingForPreload,
+    /// Held back by the rate limiter, either by its requests per second or by the adaptive concurrency limit
+    SPTDataLoaderInFlightRequestStateRateLimited,
+    /// Waiting out the exponential back-off before a retry
+    SPTDataLoaderInFlightRequestStateBackingOff,
+    /// Sent and waiting for the response to begin
+    SPTDataLoaderInFlightRequestStateRunning,
+    /// Receiving the body of the response
+    SPTDataLoaderInFlightRequestStateStreaming
+};
+
+/**
+ A human readable name for the state of an in-flight request, such as "rateLimited"
+ @param state The state to name
+ */
+FOUNDATION_EXPORT NSString *NSStringFromSPTDataLoaderInFlightRequestState(SPTDataLoaderInFlightRequestState state);
+
+/**
+ A snapshot of a request the service is performing
+ */
+@interface SPTDataLoaderInFlightRequest : NSObject
+
+/**
+ The request being performed
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderRequest *request;
+/**
+ The identifier of the source the request came from
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *sourceIdentifier;
+/**
+ What the request is waiting for
+ */
+@property (nonatomic, assign, readonly) SPTDataLoaderInFlightRequestState state;
+/**
+ The seconds since the service took the request on
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval age;
+/**
+ The seconds since the request entered its current state
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval timeInState;
+/**
+ The number of times the request has been retried so far
+ */
+@property (nonatomic, assign, readonly) NSUInteger retryCount;
+/**
+ The number of body bytes received so far
+ */
+@property (nonatomic, assign, readonly) int64_t receivedByteCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
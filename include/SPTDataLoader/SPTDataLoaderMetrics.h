@@ -0,0 +1,69 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderHistogram;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What the requests of a set of metrics have in common
+ */
+typedef NS_ENUM(NSInteger, SPTDataLoaderMetricsDimension) {
+    /// Requests to the same service, the scheme, host and first path component of their URLs
+    SPTDataLoaderMetricsDimensionServiceKey,
+    /// Requests with the same sourceIdentifier
+    SPTDataLoaderMetricsDimensionSourceIdentifier
+};
+
+/**
+ A snapshot of the metrics of the requests sharing a service key or a sourceIdentifier
+ @discussion Only requests that completed with a response or an error are counted, cancelled requests are not.
+ */
+@interface SPTDataLoaderMetrics : NSObject
+
+/**
+ Whether the metrics are of a service key or of a sourceIdentifier
+ */
+@property (nonatomic, assign, readonly) SPTDataLoaderMetricsDimension dimension;
+/**
+ The service key or sourceIdentifier the requests share
+ */
+@property (nonatomic, copy, readonly) NSString *key;
+/**
+ The seconds between the service starting a request and it completing, including every retry
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderHistogram *latency;
+/**
+ The seconds between the last attempt of a request being sent and its response arriving
+ @discussion Requests that completed without a response are not counted.
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderHistogram *timeToFirstByte;
+/**
+ The seconds a request was held back by the rate limiter, its concurrency limit and retry back-off
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderHistogram *queueWait;
+/**
+ The number of body bytes a request received
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderHistogram *bodySize;
+/**
+ The number of times a request was retried
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderHistogram *retryCount;
+/**
+ The number of requests per class of HTTP status code, keyed by "1xx" to "5xx", or "none" for requests that completed
+ without an HTTP response
+ */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSNumber *> *statusClassCounts;
+/**
+ The number of requests that failed per domain of their error
+ */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSNumber *> *errorDomainCounts;
+
+@end
+
+NS_ASSUME_NONNULL_END
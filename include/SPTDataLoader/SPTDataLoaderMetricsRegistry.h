@@ -0,0 +1,36 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderMetrics;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The metrics a service keeps of the requests it completes, per service key and per sourceIdentifier
+ @discussion Recording a request only updates atomic counters, it never waits on a lock. Every service key and
+ sourceIdentifier takes a fixed amount of memory however many requests are recorded, which makes it cheap to keep the
+ registry running and upload percentiles periodically instead of every response.
+ */
+@interface SPTDataLoaderMetricsRegistry : NSObject
+
+/**
+ A snapshot of the metrics of every service key and sourceIdentifier that completed a request since the last reset
+ */
+- (NSArray<SPTDataLoaderMetrics *> *)metrics;
+/**
+ A snapshot of the metrics, resetting them as they are taken
+ @discussion Use this to report intervals, every value recorded is counted in exactly one of the snapshots taken.
+ */
+- (NSArray<SPTDataLoaderMetrics *> *)metricsAndReset;
+/**
+ Forgets every request recorded so far
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
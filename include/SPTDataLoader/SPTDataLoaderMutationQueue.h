@@ -0,0 +1,109 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderMutationQueue;
+@class SPTDataLoaderRequest;
+@class SPTDataLoaderResponse;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The protocol an object listening to the replays of a mutation queue must conform to
+ */
+@protocol SPTDataLoaderMutationQueueDelegate <NSObject>
+
+/**
+ Called when a replayed request has received a response from the server
+ @param mutationQueue The mutation queue that replayed the request
+ @param request The replayed request
+ @param response The response of the server, which may carry any HTTP status code
+ @discussion The request has been removed from the journal when this is called
+ */
+- (void)mutationQueue:(SPTDataLoaderMutationQueue *)mutationQueue
+     didReplayRequest:(SPTDataLoaderRequest *)request
+             response:(SPTDataLoaderResponse *)response;
+
+@optional
+
+/**
+ Called when a request is dropped from the queue because a later write to the same resource supersedes it
+ @param mutationQueue The mutation queue that dropped the request
+ @param request The dropped request
+ */
+- (void)mutationQueue:(SPTDataLoaderMutationQueue *)mutationQueue
+didDiscardSupersededRequest:(SPTDataLoaderRequest *)request;
+
+@end
+
+/**
+ A durable queue of requests that change state on the server, replayed in order once connectivity returns
+ @discussion When set on a factory, requests that opt in with persistsWhenOffline and are made while the factory is
+ offline, or that fail because the network could not be reached, are written to an append-only journal on disk and
+ fail towards their data loader with SPTDataLoaderRequestErrorQueuedForReplay. The journal survives relaunches.
+ Replays go through the factory, so they are authorised and rate limited like any other request, and their responses
+ are delivered to the delegate of the queue. Replay starts when the factory goes back online, when a request through
+ the factory succeeds, or when replay is called.
+ */
+@interface SPTDataLoaderMutationQueue : NSObject
+
+/**
+ The object listening to the replays of the queue
+ */
+@property (nonatomic, weak, nullable) id<SPTDataLoaderMutationQueueDelegate> delegate;
+/**
+ The queue to call the delegate on
+ @discussion The default is the main queue
+ */
+@property (nonatomic, strong) dispatch_queue_t delegateQueue;
+/**
+ The number of requests replayed at the same time
+ @discussion The default is 1, which replays strictly one request after the other. Higher values keep the order in
+ which replays start but not the order in which they complete
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentReplays;
+/**
+ Whether a PUT or DELETE drops the pending PUT, PATCH and DELETE requests to the same URL
+ @discussion The default is NO. Requests that are being replayed are never dropped
+ */
+@property (nonatomic, assign) BOOL collapsesSupersededWrites;
+/**
+ The requests waiting to be replayed, in the order they were queued
+ */
+@property (nonatomic, copy, readonly) NSArray<SPTDataLoaderRequest *> *pendingRequests;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Class constructor
+ @param journalURL The file URL of the journal, which is created if it does not exist
+ @param error Set to the reason the journal could not be opened
+ @discussion Requests left in the journal by an earlier launch are pending again
+ */
++ (nullable instancetype)mutationQueueWithJournalURL:(NSURL *)journalURL error:(NSError * _Nullable *)error;
+
+/**
+ Whether a request may be queued
+ @param request The request to check
+ @discussion Only POST, PUT, PATCH and DELETE requests without a body stream may be queued
+ */
+- (BOOL)canEnqueueRequest:(SPTDataLoaderRequest *)request;
+/**
+ Writes a request to the journal to be replayed later
+ @param request The request to queue
+ @param error Set to the reason the request could not be queued
+ @return Whether the request was queued
+ */
+- (BOOL)enqueueRequest:(SPTDataLoaderRequest *)request error:(NSError * _Nullable *)error;
+/**
+ Starts replaying the pending requests
+ @discussion Replay pauses when a replay fails to reach the network, and continues the next time this is called
+ */
+- (void)replay;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,49 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The budget a service speculatively fetches the resources its responses ask to be preloaded within
+ @discussion Responses name the resources the client will want next in Link headers with rel=preload, on the final
+ response or on a 103 Early Hints response. The service fetches those resources at low priority into the URL cache of
+ its session, and a GET request for one of them is then answered from the cache, or waits for the preload still in
+ flight rather than fetching the resource a second time.
+ */
+@interface SPTDataLoaderPreloadPolicy : NSObject <NSCopying>
+
+/**
+ The number of preloads in flight at most, further preload hints are ignored until one completes
+ @discussion The default is 4
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentPreloads;
+/**
+ The number of body bytes the preloads in flight and the preloaded responses not yet requested may take up in total
+ @discussion The default is 4MB. A preload announcing or growing to a body past the budget is cancelled.
+ */
+@property (nonatomic, assign) int64_t maximumBytes;
+/**
+ The number of seconds a preloaded response is kept for a request to claim it
+ @discussion The default is 30 seconds. An unclaimed response stays in the URL cache, but is then only used when its
+ caching headers allow it.
+ */
+@property (nonatomic, assign) NSTimeInterval timeToLive;
+/**
+ The hosts resources may be preloaded from besides the host of the response that names them
+ @discussion The default is empty, so only resources of the same host are preloaded. The headers of the request, such
+ as its authorisation, are only sent along to the same host.
+ */
+@property (nonatomic, copy) NSSet<NSString *> *allowedHosts;
+
+/**
+ Class constructor for a policy with the default budget
+ */
++ (instancetype)preloadPolicy;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -5,6 +5,7 @@
 
 #import <Foundation/Foundation.h>
 
+@class SPTDataLoaderConcurrencyLimit;
 @class SPTDataLoaderRequest;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -15,6 +16,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface SPTDataLoaderRateLimiter : NSObject
 
+/**
+ The number of requests a service with adaptive concurrency may have in flight before it has answered any
+ @discussion The default is 4
+ */
+@property (nonatomic, assign) NSUInteger initialConcurrencyLimit;
+/**
+ The number of requests a service with adaptive concurrency may never exceed in flight
+ @discussion The default is 64
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrencyLimit;
+/**
+ How many times its baseline the round-trip time of a service may grow before the service is considered congested
+ @discussion The default is 2.0
+ */
+@property (nonatomic, assign) double concurrencyLatencyTolerance;
+
 /**
  Class constructor
  @param requestsPerSecond The number of requests per second as a default to allow for a service
@@ -49,6 +66,28 @@ NS_ASSUME_NONNULL_BEGIN
  @param URL The URL to set the retry after
  */
 - (void)setRetryAfter:(NSTimeInterval)absoluteTime forURL:(NSURL *)URL;
+/**
+ Whether the number of requests in flight to the service of a URL adapts to how the service responds
+ @param adaptiveConcurrency Whether to limit the requests in flight adaptively
+ @param URL The URL of the service
+ @discussion The default is NO. The limit starts at initialConcurrencyLimit and doubles for every round-trip in which it
+ is used up, until the service shows the first sign of congestion. From then on it grows by one request per round-trip
+ while the round-trip time stays within concurrencyLatencyTolerance of its baseline, and is halved at most once per
+ round-trip when the round-trip time grows beyond that, or the service answers with 429 or 503, or a request times
+ out. Requests over the limit wait for a request in flight to complete before they are sent
+ */
+- (void)setAdaptiveConcurrency:(BOOL)adaptiveConcurrency forURL:(NSURL *)URL;
+/**
+ Whether the number of requests in flight to the service of a URL adapts to how the service responds
+ @param URL The URL of the service
+ */
+- (BOOL)adaptiveConcurrencyForURL:(NSURL *)URL;
+/**
+ A snapshot of the adaptive concurrency limit of the service of a URL
+ @param URL The URL of the service
+ @return The snapshot, or nil if the service does not use adaptive concurrency
+ */
+- (nullable SPTDataLoaderConcurrencyLimit *)concurrencyLimitForURL:(NSURL *)URL;
 
 @end
 
@@ -0,0 +1,35 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A redirect a request followed on its way to the response
+ */
+@interface SPTDataLoaderRedirect : NSObject
+
+/**
+ The URL that answered with the redirect
+ */
+@property (nonatomic, strong, readonly) NSURL *URL;
+/**
+ The location the request was redirected to
+ */
+@property (nonatomic, strong, readonly) NSURL *redirectURL;
+/**
+ The status code of the redirect, such as 301
+ */
+@property (nonatomic, assign, readonly) NSInteger statusCode;
+/**
+ Whether the redirect was remembered from an earlier response rather than received from the server
+ @discussion A cached redirect is applied before the request is sent, so it costs no round trip.
+ */
+@property (nonatomic, assign, readonly, getter = isCached) BOOL cached;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -20,7 +20,10 @@ extern NSString * const SPTDataLoaderRequestErrorDomain;
 
 typedef NS_ERROR_ENUM(SPTDataLoaderRequestErrorDomain, SPTDataLoaderRequestErrorCode) {
     SPTDataLoaderRequestErrorCodeTimeout,
-    SPTDataLoaderRequestErrorChunkedRequestWithoutChunkedDelegate
+    SPTDataLoaderRequestErrorChunkedRequestWithoutChunkedDelegate,
+    SPTDataLoaderRequestErrorSegmentVerificationFailed,
+    SPTDataLoaderRequestErrorQueuedForReplay,
+    SPTDataLoaderRequestErrorResponseTooLarge
 };
 
 /**
@@ -36,6 +39,19 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderRequestBackgroundPolicy) {
     SPTDataLoaderRequestBackgroundPolicyAlways
 };
 
+/**
+ How the body of the request is compressed before it is uploaded
+
+ - SPTDataLoaderRequestBodyCompressionNone: Upload the body as is
+ - SPTDataLoaderRequestBodyCompressionGzip: Compress the body with gzip
+ - SPTDataLoaderRequestBodyCompressionDeflate: Compress the body with deflate in the zlib format
+ */
+typedef NS_ENUM(NSInteger, SPTDataLoaderRequestBodyCompression) {
+    SPTDataLoaderRequestBodyCompressionNone,
+    SPTDataLoaderRequestBodyCompressionGzip,
+    SPTDataLoaderRequestBodyCompressionDeflate
+};
+
 /**
  A representing of the request to make to the backend
  */
@@ -52,15 +68,51 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderRequestBackgroundPolicy) {
  This flag is ignored on OS versions earlier than iOS 11, macOS 10.13, tvOS 11, and watchOS 4.
  */
 @property (nonatomic, assign) BOOL waitsForConnectivity;
+/**
+ The name of the session partition the request is performed in
+ @discussion The default is nil, which leaves the choice to the matchers of the partitions of the service. Requests
+ naming a partition the service does not have are performed in the session created from the service configuration
+ */
+@property (nonatomic, copy, nullable) NSString *sessionPartitionName;
 /**
  The number of times to retry this request in the event of a failure
- @discussion The default is 0
+ @discussion The default is 0. When a GET breaks off mid-body and the server supports byte ranges with a strong ETag or
+ Last-Modified validator, the retry asks for the remaining bytes only. Bodies with a Content-Encoding are retried in
+ full, and so is a ranged response that does not continue the body. Download tasks resume from their resume data
  */
 @property (nonatomic, assign) NSUInteger maximumRetryCount;
 /**
  The body of the request
  */
 @property (nonatomic, strong, nullable) NSData *body;
+/**
+ How the body or body stream is compressed before it is uploaded
+ @discussion The default is SPTDataLoaderRequestBodyCompressionNone. A body is compressed off the calling thread
+ before the request is performed, and a body stream is compressed as it is read. The matching Content-Encoding header
+ is added, unless the request already sets one in which case the body is assumed to be encoded and left alone. Body
+ streams of requests with SPTDataLoaderRequestBackgroundPolicyAlways are not compressed
+ */
+@property (nonatomic, assign) SPTDataLoaderRequestBodyCompression bodyCompression;
+/**
+ The size in bytes below which the body is uploaded uncompressed
+ @discussion The default is 1024. Bodies that do not shrink when compressed are uploaded uncompressed as well. This
+ does not apply to body streams, as their size is not known up front
+ */
+@property (nonatomic, assign) NSUInteger minimumCompressedBodySize;
+/**
+ The number of byte ranges a large GET is split into and downloaded in parallel
+ @discussion The default is 0, values below 2 download the resource over a single connection. The first range of
+ minimumSegmentSize bytes probes the size of the resource, the rest is split into ranges that are fetched concurrently
+ and written into a buffer of the full size. The response carries the whole body once every range has been verified
+ against the size and validator of the probe. Servers that do not answer the probe with a byte range get a regular
+ download. This is ignored for requests that use chunks or a background policy of always
+ */
+@property (nonatomic, assign) NSUInteger segmentCount;
+/**
+ The smallest number of bytes a segment of a segmented download covers
+ @discussion The default is 1 MiB
+ */
+@property (nonatomic, assign) NSUInteger minimumSegmentSize;
 /**
  The headers represented by a dictionary
  */
@@ -70,6 +122,19 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderRequestBackgroundPolicy) {
  @discussion This will only generate chunks if the data loader delegate is set up to receive them
  */
 @property (nonatomic, assign) BOOL chunks;
+/**
+ The maximum number of chunks that may be awaiting delivery to the delegate at any one time
+ @discussion When the window is full the underlying task is suspended until the delegate has consumed a chunk. The
+ default is 0, which does not bound the number of chunks in flight. This is only used when chunks is YES
+ */
+@property (nonatomic, assign) NSUInteger maximumInFlightChunks;
+/**
+ The minimum size in bytes of a chunk delivered to the delegate
+ @discussion Smaller pieces of data received from the network are coalesced until this size is reached, the final chunk
+ of a response may be smaller. The default is 0, which delivers data as soon as it is received. This is only used when
+ chunks is YES
+ */
+@property (nonatomic, assign) NSUInteger minimumChunkSize;
 /**
  The cache policy to use for this request
  */
@@ -97,24 +162,63 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderRequestBackgroundPolicy) {
 @property (nonatomic, assign, readonly) int64_t uniqueIdentifier;
 /**
  The absolute timeout for the request to respect
- @discussion The default is 0.0, which is the equivalent of no timeout
+ @discussion The default is 0.0, which is the equivalent of no timeout. The timeout is a deadline for the request as a
+ whole: retries are only attempted if they can be sent before it passes, the timeout of every task is shortened to the
+ time that is left, and whatever is still in flight when it passes is cancelled as the timeout error is delivered.
  */
 @property (nonatomic, assign) NSTimeInterval timeout;
+/**
+ The largest response body in bytes the request accepts
+ @discussion The default is 0, which falls back to the maximumResponseBodySize of the service. A response announcing a
+ larger Content-Length is rejected as soon as its headers arrive, and one that grows past it while streaming is
+ cancelled. Either way the request fails with SPTDataLoaderRequestErrorResponseTooLarge and is not retried.
+ */
+@property (nonatomic, assign) int64_t maximumResponseBodySize;
 /**
  An input stream that can be used to stream a body
+ @discussion Unless the background policy is SPTDataLoaderRequestBackgroundPolicyAlways the body is uploaded by a
+ streamed upload task, which asks for a new body stream through needsNewBodyStream for every task, retries included
  */
 @property (nonatomic, strong, readwrite) NSInputStream *bodyStream;
+/**
+ A file whose contents are uploaded as the body
+ @discussion The default is nil. The file is streamed from disk by an upload task, so it is never read into memory and
+ every retry uploads it again from the start. This works with every background policy. When set, body and bodyStream
+ are ignored and bodyCompression does not apply
+ */
+@property (nonatomic, copy, nullable) NSURL *bodyFileURL;
 /**
  An identifier for the request source. May be nil.
 
  @discussion This is used for logging purposes to locate where data is downloaded from.
  */
 @property (nonatomic, copy, nullable) NSString *sourceIdentifier;
+/**
+ The tags the service can cancel or reprioritise the request by
+ @discussion The default is an empty set. A request is always tagged with its sourceIdentifier as well, so requests from
+ one source can be handled together without tagging them. Changing the tags of a request that is being performed has no
+ effect on it.
+ @see -[SPTDataLoaderService cancelRequestsWithTag:]
+ */
+@property (nonatomic, copy) NSSet<NSString *> *tags;
+/**
+ The priority of the task performing the request, from 0.0 to 1.0
+ @discussion The default is NSURLSessionTaskPriorityDefault. It is a hint to the URL session about which tasks to
+ serve first and does not reorder requests waiting on the rate limiter.
+ */
+@property (nonatomic, assign) float priority;
 /**
  A Boolean value that indicates whether the redirection should happen for a request.
  @discussion default is NO.
  */
 @property (nonatomic, assign) BOOL shouldStopRedirection;
+/**
+ Whether the request is written to the mutation queue of its factory when it cannot reach the server
+ @discussion The default is NO. This applies to POST, PUT, PATCH and DELETE requests without a body stream that are
+ made while the factory is offline or fail before reaching the network. Such requests fail with
+ SPTDataLoaderRequestErrorQueuedForReplay and are replayed by the mutation queue later
+ */
+@property (nonatomic, assign) BOOL persistsWhenOffline;
 
 /**
  Class constructor
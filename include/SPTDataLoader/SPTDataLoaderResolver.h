@@ -5,6 +5,8 @@
 
 #import <Foundation/Foundation.h>
 
+@protocol SPTDataLoaderResolverAddressSource;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
@@ -12,6 +14,34 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface SPTDataLoaderResolver : NSObject
 
+/**
+ The source the addresses of hosts are resolved through
+ @discussion Looking up a host the resolver has no addresses for, or whose addresses are close to expiring, asks the
+ source for new ones in the background. The lookup itself never waits: until the source answers it returns the
+ addresses it already has, even expired ones, or the host itself. Addresses of hosts that keep being looked up are
+ refreshed before they expire.
+ */
+@property (nonatomic, strong, readonly, nullable) id<SPTDataLoaderResolverAddressSource> addressSource;
+/**
+ The file the addresses are kept in across launches
+ */
+@property (nonatomic, copy, readonly, nullable) NSURL *persistenceURL;
+/**
+ The number of seconds an address marked as unreachable is avoided for
+ @discussion The default is an hour.
+ */
+@property (nonatomic, assign) NSTimeInterval unreachablePeriod;
+
+/**
+ Class constructor
+ @param addressSource The source to resolve hosts through, nil to only use the addresses that are set explicitly
+ @param persistenceURL The file to keep the addresses in, nil to keep them in memory only
+ @discussion Addresses left in the file by an earlier launch are used straight away, expired ones while they are being
+ refreshed.
+ */
++ (instancetype)resolverWithAddressSource:(nullable id<SPTDataLoaderResolverAddressSource>)addressSource
+                           persistenceURL:(nullable NSURL *)persistenceURL;
+
 /**
  Find a known valid address for the host
  @param host The host to resolve
@@ -21,8 +51,16 @@ NS_ASSUME_NONNULL_BEGIN
  Set a list of valid addresses for the host
  @param addresses An NSArray of NSString objects denoting an address
  @param host The host tied to these addresses
+ @discussion The addresses never expire.
  */
 - (void)setAddresses:(NSArray<NSString *> *)addresses forHost:(NSString *)host;
+/**
+ Set a list of valid addresses for the host that expire
+ @param addresses An NSArray of NSString objects denoting an address
+ @param host The host tied to these addresses
+ @param timeToLive The number of seconds the addresses may be used for
+ */
+- (void)setAddresses:(NSArray<NSString *> *)addresses forHost:(NSString *)host timeToLive:(NSTimeInterval)timeToLive;
 /**
  Mark an address as unreachable
  @param address The address that has become unreachable
@@ -0,0 +1,33 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The block an address source calls once it has resolved a host
+ @param addresses The addresses of the host in order of preference, nil or empty if the host could not be resolved
+ @param timeToLive The number of seconds the addresses may be used for
+ */
+typedef void (^SPTDataLoaderResolverAddressSourceCompletion)(NSArray<NSString *> * _Nullable addresses, NSTimeInterval timeToLive);
+
+/**
+ The protocol a source of addresses for a resolver must conform to
+ @discussion A source could query DNS-over-HTTPS, a bootstrap service or a fixture in tests. The resolver asks it in
+ the background and never waits for it, so it may take as long as it needs and complete on any thread.
+ */
+@protocol SPTDataLoaderResolverAddressSource <NSObject>
+
+/**
+ Resolve the addresses of a host
+ @param host The host to resolve
+ @param completion The block to call exactly once with the addresses of the host
+ */
+- (void)resolveAddressesForHost:(NSString *)host completion:(SPTDataLoaderResolverAddressSourceCompletion)completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -30,6 +30,7 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderResponseHTTPStatusCode) {
     SPTDataLoaderResponseHTTPStatusCodeUseProxy = 305,
     SPTDataLoaderResponseHTTPStatusCodeUnused = 306,
     SPTDataLoaderResponseHTTPStatusCodeTemporaryRedirect = 307,
+    SPTDataLoaderResponseHTTPStatusCodePermanentRedirect = 308,
     // Client Error
     SPTDataLoaderResponseHTTPStatusCodeBadRequest = 400,
     SPTDataLoaderResponseHTTPStatusCodeUnauthorised = 401,
@@ -58,6 +59,7 @@ typedef NS_ENUM(NSInteger, SPTDataLoaderResponseHTTPStatusCode) {
     SPTDataLoaderResponseHTTPStatusCodeHTTPVersionNotSupported = 505
 };
 
+@class SPTDataLoaderRedirect;
 @class SPTDataLoaderRequest;
 
 extern NSString * const SPTDataLoaderResponseErrorDomain;
@@ -84,6 +86,11 @@ extern NSString * const SPTDataLoaderResponseErrorDomain;
  The URL that provided the response (after any redirects).
  */
 @property (nonatomic, strong, readonly, nullable) NSURL *resolvedURL;
+/**
+ The redirects the request followed to get to the response, in the order they were followed
+ @discussion Redirects remembered from earlier responses are listed first, they were applied before the request was sent.
+ */
+@property (nonatomic, copy, readonly) NSArray<SPTDataLoaderRedirect *> *redirects;
 /**
  The date at which the request that generated the response can be retried
  @warning Can be nil if no retry-after is given in the response headers
@@ -6,15 +6,35 @@
 #import <Foundation/Foundation.h>
 
 @class SPTDataLoaderFactory;
+@class SPTDataLoaderInFlightRequest;
+@class SPTDataLoaderMetricsRegistry;
+@class SPTDataLoaderPreloadPolicy;
 @class SPTDataLoaderRateLimiter;
 @class SPTDataLoaderResolver;
 @class SPTDataLoaderServerTrustPolicy;
+@class SPTDataLoaderSessionPartition;
+@class SPTDataLoaderSessionStatistics;
 @protocol SPTDataLoaderAuthoriser;
+@protocol SPTDataLoaderTracer;
 
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol SPTDataLoaderConsumptionObserver;
 
+/**
+ The block called once a host has been pre-warmed
+ @param host The host that was pre-warmed
+ @param duration The time in seconds it took to establish and validate the connection to the host
+ @param error The object describing why the host could not be pre-warmed, or nil if the host is warm
+ */
+typedef void (^SPTDataLoaderServicePrewarmCompletion)(NSString *host, NSTimeInterval duration, NSError * _Nullable error);
+
+/**
+ The block called by the watchdog with the requests that got stuck since it last called it
+ @param stuckRequests The requests that have been in the same state for longer than the threshold
+ */
+typedef void (^SPTDataLoaderServiceStuckRequestsHandler)(NSArray<SPTDataLoaderInFlightRequest *> *stuckRequests);
+
 /**
  The service used for creating data loader factories and providing application wide rate limiting to services
  */
@@ -27,6 +47,43 @@ NS_ASSUME_NONNULL_BEGIN
  @warning This will trigger an assert if all certificates are allowed on release builds.
  */
 @property (nonatomic, assign, readwrite, getter = areAllCertificatesAllowed) BOOL allCertificatesAllowed;
+/**
+ The tracer told about the phases of every request performed through the service
+ @discussion By default this is nil, which costs the request path no more than a check per phase. Setting it applies
+ to requests already in flight as well as new ones.
+ @see SPTDataLoaderChromeTraceRecorder
+ @see SPTDataLoaderSignpostTracer
+ */
+@property (nonatomic, strong, readwrite, nullable) id<SPTDataLoaderTracer> tracer;
+/**
+ The metrics of every request the service completes, kept per service key and per sourceIdentifier
+ @discussion Cancelled requests are not counted. Take snapshots with metricsAndReset to report percentiles periodically
+ rather than a sample per response.
+ */
+@property (nonatomic, strong, readonly) SPTDataLoaderMetricsRegistry *metricsRegistry;
+/**
+ The largest response body in bytes the requests of the service accept
+ @discussion By default this is 0, which means no limit. Requests setting their own maximumResponseBodySize override
+ it. Responses delivered as downloads, for requests with SPTDataLoaderRequestBackgroundPolicyAlways, are checked once
+ the downloaded file has been read, and segmented downloads are rejected when their total size exceeds it.
+ */
+@property (nonatomic, assign, readwrite) int64_t maximumResponseBodySize;
+/**
+ The number of permanent redirects the service remembers
+ @discussion When a request is answered with a 301 or 308 the service remembers where it was sent, for as long as the
+ caching headers of the redirect allow, and sends later requests for the same method and URL straight to the new
+ location. Requests with shouldStopRedirection set are always sent to their own URL. The default is 256, 0 turns the
+ cache off.
+ */
+@property (nonatomic, assign, readwrite) NSUInteger maximumCachedRedirects;
+/**
+ The budget the service preloads resources within, nil turns preloading off
+ @discussion When a response names resources in a Link header with rel=preload, or in a 103 Early Hints response, the
+ service fetches them at a low priority into the URL cache of its session while the response is handled. The first GET
+ request for a preloaded URL is answered from the cache, or waits for the preload when it is still in flight. Preloads
+ are dropped when the request whose response named them is cancelled. The default is nil.
+ */
+@property (nonatomic, copy, readwrite, nullable) SPTDataLoaderPreloadPolicy *preloadPolicy;
 
 /**
  Class constructor
@@ -103,6 +160,73 @@ NS_ASSUME_NONNULL_BEGIN
  @param serverTrustPolicy The SPTDataLoaderServerTrustPolicy object
  */
 - (void)setServerTrustPolicy:(nullable SPTDataLoaderServerTrustPolicy *)serverTrustPolicy;
+/**
+ Opens and validates connections to hosts ahead of the first requests to them
+ @discussion Each host is contacted with a HEAD request over HTTPS through the same session its requests will use, so
+ that DNS resolution, the TCP and TLS handshakes and the server trust policy evaluation are done before the first real
+ request. Hosts are rerouted through the resolver, and the rate limiter is respected by delaying the pre-warm until it
+ allows a request to the host. The pre-warm itself does not count against the rate limiter.
+ @param hosts The hosts to pre-warm connections to
+ @param completion The block called once for every host when it is warm or could not be pre-warmed. This is called on
+ an internal queue.
+ */
+- (void)prewarmHosts:(NSArray<NSString *> *)hosts completion:(nullable SPTDataLoaderServicePrewarmCompletion)completion;
+/**
+ Splits the traffic of the service over separate URL sessions
+ @discussion A request is performed in the partition named by its sessionPartitionName, otherwise in the first partition
+ that matches it, otherwise in the session created from the service configuration. Every partition creates its session
+ the first time a request is routed to it and tears it down once it has been idle for its idle timeout. Sessions of
+ partitions that are no longer present finish their tasks before they are invalidated.
+ @param sessionPartitions The partitions to route requests to, checked in order
+ */
+- (void)setSessionPartitions:(NSArray<SPTDataLoaderSessionPartition *> *)sessionPartitions;
+/**
+ A snapshot of the traffic of every session, beginning with the session created from the service configuration and
+ followed by the partitions in order
+ */
+- (NSArray<SPTDataLoaderSessionStatistics *> *)sessionStatistics;
+/**
+ A snapshot of every request the service is performing, oldest first
+ @discussion This includes requests waiting for authorisation, for the rate limiter or for a retry, not only those with a
+ task on the network. Taking a snapshot does not hold up the requests, so it is cheap enough to take from a debug menu
+ or when the app is reported to be slow.
+ */
+- (NSArray<SPTDataLoaderInFlightRequest *> *)inFlightRequests;
+/**
+ Starts checking periodically for requests stuck in the same state
+ @discussion A request is reported once for every state it gets stuck in, so a request held back by the rate limiter
+ and then stuck waiting for its response is reported twice. Starting the watchdog again replaces the previous one.
+ @param threshold The seconds a request may spend in a single state before it is reported, checked every half of it
+ @param queue The queue to call the handler on
+ @param handler The block called with the requests that got stuck
+ */
+- (void)startWatchdogWithThreshold:(NSTimeInterval)threshold
+                             queue:(dispatch_queue_t)queue
+                           handler:(SPTDataLoaderServiceStuckRequestsHandler)handler;
+/**
+ Stops checking for stuck requests
+ */
+- (void)stopWatchdog;
+/**
+ Cancels every request carrying a tag
+ @discussion Requests are indexed by their tags as they are performed, so this takes time in proportion to the number
+ of requests it cancels rather than the number the service is performing. A request is cancelled through its
+ cancellation token where it has one, so its data loader tells its delegate the same way as when it is cancelled alone.
+ @param tag A tag or sourceIdentifier of the requests to cancel
+ */
+- (void)cancelRequestsWithTag:(NSString *)tag;
+/**
+ Changes the priority of every request carrying a tag
+ @discussion This applies to the running tasks of the requests as well as to the tasks of their retries.
+ @param priority The new priority, from 0.0 to 1.0
+ @param tag A tag or sourceIdentifier of the requests to reprioritise
+ */
+- (void)setPriority:(float)priority forRequestsWithTag:(NSString *)tag;
+/**
+ Forgets every permanent redirect the service remembers
+ @discussion Call this when the server has changed its mind about a redirect before the redirect expired.
+ */
+- (void)removeAllCachedRedirects;
 /**
  Cancels all outstanding tasks and then invalidates the session(s).
  */
@@ -0,0 +1,73 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Decides whether a request belongs to a session partition
+ @param request The request about to be performed
+ */
+typedef BOOL (^SPTDataLoaderSessionPartitionMatcher)(SPTDataLoaderRequest *request);
+
+/**
+ A class of traffic that the service performs in its own URL session
+ @discussion Every partition has its own NSURLSession, and so its own connection pool, cache and limits. This keeps bulk
+ downloads, latency critical API calls and telemetry from queueing behind each other on the same connections.
+ */
+@interface SPTDataLoaderSessionPartition : NSObject
+
+/**
+ The name requests use to pick the partition through their sessionPartitionName
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+/**
+ The configuration the session of the partition is created with
+ @discussion The HTTP headers and protocol classes of the service configuration are added to it unless it sets its own
+ */
+@property (nonatomic, copy, readonly) NSURLSessionConfiguration *configuration;
+/**
+ The number of seconds the session may go without a task before it is torn down
+ @discussion The default is 60 seconds, 0 keeps the session until the service is invalidated. A torn down session is
+ created again for the next request of the partition
+ */
+@property (nonatomic, assign) NSTimeInterval idleTimeout;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Class constructor
+ @param name The name of the partition
+ @param configuration The configuration of the session of the partition
+ @param matcher The block deciding which requests without a sessionPartitionName belong to the partition, may be nil to
+ only accept requests that name the partition
+ */
++ (instancetype)partitionWithName:(NSString *)name
+                    configuration:(NSURLSessionConfiguration *)configuration
+                          matcher:(nullable SPTDataLoaderSessionPartitionMatcher)matcher;
+
+/**
+ Class constructor for a group of hosts
+ @param name The name of the partition
+ @param configuration The configuration of the session of the partition
+ @param hosts The hosts whose requests belong to the partition, compared case insensitively with the host the request
+ is performed against
+ */
++ (instancetype)partitionWithName:(NSString *)name
+                    configuration:(NSURLSessionConfiguration *)configuration
+                            hosts:(NSSet<NSString *> *)hosts;
+
+/**
+ Whether a request belongs to the partition
+ @param request The request about to be performed
+ */
+- (BOOL)matchesRequest:(SPTDataLoaderRequest *)request;
+
+@end
+
+NS_ASSUME_NONNULL_END
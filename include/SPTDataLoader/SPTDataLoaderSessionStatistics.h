@@ -0,0 +1,54 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A snapshot of the traffic a session partition of the service has carried
+ */
+@interface SPTDataLoaderSessionStatistics : NSObject
+
+/**
+ The name of the partition, or nil for the session created from the service configuration
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *partitionName;
+/**
+ Whether the partition currently has a session
+ */
+@property (nonatomic, assign, readonly, getter = isSessionActive) BOOL sessionActive;
+/**
+ The number of sessions that have been created for the partition, including those torn down after going idle
+ */
+@property (nonatomic, assign, readonly) NSUInteger sessionCreationCount;
+/**
+ The number of tasks that have been started in the partition, including retries
+ */
+@property (nonatomic, assign, readonly) NSUInteger taskCount;
+/**
+ The number of tasks that are still running
+ */
+@property (nonatomic, assign, readonly) NSUInteger inFlightTaskCount;
+/**
+ The number of tasks that completed with an error
+ */
+@property (nonatomic, assign, readonly) NSUInteger failedTaskCount;
+/**
+ The number of body bytes sent by completed tasks
+ */
+@property (nonatomic, assign, readonly) int64_t bytesSent;
+/**
+ The number of body bytes received by completed tasks
+ */
+@property (nonatomic, assign, readonly) int64_t bytesReceived;
+/**
+ The average time in seconds between a task being created and completing
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval averageTaskDuration;
+
+@end
+
+NS_ASSUME_NONNULL_END
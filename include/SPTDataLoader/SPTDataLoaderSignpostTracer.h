@@ -0,0 +1,36 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <SPTDataLoader/SPTDataLoaderTracer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A tracer that emits the phases of requests as signposts, to be viewed in the Points of Interest of Instruments
+ @discussion Every phase becomes a signpost interval named after the phase, identified by the request, whose begin
+ message carries the uniqueIdentifier, service key and sourceIdentifier of the request. Signposts cost next to nothing
+ while Instruments is not recording.
+ */
+API_AVAILABLE(macos(10.14), ios(12.0), tvos(12.0), watchos(5.0))
+@interface SPTDataLoaderSignpostTracer : NSObject <SPTDataLoaderTracer>
+
+/**
+ The subsystem the signposts are logged under
+ */
+@property (nonatomic, copy, readonly) NSString *subsystem;
+
+/**
+ Class constructor
+ @param subsystem The subsystem to log the signposts under, such as the bundle identifier of the app
+ */
++ (instancetype)signpostTracerWithSubsystem:(NSString *)subsystem;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
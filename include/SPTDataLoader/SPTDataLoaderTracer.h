@@ -0,0 +1,66 @@
+/*
+ Copyright Spotify AB.
+ SPDX-License-Identifier: Apache-2.0
+ */
+
+#import <Foundation/Foundation.h>
+
+@class SPTDataLoaderRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The phases a request goes through on its way from a data loader to the delegate
+ */
+typedef NS_ENUM(NSInteger, SPTDataLoaderTracePhase) {
+    /// From the data loader accepting the request until the service starts it
+    SPTDataLoaderTracePhaseSubmission,
+    /// From the factory asking an authoriser to authorise the request until it has been authorised or failed to be
+    SPTDataLoaderTracePhaseAuthorisation,
+    /// Held back by the rate limiter, either by its requests per second or by the adaptive concurrency limit
+    SPTDataLoaderTracePhaseRateLimiterWait,
+    /// Waiting out the exponential back-off before a retry
+    SPTDataLoaderTracePhaseRetryBackoff,
+    /// From the URL session task being resumed until it completes, once per attempt
+    SPTDataLoaderTracePhaseTask,
+    /// From a chunk arriving until the consumer has handled it, once per chunk
+    SPTDataLoaderTracePhaseChunk,
+    /// Building the response of a completed task and handing it on
+    SPTDataLoaderTracePhaseCompletion,
+    /// From the data loader receiving the final response until its delegate has returned from handling it
+    SPTDataLoaderTracePhaseDelegateDelivery
+};
+
+/**
+ A human readable name for a trace phase, such as "rateLimiterWait"
+ @param phase The phase to name
+ */
+FOUNDATION_EXPORT NSString *NSStringFromSPTDataLoaderTracePhase(SPTDataLoaderTracePhase phase);
+
+/**
+ The protocol a tracer of requests must conform to
+ @discussion A tracer is told when every phase of every request of a service begins and ends. The calls come from
+ whichever thread the request is on at the time, so they may arrive concurrently and must return quickly. Phases of a
+ single request may overlap, chunks of a streamed request for example are delivered while its task is still running.
+ */
+@protocol SPTDataLoaderTracer <NSObject>
+
+/**
+ Called when a request enters a phase
+ @param phase The phase that began
+ @param request The request, its uniqueIdentifier identifies it across phases
+ @param serviceKey The service the request belongs to, the scheme, host and first path component of its URL
+ */
+- (void)beganPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey;
+
+/**
+ Called when a request leaves a phase
+ @param phase The phase that ended
+ @param request The request, its uniqueIdentifier identifies it across phases
+ @param serviceKey The service the request belongs to, the scheme, host and first path component of its URL
+ */
+- (void)endedPhase:(SPTDataLoaderTracePhase)phase ofRequest:(SPTDataLoaderRequest *)request serviceKey:(NSString *)serviceKey;
+
+@end
+
+NS_ASSUME_NONNULL_END